@@ -0,0 +1,270 @@
+
+#include "workload.h"
+#include "dependency_network.h"
+#include "standard_factory.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<functional>
+#include<iostream>
+#include<map>
+#include<sstream>
+#include<string>
+#include<vector>
+
+#ifndef DEPNET_BENCH_REVISION
+#define DEPNET_BENCH_REVISION "unknown"
+#endif
+
+namespace
+{
+    using namespace depnet;
+
+    /** The outcome of repeating one benchmark */
+    struct Result
+    {
+        std::string name;
+        std::string unit;
+        long iterations;
+        std::vector<double> seconds;
+    };
+
+    void usage(const char* program)
+    {
+        std::cerr << "usage: " << program << " [options]" << std::endl
+            << "  --vars N               number of variables (default 10)" << std::endl
+            << "  --rows N               number of training rows (default 5000)" << std::endl
+            << "  --discrete-fraction F  fraction of discrete variables (default 0.5)" << std::endl
+            << "  --levels N             levels of each discrete variable (default 4)" << std::endl
+            << "  --density F            probability of each dependency in the generating model (default 0.3)" << std::endl
+            << "  --seed N               workload seed (default 1)" << std::endl
+            << "  --predictions N        rows scored by the prediction benchmarks (default 10000)" << std::endl
+            << "  --sweeps N             Gibbs sweeps per sampler benchmark (default 2000)" << std::endl
+            << "  --samples N            samples drawn by the end-to-end benchmark (default 100)" << std::endl
+            << "  --repeat N             repetitions of each benchmark (default 3)" << std::endl
+            << "  --filter NAME          only run benchmarks whose names contain NAME" << std::endl
+            << "  --output FILE          write JSON results to FILE instead of standard output" << std::endl;
+    }
+
+    /**
+     * Times repetitions of a benchmark
+     * @param body Runs one repetition and returns the number of operations it performed
+     */
+    Result measure(const std::string& name, const std::string& unit, int repeat,
+            const std::function<long()>& body)
+    {
+        Result result;
+        result.name = name;
+        result.unit = unit;
+        result.iterations = 0;
+        for(int rep = 0; rep < repeat; rep++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            result.iterations = body();
+            auto stop = std::chrono::steady_clock::now();
+            result.seconds.push_back(std::chrono::duration<double>(stop - start).count());
+        }
+        std::cerr << name << ": " << result.iterations / *std::min_element(result.seconds.begin(), 
+                result.seconds.end()) << " " << unit << std::endl;
+        return result;
+    }
+
+    /** Finds the first variable of a kind, or -1 if the workload has none */
+    int findColumn(const bench::Workload& workload, bool discrete)
+    {
+        for(std::size_t col = 0; col < workload.varSpecs.size(); col++)
+            if(workload.varSpecs[col]->isDiscrete() == discrete)
+                return col;
+        return -1;
+    }
+
+    std::vector<std::shared_ptr<VariableSpecification> > otherVars(const bench::Workload& workload, int column)
+    {
+        std::vector<std::shared_ptr<VariableSpecification> > indep;
+        for(std::size_t col = 0; col < workload.varSpecs.size(); col++)
+            if(static_cast<int>(col) != column)
+                indep.push_back(workload.varSpecs[col]);
+        return indep;
+    }
+
+    void writeJson(std::ostream& out, const bench::WorkloadOptions& options, int repeat,
+            const std::vector<Result>& results)
+    {
+        out.precision(9);
+        out << "{" << std::endl
+            << "  \"benchmark\": \"depnet\"," << std::endl
+            << "  \"revision\": \"" << DEPNET_BENCH_REVISION << "\"," << std::endl
+            << "  \"config\": {\"vars\": " << options.numVars << ", \"rows\": " << options.numRows
+            << ", \"discrete_fraction\": " << options.discreteFraction << ", \"levels\": " << options.numLevels
+            << ", \"density\": " << options.density << ", \"seed\": " << options.seed
+            << ", \"repeat\": " << repeat << "}," << std::endl
+            << "  \"results\": [" << std::endl;
+        for(std::size_t index = 0; index < results.size(); index++)
+        {
+            const Result& result = results[index];
+            std::vector<double> sorted(result.seconds);
+            std::sort(sorted.begin(), sorted.end());
+            double median = sorted[sorted.size() / 2];
+            out << "    {\"name\": \"" << result.name << "\", \"unit\": \"" << result.unit
+                << "\", \"iterations\": " << result.iterations
+                << ", \"min_seconds\": " << sorted.front() << ", \"median_seconds\": " << median
+                << ", \"rate\": " << result.iterations / sorted.front() << "}"
+                << (index + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "  ]" << std::endl << "}" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::WorkloadOptions options;
+    long numPredictions = 10000;
+    long numSweeps = 2000;
+    int numSamples = 100;
+    int repeat = 3;
+    std::string filter;
+    const char* outputPath = NULL;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        bool hasValue = arg + 1 < argc;
+        if(std::strcmp(argv[arg], "--vars") == 0 && hasValue)
+            options.numVars = std::atol(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--rows") == 0 && hasValue)
+            options.numRows = std::atol(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--discrete-fraction") == 0 && hasValue)
+            options.discreteFraction = std::atof(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--levels") == 0 && hasValue)
+            options.numLevels = std::atoi(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--density") == 0 && hasValue)
+            options.density = std::atof(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--seed") == 0 && hasValue)
+            options.seed = std::strtoull(argv[++arg], NULL, 10);
+        else if(std::strcmp(argv[arg], "--predictions") == 0 && hasValue)
+            numPredictions = std::atol(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--sweeps") == 0 && hasValue)
+            numSweeps = std::atol(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--samples") == 0 && hasValue)
+            numSamples = std::atoi(argv[++arg]);
+        else if(std::strcmp(argv[arg], "--repeat") == 0 && hasValue)
+            repeat = std::max(1, std::atoi(argv[++arg]));
+        else if(std::strcmp(argv[arg], "--filter") == 0 && hasValue)
+            filter = argv[++arg];
+        else if(std::strcmp(argv[arg], "--output") == 0 && hasValue)
+            outputPath = argv[++arg];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(options.numVars < 2 || options.numRows < 1 || options.numLevels < 2)
+    {
+        std::cerr << "At least two variables, one row and two levels are required." << std::endl;
+        return 1;
+    }
+
+    bench::Workload workload = bench::generateWorkload(options);
+    std::shared_ptr<Factory> factory(new StandardFactory());
+    const boost::multi_array<double, 2>& data = workload.data;
+
+    std::vector<Result> results;
+    auto enabled = [&filter](const std::string& name) { return name.find(filter) != std::string::npos; };
+
+    // micro benchmarks over the first model of each kind, for each tree ensemble
+    const char* modelTypes[] = {"rdf", "gbt"};
+    for(const char* modelType : modelTypes)
+    for(int discrete = 1; discrete >= 0; discrete--)
+    {
+        int column = findColumn(workload, discrete);
+        if(column < 0)
+            continue;
+        std::string kind = discrete ? "discrete" : "continuous";
+        std::vector<std::shared_ptr<VariableSpecification> > indep = otherVars(workload, column);
+        std::shared_ptr<ConditionalModel> model = factory->createModel(modelType, indep, workload.varSpecs[column]);
+
+        if(enabled(std::string(modelType) + "_train_" + kind))
+            results.push_back(measure(std::string(modelType) + "_train_" + kind, "rows/s", repeat, [&]()
+            {
+                std::shared_ptr<ConditionalModel> trained = factory->createModel(modelType, indep, workload.varSpecs[column]);
+                trained->train(data, column);
+                return static_cast<long>(options.numRows);
+            }));
+
+        model->train(data, column);
+        std::vector<std::vector<double> > rows(std::min<long>(numPredictions, options.numRows));
+        for(std::size_t row = 0; row < rows.size(); row++)
+            for(std::size_t col = 0; col < options.numVars; col++)
+                if(static_cast<int>(col) != column)
+                    rows[row].push_back(data[row][col]);
+
+        std::string name = std::string(modelType) + (discrete ? "_class_density" : "_predict");
+        if(!enabled(name))
+            continue;
+        results.push_back(measure(name, "rows/s", repeat, [&]()
+        {
+            std::vector<double> posterior;
+            volatile double sink = 0;
+            for(long call = 0; call < numPredictions; call++)
+            {
+                const std::vector<double>& indepValues = rows[call % rows.size()];
+                if(discrete)
+                {
+                    model->getClassDensity(indepValues, posterior);
+                    sink = posterior[0];
+                } else
+                    sink = model->predict(indepValues);
+            }
+            (void) sink;
+            return numPredictions;
+        }));
+    }
+
+    // macro benchmarks over a whole network
+    DependencyNetwork network(workload.varSpecs, factory);
+    if(enabled("network_train"))
+        results.push_back(measure("network_train", "models/s", repeat, [&]()
+        {
+            network.train(data);
+            return static_cast<long>(options.numVars);
+        }));
+    else
+        network.train(data);
+
+    std::map<std::shared_ptr<VariableSpecification>, std::shared_ptr<ConditionalModel> > models;
+    for(auto it = workload.varSpecs.begin(); it != workload.varSpecs.end(); ++it)
+        models[*it] = network.getModel(*it);
+
+    if(enabled("gibbs_sweep"))
+        results.push_back(measure("gibbs_sweep", "sweeps/s", repeat, [&]()
+        {
+            std::shared_ptr<GibbsSampler> sampler = factory->createSampler(models, 1, options.seed);
+            for(long sweep = 0; sweep < numSweeps; sweep++)
+                sampler->sample();
+            return numSweeps;
+        }));
+
+    if(enabled("get_samples"))
+        results.push_back(measure("get_samples", "samples/s", repeat, [&]()
+        {
+            network.resetSampler();
+            network.getSamples(numSamples);
+            return static_cast<long>(numSamples);
+        }));
+
+    if(outputPath)
+    {
+        std::ofstream out(outputPath);
+        writeJson(out, options, repeat, results);
+        if(!out)
+        {
+            std::cerr << "Unable to write " << outputPath << std::endl;
+            return 1;
+        }
+    } else
+        writeJson(std::cout, options, repeat, results);
+    return 0;
+}
+
@@ -0,0 +1,87 @@
+
+#include "workload.h"
+#include "standard_var_spec.h"
+
+#include<algorithm>
+#include<cmath>
+#include<random>
+#include<string>
+
+namespace depnet
+{
+    namespace bench
+    {
+        WorkloadOptions::WorkloadOptions() : numVars(10), numRows(5000), discreteFraction(0.5),
+            numLevels(4), density(0.3), seed(1) { }
+
+        Workload generateWorkload(const WorkloadOptions& options)
+        {
+            std::mt19937_64 generator(options.seed);
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            std::normal_distribution<double> normal(0.0, 1.0);
+
+            Workload workload;
+            workload.parents.resize(options.numVars);
+            workload.data.resize(boost::extents[options.numRows][options.numVars]);
+
+            std::vector<std::string> levels;
+            for(int level = 0; level < options.numLevels; level++)
+                levels.push_back("l" + std::to_string(level));
+
+            for(std::size_t var = 0; var < options.numVars; var++)
+            {
+                std::shared_ptr<VariableSpecification> spec(new StandardVariableSpecification());
+                spec->setName("v" + std::to_string(var));
+                bool isDiscrete = uniform(generator) < options.discreteFraction;
+                if(isDiscrete)
+                {
+                    spec->setLevels(levels);
+                    spec->setDiscrete(true);
+                }
+                workload.varSpecs.push_back(spec);
+
+                std::vector<double> weights;
+                for(std::size_t parent = 0; parent < var; parent++)
+                {
+                    if(uniform(generator) < options.density)
+                    {
+                        workload.parents[var].push_back(parent);
+                        weights.push_back(normal(generator));
+                    }
+                }
+
+                // scaling keeps every variable's latent value near unit variance whatever its number of parents
+                double scale = 1.0 / std::sqrt(1.0 + weights.size());
+                std::vector<double> latent(options.numRows);
+                for(std::size_t row = 0; row < options.numRows; row++)
+                {
+                    double value = normal(generator);
+                    for(std::size_t parent = 0; parent < weights.size(); parent++)
+                    {
+                        std::size_t parentVar = workload.parents[var][parent];
+                        double parentValue = workload.data[row][parentVar];
+                        if(workload.varSpecs[parentVar]->isDiscrete())
+                            parentValue = (parentValue - (options.numLevels - 1) / 2.0) / options.numLevels * 3;
+                        value += weights[parent] * parentValue;
+                    }
+                    latent[row] = value * scale;
+                }
+
+                for(std::size_t row = 0; row < options.numRows; row++)
+                {
+                    double value = latent[row];
+                    if(isDiscrete)
+                    {
+                        // the standard normal CDF splits the latent value into equally likely levels
+                        double quantile = 0.5 * std::erfc(-value / std::sqrt(2.0));
+                        value = std::min<double>(std::floor(quantile * options.numLevels), options.numLevels - 1);
+                    }
+                    workload.data[row][var] = value;
+                }
+            }
+
+            return workload;
+        }
+    }
+}
+
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+
+namespace depnet
+{
+    namespace bench
+    {
+        /**
+         * Describes a synthetic training set
+         */
+        struct WorkloadOptions
+        {
+            /** Creates options for a small mixed workload */
+            WorkloadOptions();
+
+            /** The number of variables */
+            std::size_t numVars;
+
+            /** The number of training rows */
+            std::size_t numRows;
+
+            /** The fraction of variables which are strictly discrete */
+            double discreteFraction;
+
+            /** The number of levels of each discrete variable */
+            int numLevels;
+
+            /** The probability that a variable depends on each variable generated before it */
+            double density;
+
+            /** Seeds the generator, so that a workload is identical across runs and commits */
+            std::uint64_t seed;
+        };
+
+        /**
+         * A generated training set and the variables describing it
+         */
+        struct Workload
+        {
+            /** The variables, in column order */
+            std::vector<std::shared_ptr<VariableSpecification> > varSpecs;
+
+            /** The training data, with discrete values as level indices */
+            boost::multi_array<double, 2> data;
+
+            /** The parents of each variable in the generating model */
+            std::vector<std::vector<std::size_t> > parents;
+        };
+
+        /**
+         * Generates a training set from a random directed acyclic model. Each variable is a noisy
+         * linear function of randomly chosen earlier variables; discrete variables threshold that 
+         * function into equally likely levels.
+         * @param options Describes the workload
+         * @return The generated workload
+         */
+        Workload generateWorkload(const WorkloadOptions& options);
+    }
+}
+
+#endif
+
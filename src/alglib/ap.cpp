@@ -18,6 +18,8 @@ http://www.fsf.org/licensing/licenses
 *************************************************************************/
 #include "stdafx.h"
 #include "ap.h"
+#include "smp.h"
+#include <atomic>
 #include <limits>
 #include <locale.h>
 using namespace std;
@@ -32,6 +34,10 @@ using namespace std;
 #endif
 #endif
 
+#if defined(AE_HAS_AVX2_INTRINSICS)
+#include <immintrin.h>
+#endif
+
 // disable some irrelevant warnings
 #if (AE_COMPILER==AE_MSVC)
 #pragma warning(disable:4100)
@@ -83,6 +89,8 @@ namespace alglib_impl
 #define x_nb 16
 #define AE_DATA_ALIGN 64
 #define AE_PTR_ALIGN sizeof(void*)
+#define AE_ARENA_CHUNK_SIZE 262144
+#define AE_ARENA_MAX_BLOCK 65536
 #define DYN_BOTTOM ((void*)1)
 #define DYN_FRAME  ((void*)2)
 #define AE_LITTLE_ENDIAN 1
@@ -125,6 +133,12 @@ typedef struct
  */
 ae_int64_t _alloc_counter = 0;
 ae_bool    _use_alloc_counter = ae_false;
+
+/*
+ * allocation counters reported by ae_get_alloc_counters()
+ */
+static std::atomic<ae_int64_t> _ae_heap_allocations(0);
+static std::atomic<ae_int64_t> _ae_arena_chunks(0);
 #ifdef AE_SMP_DEBUGCOUNTERS
 __declspec(align(AE_LOCK_ALIGNMENT)) volatile ae_int64_t _ae_dbg_lock_acquisitions = 0;
 __declspec(align(AE_LOCK_ALIGNMENT)) volatile ae_int64_t _ae_dbg_lock_spinwaits = 0;
@@ -213,6 +227,7 @@ void* aligned_malloc(size_t size, size_t alignment)
             return NULL;
         p = (void**)block;
         *p = block;
+        _ae_heap_allocations.fetch_add(1, std::memory_order_relaxed);
         if( _use_alloc_counter )
         {
 #if AE_OS==AE_WINDOWS
@@ -235,6 +250,7 @@ void* aligned_malloc(size_t size, size_t alignment)
             result += alignment - (result-(char*)0)%alignment;*/
         result = (char*)ae_align(result, alignment);
         *((void**)(result-sizeof(void*))) = block;
+        _ae_heap_allocations.fetch_add(1, std::memory_order_relaxed);
         if( _use_alloc_counter )
         {
 #if AE_OS==AE_WINDOWS
@@ -288,6 +304,180 @@ void ae_free(void *p)
         aligned_free(p);
 }
 
+/************************************************************************
+Per-thread arena.
+
+Memory is carved from a list of chunks of AE_ARENA_CHUNK_SIZE bytes.  The
+position of the arena is a chunk and the number of bytes used in it; when
+a frame is left, the position saved by ae_frame_make() is restored,  and
+chunks past it are reused by later allocations. Chunks are freed when the
+thread exits.
+
+Each block is preceded by AE_DATA_ALIGN bytes which hold its size, so that
+ae_db_promote() can copy it to the heap.
+************************************************************************/
+typedef struct ae_arena_chunk
+{
+    struct ae_arena_chunk *p_next;
+    size_t used;
+} ae_arena_chunk;
+
+struct ae_arena
+{
+    ae_arena() : p_first(NULL), p_current(NULL), allocations(0) { }
+    ~ae_arena()
+    {
+        while( p_first!=NULL )
+        {
+            ae_arena_chunk *p_next = p_first->p_next;
+            aligned_free(p_first);
+            p_first = p_next;
+        }
+    }
+
+    ae_arena_chunk *p_first;
+    ae_arena_chunk *p_current;
+    ae_int64_t allocations;
+};
+
+static thread_local ae_arena _ae_thread_arena;
+static volatile ae_bool _ae_arena_enabled = ae_true;
+
+/************************************************************************
+Arena blocks are released with their frame, so freeing one does nothing.
+************************************************************************/
+static void ae_arena_free(void *p)
+{
+}
+
+/************************************************************************
+Allocates block from the arena of the calling thread.
+
+Returns NULL when the block is too large for the arena or when a new chunk
+can not be allocated; caller should use the heap instead.
+************************************************************************/
+static void* ae_arena_malloc(size_t size)
+{
+    ae_arena *arena = &_ae_thread_arena;
+    ae_arena_chunk *chunk;
+    size_t required;
+    char *result;
+    
+    required = AE_DATA_ALIGN+(size+AE_DATA_ALIGN-1)/AE_DATA_ALIGN*AE_DATA_ALIGN;
+    if( required>AE_ARENA_MAX_BLOCK )
+        return NULL;
+    chunk = arena->p_current;
+    if( chunk==NULL || chunk->used+required>AE_ARENA_CHUNK_SIZE )
+    {
+        /*
+         * move to the next chunk, allocating it if this is the furthest
+         * the arena has grown
+         */
+        ae_arena_chunk *p_next = chunk==NULL ? arena->p_first : chunk->p_next;
+        if( p_next==NULL )
+        {
+            p_next = (ae_arena_chunk*)aligned_malloc(AE_DATA_ALIGN+AE_ARENA_CHUNK_SIZE, AE_DATA_ALIGN);
+            if( p_next==NULL )
+                return NULL;
+            p_next->p_next = NULL;
+            if( chunk==NULL )
+                arena->p_first = p_next;
+            else
+                chunk->p_next = p_next;
+            _ae_arena_chunks.fetch_add(1, std::memory_order_relaxed);
+        }
+        p_next->used = 0;
+        arena->p_current = p_next;
+        chunk = p_next;
+    }
+    result = (char*)chunk+AE_DATA_ALIGN+chunk->used;
+    *((size_t*)result) = size;
+    chunk->used += required;
+    arena->allocations++;
+    return result+AE_DATA_ALIGN;
+}
+
+/************************************************************************
+Allocates memory for automatic dynamic block which belongs to the  top
+frame of the state: from the arena when it is enabled and the block fits,
+from the heap otherwise. Deallocator is stored in the block.
+************************************************************************/
+static void* ae_db_frame_malloc(ae_dyn_block *block, size_t size, ae_state *state)
+{
+    void *result;
+    if( size==0 )
+    {
+        block->deallocator = ae_free;
+        return NULL;
+    }
+    if( _ae_arena_enabled )
+    {
+        result = ae_arena_malloc(size);
+        if( result!=NULL )
+        {
+            block->deallocator = ae_arena_free;
+            return result;
+        }
+    }
+    block->deallocator = ae_free;
+    return ae_malloc(size, state);
+}
+
+/************************************************************************
+Returns true if block is attached to the top frame of the state, i.e. it
+will be released no later than the arena is reset by ae_frame_leave().
+************************************************************************/
+static ae_bool ae_db_in_top_frame(ae_dyn_block *block, ae_state *state)
+{
+    ae_dyn_block *p;
+    if( state==NULL || state->p_top_frame==NULL )
+        return ae_false;
+    for(p=state->p_top_block; p!=&state->p_top_frame->db_marker; p=p->p_next)
+        if( p==block )
+            return ae_true;
+    return ae_false;
+}
+
+/************************************************************************
+Moves arena-allocated block to the heap, so that it may outlive its frame.
+
+Returns size of the block, and its old location in p_old (the old copy is
+valid until the frame is left), or zero if the block was not moved.
+************************************************************************/
+static size_t ae_db_promote(ae_dyn_block *block, void **p_old)
+{
+    void *p;
+    size_t size;
+    if( block->ptr==NULL || block->deallocator!=ae_arena_free )
+        return 0;
+    size = *((size_t*)((char*)block->ptr-AE_DATA_ALIGN));
+    p = aligned_malloc(size, AE_DATA_ALIGN);
+    if( p==NULL )
+        abort();
+    memcpy(p, block->ptr, size);
+    *p_old = block->ptr;
+    block->ptr = p;
+    block->deallocator = ae_free;
+    return size;
+}
+
+void ae_set_arena_enabled(ae_bool enabled)
+{
+    _ae_arena_enabled = enabled;
+}
+
+ae_bool ae_get_arena_enabled()
+{
+    return _ae_arena_enabled;
+}
+
+void ae_get_alloc_counters(ae_alloc_counters *counters)
+{
+    counters->heap_allocations = _ae_heap_allocations.load(std::memory_order_relaxed);
+    counters->arena_chunks = _ae_arena_chunks.load(std::memory_order_relaxed);
+    counters->arena_allocations = _ae_thread_arena.allocations;
+}
+
 /************************************************************************
 Sets pointers to the matrix rows.
 
@@ -369,6 +559,7 @@ void ae_state_init(ae_state *state)
     state->last_block.deallocator = NULL;
     state->last_block.ptr = DYN_BOTTOM;
     state->p_top_block = &(state->last_block);
+    state->p_top_frame = NULL;
 #ifndef AE_USE_CPP_ERROR_HANDLING
     state->break_jump = NULL;
 #endif
@@ -446,19 +637,29 @@ dynamic block which will be used as indicator  of  the  frame  beginning.
 This dynamic block must be initialized by caller and mustn't  be changed/
 deallocated/reused till ae_leave_frame called. It may be global or  local
 variable (local is even better).
+
+Current position of the thread's arena is saved in the frame.
 ************************************************************************/
 void ae_frame_make(ae_state *state, ae_frame *tmp)
 {
+    ae_arena *arena = &_ae_thread_arena;
     tmp->db_marker.p_next = state->p_top_block;
     tmp->db_marker.deallocator = NULL;
     tmp->db_marker.ptr = DYN_FRAME;
+    tmp->p_prev_frame = state->p_top_frame;
+    tmp->p_arena_chunk = arena->p_current;
+    tmp->arena_used = arena->p_current!=NULL ? arena->p_current->used : 0;
     state->p_top_block = &tmp->db_marker;
+    state->p_top_frame = tmp;
 }
 
 
 /************************************************************************
 This function leaves current stack frame and deallocates all automatic
 dynamic blocks which were attached to this frame.
+
+Arena of the calling thread is rewound to the position saved when the
+frame was made, which releases all arena blocks of this frame at once.
 ************************************************************************/
 void ae_frame_leave(ae_state *state)
 {
@@ -468,6 +669,15 @@ void ae_frame_leave(ae_state *state)
             ((ae_deallocator)(state->p_top_block->deallocator))(state->p_top_block->ptr);
         state->p_top_block = state->p_top_block->p_next;
     }
+    if( state->p_top_block->ptr==DYN_FRAME )
+    {
+        ae_frame *frame = (ae_frame*)state->p_top_block;
+        ae_arena *arena = &_ae_thread_arena;
+        arena->p_current = (ae_arena_chunk*)frame->p_arena_chunk;
+        if( arena->p_current!=NULL )
+            arena->p_current->used = frame->arena_used;
+        state->p_top_frame = frame->p_prev_frame;
+    }
     state->p_top_block = state->p_top_block->p_next;
 }
 
@@ -515,8 +725,14 @@ ae_bool ae_db_malloc(ae_dyn_block *block, ae_int_t size, ae_state *state, ae_boo
     if( size<0 )
         return ae_false;
     
-    /* allocation */
-    block->ptr = ae_malloc((size_t)size, state);
+    /* allocation; automatic blocks of a frame may come from the arena */
+    if( make_automatic && state!=NULL && state->p_top_frame!=NULL )
+        block->ptr = ae_db_frame_malloc(block, (size_t)size, state);
+    else
+    {
+        block->ptr = ae_malloc((size_t)size, state);
+        block->deallocator = ae_free;
+    }
     if( block->ptr==NULL && size!=0 )
     {
         /* for state!=NULL exception is thrown from ae_malloc(), so
@@ -527,7 +743,6 @@ ae_bool ae_db_malloc(ae_dyn_block *block, ae_int_t size, ae_state *state, ae_boo
         ae_db_attach(block, state);
     else
         block->p_next = NULL;
-    block->deallocator = ae_free;
     return ae_true;
 }
 
@@ -562,17 +777,23 @@ ae_bool ae_db_realloc(ae_dyn_block *block, ae_int_t size, ae_state *state)
     if( size<0 )
         return ae_false;
     
-    /* realloc */
+    /* realloc; blocks of the top frame may come from the arena */
     if( block->ptr!=NULL )
         ((ae_deallocator)block->deallocator)(block->ptr);
-    block->ptr = ae_malloc((size_t)size, state);
+    block->ptr = NULL;
+    if( ae_db_in_top_frame(block, state) )
+        block->ptr = ae_db_frame_malloc(block, (size_t)size, state);
+    else
+    {
+        block->ptr = ae_malloc((size_t)size, state);
+        block->deallocator = ae_free;
+    }
     if( block->ptr==NULL && size!=0 )
     {
         /* for state!=NULL exception is thrown from ae_malloc(), so
            we have to handle only situation when state is NULL */
         return ae_false;
     }
-    block->deallocator = ae_free;
     return ae_true;
 }
 
@@ -821,7 +1042,13 @@ void ae_swap_vectors(ae_vector *vec1, ae_vector *vec2)
     ae_int_t cnt;
     ae_datatype datatype;
     void *p_ptr;
+    void *p_old;
     
+    /* arena blocks may be swapped into vectors of outer frames */
+    if( ae_db_promote(&vec1->data, &p_old)!=0 )
+        vec1->ptr.p_ptr = vec1->data.ptr;
+    if( ae_db_promote(&vec2->data, &p_old)!=0 )
+        vec2->ptr.p_ptr = vec2->data.ptr;
     ae_db_swap(&vec1->data, &vec2->data);
     
     cnt = vec1->cnt;
@@ -1096,6 +1323,28 @@ void ae_matrix_destroy(ae_matrix *dst)
 }
 
 
+/************************************************************************
+Moves matrix storage from the arena to the heap. Row pointers which point
+into the storage itself are moved with it; ones which point to external
+memory (matrices attached to x_matrix) are left unchanged.
+************************************************************************/
+static void ae_matrix_promote(ae_matrix *mat)
+{
+    char *p_old;
+    size_t size;
+    ae_int_t i;
+    void **pp;
+    
+    size = ae_db_promote(&mat->data, (void**)&p_old);
+    if( size==0 || mat->ptr.pp_void==NULL )
+        return;
+    pp = (void**)mat->data.ptr;
+    mat->ptr.pp_void = pp;
+    for(i=0; i<mat->rows; i++)
+        if( (char*)pp[i]>=p_old && (char*)pp[i]<p_old+size )
+            pp[i] = (char*)mat->data.ptr+((char*)pp[i]-p_old);
+}
+
 /************************************************************************
 This function efficiently swaps contents of two vectors, leaving other
 pararemeters (automatic management, etc.) unchanged.
@@ -1108,6 +1357,9 @@ void ae_swap_matrices(ae_matrix *mat1, ae_matrix *mat2)
     ae_datatype datatype;
     void *p_ptr;
     
+    /* arena blocks may be swapped into matrices of outer frames */
+    ae_matrix_promote(mat1);
+    ae_matrix_promote(mat2);
     ae_db_swap(&mat1->data, &mat2->data);
     
     rows = mat1->rows;
@@ -1480,7 +1732,8 @@ CPUID
 Returns information about features CPU and compiler support.
 
 You must tell ALGLIB what CPU family is used by defining AE_CPU symbol
-(without this hint zero will be returned).
+(without this hint CPU_SSE2 will not be returned). CPU_AVX2 and CPU_FMA
+are detected whenever AE_HAS_AVX2_INTRINSICS is defined.
 
 Note: results of this function depend on both CPU and compiler;
 if compiler doesn't support SSE intrinsics, function won't set 
@@ -1488,6 +1741,8 @@ corresponding flag.
 ************************************************************************/
 static volatile ae_bool _ae_cpuid_initialized = ae_false;
 static volatile ae_bool _ae_cpuid_has_sse2 = ae_false;
+static volatile ae_bool _ae_cpuid_has_avx2 = ae_false;
+static volatile ae_bool _ae_cpuid_has_fma = ae_false;
 ae_int_t ae_cpuid()
 {
     /*
@@ -1535,6 +1790,14 @@ ae_int_t ae_cpuid()
 #else
 #endif
 #endif
+#endif
+        /*
+         * AVX2 and FMA; the builtin also checks that the OS saves YMM registers
+         */
+#if defined(AE_HAS_AVX2_INTRINSICS)
+        __builtin_cpu_init();
+        _ae_cpuid_has_avx2 = __builtin_cpu_supports("avx2") ? ae_true : ae_false;
+        _ae_cpuid_has_fma = __builtin_cpu_supports("fma") ? ae_true : ae_false;
 #endif
         /*
          * set initialization flag
@@ -1548,6 +1811,10 @@ ae_int_t ae_cpuid()
     result = 0;
     if( _ae_cpuid_has_sse2 )
         result = result|CPU_SSE2;
+    if( _ae_cpuid_has_avx2 )
+        result = result|CPU_AVX2;
+    if( _ae_cpuid_has_fma )
+        result = result|CPU_FMA;
     return result;
 }
 
@@ -4570,6 +4837,68 @@ void ae_v_cmulc(ae_complex *vdst, ae_int_t stride_dst, ae_int_t n, ae_complex al
     }
 }
 
+/************************************************************************
+AVX2/FMA kernels for the unit-stride cases of the real BLAS operations.
+
+They are used for vectors of at least AE_AVX2_MIN_LENGTH elements, when
+ae_cpuid() reports both CPU_AVX2 and CPU_FMA. Fused multiply-adds round
+once per term, so results may differ from the generic code in the last
+bits.
+************************************************************************/
+#if defined(AE_HAS_AVX2_INTRINSICS)
+#define AE_AVX2_MIN_LENGTH 8
+
+static ae_bool ae_has_avx2_fma()
+{
+    return (ae_cpuid()&(CPU_AVX2|CPU_FMA))==(CPU_AVX2|CPU_FMA);
+}
+
+AE_AVX2_TARGET static double ae_v_dotproduct_avx2(const double *v0, const double *v1, ae_int_t n)
+{
+    ae_int_t i;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m128d h;
+    double result;
+    for(i=0; i+8<=n; i+=8)
+    {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(v0+i), _mm256_loadu_pd(v1+i), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(v0+i+4), _mm256_loadu_pd(v1+i+4), s1);
+    }
+    if( i+4<=n )
+    {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(v0+i), _mm256_loadu_pd(v1+i), s0);
+        i += 4;
+    }
+    s0 = _mm256_add_pd(s0, s1);
+    h = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+    result = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    for(; i<n; i++)
+        result += v0[i]*v1[i];
+    return result;
+}
+
+AE_AVX2_TARGET static void ae_v_moved_avx2(double *vdst, const double *vsrc, ae_int_t n, double alpha)
+{
+    ae_int_t i;
+    __m256d va = _mm256_set1_pd(alpha);
+    for(i=0; i+4<=n; i+=4)
+        _mm256_storeu_pd(vdst+i, _mm256_mul_pd(va, _mm256_loadu_pd(vsrc+i)));
+    for(; i<n; i++)
+        vdst[i] = alpha*vsrc[i];
+}
+
+AE_AVX2_TARGET static void ae_v_addd_avx2(double *vdst, const double *vsrc, ae_int_t n, double alpha)
+{
+    ae_int_t i;
+    __m256d va = _mm256_set1_pd(alpha);
+    for(i=0; i+4<=n; i+=4)
+        _mm256_storeu_pd(vdst+i, _mm256_fmadd_pd(va, _mm256_loadu_pd(vsrc+i), _mm256_loadu_pd(vdst+i)));
+    for(; i<n; i++)
+        vdst[i] += alpha*vsrc[i];
+}
+#endif
+
 /************************************************************************
 Real BLAS operations
 ************************************************************************/
@@ -4587,6 +4916,10 @@ double ae_v_dotproduct(const double *v0, ae_int_t stride0, const double *v1, ae_
     }
     else
     {
+#if defined(AE_HAS_AVX2_INTRINSICS)
+        if( n>=AE_AVX2_MIN_LENGTH && ae_has_avx2_fma() )
+            return ae_v_dotproduct_avx2(v0, v1, n);
+#endif
         /*
          * optimized code for stride=1
          */
@@ -4667,6 +5000,13 @@ void ae_v_moved(double *vdst,  ae_int_t stride_dst, const double* vsrc,  ae_int_
     }
     else
     {
+#if defined(AE_HAS_AVX2_INTRINSICS)
+        if( n>=AE_AVX2_MIN_LENGTH && ae_has_avx2_fma() )
+        {
+            ae_v_moved_avx2(vdst, vsrc, n, alpha);
+            return;
+        }
+#endif
         /*
          * optimized case
          */
@@ -4721,6 +5061,13 @@ void ae_v_addd(double *vdst,    ae_int_t stride_dst, const double *vsrc,  ae_int
     }
     else
     {
+#if defined(AE_HAS_AVX2_INTRINSICS)
+        if( n>=AE_AVX2_MIN_LENGTH && ae_has_avx2_fma() )
+        {
+            ae_v_addd_avx2(vdst, vsrc, n, alpha);
+            return;
+        }
+#endif
         /*
          * optimized case
          */
@@ -5207,9 +5554,7 @@ alglib::complex alglib::csqr(const alglib::complex &z)
 
 void alglib::setnworkers(alglib::ae_int_t nworkers)
 {
-#ifdef AE_HPC
     alglib_impl::ae_set_cores_to_use(nworkers);
-#endif
 }
 
 /********************************************************************
@@ -8259,6 +8604,80 @@ void _ialglib_rmv(ae_int_t m, ae_int_t n, const double *a, const double *x, doub
 }
 
 
+/*************************************************************************
+This function calculates MxN real matrix-vector product:
+
+    y := beta*y + alpha*A*x
+
+using AVX2 and FMA. Four rows of A are multiplied at once, each with its
+own vector accumulator. Special cases (zero M, N or alpha) are passed to
+the generic code.
+
+IMPORTANT:
+* 0<=M<=alglib_r_block, 0<=N<=alglib_r_block
+* A must be stored in row-major order with stride equal to alglib_r_block
+* A, x and y may be non-aligned
+
+This function may be called only when ae_cpuid() result contains both
+CPU_AVX2 and CPU_FMA.
+*************************************************************************/
+#if defined(AE_HAS_AVX2_INTRINSICS)
+AE_AVX2_TARGET void _ialglib_rmv_avx2(ae_int_t m, ae_int_t n, const double *a, const double *x, double *y, ae_int_t stride, double alpha, double beta)
+{
+    ae_int_t i, k;
+    double v[4];
+
+    if( m==0 || n==0 || alpha==0.0 )
+    {
+        _ialglib_rmv(m, n, a, x, y, stride, alpha, beta);
+        return;
+    }
+    for(i=0; i<m; i+=4)
+    {
+        ae_int_t j, rows = m-i<4 ? m-i : 4;
+        const double *pa0 = a+i*alglib_r_block;
+        const double *pa1 = rows>1 ? pa0+alglib_r_block : pa0;
+        const double *pa2 = rows>2 ? pa0+2*alglib_r_block : pa0;
+        const double *pa3 = rows>3 ? pa0+3*alglib_r_block : pa0;
+        __m256d v0 = _mm256_setzero_pd();
+        __m256d v1 = _mm256_setzero_pd();
+        __m256d v2 = _mm256_setzero_pd();
+        __m256d v3 = _mm256_setzero_pd();
+        __m256d t0, t1;
+        for(k=0; k+4<=n; k+=4)
+        {
+            __m256d vx = _mm256_loadu_pd(x+k);
+            v0 = _mm256_fmadd_pd(_mm256_loadu_pd(pa0+k), vx, v0);
+            v1 = _mm256_fmadd_pd(_mm256_loadu_pd(pa1+k), vx, v1);
+            v2 = _mm256_fmadd_pd(_mm256_loadu_pd(pa2+k), vx, v2);
+            v3 = _mm256_fmadd_pd(_mm256_loadu_pd(pa3+k), vx, v3);
+        }
+        
+        /*
+         * horizontal sums of the four accumulators, in row order
+         */
+        t0 = _mm256_hadd_pd(v0, v1);
+        t1 = _mm256_hadd_pd(v2, v3);
+        _mm256_storeu_pd(v, _mm256_add_pd(_mm256_permute2f128_pd(t0, t1, 0x21), _mm256_blend_pd(t0, t1, 0xC)));
+        for(; k<n; k++)
+        {
+            v[0] += pa0[k]*x[k];
+            v[1] += pa1[k]*x[k];
+            v[2] += pa2[k]*x[k];
+            v[3] += pa3[k]*x[k];
+        }
+        for(j=0; j<rows; j++, y+=stride)
+        {
+            if( beta!=0 )
+                y[0] = beta*y[0]+alpha*v[j];
+            else
+                y[0] = alpha*v[j];
+        }
+    }
+}
+#endif
+
+
 /*************************************************************************
 This function calculates MxN real matrix-vector product:
 
@@ -9332,6 +9751,10 @@ ae_bool _ialglib_rmatrixgemm(ae_int_t m,
         mcopyblock = &_ialglib_mcopyblock_sse2;
     }
 #endif
+#ifdef AE_HAS_AVX2_INTRINSICS
+    if( (ae_cpuid()&(CPU_AVX2|CPU_FMA))==(CPU_AVX2|CPU_FMA) )
+        rmv = &_ialglib_rmv_avx2;
+#endif
     
     /*
      * copy b
@@ -9599,6 +10022,10 @@ ae_bool _ialglib_rmatrixrighttrsm(ae_int_t m,
         mcopyblock = &_ialglib_mcopyblock_sse2;
     }    
 #endif
+#ifdef AE_HAS_AVX2_INTRINSICS
+    if( (ae_cpuid()&(CPU_AVX2|CPU_FMA))==(CPU_AVX2|CPU_FMA) )
+        rmv = &_ialglib_rmv_avx2;
+#endif
     
     /*
      * Prepare
@@ -9780,6 +10207,10 @@ ae_bool _ialglib_rmatrixlefttrsm(ae_int_t m,
         mcopyblock = &_ialglib_mcopyblock_sse2;
     }    
 #endif
+#ifdef AE_HAS_AVX2_INTRINSICS
+    if( (ae_cpuid()&(CPU_AVX2|CPU_FMA))==(CPU_AVX2|CPU_FMA) )
+        rmv = &_ialglib_rmv_avx2;
+#endif
     
     /*
      * Prepare
@@ -125,6 +125,20 @@ http://www.fsf.org/licensing/licenses
 #endif
 #endif
 
+/*
+ * AVX2/FMA intrinsics
+ *
+ * AE_HAS_AVX2_INTRINSICS is defined when the compiler can build functions
+ * for AVX2 and FMA with a target attribute, leaving the rest of the library
+ * on the baseline instruction set. Such functions are called only when
+ * ae_cpuid() reports both CPU_AVX2 and CPU_FMA at run-time. Define
+ * AE_NO_AVX2 to leave them out.
+ */
+#if AE_COMPILER==AE_GNUC && (defined(__x86_64__) || defined(__i386__)) && !defined(AE_NO_AVX2)
+#define AE_HAS_AVX2_INTRINSICS
+#define AE_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
 
 
 /////////////////////////////////////////////////////////////////////////
@@ -210,7 +224,7 @@ typedef ae_int_t ae_datatype;
 enum { OWN_CALLER=1, OWN_AE=2 };
 enum { ACT_UNCHANGED=1, ACT_SAME_LOCATION=2, ACT_NEW_LOCATION=3 };
 enum { DT_BOOL=1, DT_INT=2, DT_REAL=3, DT_COMPLEX=4 };
-enum { CPU_SSE2=1 };
+enum { CPU_SSE2=1, CPU_AVX2=2, CPU_FMA=4 };
 
 /************************************************************************
 x-string (zero-terminated):
@@ -333,6 +347,14 @@ frame marker
 typedef struct ae_frame
 {
     ae_dyn_block db_marker;
+    
+    /*
+     * enclosing frame of the same state, and position of the thread's
+     * arena when this frame was made (restored when it is left)
+     */
+    struct ae_frame *p_prev_frame;
+    void *p_arena_chunk;
+    size_t arena_used;
 } ae_frame;
 
 /************************************************************************
@@ -367,6 +389,11 @@ typedef struct ae_state
     ae_dyn_block * volatile p_top_block;
     ae_dyn_block last_block;
     
+    /*
+     * innermost frame, NULL when no frame was made
+     */
+    ae_frame * volatile p_top_frame;
+    
     /*
      * jmp_buf for cases when C-style exception handling is used
      */
@@ -579,6 +606,35 @@ ae_bool ae_db_realloc(ae_dyn_block *block, ae_int_t size, ae_state *state);
 void ae_db_free(ae_dyn_block *block);
 void ae_db_swap(ae_dyn_block *block1, ae_dyn_block *block2);
 
+/************************************************************************
+Per-thread arena for automatic dynamic blocks
+
+Blocks which are attached to the innermost frame of a state are carved
+out of an arena owned by the calling thread instead of being malloc'ed,
+and the whole frame is released at once by ae_frame_leave(). Chunks of
+the arena are kept for reuse, so a function which is called repeatedly
+stops allocating once its first call has grown the arena.
+
+A state must be used by one thread only, and frames must be left in the
+reverse order they were made (which is how generated code uses them).
+Blocks larger than 64 KB, non-automatic blocks and
+blocks moved between vectors/matrices by ae_swap_XXX() use the heap.
+
+ae_get_alloc_counters() reports heap allocations made by ALGLIB and
+arena chunks allocated by all threads, and arena allocations made by
+the calling thread.
+************************************************************************/
+typedef struct
+{
+    ae_int64_t heap_allocations;
+    ae_int64_t arena_chunks;
+    ae_int64_t arena_allocations;
+} ae_alloc_counters;
+
+void ae_set_arena_enabled(ae_bool enabled);
+ae_bool ae_get_arena_enabled();
+void ae_get_alloc_counters(ae_alloc_counters *counters);
+
 ae_bool ae_vector_init(ae_vector *dst, ae_int_t size, ae_datatype datatype, ae_state *state, ae_bool make_automatic);
 ae_bool ae_vector_init_copy(ae_vector *dst, ae_vector *src, ae_state *state, ae_bool make_automatic);
 void ae_vector_init_from_x(ae_vector *dst, x_vector *src, ae_state *state, ae_bool make_automatic);
@@ -9628,6 +9628,8 @@ static void dforest_dfprocessinternal(decisionforest* df,
      /* Real    */ ae_vector* x,
      /* Real    */ ae_vector* y,
      ae_state *_state);
+static dftreestarthook dforest_treestarthook = NULL;
+static dftreefinishhook dforest_treefinishhook = NULL;
 static void dforest_dfbuildtree(/* Real    */ ae_matrix* xy,
      ae_int_t npoints,
      ae_int_t nvars,
@@ -13797,6 +13799,19 @@ void dfbuildrandomdecisionforestx1(/* Real    */ ae_matrix* xy,
 }
 
 
+/*************************************************************************
+Sets optional hooks called by DFBuildInternal before and after each tree is
+built, e.g. to profile training. The value returned by OnStart is passed to
+OnFinish. Either may be NULL. Hooks should be set before any forest is built.
+*************************************************************************/
+void dfsettreehooks(dftreestarthook onstart,
+     dftreefinishhook onfinish)
+{
+    dforest_treestarthook = onstart;
+    dforest_treefinishhook = onfinish;
+}
+
+
 void dfbuildinternal(/* Real    */ ae_matrix* xy,
      ae_int_t npoints,
      ae_int_t nvars,
@@ -13835,6 +13850,7 @@ void dfbuildinternal(/* Real    */ ae_matrix* xy,
     double vmax;
     ae_bool bflag;
     hqrndstate rs;
+    ae_int64_t treestart;
 
     ae_frame_make(_state, &_frame_block);
     *info = 0;
@@ -14028,7 +14044,12 @@ void dfbuildinternal(/* Real    */ ae_matrix* xy,
         /*
          * build tree, copy
          */
+        treestart = dforest_treestarthook!=NULL ? dforest_treestarthook() : 0;
         dforest_dfbuildtree(&xys, samplesize, nvars, nclasses, nfeatures, nvarsinpool, flags, &bufs, &rs, _state);
+        if( dforest_treefinishhook!=NULL )
+        {
+            dforest_treefinishhook(treestart);
+        }
         j = ae_round(bufs.treebuf.ptr.p_double[0], _state);
         ae_v_move(&df->trees.ptr.p_double[offs], 1, &bufs.treebuf.ptr.p_double[0], 1, ae_v_len(offs,offs+j-1));
         lasttreeoffs = offs;
@@ -6292,6 +6292,10 @@ void dfbuildrandomdecisionforestx1(/* Real    */ ae_matrix* xy,
      decisionforest* df,
      dfreport* rep,
      ae_state *_state);
+typedef ae_int64_t (*dftreestarthook)(void);
+typedef void (*dftreefinishhook)(ae_int64_t started);
+void dfsettreehooks(dftreestarthook onstart,
+     dftreefinishhook onfinish);
 void dfbuildinternal(/* Real    */ ae_matrix* xy,
      ae_int_t npoints,
      ae_int_t nvars,
@@ -18,6 +18,7 @@ http://www.fsf.org/licensing/licenses
 *************************************************************************/
 #include "stdafx.h"
 #include "linalg.h"
+#include "smp.h"
 
 // disable some irrelevant warnings
 #if (AE_COMPILER==AE_MSVC)
@@ -8618,7 +8619,8 @@ void rmatrixrighttrsm(ae_int_t m,
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version of RMatrixRightTRSM(): rows of X are independent, so  they
+are split recursively between threads of the SMP pool.
 *************************************************************************/
 void _pexec_rmatrixrighttrsm(ae_int_t m,
     ae_int_t n,
@@ -8632,7 +8634,19 @@ void _pexec_rmatrixrighttrsm(ae_int_t m,
     ae_int_t i2,
     ae_int_t j2, ae_state *_state)
 {
-    rmatrixrighttrsm(m,n,a,i1,j1,isupper,isunit,optype,x,i2,j2, _state);
+    ae_int_t s1;
+    ae_int_t s2;
+
+    if( m<=ablasblocksize(a, _state)||!ae_smp_worthwhile(inttoreal(m, _state)*inttoreal(n, _state)*inttoreal(n, _state)) )
+    {
+        rmatrixrighttrsm(m,n,a,i1,j1,isupper,isunit,optype,x,i2,j2, _state);
+        return;
+    }
+    ablassplitlength(x, m, &s1, &s2, _state);
+    ae_smp_invoke(
+        [=](ae_state *s) { _pexec_rmatrixrighttrsm(s1,n,a,i1,j1,isupper,isunit,optype,x,i2,j2, s); },
+        [=](ae_state *s) { _pexec_rmatrixrighttrsm(s2,n,a,i1,j1,isupper,isunit,optype,x,i2+s1,j2, s); },
+        _state);
 }
 
 
@@ -8734,7 +8748,8 @@ void rmatrixlefttrsm(ae_int_t m,
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version of RMatrixLeftTRSM(): columns of X are independent,  so
+they are split recursively between threads of the SMP pool.
 *************************************************************************/
 void _pexec_rmatrixlefttrsm(ae_int_t m,
     ae_int_t n,
@@ -8748,7 +8763,19 @@ void _pexec_rmatrixlefttrsm(ae_int_t m,
     ae_int_t i2,
     ae_int_t j2, ae_state *_state)
 {
-    rmatrixlefttrsm(m,n,a,i1,j1,isupper,isunit,optype,x,i2,j2, _state);
+    ae_int_t s1;
+    ae_int_t s2;
+
+    if( n<=ablasblocksize(a, _state)||!ae_smp_worthwhile(inttoreal(m, _state)*inttoreal(m, _state)*inttoreal(n, _state)) )
+    {
+        rmatrixlefttrsm(m,n,a,i1,j1,isupper,isunit,optype,x,i2,j2, _state);
+        return;
+    }
+    ablassplitlength(x, n, &s1, &s2, _state);
+    ae_smp_invoke(
+        [=](ae_state *s) { _pexec_rmatrixlefttrsm(m,s1,a,i1,j1,isupper,isunit,optype,x,i2,j2, s); },
+        [=](ae_state *s) { _pexec_rmatrixlefttrsm(m,s2,a,i1,j1,isupper,isunit,optype,x,i2,j2+s1, s); },
+        _state);
 }
 
 
@@ -8949,7 +8976,10 @@ void rmatrixsyrk(ae_int_t n,
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version of RMatrixSYRK(). N is split  recursively  as  in  the
+serial code: the diagonal blocks of C and the off-diagonal block computed
+by GEMM are independent, so they are solved by threads of the SMP pool.
+Splits on K accumulate into the same block of C and remain serial.
 *************************************************************************/
 void _pexec_rmatrixsyrk(ae_int_t n,
     ae_int_t k,
@@ -8964,7 +8994,38 @@ void _pexec_rmatrixsyrk(ae_int_t n,
     ae_int_t jc,
     ae_bool isupper, ae_state *_state)
 {
-    rmatrixsyrk(n,k,alpha,a,ia,ja,optypea,beta,c,ic,jc,isupper, _state);
+    ae_int_t s1;
+    ae_int_t s2;
+
+    if( n<=ablasblocksize(a, _state)||!ae_smp_worthwhile(inttoreal(n, _state)*inttoreal(n, _state)*inttoreal(k, _state)) )
+    {
+        rmatrixsyrk(n,k,alpha,a,ia,ja,optypea,beta,c,ic,jc,isupper, _state);
+        return;
+    }
+    
+    /*
+     * Split N: the first diagonal block and the off-diagonal block
+     * are solved alongside the second diagonal block.
+     */
+    ablassplitlength(a, n, &s1, &s2, _state);
+    ae_int_t ia2 = optypea==0 ? ia+s1 : ia;
+    ae_int_t ja2 = optypea==0 ? ja : ja+s1;
+    ae_smp_invoke(
+        [=](ae_state *s)
+        {
+            ae_smp_invoke(
+                [=](ae_state *s) { _pexec_rmatrixsyrk(s1,k,alpha,a,ia,ja,optypea,beta,c,ic,jc,isupper, s); },
+                [=](ae_state *s)
+                {
+                    if( isupper )
+                        _pexec_rmatrixgemm(s1,s2,k,alpha,a,ia,ja,optypea,a,ia2,ja2,optypea==0 ? 1 : 0,beta,c,ic,jc+s1, s);
+                    else
+                        _pexec_rmatrixgemm(s2,s1,k,alpha,a,ia2,ja2,optypea,a,ia,ja,optypea==0 ? 1 : 0,beta,c,ic+s1,jc, s);
+                },
+                s);
+        },
+        [=](ae_state *s) { _pexec_rmatrixsyrk(s2,k,alpha,a,ia2,ja2,optypea,beta,c,ic+s1,jc+s1,isupper, s); },
+        _state);
 }
 
 
@@ -9228,7 +9289,10 @@ void rmatrixgemm(ae_int_t m,
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version of RMatrixGEMM(). The larger of M and N is split
+recursively down to the ABLAS block size, and the halves, which  write
+disjoint blocks of C, are solved by threads of the SMP pool. Splits on K
+accumulate into the same block of C, so they are left to the serial code.
 *************************************************************************/
 void _pexec_rmatrixgemm(ae_int_t m,
     ae_int_t n,
@@ -9247,7 +9311,46 @@ void _pexec_rmatrixgemm(ae_int_t m,
     ae_int_t ic,
     ae_int_t jc, ae_state *_state)
 {
-    rmatrixgemm(m,n,k,alpha,a,ia,ja,optypea,b,ib,jb,optypeb,beta,c,ic,jc, _state);
+    ae_int_t s1;
+    ae_int_t s2;
+    ae_int_t bs;
+
+    bs = ablasblocksize(a, _state);
+    if( (m<=bs&&n<=bs)||!ae_smp_worthwhile(2*inttoreal(m, _state)*inttoreal(n, _state)*inttoreal(k, _state)) )
+    {
+        rmatrixgemm(m,n,k,alpha,a,ia,ja,optypea,b,ib,jb,optypeb,beta,c,ic,jc, _state);
+        return;
+    }
+    ae_assert(ic+m<=c->rows, "RMatrixGEMM: incorect size of output matrix C", _state);
+    ae_assert(jc+n<=c->cols, "RMatrixGEMM: incorect size of output matrix C", _state);
+    if( m>=n )
+    {
+        
+        /*
+         * A*B = (A1 A2)^T*B
+         */
+        ablassplitlength(a, m, &s1, &s2, _state);
+        ae_int_t ia2 = optypea==0 ? ia+s1 : ia;
+        ae_int_t ja2 = optypea==0 ? ja : ja+s1;
+        ae_smp_invoke(
+            [=](ae_state *s) { _pexec_rmatrixgemm(s1,n,k,alpha,a,ia,ja,optypea,b,ib,jb,optypeb,beta,c,ic,jc, s); },
+            [=](ae_state *s) { _pexec_rmatrixgemm(s2,n,k,alpha,a,ia2,ja2,optypea,b,ib,jb,optypeb,beta,c,ic+s1,jc, s); },
+            _state);
+    }
+    else
+    {
+        
+        /*
+         * A*B = A*(B1 B2)
+         */
+        ablassplitlength(a, n, &s1, &s2, _state);
+        ae_int_t ib2 = optypeb==0 ? ib : ib+s1;
+        ae_int_t jb2 = optypeb==0 ? jb+s1 : jb;
+        ae_smp_invoke(
+            [=](ae_state *s) { _pexec_rmatrixgemm(m,s1,k,alpha,a,ia,ja,optypea,b,ib,jb,optypeb,beta,c,ic,jc, s); },
+            [=](ae_state *s) { _pexec_rmatrixgemm(m,s2,k,alpha,a,ia,ja,optypea,b,ib2,jb2,optypeb,beta,c,ic,jc+s1, s); },
+            _state);
+    }
 }
 
 
@@ -0,0 +1,278 @@
+/*************************************************************************
+Thread pool which executes the _pexec_* (SMP) entry points of ALGLIB.
+
+Each worker owns a deque of tasks: it pushes and pops tasks at the back,
+while idle threads steal from the front of other deques, taking the
+largest pending subproblems of a recursive split. Threads outside the
+pool submit tasks through a shared queue.
+*************************************************************************/
+#include "stdafx.h"
+#include "smp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace alglib_impl
+{
+
+namespace
+{
+
+/*************************************************************************
+Task submitted to the pool, owned by the thread which waits for it.
+*************************************************************************/
+struct smp_job
+{
+    smp_job(const ae_smp_task &task) : task(task), done(false), failed(false), error(ERR_ASSERTION_FAILED), msg("") { }
+
+    const ae_smp_task &task;
+    std::atomic<bool> done;
+    bool failed;
+    ae_error_type error;
+    const char *msg;
+};
+
+/*************************************************************************
+Runs a task with an environment state of its own, recording its error.
+*************************************************************************/
+void smp_run(smp_job &job)
+{
+    ae_state state;
+    ae_state_init(&state);
+    try
+    {
+        job.task(&state);
+        ae_state_clear(&state);
+    }
+    catch(ae_error_type error)
+    {
+        job.failed = true;
+        job.error = error;
+        job.msg = state.error_msg;
+    }
+    catch(...)
+    {
+        ae_state_clear(&state);
+        job.failed = true;
+        job.error = ERR_OUT_OF_MEMORY;
+        job.msg = "ae_smp_invoke(): unexpected exception in parallel task";
+    }
+    job.done.store(true, std::memory_order_release);
+}
+
+/*************************************************************************
+Deque of tasks owned by one worker.
+*************************************************************************/
+struct smp_queue
+{
+    std::mutex mutex;
+    std::deque<smp_job*> jobs;
+};
+
+class smp_pool;
+
+/* the pool and queue of the current thread, if it is a worker */
+thread_local smp_pool *current_pool = NULL;
+thread_local ae_int_t current_worker = -1;
+
+class smp_pool
+{
+public:
+    smp_pool(ae_int_t nworkers) : queues(nworkers), pending(0), stopping(false)
+    {
+        for(ae_int_t i=0; i<nworkers; i++)
+            queues[i].reset(new smp_queue());
+        for(ae_int_t i=0; i<nworkers; i++)
+            workers.push_back(std::thread(&smp_pool::work, this, i));
+    }
+
+    ~smp_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(size_t i=0; i<workers.size(); i++)
+            workers[i].join();
+    }
+
+    ae_int_t size() const
+    {
+        return (ae_int_t)workers.size();
+    }
+
+    void push(smp_job *job)
+    {
+        if( current_pool==this )
+        {
+            std::lock_guard<std::mutex> lock(queues[current_worker]->mutex);
+            queues[current_worker]->jobs.push_back(job);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.jobs.push_back(job);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            pending++;
+        }
+        wake.notify_one();
+        progress.notify_all();
+    }
+
+    /* runs one queued task, returning False if there was none */
+    bool run_one()
+    {
+        smp_job *job = NULL;
+        if( current_pool==this )
+            job = pop_back(*queues[current_worker]);
+        if( job==NULL )
+            job = pop_front(shared);
+        for(size_t i=0; job==NULL && i<queues.size(); i++)
+            if( current_pool!=this || (ae_int_t)i!=current_worker )
+                job = pop_front(*queues[i]);
+        if( job==NULL )
+            return false;
+        pending--;
+        smp_run(*job);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        progress.notify_all();
+        return true;
+    }
+
+    /* runs queued tasks until a job is done, sleeping while there are none */
+    void wait(const smp_job &job)
+    {
+        while( !job.done.load(std::memory_order_acquire) )
+        {
+            if( run_one() )
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            progress.wait(lock, [this, &job]() { return job.done.load(std::memory_order_acquire) || pending.load()>0; });
+        }
+    }
+
+private:
+    void work(ae_int_t index)
+    {
+        current_pool = this;
+        current_worker = index;
+        for(;;)
+        {
+            if( run_one() )
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait(lock, [this]() { return stopping || pending.load()>0; });
+            if( stopping )
+                return;
+        }
+    }
+
+    static smp_job* pop_back(smp_queue &queue)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if( queue.jobs.empty() )
+            return NULL;
+        smp_job *job = queue.jobs.back();
+        queue.jobs.pop_back();
+        return job;
+    }
+
+    static smp_job* pop_front(smp_queue &queue)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if( queue.jobs.empty() )
+            return NULL;
+        smp_job *job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return job;
+    }
+
+    std::vector<std::unique_ptr<smp_queue> > queues;
+    smp_queue shared;
+    std::vector<std::thread> workers;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+
+    /* signalled when a task finishes or is queued, for threads waiting in ae_smp_invoke */
+    std::condition_variable progress;
+    std::atomic<long> pending;
+    bool stopping;
+};
+
+std::mutex pool_mutex;
+std::atomic<ae_int_t> cores_to_use(0);
+
+/* never destroyed, so that workers outlive static destructors which may call ALGLIB */
+smp_pool *pool = NULL;
+
+smp_pool* get_pool()
+{
+    if( current_pool!=NULL )
+        return current_pool;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    ae_int_t nworkers = ae_cores_count()-1;
+    if( pool!=NULL && pool->size()!=nworkers )
+    {
+        delete pool;
+        pool = NULL;
+    }
+    if( pool==NULL )
+        pool = new smp_pool(nworkers);
+    return pool;
+}
+
+}
+
+void ae_set_cores_to_use(ae_int_t ncores)
+{
+    cores_to_use.store(ncores);
+}
+
+ae_int_t ae_cores_count()
+{
+    ae_int_t ncores = cores_to_use.load();
+    ae_int_t hardware = std::max<ae_int_t>((ae_int_t)std::thread::hardware_concurrency(), 1);
+    if( ncores>0 )
+        return ncores;
+    return std::max<ae_int_t>(hardware+ncores, 1);
+}
+
+ae_bool ae_smp_worthwhile(double flops)
+{
+    return flops>=AE_SMP_MIN_FLOPS && ae_cores_count()>1;
+}
+
+void ae_smp_invoke(const ae_smp_task &task0, const ae_smp_task &task1, ae_state *state)
+{
+    if( ae_cores_count()<=1 && current_pool==NULL )
+    {
+        task0(state);
+        task1(state);
+        return;
+    }
+
+    smp_pool *p = get_pool();
+    smp_job job0(task0), job1(task1);
+    p->push(&job1);
+    smp_run(job0);
+    p->wait(job1);
+
+    if( job0.failed )
+        ae_break(state, job0.error, job0.msg);
+    if( job1.failed )
+        ae_break(state, job1.error, job1.msg);
+}
+
+}
+
@@ -0,0 +1,68 @@
+/*************************************************************************
+Thread pool which executes the _pexec_* (SMP) entry points of ALGLIB.
+
+This file is not part of the ALGLIB distribution. It replaces the
+multithreading layer of the commercial HPC edition with a portable pool
+built on C++11 threads, so that smp_* functions use every core. The same
+pool runs depnet::parallelFor.
+*************************************************************************/
+#ifndef _smp_h
+#define _smp_h
+
+#include "ap.h"
+#include <functional>
+
+namespace alglib_impl
+{
+
+/*************************************************************************
+Work item executed by ae_smp_invoke(). It receives an environment  state
+of its own, so errors raised by one task do not unwind frames  owned  by
+another.
+*************************************************************************/
+typedef std::function<void(ae_state*)> ae_smp_task;
+
+/*************************************************************************
+Smallest number of floating point operations worth  splitting  between
+threads. Smaller problems are solved serially by the calling thread.
+*************************************************************************/
+#define AE_SMP_MIN_FLOPS 2097152.0
+
+/*************************************************************************
+Sets the number of cores used by SMP functions:
+* positive values give the number of threads, including the caller
+* zero means all cores of the system
+* negative values mean all cores except -NCores of them
+The pool is rebuilt on the next parallel call, which must not overlap
+with a call to this function.
+*************************************************************************/
+void ae_set_cores_to_use(ae_int_t ncores);
+
+/*************************************************************************
+Returns the number of threads, including the caller, which  execute  SMP
+functions. One means that SMP functions run serially.
+*************************************************************************/
+ae_int_t ae_cores_count();
+
+/*************************************************************************
+Returns True if a problem of the given cost should be split between
+threads, i.e. it is large enough and more than one core is in use.
+*************************************************************************/
+ae_bool ae_smp_worthwhile(double flops);
+
+/*************************************************************************
+Executes two independent tasks, possibly in parallel, and  returns  once
+both have finished. The second task is offered to idle workers while the
+calling thread executes the first; if no worker picks it up, the caller
+executes it too. While waiting, the caller runs other queued tasks, so
+tasks may call ae_smp_invoke() recursively without deadlock.
+
+If either task fails, the error is raised in State after both tasks have
+finished.
+*************************************************************************/
+void ae_smp_invoke(const ae_smp_task &task0, const ae_smp_task &task1, ae_state *state);
+
+}
+
+#endif
+
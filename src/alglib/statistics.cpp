@@ -18,6 +18,7 @@ http://www.fsf.org/licensing/licenses
 *************************************************************************/
 #include "stdafx.h"
 #include "statistics.h"
+#include "smp.h"
 
 // disable some irrelevant warnings
 #if (AE_COMPILER==AE_MSVC)
@@ -2673,6 +2674,41 @@ static void basestat_rankdatabasecase(/* Real    */ ae_matrix* xy,
      apbuffers* buf0,
      apbuffers* buf1,
      ae_state *_state);
+static void basestat_centercolumns(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_vector* s,
+     ae_state *_state);
+static void basestat_covmx(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state);
+static void basestat_pearsoncorrmx(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state);
+static void basestat_covm2x(/* Real    */ ae_matrix* x,
+     /* Real    */ ae_matrix* y,
+     ae_int_t n,
+     ae_int_t m1,
+     ae_int_t m2,
+     /* Real    */ ae_matrix* c,
+     /* Real    */ ae_vector* sx,
+     /* Real    */ ae_vector* sy,
+     ae_bool smp,
+     ae_state *_state);
+static void basestat_pearsoncorrm2x(/* Real    */ ae_matrix* x,
+     /* Real    */ ae_matrix* y,
+     ae_int_t n,
+     ae_int_t m1,
+     ae_int_t m2,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state);
 
 
 static double correlationtests_spearmantail5(double s, ae_state *_state);
@@ -3757,103 +3793,19 @@ void covm(/* Real    */ ae_matrix* x,
      /* Real    */ ae_matrix* c,
      ae_state *_state)
 {
-    ae_frame _frame_block;
-    ae_matrix _x;
-    ae_int_t i;
-    ae_int_t j;
-    double v;
-    ae_vector t;
-    ae_vector x0;
-    ae_vector same;
-
-    ae_frame_make(_state, &_frame_block);
-    ae_matrix_init_copy(&_x, x, _state, ae_true);
-    x = &_x;
-    ae_matrix_clear(c);
-    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&x0, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&same, 0, DT_BOOL, _state, ae_true);
-
-    ae_assert(n>=0, "CovM: N<0", _state);
-    ae_assert(m>=1, "CovM: M<1", _state);
-    ae_assert(x->rows>=n, "CovM: Rows(X)<N!", _state);
-    ae_assert(x->cols>=m||n==0, "CovM: Cols(X)<M!", _state);
-    ae_assert(apservisfinitematrix(x, n, m, _state), "CovM: X contains infinite/NAN elements", _state);
-    
-    /*
-     * N<=1, return zero
-     */
-    if( n<=1 )
-    {
-        ae_matrix_set_length(c, m, m, _state);
-        for(i=0; i<=m-1; i++)
-        {
-            for(j=0; j<=m-1; j++)
-            {
-                c->ptr.pp_double[i][j] = 0;
-            }
-        }
-        ae_frame_leave(_state);
-        return;
-    }
-    
-    /*
-     * Calculate means,
-     * check for constant columns
-     */
-    ae_vector_set_length(&t, m, _state);
-    ae_vector_set_length(&x0, m, _state);
-    ae_vector_set_length(&same, m, _state);
-    ae_matrix_set_length(c, m, m, _state);
-    for(i=0; i<=m-1; i++)
-    {
-        t.ptr.p_double[i] = 0;
-        same.ptr.p_bool[i] = ae_true;
-    }
-    ae_v_move(&x0.ptr.p_double[0], 1, &x->ptr.pp_double[0][0], 1, ae_v_len(0,m-1));
-    v = (double)1/(double)n;
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_addd(&t.ptr.p_double[0], 1, &x->ptr.pp_double[i][0], 1, ae_v_len(0,m-1), v);
-        for(j=0; j<=m-1; j++)
-        {
-            same.ptr.p_bool[j] = same.ptr.p_bool[j]&&ae_fp_eq(x->ptr.pp_double[i][j],x0.ptr.p_double[j]);
-        }
-    }
-    
-    /*
-     * * center variables;
-     * * if we have constant columns, these columns are
-     *   artificially zeroed (they must be zero in exact arithmetics,
-     *   but unfortunately floating point ops are not exact).
-     * * calculate upper half of symmetric covariance matrix
-     */
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_sub(&x->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m-1));
-        for(j=0; j<=m-1; j++)
-        {
-            if( same.ptr.p_bool[j] )
-            {
-                x->ptr.pp_double[i][j] = 0;
-            }
-        }
-    }
-    rmatrixsyrk(m, n, (double)1/(double)(n-1), x, 0, 0, 1, 0.0, c, 0, 0, ae_true, _state);
-    rmatrixenforcesymmetricity(c, m, ae_true, _state);
-    ae_frame_leave(_state);
+    basestat_covmx(x, n, m, c, ae_false, _state);
 }
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version: the covariance product is computed by the SMP pool.
 *************************************************************************/
 void _pexec_covm(/* Real    */ ae_matrix* x,
     ae_int_t n,
     ae_int_t m,
     /* Real    */ ae_matrix* c, ae_state *_state)
 {
-    covm(x,n,m,c, _state);
+    basestat_covmx(x,n,m,c, ae_true, _state);
 }
 
 
@@ -3902,55 +3854,19 @@ void pearsoncorrm(/* Real    */ ae_matrix* x,
      /* Real    */ ae_matrix* c,
      ae_state *_state)
 {
-    ae_frame _frame_block;
-    ae_vector t;
-    ae_int_t i;
-    ae_int_t j;
-    double v;
-
-    ae_frame_make(_state, &_frame_block);
-    ae_matrix_clear(c);
-    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
-
-    ae_assert(n>=0, "PearsonCorrM: N<0", _state);
-    ae_assert(m>=1, "PearsonCorrM: M<1", _state);
-    ae_assert(x->rows>=n, "PearsonCorrM: Rows(X)<N!", _state);
-    ae_assert(x->cols>=m||n==0, "PearsonCorrM: Cols(X)<M!", _state);
-    ae_assert(apservisfinitematrix(x, n, m, _state), "PearsonCorrM: X contains infinite/NAN elements", _state);
-    ae_vector_set_length(&t, m, _state);
-    covm(x, n, m, c, _state);
-    for(i=0; i<=m-1; i++)
-    {
-        if( ae_fp_greater(c->ptr.pp_double[i][i],0) )
-        {
-            t.ptr.p_double[i] = 1/ae_sqrt(c->ptr.pp_double[i][i], _state);
-        }
-        else
-        {
-            t.ptr.p_double[i] = 0.0;
-        }
-    }
-    for(i=0; i<=m-1; i++)
-    {
-        v = t.ptr.p_double[i];
-        for(j=0; j<=m-1; j++)
-        {
-            c->ptr.pp_double[i][j] = c->ptr.pp_double[i][j]*v*t.ptr.p_double[j];
-        }
-    }
-    ae_frame_leave(_state);
+    basestat_pearsoncorrmx(x, n, m, c, ae_false, _state);
 }
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version: the covariance product is computed by the SMP pool.
 *************************************************************************/
 void _pexec_pearsoncorrm(/* Real    */ ae_matrix* x,
     ae_int_t n,
     ae_int_t m,
     /* Real    */ ae_matrix* c, ae_state *_state)
 {
-    pearsoncorrm(x,n,m,c, _state);
+    basestat_pearsoncorrmx(x,n,m,c, ae_true, _state);
 }
 
 
@@ -4205,141 +4121,12 @@ void covm2(/* Real    */ ae_matrix* x,
      /* Real    */ ae_matrix* c,
      ae_state *_state)
 {
-    ae_frame _frame_block;
-    ae_matrix _x;
-    ae_matrix _y;
-    ae_int_t i;
-    ae_int_t j;
-    double v;
-    ae_vector t;
-    ae_vector x0;
-    ae_vector y0;
-    ae_vector samex;
-    ae_vector samey;
-
-    ae_frame_make(_state, &_frame_block);
-    ae_matrix_init_copy(&_x, x, _state, ae_true);
-    x = &_x;
-    ae_matrix_init_copy(&_y, y, _state, ae_true);
-    y = &_y;
-    ae_matrix_clear(c);
-    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&x0, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&y0, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&samex, 0, DT_BOOL, _state, ae_true);
-    ae_vector_init(&samey, 0, DT_BOOL, _state, ae_true);
-
-    ae_assert(n>=0, "CovM2: N<0", _state);
-    ae_assert(m1>=1, "CovM2: M1<1", _state);
-    ae_assert(m2>=1, "CovM2: M2<1", _state);
-    ae_assert(x->rows>=n, "CovM2: Rows(X)<N!", _state);
-    ae_assert(x->cols>=m1||n==0, "CovM2: Cols(X)<M1!", _state);
-    ae_assert(apservisfinitematrix(x, n, m1, _state), "CovM2: X contains infinite/NAN elements", _state);
-    ae_assert(y->rows>=n, "CovM2: Rows(Y)<N!", _state);
-    ae_assert(y->cols>=m2||n==0, "CovM2: Cols(Y)<M2!", _state);
-    ae_assert(apservisfinitematrix(y, n, m2, _state), "CovM2: X contains infinite/NAN elements", _state);
-    
-    /*
-     * N<=1, return zero
-     */
-    if( n<=1 )
-    {
-        ae_matrix_set_length(c, m1, m2, _state);
-        for(i=0; i<=m1-1; i++)
-        {
-            for(j=0; j<=m2-1; j++)
-            {
-                c->ptr.pp_double[i][j] = 0;
-            }
-        }
-        ae_frame_leave(_state);
-        return;
-    }
-    
-    /*
-     * Allocate
-     */
-    ae_vector_set_length(&t, ae_maxint(m1, m2, _state), _state);
-    ae_vector_set_length(&x0, m1, _state);
-    ae_vector_set_length(&y0, m2, _state);
-    ae_vector_set_length(&samex, m1, _state);
-    ae_vector_set_length(&samey, m2, _state);
-    ae_matrix_set_length(c, m1, m2, _state);
-    
-    /*
-     * * calculate means of X
-     * * center X
-     * * if we have constant columns, these columns are
-     *   artificially zeroed (they must be zero in exact arithmetics,
-     *   but unfortunately floating point ops are not exact).
-     */
-    for(i=0; i<=m1-1; i++)
-    {
-        t.ptr.p_double[i] = 0;
-        samex.ptr.p_bool[i] = ae_true;
-    }
-    ae_v_move(&x0.ptr.p_double[0], 1, &x->ptr.pp_double[0][0], 1, ae_v_len(0,m1-1));
-    v = (double)1/(double)n;
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_addd(&t.ptr.p_double[0], 1, &x->ptr.pp_double[i][0], 1, ae_v_len(0,m1-1), v);
-        for(j=0; j<=m1-1; j++)
-        {
-            samex.ptr.p_bool[j] = samex.ptr.p_bool[j]&&ae_fp_eq(x->ptr.pp_double[i][j],x0.ptr.p_double[j]);
-        }
-    }
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_sub(&x->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m1-1));
-        for(j=0; j<=m1-1; j++)
-        {
-            if( samex.ptr.p_bool[j] )
-            {
-                x->ptr.pp_double[i][j] = 0;
-            }
-        }
-    }
-    
-    /*
-     * Repeat same steps for Y
-     */
-    for(i=0; i<=m2-1; i++)
-    {
-        t.ptr.p_double[i] = 0;
-        samey.ptr.p_bool[i] = ae_true;
-    }
-    ae_v_move(&y0.ptr.p_double[0], 1, &y->ptr.pp_double[0][0], 1, ae_v_len(0,m2-1));
-    v = (double)1/(double)n;
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_addd(&t.ptr.p_double[0], 1, &y->ptr.pp_double[i][0], 1, ae_v_len(0,m2-1), v);
-        for(j=0; j<=m2-1; j++)
-        {
-            samey.ptr.p_bool[j] = samey.ptr.p_bool[j]&&ae_fp_eq(y->ptr.pp_double[i][j],y0.ptr.p_double[j]);
-        }
-    }
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_sub(&y->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m2-1));
-        for(j=0; j<=m2-1; j++)
-        {
-            if( samey.ptr.p_bool[j] )
-            {
-                y->ptr.pp_double[i][j] = 0;
-            }
-        }
-    }
-    
-    /*
-     * calculate cross-covariance matrix
-     */
-    rmatrixgemm(m1, m2, n, (double)1/(double)(n-1), x, 0, 0, 1, y, 0, 0, 0, 0.0, c, 0, 0, _state);
-    ae_frame_leave(_state);
+    basestat_covm2x(x, y, n, m1, m2, c, NULL, NULL, ae_false, _state);
 }
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version: the covariance product is computed by the SMP pool.
 *************************************************************************/
 void _pexec_covm2(/* Real    */ ae_matrix* x,
     /* Real    */ ae_matrix* y,
@@ -4348,7 +4135,7 @@ void _pexec_covm2(/* Real    */ ae_matrix* x,
     ae_int_t m2,
     /* Real    */ ae_matrix* c, ae_state *_state)
 {
-    covm2(x,y,n,m1,m2,c, _state);
+    basestat_covm2x(x,y,n,m1,m2,c, NULL, NULL, ae_true, _state);
 }
 
 
@@ -4405,194 +4192,12 @@ void pearsoncorrm2(/* Real    */ ae_matrix* x,
      /* Real    */ ae_matrix* c,
      ae_state *_state)
 {
-    ae_frame _frame_block;
-    ae_matrix _x;
-    ae_matrix _y;
-    ae_int_t i;
-    ae_int_t j;
-    double v;
-    ae_vector t;
-    ae_vector x0;
-    ae_vector y0;
-    ae_vector sx;
-    ae_vector sy;
-    ae_vector samex;
-    ae_vector samey;
-
-    ae_frame_make(_state, &_frame_block);
-    ae_matrix_init_copy(&_x, x, _state, ae_true);
-    x = &_x;
-    ae_matrix_init_copy(&_y, y, _state, ae_true);
-    y = &_y;
-    ae_matrix_clear(c);
-    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&x0, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&y0, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&sx, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&sy, 0, DT_REAL, _state, ae_true);
-    ae_vector_init(&samex, 0, DT_BOOL, _state, ae_true);
-    ae_vector_init(&samey, 0, DT_BOOL, _state, ae_true);
-
-    ae_assert(n>=0, "PearsonCorrM2: N<0", _state);
-    ae_assert(m1>=1, "PearsonCorrM2: M1<1", _state);
-    ae_assert(m2>=1, "PearsonCorrM2: M2<1", _state);
-    ae_assert(x->rows>=n, "PearsonCorrM2: Rows(X)<N!", _state);
-    ae_assert(x->cols>=m1||n==0, "PearsonCorrM2: Cols(X)<M1!", _state);
-    ae_assert(apservisfinitematrix(x, n, m1, _state), "PearsonCorrM2: X contains infinite/NAN elements", _state);
-    ae_assert(y->rows>=n, "PearsonCorrM2: Rows(Y)<N!", _state);
-    ae_assert(y->cols>=m2||n==0, "PearsonCorrM2: Cols(Y)<M2!", _state);
-    ae_assert(apservisfinitematrix(y, n, m2, _state), "PearsonCorrM2: X contains infinite/NAN elements", _state);
-    
-    /*
-     * N<=1, return zero
-     */
-    if( n<=1 )
-    {
-        ae_matrix_set_length(c, m1, m2, _state);
-        for(i=0; i<=m1-1; i++)
-        {
-            for(j=0; j<=m2-1; j++)
-            {
-                c->ptr.pp_double[i][j] = 0;
-            }
-        }
-        ae_frame_leave(_state);
-        return;
-    }
-    
-    /*
-     * Allocate
-     */
-    ae_vector_set_length(&t, ae_maxint(m1, m2, _state), _state);
-    ae_vector_set_length(&x0, m1, _state);
-    ae_vector_set_length(&y0, m2, _state);
-    ae_vector_set_length(&sx, m1, _state);
-    ae_vector_set_length(&sy, m2, _state);
-    ae_vector_set_length(&samex, m1, _state);
-    ae_vector_set_length(&samey, m2, _state);
-    ae_matrix_set_length(c, m1, m2, _state);
-    
-    /*
-     * * calculate means of X
-     * * center X
-     * * if we have constant columns, these columns are
-     *   artificially zeroed (they must be zero in exact arithmetics,
-     *   but unfortunately floating point ops are not exact).
-     * * calculate column variances
-     */
-    for(i=0; i<=m1-1; i++)
-    {
-        t.ptr.p_double[i] = 0;
-        samex.ptr.p_bool[i] = ae_true;
-        sx.ptr.p_double[i] = 0;
-    }
-    ae_v_move(&x0.ptr.p_double[0], 1, &x->ptr.pp_double[0][0], 1, ae_v_len(0,m1-1));
-    v = (double)1/(double)n;
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_addd(&t.ptr.p_double[0], 1, &x->ptr.pp_double[i][0], 1, ae_v_len(0,m1-1), v);
-        for(j=0; j<=m1-1; j++)
-        {
-            samex.ptr.p_bool[j] = samex.ptr.p_bool[j]&&ae_fp_eq(x->ptr.pp_double[i][j],x0.ptr.p_double[j]);
-        }
-    }
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_sub(&x->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m1-1));
-        for(j=0; j<=m1-1; j++)
-        {
-            if( samex.ptr.p_bool[j] )
-            {
-                x->ptr.pp_double[i][j] = 0;
-            }
-            sx.ptr.p_double[j] = sx.ptr.p_double[j]+x->ptr.pp_double[i][j]*x->ptr.pp_double[i][j];
-        }
-    }
-    for(j=0; j<=m1-1; j++)
-    {
-        sx.ptr.p_double[j] = ae_sqrt(sx.ptr.p_double[j]/(n-1), _state);
-    }
-    
-    /*
-     * Repeat same steps for Y
-     */
-    for(i=0; i<=m2-1; i++)
-    {
-        t.ptr.p_double[i] = 0;
-        samey.ptr.p_bool[i] = ae_true;
-        sy.ptr.p_double[i] = 0;
-    }
-    ae_v_move(&y0.ptr.p_double[0], 1, &y->ptr.pp_double[0][0], 1, ae_v_len(0,m2-1));
-    v = (double)1/(double)n;
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_addd(&t.ptr.p_double[0], 1, &y->ptr.pp_double[i][0], 1, ae_v_len(0,m2-1), v);
-        for(j=0; j<=m2-1; j++)
-        {
-            samey.ptr.p_bool[j] = samey.ptr.p_bool[j]&&ae_fp_eq(y->ptr.pp_double[i][j],y0.ptr.p_double[j]);
-        }
-    }
-    for(i=0; i<=n-1; i++)
-    {
-        ae_v_sub(&y->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m2-1));
-        for(j=0; j<=m2-1; j++)
-        {
-            if( samey.ptr.p_bool[j] )
-            {
-                y->ptr.pp_double[i][j] = 0;
-            }
-            sy.ptr.p_double[j] = sy.ptr.p_double[j]+y->ptr.pp_double[i][j]*y->ptr.pp_double[i][j];
-        }
-    }
-    for(j=0; j<=m2-1; j++)
-    {
-        sy.ptr.p_double[j] = ae_sqrt(sy.ptr.p_double[j]/(n-1), _state);
-    }
-    
-    /*
-     * calculate cross-covariance matrix
-     */
-    rmatrixgemm(m1, m2, n, (double)1/(double)(n-1), x, 0, 0, 1, y, 0, 0, 0, 0.0, c, 0, 0, _state);
-    
-    /*
-     * Divide by standard deviations
-     */
-    for(i=0; i<=m1-1; i++)
-    {
-        if( ae_fp_neq(sx.ptr.p_double[i],0) )
-        {
-            sx.ptr.p_double[i] = 1/sx.ptr.p_double[i];
-        }
-        else
-        {
-            sx.ptr.p_double[i] = 0.0;
-        }
-    }
-    for(i=0; i<=m2-1; i++)
-    {
-        if( ae_fp_neq(sy.ptr.p_double[i],0) )
-        {
-            sy.ptr.p_double[i] = 1/sy.ptr.p_double[i];
-        }
-        else
-        {
-            sy.ptr.p_double[i] = 0.0;
-        }
-    }
-    for(i=0; i<=m1-1; i++)
-    {
-        v = sx.ptr.p_double[i];
-        for(j=0; j<=m2-1; j++)
-        {
-            c->ptr.pp_double[i][j] = c->ptr.pp_double[i][j]*v*sy.ptr.p_double[j];
-        }
-    }
-    ae_frame_leave(_state);
-}
+    basestat_pearsoncorrm2x(x, y, n, m1, m2, c, ae_false, _state);
+}
 
 
 /*************************************************************************
-Single-threaded stub. HPC ALGLIB replaces it by multithreaded code.
+Parallel version: the covariance product is computed by the SMP pool.
 *************************************************************************/
 void _pexec_pearsoncorrm2(/* Real    */ ae_matrix* x,
     /* Real    */ ae_matrix* y,
@@ -4601,7 +4206,7 @@ void _pexec_pearsoncorrm2(/* Real    */ ae_matrix* x,
     ae_int_t m2,
     /* Real    */ ae_matrix* c, ae_state *_state)
 {
-    pearsoncorrm2(x,y,n,m1,m2,c, _state);
+    basestat_pearsoncorrm2x(x,y,n,m1,m2,c, ae_true, _state);
 }
 
 
@@ -5068,6 +4673,334 @@ static void basestat_rankdatarec(/* Real    */ ae_matrix* xy,
     ae_frame_leave(_state);
 }
 
+static void basestat_covmx(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state)
+{
+    ae_frame _frame_block;
+    ae_matrix _x;
+    ae_int_t i;
+    ae_int_t j;
+
+    ae_frame_make(_state, &_frame_block);
+    ae_matrix_init_copy(&_x, x, _state, ae_true);
+    x = &_x;
+    ae_matrix_clear(c);
+
+    ae_assert(n>=0, "CovM: N<0", _state);
+    ae_assert(m>=1, "CovM: M<1", _state);
+    ae_assert(x->rows>=n, "CovM: Rows(X)<N!", _state);
+    ae_assert(x->cols>=m||n==0, "CovM: Cols(X)<M!", _state);
+    ae_assert(apservisfinitematrix(x, n, m, _state), "CovM: X contains infinite/NAN elements", _state);
+    
+    /*
+     * N<=1, return zero
+     */
+    if( n<=1 )
+    {
+        ae_matrix_set_length(c, m, m, _state);
+        for(i=0; i<=m-1; i++)
+        {
+            for(j=0; j<=m-1; j++)
+            {
+                c->ptr.pp_double[i][j] = 0;
+            }
+        }
+        ae_frame_leave(_state);
+        return;
+    }
+    
+    /*
+     * center variables, then calculate upper half of symmetric covariance matrix
+     */
+    ae_matrix_set_length(c, m, m, _state);
+    basestat_centercolumns(x, n, m, NULL, _state);
+    if( smp )
+    {
+        _pexec_rmatrixsyrk(m, n, (double)1/(double)(n-1), x, 0, 0, 1, 0.0, c, 0, 0, ae_true, _state);
+    }
+    else
+    {
+        rmatrixsyrk(m, n, (double)1/(double)(n-1), x, 0, 0, 1, 0.0, c, 0, 0, ae_true, _state);
+    }
+    rmatrixenforcesymmetricity(c, m, ae_true, _state);
+    ae_frame_leave(_state);
+}
+
+
+static void basestat_pearsoncorrmx(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state)
+{
+    ae_frame _frame_block;
+    ae_vector t;
+    ae_int_t i;
+    ae_int_t j;
+    double v;
+
+    ae_frame_make(_state, &_frame_block);
+    ae_matrix_clear(c);
+    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
+
+    ae_assert(n>=0, "PearsonCorrM: N<0", _state);
+    ae_assert(m>=1, "PearsonCorrM: M<1", _state);
+    ae_assert(x->rows>=n, "PearsonCorrM: Rows(X)<N!", _state);
+    ae_assert(x->cols>=m||n==0, "PearsonCorrM: Cols(X)<M!", _state);
+    ae_assert(apservisfinitematrix(x, n, m, _state), "PearsonCorrM: X contains infinite/NAN elements", _state);
+    ae_vector_set_length(&t, m, _state);
+    basestat_covmx(x, n, m, c, smp, _state);
+    for(i=0; i<=m-1; i++)
+    {
+        if( ae_fp_greater(c->ptr.pp_double[i][i],0) )
+        {
+            t.ptr.p_double[i] = 1/ae_sqrt(c->ptr.pp_double[i][i], _state);
+        }
+        else
+        {
+            t.ptr.p_double[i] = 0.0;
+        }
+    }
+    for(i=0; i<=m-1; i++)
+    {
+        v = t.ptr.p_double[i];
+        for(j=0; j<=m-1; j++)
+        {
+            c->ptr.pp_double[i][j] = c->ptr.pp_double[i][j]*v*t.ptr.p_double[j];
+        }
+    }
+    ae_frame_leave(_state);
+}
+
+
+/*************************************************************************
+Centers the leading N rows of the first M columns of X. Constant columns
+are zeroed, since they must be zero in exact arithmetic but floating point
+ops are not exact. If S is not NULL, it receives the standard deviation of
+each column. Requires N>1.
+*************************************************************************/
+static void basestat_centercolumns(/* Real    */ ae_matrix* x,
+     ae_int_t n,
+     ae_int_t m,
+     /* Real    */ ae_vector* s,
+     ae_state *_state)
+{
+    ae_frame _frame_block;
+    ae_int_t i;
+    ae_int_t j;
+    double v;
+    ae_vector t;
+    ae_vector x0;
+    ae_vector same;
+
+    ae_frame_make(_state, &_frame_block);
+    ae_vector_init(&t, 0, DT_REAL, _state, ae_true);
+    ae_vector_init(&x0, 0, DT_REAL, _state, ae_true);
+    ae_vector_init(&same, 0, DT_BOOL, _state, ae_true);
+
+    ae_vector_set_length(&t, m, _state);
+    ae_vector_set_length(&x0, m, _state);
+    ae_vector_set_length(&same, m, _state);
+    for(i=0; i<=m-1; i++)
+    {
+        t.ptr.p_double[i] = 0;
+        same.ptr.p_bool[i] = ae_true;
+    }
+    ae_v_move(&x0.ptr.p_double[0], 1, &x->ptr.pp_double[0][0], 1, ae_v_len(0,m-1));
+    v = (double)1/(double)n;
+    for(i=0; i<=n-1; i++)
+    {
+        ae_v_addd(&t.ptr.p_double[0], 1, &x->ptr.pp_double[i][0], 1, ae_v_len(0,m-1), v);
+        for(j=0; j<=m-1; j++)
+        {
+            same.ptr.p_bool[j] = same.ptr.p_bool[j]&&ae_fp_eq(x->ptr.pp_double[i][j],x0.ptr.p_double[j]);
+        }
+    }
+    for(i=0; i<=n-1; i++)
+    {
+        ae_v_sub(&x->ptr.pp_double[i][0], 1, &t.ptr.p_double[0], 1, ae_v_len(0,m-1));
+        for(j=0; j<=m-1; j++)
+        {
+            if( same.ptr.p_bool[j] )
+            {
+                x->ptr.pp_double[i][j] = 0;
+            }
+        }
+    }
+    if( s!=NULL )
+    {
+        ae_vector_set_length(s, m, _state);
+        for(j=0; j<=m-1; j++)
+        {
+            s->ptr.p_double[j] = 0;
+        }
+        for(i=0; i<=n-1; i++)
+        {
+            for(j=0; j<=m-1; j++)
+            {
+                s->ptr.p_double[j] = s->ptr.p_double[j]+x->ptr.pp_double[i][j]*x->ptr.pp_double[i][j];
+            }
+        }
+        for(j=0; j<=m-1; j++)
+        {
+            s->ptr.p_double[j] = ae_sqrt(s->ptr.p_double[j]/(n-1), _state);
+        }
+    }
+    ae_frame_leave(_state);
+}
+
+
+/*************************************************************************
+Cross-covariance of X and Y. If SX and SY are not NULL, they receive the
+standard deviations of the columns of X and Y (left untouched if N<=1).
+*************************************************************************/
+static void basestat_covm2x(/* Real    */ ae_matrix* x,
+     /* Real    */ ae_matrix* y,
+     ae_int_t n,
+     ae_int_t m1,
+     ae_int_t m2,
+     /* Real    */ ae_matrix* c,
+     /* Real    */ ae_vector* sx,
+     /* Real    */ ae_vector* sy,
+     ae_bool smp,
+     ae_state *_state)
+{
+    ae_frame _frame_block;
+    ae_matrix _x;
+    ae_matrix _y;
+    ae_int_t i;
+    ae_int_t j;
+
+    ae_frame_make(_state, &_frame_block);
+    ae_matrix_init_copy(&_x, x, _state, ae_true);
+    x = &_x;
+    ae_matrix_init_copy(&_y, y, _state, ae_true);
+    y = &_y;
+    ae_matrix_clear(c);
+
+    ae_assert(n>=0, "CovM2: N<0", _state);
+    ae_assert(m1>=1, "CovM2: M1<1", _state);
+    ae_assert(m2>=1, "CovM2: M2<1", _state);
+    ae_assert(x->rows>=n, "CovM2: Rows(X)<N!", _state);
+    ae_assert(x->cols>=m1||n==0, "CovM2: Cols(X)<M1!", _state);
+    ae_assert(apservisfinitematrix(x, n, m1, _state), "CovM2: X contains infinite/NAN elements", _state);
+    ae_assert(y->rows>=n, "CovM2: Rows(Y)<N!", _state);
+    ae_assert(y->cols>=m2||n==0, "CovM2: Cols(Y)<M2!", _state);
+    ae_assert(apservisfinitematrix(y, n, m2, _state), "CovM2: X contains infinite/NAN elements", _state);
+    
+    /*
+     * N<=1, return zero
+     */
+    if( n<=1 )
+    {
+        ae_matrix_set_length(c, m1, m2, _state);
+        for(i=0; i<=m1-1; i++)
+        {
+            for(j=0; j<=m2-1; j++)
+            {
+                c->ptr.pp_double[i][j] = 0;
+            }
+        }
+        ae_frame_leave(_state);
+        return;
+    }
+    
+    /*
+     * center X and Y, then calculate cross-covariance matrix
+     */
+    ae_matrix_set_length(c, m1, m2, _state);
+    basestat_centercolumns(x, n, m1, sx, _state);
+    basestat_centercolumns(y, n, m2, sy, _state);
+    if( smp )
+    {
+        _pexec_rmatrixgemm(m1, m2, n, (double)1/(double)(n-1), x, 0, 0, 1, y, 0, 0, 0, 0.0, c, 0, 0, _state);
+    }
+    else
+    {
+        rmatrixgemm(m1, m2, n, (double)1/(double)(n-1), x, 0, 0, 1, y, 0, 0, 0, 0.0, c, 0, 0, _state);
+    }
+    ae_frame_leave(_state);
+}
+
+
+static void basestat_pearsoncorrm2x(/* Real    */ ae_matrix* x,
+     /* Real    */ ae_matrix* y,
+     ae_int_t n,
+     ae_int_t m1,
+     ae_int_t m2,
+     /* Real    */ ae_matrix* c,
+     ae_bool smp,
+     ae_state *_state)
+{
+    ae_frame _frame_block;
+    ae_int_t i;
+    ae_int_t j;
+    double v;
+    ae_vector sx;
+    ae_vector sy;
+
+    ae_frame_make(_state, &_frame_block);
+    ae_matrix_clear(c);
+    ae_vector_init(&sx, 0, DT_REAL, _state, ae_true);
+    ae_vector_init(&sy, 0, DT_REAL, _state, ae_true);
+
+    ae_assert(n>=0, "PearsonCorrM2: N<0", _state);
+    ae_assert(m1>=1, "PearsonCorrM2: M1<1", _state);
+    ae_assert(m2>=1, "PearsonCorrM2: M2<1", _state);
+    ae_assert(x->rows>=n, "PearsonCorrM2: Rows(X)<N!", _state);
+    ae_assert(x->cols>=m1||n==0, "PearsonCorrM2: Cols(X)<M1!", _state);
+    ae_assert(apservisfinitematrix(x, n, m1, _state), "PearsonCorrM2: X contains infinite/NAN elements", _state);
+    ae_assert(y->rows>=n, "PearsonCorrM2: Rows(Y)<N!", _state);
+    ae_assert(y->cols>=m2||n==0, "PearsonCorrM2: Cols(Y)<M2!", _state);
+    ae_assert(apservisfinitematrix(y, n, m2, _state), "PearsonCorrM2: X contains infinite/NAN elements", _state);
+    basestat_covm2x(x, y, n, m1, m2, c, &sx, &sy, smp, _state);
+    if( n<=1 )
+    {
+        ae_frame_leave(_state);
+        return;
+    }
+    
+    /*
+     * Divide by standard deviations
+     */
+    for(i=0; i<=m1-1; i++)
+    {
+        if( ae_fp_neq(sx.ptr.p_double[i],0) )
+        {
+            sx.ptr.p_double[i] = 1/sx.ptr.p_double[i];
+        }
+        else
+        {
+            sx.ptr.p_double[i] = 0.0;
+        }
+    }
+    for(i=0; i<=m2-1; i++)
+    {
+        if( ae_fp_neq(sy.ptr.p_double[i],0) )
+        {
+            sy.ptr.p_double[i] = 1/sy.ptr.p_double[i];
+        }
+        else
+        {
+            sy.ptr.p_double[i] = 0.0;
+        }
+    }
+    for(i=0; i<=m1-1; i++)
+    {
+        v = sx.ptr.p_double[i];
+        for(j=0; j<=m2-1; j++)
+        {
+            c->ptr.pp_double[i][j] = c->ptr.pp_double[i][j]*v*sy.ptr.p_double[j];
+        }
+    }
+    ae_frame_leave(_state);
+}
+
 
 static void basestat_rankdatabasecase(/* Real    */ ae_matrix* xy,
      ae_int_t i0,
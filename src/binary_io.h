@@ -0,0 +1,368 @@
+#pragma once
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<istream>
+#include<memory>
+#include<ostream>
+#include<streambuf>
+#include<string>
+#include<type_traits>
+#include<vector>
+
+#include "exceptions/conversion.h"
+#include "mapped_buffer.h"
+
+namespace depnet
+{
+    /**
+     * Helpers for the compact binary formats used by checkpoints and saved models.
+     * Values are written in native byte order; readers throw ConversionException on truncated input.
+     */
+    namespace binary_io
+    {
+        /**
+         * Writes a trivially copyable value
+         * @param out The stream to write to
+         * @param value The value to write
+         */
+        template<typename T>
+        inline void write(std::ostream& out, const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        /**
+         * Reads a trivially copyable value
+         * @param in The stream to read from
+         * @return The value read
+         */
+        template<typename T>
+        inline T read(std::istream& in)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+            T value;
+            if(!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+                throw ConversionException("Unexpected end of binary input.");
+            return value;
+        }
+
+        /**
+         * Writes a length-prefixed array of trivially copyable values
+         * @param out The stream to write to
+         * @param values The values to write
+         */
+        template<typename T>
+        inline void writeVector(std::ostream& out, const std::vector<T>& values)
+        {
+            write<std::uint64_t>(out, values.size());
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        /**
+         * The most bytes a stream reader allocates before the input has shown that they are present,
+         * so that a corrupt length prefix cannot trigger a huge allocation
+         */
+        const std::size_t READ_CHUNK = 1 << 20;
+
+        /**
+         * Reads a length-prefixed array of trivially copyable values
+         * @param in The stream to read from
+         * @return The values read
+         */
+        template<typename T>
+        inline std::vector<T> readVector(std::istream& in)
+        {
+            std::uint64_t size = read<std::uint64_t>(in);
+            std::size_t chunk = std::max<std::size_t>(1, READ_CHUNK / sizeof(T));
+            std::vector<T> values;
+            while(values.size() < size)
+            {
+                std::size_t offset = values.size();
+                values.resize(offset + static_cast<std::size_t>(std::min<std::uint64_t>(chunk, size - offset)));
+                if(!in.read(reinterpret_cast<char*>(values.data() + offset), (values.size() - offset) * sizeof(T)))
+                    throw ConversionException("Unexpected end of binary input.");
+            }
+            return values;
+        }
+
+        /**
+         * Writes a length-prefixed string
+         * @param out The stream to write to
+         * @param value The string to write
+         */
+        inline void writeString(std::ostream& out, const std::string& value)
+        {
+            write<std::uint32_t>(out, value.size());
+            out.write(value.data(), value.size());
+        }
+
+        /**
+         * Reads a length-prefixed string
+         * @param in The stream to read from
+         * @return The string read
+         */
+        inline std::string readString(std::istream& in)
+        {
+            std::uint32_t size = read<std::uint32_t>(in);
+            std::string value;
+            while(value.size() < size)
+            {
+                std::size_t offset = value.size();
+                value.resize(offset + std::min<std::size_t>(READ_CHUNK, size - offset));
+                if(!in.read(&value[offset], value.size() - offset))
+                    throw ConversionException("Unexpected end of binary input.");
+            }
+            return value;
+        }
+
+        /**
+         * Writes a four character tag and a format version
+         * @param out The stream to write to
+         * @param magic A four character tag identifying the format
+         * @param version The version of the format being written
+         */
+        inline void writeHeader(std::ostream& out, const char magic[4], std::uint32_t version)
+        {
+            out.write(magic, 4);
+            write<std::uint32_t>(out, version);
+        }
+
+        /**
+         * Reads and validates a four character tag, returning the format version
+         * @param in The stream to read from
+         * @param magic The expected four character tag
+         * @param maxVersion The newest version the caller understands
+         * @return The version of the format being read
+         */
+        inline std::uint32_t readHeader(std::istream& in, const char magic[4], std::uint32_t maxVersion)
+        {
+            char found[4];
+            if(!in.read(found, 4) || !std::equal(found, found + 4, magic))
+                throw ConversionException(std::string("Binary input is not in the expected ") +
+                    std::string(magic, 4) + " format.");
+
+            std::uint32_t version = read<std::uint32_t>(in);
+            if(version == 0 || version > maxVersion)
+                throw ConversionException("Unsupported binary format version " + std::to_string(version) + ".");
+            return version;
+        }
+
+        /**
+         * A stream which forwards to another stream and counts the bytes written through it, so that
+         * offsets are known even when the underlying stream is not seekable or did not start empty
+         */
+        class OffsetStream : public std::ostream
+        {
+        public:
+            /**
+             * Creates a stream whose offset 0 is the current position of another stream
+             * @param target The stream which receives every byte written
+             */
+            explicit OffsetStream(std::ostream& target) : std::ostream(NULL), counter(target.rdbuf())
+            {
+                this->rdbuf(&this->counter);
+            }
+
+            /**
+             * Retrieves the number of bytes written so far
+             * @return The offset of the next write from the start of this stream
+             */
+            std::size_t offset() const
+            {
+                return this->counter.count;
+            }
+
+        private:
+            /** Forwards characters to the target buffer, counting those accepted */
+            struct CountingBuffer : public std::streambuf
+            {
+                explicit CountingBuffer(std::streambuf* target) : target(target), count(0) { }
+
+                int_type overflow(int_type ch)
+                {
+                    if(traits_type::eq_int_type(ch, traits_type::eof()))
+                        return traits_type::not_eof(ch);
+                    if(traits_type::eq_int_type(this->target->sputc(traits_type::to_char_type(ch)), traits_type::eof()))
+                        return traits_type::eof();
+                    this->count++;
+                    return ch;
+                }
+
+                std::streamsize xsputn(const char* data, std::streamsize size)
+                {
+                    std::streamsize written = this->target->sputn(data, size);
+                    this->count += written;
+                    return written;
+                }
+
+                int sync()
+                {
+                    return this->target->pubsync();
+                }
+
+                std::streambuf* target;
+                std::size_t count;
+            };
+
+            CountingBuffer counter;
+        };
+
+        /**
+         * Pads a stream with zeros until its offset is a multiple of an alignment, so that
+         * arrays can later be used in place from a MappedBuffer
+         * @param out The stream to pad, whose offset must be measured from the start of the format
+         * @param alignment The required alignment in bytes
+         */
+        inline void pad(OffsetStream& out, std::size_t alignment)
+        {
+            while(out && out.offset() % alignment != 0)
+                out.put('\0');
+        }
+
+        /**
+         * Reads values sequentially from a MappedBuffer. Arrays may be viewed in place 
+         * rather than copied, in which case the viewer must hold on to the buffer.
+         */
+        class MemoryReader
+        {
+        public:
+            /**
+             * Creates a reader positioned at the start of a buffer
+             * @param buffer The buffer to read from
+             */
+            explicit MemoryReader(std::shared_ptr<const MappedBuffer> buffer) : 
+                buffer(buffer), position(0), end(buffer->size()) { }
+
+            /**
+             * Retrieves the buffer being read, which must be kept alive by any in-place views
+             * @return The buffer
+             */
+            std::shared_ptr<const MappedBuffer> getBuffer() const
+            {
+                return this->buffer;
+            }
+
+            /**
+             * Reads a trivially copyable value
+             * @return The value read
+             */
+            template<typename T>
+            T read()
+            {
+                T value;
+                std::memcpy(&value, this->claim(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+            /**
+             * Reads a length-prefixed string written by binary_io::writeString
+             * @return The string read
+             */
+            std::string readString()
+            {
+                std::uint32_t size = this->read<std::uint32_t>();
+                return std::string(this->claim(size), size);
+            }
+
+            /**
+             * Skips padding written by binary_io::pad
+             * @param alignment The alignment in bytes passed to binary_io::pad
+             */
+            void align(std::size_t alignment)
+            {
+                while(this->position % alignment != 0)
+                    this->claim(1);
+            }
+
+            /**
+             * Advances past a number of bytes without reading them
+             * @param size The number of bytes to skip
+             */
+            void skip(std::size_t size)
+            {
+                this->claim(size);
+            }
+
+            /**
+             * Views an array in place without copying it
+             * @param count The number of values in the array
+             * @return A pointer into the buffer
+             */
+            template<typename T>
+            const T* view(std::size_t count)
+            {
+                if(count > this->remaining() / sizeof(T))
+                    throw ConversionException("Unexpected end of binary input.");
+                const char* start = this->claim(count * sizeof(T));
+                if(reinterpret_cast<std::uintptr_t>(start) % alignof(T) != 0)
+                    throw ConversionException("Binary input is not aligned for in-place use.");
+                return reinterpret_cast<const T*>(start);
+            }
+
+            /**
+             * Splits off a reader over the next bytes of the buffer and advances past them.
+             * Positions in the slice remain relative to the start of the buffer, so alignment is preserved.
+             * @param size The number of bytes in the slice
+             * @return A reader which cannot read beyond the slice
+             */
+            MemoryReader slice(std::size_t size)
+            {
+                MemoryReader part(*this);
+                this->claim(size);
+                part.end = this->position;
+                return part;
+            }
+
+            /**
+             * Retrieves the number of bytes left to read, allowing optional trailing fields to be detected
+             * @return The number of unread bytes
+             */
+            std::size_t remaining() const
+            {
+                return this->end - this->position;
+            }
+
+            /**
+             * Retrieves the number of bytes consumed so far
+             * @return The offset of the next read from the start of the buffer
+             */
+            std::size_t tell() const
+            {
+                return this->position;
+            }
+
+        private:
+            /**
+             * Advances past a number of bytes, throwing ConversionException if the buffer is too short
+             * @param size The number of bytes to consume
+             * @return A pointer to the first byte consumed
+             */
+            const char* claim(std::size_t size)
+            {
+                if(size > this->end - this->position)
+                    throw ConversionException("Unexpected end of binary input.");
+                const char* start = this->buffer->data() + this->position;
+                this->position += size;
+                return start;
+            }
+
+            /** The buffer being read */
+            std::shared_ptr<const MappedBuffer> buffer;
+
+            /** The offset of the next read */
+            std::size_t position;
+
+            /** The offset just past the last readable byte */
+            std::size_t end;
+        };
+    }
+}
+
+#endif
+
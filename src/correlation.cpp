@@ -0,0 +1,231 @@
+#include "correlation.h"
+#include "parallel.h"
+#include "tracing.h"
+#include "alglib/linalg.h"
+
+#include<algorithm>
+#include<cmath>
+#include<memory>
+#include<mutex>
+#include<stdexcept>
+
+namespace depnet
+{
+    namespace
+    {
+        /** The number of observations of each column used at once when accumulating a single precision tile */
+        const std::size_t SINGLE_ROW_CHUNK = 128;
+
+        /** Orders columns by decreasing absolute correlation, then by increasing index */
+        bool stronger(const CorrelatedColumn& a, const CorrelatedColumn& b)
+        {
+            double absA = std::fabs(a.correlation);
+            double absB = std::fabs(b.correlation);
+            return absA > absB || (absA == absB && a.column < b.column);
+        }
+
+        /**
+         * Keeps a correlation if it is among the k strongest seen so far
+         * @param heap The strongest correlations so far, with the weakest at the front
+         */
+        void offer(std::vector<CorrelatedColumn>& heap, std::size_t k, std::size_t column, double correlation)
+        {
+            CorrelatedColumn candidate = {column, correlation};
+            if(heap.size() < k)
+            {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), stronger);
+            } else if(stronger(candidate, heap.front()))
+            {
+                std::pop_heap(heap.begin(), heap.end(), stronger);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), stronger);
+            }
+        }
+    }
+
+    CorrelationOptions::CorrelationOptions() : blockSize(256), singlePrecision(false), numThreads(0)
+    {
+    }
+
+    ColumnCorrelations::ColumnCorrelations(const boost::const_multi_array_ref<double, 2>& data,
+            const CorrelationOptions& options) :
+        options(options), numRows(data.shape()[0]), numCols(data.shape()[1])
+    {
+        if(this->numRows < 2)
+            throw std::invalid_argument("Correlations require at least two rows.");
+        if(this->options.blockSize == 0)
+            throw std::invalid_argument("The correlation block size must be positive.");
+
+        TraceSpan span("ColumnCorrelations::ColumnCorrelations", "correlation");
+        std::vector<double> means(this->numCols, 0.0);
+        std::vector<double> sumSquares(this->numCols, 0.0);
+        for(std::size_t row = 0; row < this->numRows; row++)
+            for(std::size_t col = 0; col < this->numCols; col++)
+                means[col] += data[row][col];
+        for(std::size_t col = 0; col < this->numCols; col++)
+            means[col] /= this->numRows;
+        for(std::size_t row = 0; row < this->numRows; row++)
+            for(std::size_t col = 0; col < this->numCols; col++)
+            {
+                double centered = data[row][col] - means[col];
+                sumSquares[col] += centered * centered;
+            }
+
+        // scaling each column to unit length makes every correlation a dot product
+        std::vector<double> multipliers(this->numCols);
+        this->scales.resize(this->numCols);
+        for(std::size_t col = 0; col < this->numCols; col++)
+        {
+            this->scales[col] = std::sqrt(sumSquares[col] / (this->numRows - 1));
+            multipliers[col] = sumSquares[col] > 0 ? 1 / std::sqrt(sumSquares[col]) : 0;
+        }
+
+        if(this->options.singlePrecision)
+        {
+            this->standardizedSingle.resize(this->numRows * this->numCols);
+            for(std::size_t row = 0; row < this->numRows; row++)
+                for(std::size_t col = 0; col < this->numCols; col++)
+                    this->standardizedSingle[col * this->numRows + row] =
+                        static_cast<float>((data[row][col] - means[col]) * multipliers[col]);
+        } else
+        {
+            this->standardized.setlength(this->numRows, this->numCols);
+            for(std::size_t row = 0; row < this->numRows; row++)
+                for(std::size_t col = 0; col < this->numCols; col++)
+                    this->standardized[row][col] = (data[row][col] - means[col]) * multipliers[col];
+        }
+    }
+
+    std::size_t ColumnCorrelations::getNumColumns() const
+    {
+        return this->numCols;
+    }
+
+    void ColumnCorrelations::computeTile(std::size_t rowBegin, std::size_t colBegin, std::size_t numRowCols,
+            std::size_t numColCols, alglib::real_2d_array& tile) const
+    {
+        if(this->options.singlePrecision)
+        {
+            this->computeSingleTile(rowBegin, colBegin, numRowCols, numColCols, tile);
+            return;
+        }
+
+        if(rowBegin == colBegin)
+        {
+            // tiles on the diagonal are symmetric, so only the upper triangle is computed
+            alglib::rmatrixsyrk(numRowCols, this->numRows, 1.0, this->standardized, 0, rowBegin, 1,
+                0.0, tile, 0, 0, true);
+            for(std::size_t i = 0; i < numRowCols; i++)
+                for(std::size_t j = 0; j < i; j++)
+                    tile[i][j] = tile[j][i];
+        } else
+            alglib::rmatrixgemm(numRowCols, numColCols, this->numRows, 1.0, this->standardized, 0, rowBegin, 1,
+                this->standardized, 0, colBegin, 0, 0.0, tile, 0, 0);
+    }
+
+    void ColumnCorrelations::computeSingleTile(std::size_t rowBegin, std::size_t colBegin, std::size_t numRowCols,
+            std::size_t numColCols, alglib::real_2d_array& tile) const
+    {
+        std::vector<float> sums(numRowCols * numColCols, 0.0f);
+        bool diagonal = rowBegin == colBegin;
+        for(std::size_t chunkBegin = 0; chunkBegin < this->numRows; chunkBegin += SINGLE_ROW_CHUNK)
+        {
+            std::size_t chunkEnd = std::min(this->numRows, chunkBegin + SINGLE_ROW_CHUNK);
+            for(std::size_t i = 0; i < numRowCols; i++)
+            {
+                const float* x = &this->standardizedSingle[(rowBegin + i) * this->numRows];
+                float* out = &sums[i * numColCols];
+                for(std::size_t j = diagonal ? i : 0; j < numColCols; j++)
+                {
+                    const float* y = &this->standardizedSingle[(colBegin + j) * this->numRows];
+                    float sum = 0.0f;
+                    for(std::size_t row = chunkBegin; row < chunkEnd; row++)
+                        sum += x[row] * y[row];
+                    out[j] += sum;
+                }
+            }
+        }
+
+        for(std::size_t i = 0; i < numRowCols; i++)
+            for(std::size_t j = 0; j < numColCols; j++)
+                tile[i][j] = diagonal && j < i ? sums[j * numColCols + i] : sums[i * numColCols + j];
+    }
+
+    void ColumnCorrelations::correlation(boost::multi_array<double, 2>& out) const
+    {
+        TraceSpan span("ColumnCorrelations::correlation", "correlation");
+        out.resize(boost::extents[this->numCols][this->numCols]);
+        std::size_t blockSize = this->options.blockSize;
+        std::size_t numBlocks = (this->numCols + blockSize - 1) / blockSize;
+
+        // the task for a row of tiles writes that row right of the diagonal and the matching column below it
+        parallelFor(numBlocks, this->options.numThreads, [&](std::size_t rowBlock) {
+            alglib::real_2d_array tile;
+            tile.setlength(blockSize, blockSize);
+            std::size_t rowBegin = rowBlock * blockSize;
+            std::size_t numRowCols = std::min(blockSize, this->numCols - rowBegin);
+            for(std::size_t colBegin = rowBegin; colBegin < this->numCols; colBegin += blockSize)
+            {
+                std::size_t numColCols = std::min(blockSize, this->numCols - colBegin);
+                this->computeTile(rowBegin, colBegin, numRowCols, numColCols, tile);
+                for(std::size_t i = 0; i < numRowCols; i++)
+                    for(std::size_t j = 0; j < numColCols; j++)
+                    {
+                        out[rowBegin + i][colBegin + j] = tile[i][j];
+                        out[colBegin + j][rowBegin + i] = tile[i][j];
+                    }
+            }
+        });
+    }
+
+    void ColumnCorrelations::covariance(boost::multi_array<double, 2>& out) const
+    {
+        this->correlation(out);
+        for(std::size_t i = 0; i < this->numCols; i++)
+            for(std::size_t j = 0; j < this->numCols; j++)
+                out[i][j] *= this->scales[i] * this->scales[j];
+    }
+
+    std::vector<std::vector<CorrelatedColumn> > ColumnCorrelations::topCorrelations(std::size_t k) const
+    {
+        TraceSpan span("ColumnCorrelations::topCorrelations", "correlation");
+        std::vector<std::vector<CorrelatedColumn> > heaps(this->numCols);
+        if(k == 0)
+            return heaps;
+        std::size_t blockSize = this->options.blockSize;
+        std::size_t numBlocks = (this->numCols + blockSize - 1) / blockSize;
+        std::unique_ptr<std::mutex[]> blockLocks(new std::mutex[numBlocks]);
+
+        // each tile above the diagonal updates the columns of its row and of its column
+        parallelFor(numBlocks, this->options.numThreads, [&](std::size_t rowBlock) {
+            alglib::real_2d_array tile;
+            tile.setlength(blockSize, blockSize);
+            std::size_t rowBegin = rowBlock * blockSize;
+            std::size_t numRowCols = std::min(blockSize, this->numCols - rowBegin);
+            for(std::size_t colBlock = rowBlock; colBlock < numBlocks; colBlock++)
+            {
+                std::size_t colBegin = colBlock * blockSize;
+                std::size_t numColCols = std::min(blockSize, this->numCols - colBegin);
+                this->computeTile(rowBegin, colBegin, numRowCols, numColCols, tile);
+                {
+                    std::lock_guard<std::mutex> lock(blockLocks[rowBlock]);
+                    for(std::size_t i = 0; i < numRowCols; i++)
+                        for(std::size_t j = 0; j < numColCols; j++)
+                            if(rowBegin + i != colBegin + j)
+                                offer(heaps[rowBegin + i], k, colBegin + j, tile[i][j]);
+                }
+                if(colBlock == rowBlock)
+                    continue;
+                std::lock_guard<std::mutex> lock(blockLocks[colBlock]);
+                for(std::size_t j = 0; j < numColCols; j++)
+                    for(std::size_t i = 0; i < numRowCols; i++)
+                        offer(heaps[colBegin + j], k, rowBegin + i, tile[i][j]);
+            }
+        });
+
+        for(auto it = heaps.begin(); it != heaps.end(); ++it)
+            std::sort_heap(it->begin(), it->end(), stronger);
+        return heaps;
+    }
+}
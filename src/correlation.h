@@ -0,0 +1,117 @@
+
+#pragma once
+
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include<cstddef>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "alglib/ap.h"
+
+namespace depnet
+{
+    /**
+     * Controls how ColumnCorrelations computes products of columns
+     */
+    struct CorrelationOptions
+    {
+        /** Uses tiles of 256 columns, double precision and one thread per core */
+        CorrelationOptions();
+
+        /** The number of columns in each tile. A tile of products is blockSize x blockSize. */
+        std::size_t blockSize;
+
+        /**
+         * Stores standardized columns and accumulates their products in single precision. This halves
+         * memory and doubles the values per cache line, at the cost of about six significant digits.
+         */
+        bool singlePrecision;
+
+        /** The number of rows of tiles computed at once by correlation, covariance and topCorrelations, or 0 for one per core */
+        unsigned int numThreads;
+    };
+
+    /** A column and its correlation with another column */
+    struct CorrelatedColumn
+    {
+        std::size_t column;
+        double correlation;
+    };
+
+    /**
+     * Computes Pearson correlations and covariances between the columns of a data matrix. The columns are
+     * centered and scaled to unit variance once, when the object is created, so that each correlation is a
+     * dot product. Full matrices are computed with a symmetric rank-k update. Correlations can also be
+     * screened a tile of columns at a time, so that the strongest correlations of every column are found
+     * without holding the whole matrix. Columns with zero variance have zero correlation with every column,
+     * including themselves.
+     */
+    class ColumnCorrelations
+    {
+    public:
+        /**
+         * Centers and scales the columns of a data matrix
+         * @param data The data, with one row per observation and at least two rows
+         * @param options Controls tiling, precision and threads
+         */
+        ColumnCorrelations(const boost::const_multi_array_ref<double, 2>& data,
+                const CorrelationOptions& options = CorrelationOptions());
+
+        /** @return The number of columns */
+        std::size_t getNumColumns() const;
+
+        /**
+         * Computes the correlation of every pair of columns
+         * @param out Resized to hold the symmetric correlation matrix
+         */
+        void correlation(boost::multi_array<double, 2>& out) const;
+
+        /**
+         * Computes the covariance of every pair of columns
+         * @param out Resized to hold the symmetric covariance matrix
+         */
+        void covariance(boost::multi_array<double, 2>& out) const;
+
+        /**
+         * Finds the columns most correlated with each column, by absolute correlation. Only one tile of
+         * correlations per thread is held at a time.
+         * @param k The largest number of columns to report for each column
+         * @return For each column, up to k other columns in order of decreasing absolute correlation
+         */
+        std::vector<std::vector<CorrelatedColumn> > topCorrelations(std::size_t k) const;
+
+    private:
+        /**
+         * Computes the correlations of two ranges of columns
+         * @param rowBegin The first column of the first range
+         * @param colBegin The first column of the second range
+         * @param numRowCols The number of columns in the first range
+         * @param numColCols The number of columns in the second range
+         * @param tile Receives the correlations, with numRowCols rows and at least numColCols columns
+         */
+        void computeTile(std::size_t rowBegin, std::size_t colBegin, std::size_t numRowCols,
+                std::size_t numColCols, alglib::real_2d_array& tile) const;
+
+        /** Computes a tile from the single precision columns */
+        void computeSingleTile(std::size_t rowBegin, std::size_t colBegin, std::size_t numRowCols,
+                std::size_t numColCols, alglib::real_2d_array& tile) const;
+
+        CorrelationOptions options;
+        std::size_t numRows;
+        std::size_t numCols;
+
+        /** The standard deviation of each column */
+        std::vector<double> scales;
+
+        /** The standardized data, numRows x numCols, in double precision */
+        alglib::real_2d_array standardized;
+
+        /** The standardized data in single precision, one column after another */
+        std::vector<float> standardizedSingle;
+    };
+}
+
+#endif
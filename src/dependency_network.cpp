@@ -1,17 +1,37 @@
 
 #include "dependency_network.h"
-#include "models/rdf_model.h"
+#include "exceptions/checkpoint.h"
+#include "exceptions/conversion.h"
+#include "binary_io.h"
+#include "tracing.h"
 
-#include<iostream>
+#include<algorithm>
+#include<chrono>
+#include<cstdio>
+#include<fstream>
+#include<sstream>
+#include<stdexcept>
 
 namespace depnet
 {
-    DependencyNetwork::DependencyNetwork() { }
+    namespace
+    {
+        const char NETWORK_MAGIC[4] = {'D', 'N', 'M', 'D'};
+        const std::uint32_t NETWORK_VERSION = 1;
+
+        // alignment of each model's data, allowing models to view arrays in place
+        const std::size_t MODEL_ALIGNMENT = 8;
+
+        // the fewest bytes a saved variable can occupy: its name length, three flags and its range
+        const std::size_t MIN_VARIABLE_BYTES = sizeof(std::uint32_t) + 3 + 2 * sizeof(double);
+    }
+
+    DependencyNetwork::DependencyNetwork() : factory(new StandardFactory()), seed(0) { }
 
     DependencyNetwork::DependencyNetwork(
         const std::vector<std::shared_ptr<VariableSpecification> >& varSpecs,
             std::shared_ptr<Factory> factory) :
-        varSpecs(varSpecs), factory(factory)
+        varSpecs(varSpecs), factory(factory), seed(0)
     {
     }
 
@@ -29,23 +49,85 @@ namespace depnet
         std::shared_ptr<boost::multi_array<double, 2> > result(
             new boost::multi_array<double, 2>(
                 boost::extents[numSamples][this->varSpecs.size()]));
-        for(unsigned int i = 0; i < numSamples; i++)
+
+        double* out = result->data();
+        this->getSamples(numSamples, 
+            [&out](const double* rows, std::size_t numRows, std::size_t numCols)
+            {
+                out = std::copy(rows, rows + numRows * numCols, out);
+                return true;
+            });
+
+        return result;
+    }
+
+    long DependencyNetwork::getSamples(int numSamples, SampleCallback callback, int blockSize)
+    {
+        if(!this->gibbsIterator)
+            throw std::logic_error("The network must be trained before sampling.");
+
+        std::size_t numCols = this->varSpecs.size();
+        std::size_t blockRows = std::max(1, std::min(blockSize, numSamples));
+        std::vector<double> block(blockRows * numCols);
+
+        long delivered = 0;
+        while(delivered < numSamples)
         {
-            std::cout << "Advancing iterator" << std::endl;
-            (*this->gibbsIterator)++;
-            std::cout << "Getting a sample" << std::endl;
-            SampleType sampleMap = *(*this->gibbsIterator);
-
-            unsigned int featureCtr = 0;
-            std::cout << "Assigning sampled values to variables" << std::endl;
-            for(auto varSpec = this->varSpecs.begin(); varSpec != this->varSpecs.end(); ++varSpec)
+            std::size_t numRows = std::min<std::size_t>(blockRows, numSamples - delivered);
             {
-                (*result)[i][featureCtr] = (*sampleMap)[*varSpec];
-                featureCtr++;
+                TraceSpan span("sample block", "network");
+                for(std::size_t row = 0; row < numRows; row++)
+                    this->nextSample(block.data() + row * numCols);
             }
+
+            TraceSpan span("deliver block", "queue");
+            if(!callback(block.data(), numRows, numCols))
+                return delivered + numRows;
+            delivered += numRows;
         }
 
-        return result;
+        return delivered;
+    }
+
+    long DependencyNetwork::getSamples(int numSamples, SampleBuffer& buffer)
+    {
+        if(buffer.getNumCols() != this->varSpecs.size())
+            throw std::invalid_argument("Sample buffer width does not match the number of variables.");
+        if(!this->gibbsIterator)
+            throw std::logic_error("The network must be trained before sampling.");
+
+        std::vector<double> row(this->varSpecs.size());
+        long delivered = 0;
+        for(; delivered < numSamples; delivered++)
+        {
+            this->nextSample(row.data());
+            if(!buffer.push(row.data()))
+                break;
+        }
+
+        buffer.close();
+        return delivered;
+    }
+
+    void DependencyNetwork::nextSample(double* row)
+    {
+        ++(*this->gibbsIterator);
+        SampleType sampleMap = *(*this->gibbsIterator);
+
+        // every sample shares the same keys, so the column of each map entry only needs to be found once
+        if(this->sampleColumns.size() != sampleMap->size())
+        {
+            this->sampleColumns.clear();
+            for(auto sampleIt = sampleMap->begin(); sampleIt != sampleMap->end(); ++sampleIt)
+            {
+                auto varSpec = std::find(this->varSpecs.begin(), this->varSpecs.end(), sampleIt->first);
+                this->sampleColumns.push_back(varSpec - this->varSpecs.begin());
+            }
+        }
+
+        auto column = this->sampleColumns.begin();
+        for(auto sampleIt = sampleMap->begin(); sampleIt != sampleMap->end(); ++sampleIt, ++column)
+            row[*column] = sampleIt->second;
     }
 
     const std::shared_ptr<ConditionalModel> DependencyNetwork::getModel(
@@ -56,13 +138,64 @@ namespace depnet
 
     void DependencyNetwork::resetSampler()
     {
-        // TODO
+        if(!this->models.empty())
+            this->buildSampler();
+    }
+
+    void DependencyNetwork::setSeed(std::uint64_t seed)
+    {
+        this->seed = seed;
+    }
+
+    void DependencyNetwork::setScanPolicy(std::shared_ptr<ScanPolicy> policy)
+    {
+        this->scanPolicy = policy;
+    }
+
+    void DependencyNetwork::setModelSelection(std::shared_ptr<ModelSelectionOptions> options)
+    {
+        this->modelSelection = options;
+    }
+
+    void DependencyNetwork::saveCheckpoint(std::ostream& out) const
+    {
+        if(!this->gibbsIterator)
+            throw CheckpointException("Cannot checkpoint a dependency network before it has been trained.");
+
+        SamplerCheckpoint checkpoint;
+        this->gibbsIterator->saveCheckpoint(checkpoint);
+        checkpoint.write(out);
+    }
+
+    void DependencyNetwork::restoreCheckpoint(std::istream& in)
+    {
+        if(!this->gibbsIterator)
+            throw CheckpointException("Cannot restore a checkpoint before the dependency network has been trained.");
+
+        SamplerCheckpoint checkpoint;
+        checkpoint.read(in);
+        this->gibbsIterator->restoreCheckpoint(checkpoint);
     }
 
-    void DependencyNetwork::train(boost::multi_array<double, 2> samples)
+    void DependencyNetwork::train(const boost::const_multi_array_ref<double, 2>& samples)
     {
+        TraceSpan span("DependencyNetwork::train", "network");
         typedef boost::multi_array_types::index_range range;
 
+        this->candidateMetrics.clear();
+        if(this->modelSelection)
+        {
+            ModelSelection selection = ModelSelector(this->factory, *this->modelSelection).select(this->varSpecs, samples);
+            for(std::size_t var = 0; var < this->varSpecs.size(); var++)
+            {
+                models[this->varSpecs[var]] = selection.models[var];
+                this->trainSeconds[this->varSpecs[var]] = selection.trainSeconds[var];
+                this->candidateMetrics[this->varSpecs[var]] = selection.candidates[var];
+            }
+            this->buildSampler();
+            return;
+        }
+
         boost::multi_array<double, 2>::index depColumn = 0;
         for(auto varIt = varSpecs.begin(); varIt != varSpecs.end(); ++varIt)
         {
@@ -72,16 +205,227 @@ namespace depnet
                 [varIt](const std::shared_ptr<VariableSpecification>& v) { return v != *varIt; });
 
             // learn a model for the current column on all others
-            std::shared_ptr<RandomForestModel> rfModel(new RandomForestModel(indepVars, *varIt, 0.1, 100));
-            rfModel->train(samples, depColumn);
-            models[*varIt] = rfModel;
+            auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<ConditionalModel> model = this->factory->createModel(this->factory->chooseModelType(indepVars, *varIt), indepVars, *varIt);
+            model->train(samples, depColumn);
+            models[*varIt] = model;
+            this->trainSeconds[*varIt] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
             depColumn++;
         }
 
-        std::shared_ptr<GibbsSampler> sampler = this->factory->createSampler(this->models, 10);
-        this->gibbsIterator = this->factory->createSampleIterator(sampler, 500, 100);
+        this->buildSampler();
     }
 
-}
+    void DependencyNetwork::buildSampler()
+    {
+        this->sampler = this->factory->createSampler(this->models, 10, this->seed);
+        if(this->scanPolicy)
+            this->sampler->setScanPolicy(this->scanPolicy->clone());
+        this->gibbsIterator = this->factory->createSampleIterator(this->sampler, 500, 100);
+        this->sampleColumns.clear();
+    }
 
+    const std::vector<std::shared_ptr<VariableSpecification> >& DependencyNetwork::getVariableSpecs() const
+    {
+        return this->varSpecs;
+    }
+
+    std::shared_ptr<Factory> DependencyNetwork::getFactory() const
+    {
+        return this->factory;
+    }
+
+    NetworkMetrics DependencyNetwork::metrics() const
+    {
+        NetworkMetrics metrics;
+        for(auto varIt = this->varSpecs.begin(); varIt != this->varSpecs.end(); ++varIt)
+        {
+            VariableMetrics var;
+            var.name = (*varIt)->getName();
+            auto modelIt = this->models.find(*varIt);
+            if(modelIt != this->models.end())
+            {
+                var.modelType = modelIt->second->getModelType();
+                modelIt->second->getMetrics(var);
+            }
+            auto secondsIt = this->trainSeconds.find(*varIt);
+            if(secondsIt != this->trainSeconds.end())
+                var.trainSeconds = secondsIt->second;
+            auto candidatesIt = this->candidateMetrics.find(*varIt);
+            if(candidatesIt != this->candidateMetrics.end())
+                var.candidates = candidatesIt->second;
+            if(this->sampler)
+                var.cacheHits = this->sampler->getCacheHits(*varIt);
+            metrics.variables.push_back(var);
+        }
+
+        if(this->sampler)
+            metrics.chains = this->sampler->getChainMetrics();
+        return metrics;
+    }
+
+    void DependencyNetwork::save(std::ostream& stream) const
+    {
+        binary_io::OffsetStream out(stream);
+        binary_io::writeHeader(out, NETWORK_MAGIC, NETWORK_VERSION);
+        binary_io::write(out, this->seed);
+
+        binary_io::write<std::uint32_t>(out, this->varSpecs.size());
+        for(auto varIt = this->varSpecs.begin(); varIt != this->varSpecs.end(); ++varIt)
+        {
+            const VariableSpecification& var = **varIt;
+            double minVal, maxVal;
+            var.getRange(minVal, maxVal);
+
+            binary_io::writeString(out, var.getName());
+            binary_io::write<std::uint8_t>(out, var.isDiscrete());
+            binary_io::write<std::uint8_t>(out, var.isOrdinal());
+            binary_io::write<std::uint8_t>(out, var.isBoolean());
+            binary_io::write(out, minVal);
+            binary_io::write(out, maxVal);
+            var.getLevelDictionary()->write(out);
+        }
+
+        binary_io::write<std::uint8_t>(out, !this->models.empty());
+
+        for(auto varIt = this->varSpecs.begin(); !this->models.empty() && varIt != this->varSpecs.end(); ++varIt)
+        {
+            std::shared_ptr<ConditionalModel> model = this->models.at(*varIt);
+            binary_io::writeString(out, model->getModelType());
+
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep = model->getIndependentVars();
+            binary_io::write<std::uint32_t>(out, indep.size());
+            for(auto indepIt = indep.begin(); indepIt != indep.end(); ++indepIt)
+            {
+                auto position = std::find(this->varSpecs.begin(), this->varSpecs.end(), *indepIt);
+                binary_io::write<std::uint32_t>(out, position - this->varSpecs.begin());
+            }
+
+            // models are written separately first so their internal alignment is relative to an aligned start
+            std::ostringstream modelData;
+            binary_io::OffsetStream modelOut(modelData);
+            model->save(modelOut);
+            std::string bytes = modelData.str();
+            binary_io::write<std::uint64_t>(out, bytes.size());
+            binary_io::pad(out, MODEL_ALIGNMENT);
+            out.write(bytes.data(), bytes.size());
+        }
+
+        if(!out)
+            stream.setstate(std::ios::badbit);
+    }
+
+    void DependencyNetwork::save(const std::string& path) const
+    {
+        // a network loaded from path may still be mapped, so the file is replaced rather than rewritten
+        std::string tempPath = path + ".tmp";
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if(!out)
+            throw ConversionException("Unable to open " + tempPath + " for writing.");
+        this->save(out);
+        out.close();
+        if(!out)
+        {
+            std::remove(tempPath.c_str());
+            throw ConversionException("Unable to write " + tempPath + ".");
+        }
+        if(std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tempPath.c_str());
+            throw ConversionException("Unable to replace " + path + ".");
+        }
+    }
+
+    void DependencyNetwork::saveSharedMemory(const std::string& name) const
+    {
+        std::ostringstream out;
+        this->save(out);
+        std::string bytes = out.str();
+        MappedBuffer::publishSharedMemory(name, bytes.data(), bytes.size());
+    }
+
+    void DependencyNetwork::loadSharedMemory(const std::string& name)
+    {
+        this->load(MappedBuffer::mapSharedMemory(name));
+    }
+
+    void DependencyNetwork::load(const std::string& path)
+    {
+        this->load(MappedBuffer::mapFile(path));
+    }
+
+    void DependencyNetwork::load(std::shared_ptr<const MappedBuffer> buffer)
+    {
+        binary_io::MemoryReader in(buffer);
+        char magic[4];
+        for(int i = 0; i < 4; i++)
+            magic[i] = in.read<char>();
+        if(!std::equal(magic, magic + 4, NETWORK_MAGIC))
+            throw ConversionException("Input is not a saved dependency network.");
+        std::uint32_t version = in.read<std::uint32_t>();
+        if(version == 0 || version > NETWORK_VERSION)
+            throw ConversionException("Unsupported dependency network version " + std::to_string(version) + ".");
+
+        std::uint64_t seed = in.read<std::uint64_t>();
+
+        std::uint32_t numVars = in.read<std::uint32_t>();
+        if(numVars > in.remaining() / MIN_VARIABLE_BYTES)
+            throw ConversionException("Saved network claims more variables than it contains.");
+        std::vector<std::shared_ptr<VariableSpecification> > varSpecs(numVars);
+        for(auto varIt = varSpecs.begin(); varIt != varSpecs.end(); ++varIt)
+        {
+            *varIt = this->factory->createVariableSpec();
+            (*varIt)->setName(in.readString());
+            bool isDiscrete = in.read<std::uint8_t>();
+            bool isOrdinal = in.read<std::uint8_t>();
+            bool isBoolean = in.read<std::uint8_t>();
+            double minVal = in.read<double>();
+            double maxVal = in.read<double>();
+
+            (*varIt)->setLevelDictionary(LevelDictionary::read(in));
+            (*varIt)->setDiscrete(isDiscrete);
+            (*varIt)->setOrdinal(isOrdinal);
+            (*varIt)->setBoolean(isBoolean);
+            (*varIt)->setRange(minVal, maxVal);
+        }
+
+        std::map<std::shared_ptr<VariableSpecification>, std::shared_ptr<ConditionalModel> > models;
+        bool isTrained = in.read<std::uint8_t>();
+        for(auto varIt = varSpecs.begin(); isTrained && varIt != varSpecs.end(); ++varIt)
+        {
+            std::string modelType = in.readString();
+            std::uint32_t numIndep = in.read<std::uint32_t>();
+            if(numIndep > in.remaining() / sizeof(std::uint32_t))
+                throw ConversionException("Saved model claims more variables than it contains.");
+            std::vector<std::shared_ptr<VariableSpecification> > indep(numIndep);
+            for(auto indepIt = indep.begin(); indepIt != indep.end(); ++indepIt)
+            {
+                std::uint32_t position = in.read<std::uint32_t>();
+                if(position >= varSpecs.size())
+                    throw ConversionException("Saved model refers to an unknown variable.");
+                *indepIt = varSpecs[position];
+            }
+
+            std::uint64_t size = in.read<std::uint64_t>();
+            in.align(MODEL_ALIGNMENT);
+            binary_io::MemoryReader modelIn = in.slice(size);
+
+            std::shared_ptr<ConditionalModel> model = this->factory->createModel(modelType, indep, *varIt);
+            model->load(modelIn);
+            models[*varIt] = model;
+        }
+
+        this->varSpecs = varSpecs;
+        this->models = models;
+        this->seed = seed;
+        this->trainSeconds.clear();
+        this->candidateMetrics.clear();
+        this->sampleColumns.clear();
+        this->gibbsIterator.reset();
+        this->sampler.reset();
+        if(isTrained)
+            this->buildSampler();
+    }
+
+}
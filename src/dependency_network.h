@@ -4,10 +4,17 @@
 #ifndef DEPENDENCY_NETWORK_H
 #define DEPENDENCY_NETWORK_H
 
+#include<cstdint>
 #include<cstdlib>
+#include<istream>
 #include<memory>
+#include<ostream>
 
 #include "var_spec.h"
+#include "sample_buffer.h"
+#include "mapped_buffer.h"
+#include "metrics.h"
+#include "model_selection.h"
 #include "mcmc/gibbs_iterator.h"
 #include "factory.h"
 #include "standard_factory.h"
@@ -60,16 +67,147 @@ namespace depnet
         std::shared_ptr<boost::multi_array<double, 2> > getSamples(int numSamples);
 
         /**
-         * Resets Gibbs iteration to a new random initial state
+         * Streams numSamples valid samples from a Gibbs sampler to a callback in blocks of contiguous rows,
+         * without materializing the full sample set.
+         * @param numSamples The number of samples to extract from the sampler, 
+         * after correcting for warm-up and autocorrelation
+         * @param callback Invoked with each block of samples; returning false stops sampling
+         * @param blockSize The maximum number of rows passed to each invocation of the callback
+         * @return The number of samples delivered to the callback
+         */
+        long getSamples(int numSamples, SampleCallback callback, int blockSize = 1024);
+
+        /**
+         * Streams numSamples valid samples from a Gibbs sampler into a bounded buffer.
+         * This call blocks whenever the buffer is full, so a consumer draining the buffer on 
+         * another thread controls the pace of sampling. The buffer is closed once sampling completes.
+         * @param numSamples The number of samples to extract from the sampler, 
+         * after correcting for warm-up and autocorrelation
+         * @param buffer The buffer to push rows into. Its width must match the number of variables.
+         * @return The number of samples pushed, which is less than numSamples if the buffer was closed early
+         */
+        long getSamples(int numSamples, SampleBuffer& buffer);
+
+        /**
+         * Restarts Gibbs iteration from the initial state given by the seed, repeating warm up.
+         * Has no effect if the network has not been trained.
          */
         void resetSampler();
 
+        /**
+         * Establishes the seed used by samplers created during subsequent calls to train.
+         * Sampling is reproducible for a given seed and training set.
+         * @param seed The seed for the sampler's counter-based random number generator
+         */
+        void setSeed(std::uint64_t seed);
+
+        /**
+         * Establishes the policy which schedules variable updates in samplers 
+         * created during subsequent calls to train, e.g. an AdaptiveScan. 
+         * Each sampler is given its own clone of the policy, so adaptation starts afresh whenever
+         * a sampler is built. Samplers use a systematic scan if no policy is supplied.
+         * @param policy The scheduling policy to use
+         */
+        void setScanPolicy(std::shared_ptr<ScanPolicy> policy);
+
+        /**
+         * Chooses each variable's model during subsequent calls to train by comparing candidates
+         * on held-out rows, rather than using the factory's choice. The candidates evaluated for 
+         * each variable are reported in its metrics.
+         * @param options The candidates, split and latency budget, or null to use the factory's choice
+         * @see ModelSelector
+         */
+        void setModelSelection(std::shared_ptr<ModelSelectionOptions> options);
+
+        /**
+         * Writes the state of the sampler to a compact binary checkpoint, covering every chain,
+         * the position of the random number generator and the warm up and interval counters.
+         * Throws CheckpointException if the network has not been trained.
+         * @param out The stream to write to, which should be opened in binary mode
+         */
+        void saveCheckpoint(std::ostream& out) const;
+
+        /**
+         * Resumes sampling from a checkpoint written by DependencyNetwork::saveCheckpoint,
+         * without repeating warm up. The network must have been trained over variables with the same names.
+         * Throws CheckpointException if the checkpoint does not match the network.
+         * @param in The stream to read from, which should be opened in binary mode
+         */
+        void restoreCheckpoint(std::istream& in);
+
        /** 
         * Trains the dependency network with a set of samples specified as a 2D array.
         * @param A 2D array with features stored in columns. The columns should be arranged in 
         * the same order as VariableSpecifications where supplied during construction.
+        * A boost::multi_array may be passed, or a reference to memory owned elsewhere, which is not copied.
         */
-       void train(boost::multi_array<double, 2> samples); 
+       void train(const boost::const_multi_array_ref<double, 2>& samples);
+
+        /**
+         * Writes the trained network in a versioned binary format, covering variable specifications,
+         * the type and parameters of each conditional model, and the learned model state.
+         * @param out The stream to write to, which should be opened in binary mode and positioned at its start
+         */
+        void save(std::ostream& out) const;
+
+        /**
+         * Writes the trained network to a file
+         * @param path The file to create or overwrite
+         * @see DependencyNetwork::save(std::ostream&)
+         */
+        void save(const std::string& path) const;
+
+        /**
+         * Replaces this network's variables and models with a network written by DependencyNetwork::save.
+         * The file is memory-mapped and large model arrays are used in place, so loading does not retrain
+         * and costs little more than mapping the file. Throws ConversionException if the file is invalid.
+         * @param path The file to load
+         */
+        void load(const std::string& path);
+
+        /**
+         * Replaces this network's variables and models with a network serialized in a buffer.
+         * Models may refer to the buffer in place and keep it alive.
+         * @param buffer The serialized network
+         */
+        void load(std::shared_ptr<const MappedBuffer> buffer);
+
+        /**
+         * Writes the trained network to a POSIX shared memory segment, replacing any segment with the same name,
+         * so that other processes can load it with DependencyNetwork::loadSharedMemory
+         * @param name The name of the segment, e.g. "/depnet_model"
+         * @see MappedBuffer::unlinkSharedMemory
+         */
+        void saveSharedMemory(const std::string& name) const;
+
+        /**
+         * Replaces this network's variables and models with a network published by 
+         * DependencyNetwork::saveSharedMemory. Model arrays are used in place from the segment,
+         * so every process loading the same segment shares one read-only copy of the forests.
+         * @param name The name of the segment
+         */
+        void loadSharedMemory(const std::string& name);
+
+        /**
+         * Retrieves the variables modeled by the network
+         * @return Variable metadata in the order used for training and sampling
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> >& getVariableSpecs() const;
+
+        /**
+         * Takes a snapshot of the network's counters: the training time, size and prediction cost of 
+         * each variable's model, and the sweeps and accepted samples of each chain of the current sampler.
+         * Prediction counters accumulate from every thread using the models; sampler counters restart
+         * whenever the sampler is rebuilt.
+         * @return The counters at the time of the call
+         */
+        NetworkMetrics metrics() const;
+
+        /**
+         * Retrieves the factory which creates the network's models and samplers
+         * @return The factory supplied during construction
+         */
+        std::shared_ptr<Factory> getFactory() const;
     protected:
         /** Constructor which does not require variable instantiation, to be used by subclasses */
         DependencyNetwork();
@@ -79,14 +217,47 @@ namespace depnet
         std::vector<std::shared_ptr<VariableSpecification> > varSpecs;
     private:
 
+        /**
+         * Creates a sampler and iterator over the current models
+         */
+        void buildSampler();
+
+        /**
+         * Advances the sampler and copies the next valid sample into a row
+         * @param row A destination with room for one value per variable, 
+         * written in the same order as varSpecs
+         */
+        void nextSample(double* row);
+
         /** Used for object construction */
         std::shared_ptr<Factory> factory;
+
+        /** Keys the random number generator of each sampler */
+        std::uint64_t seed;
+
+        /** Schedules variable updates in each sampler, or null for the sampler's default */
+        std::shared_ptr<ScanPolicy> scanPolicy;
+
+        /** Controls the choice of models during training, or null to use the factory's choice */
+        std::shared_ptr<ModelSelectionOptions> modelSelection;
     
+        /** The sampler underlying gibbsIterator, kept for its counters */
+        std::shared_ptr<GibbsSampler> sampler;
+
         /** An iterator over Gibbs samples */
         std::shared_ptr<GibbsIterator> gibbsIterator;
 
         /** The local conditional model for each variable */
         std::map<std::shared_ptr<VariableSpecification>, std::shared_ptr<ConditionalModel> > models;
+
+        /** The seconds spent training each variable's model */
+        std::map<std::shared_ptr<VariableSpecification>, double> trainSeconds;
+
+        /** The candidates evaluated for each variable when its model was selected */
+        std::map<std::shared_ptr<VariableSpecification>, std::vector<CandidateMetrics> > candidateMetrics;
+
+        /** The output column of each variable, in the iteration order of a sample */
+        std::vector<std::size_t> sampleColumns;
     };
 
 }
@@ -3,7 +3,14 @@
 #include "var_spec.h"
 #include "factory.h"
 #include "standard_factory.h"
+#include "io/csv_reader.h"
+#include "io/sample_file.h"
+#include "tracing.h"
 
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<limits>
 #include<memory>
 #include<vector>
 #include<iostream>
@@ -11,10 +18,133 @@
 
 #include "math.h"
 
+namespace
+{
+    void usage(const char* program)
+    {
+        std::cerr << "usage: " << program << " [--csv DATA] [--save MODEL] [--load MODEL] [--samples OUT [--compress]]" << std::endl
+            << "       [--num-samples N]" << std::endl
+            << "       [--metrics OUT] [--trace OUT] [--fast] [--table-budget BYTES]" << std::endl
+            << "       [--select [--latency-budget NS]]" << std::endl
+            << "  --csv DATA    train on a comma or tab separated file with a header row" << std::endl
+            << "  --save MODEL  write the trained network to MODEL" << std::endl
+            << "  --load MODEL  load a saved network from MODEL instead of training" << std::endl
+            << "  --samples OUT write samples to OUT in the columnar sample file format" << std::endl
+            << "  --compress    compress sample file columns" << std::endl
+            << "  --num-samples N  draw N samples, 5000 by default" << std::endl
+            << "  --metrics OUT write training, prediction and sampling counters to OUT as JSON" << std::endl
+            << "  --trace OUT   record a timeline of training and sampling to OUT in the Chrome trace format" << std::endl
+            << "  --fast        train linear and logistic models instead of random forests" << std::endl
+            << "  --table-budget BYTES  use probability tables of up to BYTES for discrete variables with discrete inputs" << std::endl
+            << "  --select      choose each variable's model by validation loss on held-out rows" << std::endl
+            << "  --latency-budget NS  with --select, trade accuracy for speed until a sweep predicts in NS nanoseconds" << std::endl;
+    }
+
+    void writeMetrics(const depnet::DependencyNetwork& network, const char* metricsPath)
+    {
+        if(!metricsPath)
+            return;
+        std::ofstream out(metricsPath);
+        network.metrics().writeJson(out);
+        out << std::endl;
+    }
+
+    void writeTrace(const char* tracePath)
+    {
+        if(!tracePath)
+            return;
+        depnet::tracing::writeChromeTrace(tracePath);
+        if(depnet::tracing::getDroppedEvents() > 0)
+            std::cerr << "Dropped " << depnet::tracing::getDroppedEvents() << " trace events" << std::endl;
+    }
+
+    void sample(depnet::DependencyNetwork& network, const char* samplesPath, bool compress, int numSamples)
+    {
+        // without a file, samples are drawn block by block and discarded rather than held in memory
+        if(!samplesPath)
+        {
+            network.getSamples(numSamples, [](const double* rows, std::size_t numRows, std::size_t numCols) {
+                return true;
+            });
+            return;
+        }
+
+        std::vector<std::string> names;
+        for(auto it = network.getVariableSpecs().begin(); it != network.getVariableSpecs().end(); ++it)
+            names.push_back((*it)->getName());
+
+        depnet::SampleFileOptions options;
+        if(compress)
+            options.defaultCodec = depnet::ColumnCodec::Deflate;
+        depnet::SampleFileWriter writer(samplesPath, names, options);
+        network.getSamples(numSamples, writer.callback());
+        writer.close();
+        std::cout << "Wrote " << writer.getNumRows() << " samples to " << samplesPath << std::endl;
+    }
+}
+
 int main(int argc, char** argv)
 {
+    const char* savePath = NULL;
+    const char* loadPath = NULL;
+    const char* csvPath = NULL;
+    const char* samplesPath = NULL;
+    const char* metricsPath = NULL;
+    const char* tracePath = NULL;
+    bool compress = false;
+    long numSamples = 5000;
+    bool fast = false;
+    std::uint64_t tableBudget = 0;
+    std::shared_ptr<depnet::ModelSelectionOptions> selection;
+    double latencyBudget = 0;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        if(std::strcmp(argv[arg], "--save") == 0 && arg + 1 < argc)
+            savePath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--load") == 0 && arg + 1 < argc)
+            loadPath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--csv") == 0 && arg + 1 < argc)
+            csvPath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--samples") == 0 && arg + 1 < argc)
+            samplesPath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--metrics") == 0 && arg + 1 < argc)
+            metricsPath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc)
+            tracePath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--num-samples") == 0 && arg + 1 < argc)
+            numSamples = std::strtol(argv[++arg], NULL, 10);
+        else if(std::strcmp(argv[arg], "--compress") == 0)
+            compress = true;
+        else if(std::strcmp(argv[arg], "--fast") == 0)
+            fast = true;
+        else if(std::strcmp(argv[arg], "--table-budget") == 0 && arg + 1 < argc)
+            tableBudget = std::strtoull(argv[++arg], NULL, 10);
+        else if(std::strcmp(argv[arg], "--select") == 0)
+            selection.reset(new depnet::ModelSelectionOptions());
+        else if(std::strcmp(argv[arg], "--latency-budget") == 0 && arg + 1 < argc)
+            latencyBudget = std::strtod(argv[++arg], NULL);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(numSamples <= 0 || numSamples > std::numeric_limits<int>::max())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(tracePath)
+        depnet::tracing::setEnabled(true);
+
     std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
-    std::shared_ptr<depnet::Factory> factory(new depnet::StandardFactory());
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    if(fast)
+        factory->setDefaultModelType("fast");
+    factory->setTableBudget(tableBudget);
+    if(selection)
+        selection->latencyBudget = latencyBudget;
 
     auto xVar = factory->createVariableSpec();
     xVar->setName("x");
@@ -24,21 +154,67 @@ int main(int argc, char** argv)
     yVar->setName("y");
     varSpecs.push_back(yVar);
 
-    int numPoints = 5000;
-    depnet::DependencyNetwork network(varSpecs);
-    boost::multi_array<double, 2> arr(boost::extents[numPoints][2]);
+    if(csvPath && !loadPath)
+    {
+        depnet::CsvReader reader;
+        reader.read(csvPath);
+        const boost::multi_array<double, 2>& data = reader.getData();
+        std::cout << "Read " << data.shape()[0] << " rows from " << csvPath << std::endl;
+        for(auto it = reader.getVariableSpecs().begin(); it != reader.getVariableSpecs().end(); ++it)
+        {
+            std::cout << "  " << (*it)->getName() << ": ";
+            if((*it)->isBoolean())
+                std::cout << "boolean";
+            else if((*it)->isOrdinal())
+                std::cout << "ordinal, " << (*it)->getNumLevels() << " levels";
+            else if((*it)->isDiscrete())
+                std::cout << "discrete, " << (*it)->getNumLevels() << " levels";
+            else
+            {
+                double minVal, maxVal;
+                (*it)->getRange(minVal, maxVal);
+                std::cout << "continuous in [" << minVal << ", " << maxVal << "]";
+            }
+            std::cout << std::endl;
+        }
+
+        depnet::DependencyNetwork network(reader.getVariableSpecs(), factory);
+        network.setModelSelection(selection);
+        network.train(data);
+        if(savePath)
+            network.save(savePath);
+        sample(network, samplesPath, compress, static_cast<int>(numSamples));
+        writeMetrics(network, metricsPath);
+        writeTrace(tracePath);
+        return 0;
+    }
 
-    std::default_random_engine generator;
-    std::uniform_real_distribution<double> distr(0.0, 20.0);
-    for(int i = 0; i < 5000; i++)
+    depnet::DependencyNetwork network(varSpecs, factory);
+    network.setModelSelection(selection);
+    if(loadPath)
     {
-        arr[i][0] = distr(generator);
+        network.load(loadPath);
+        yVar = network.getVariableSpecs()[1];
+    } else
+    {
+        int numPoints = 5000;
+        boost::multi_array<double, 2> arr(boost::extents[numPoints][2]);
+
+        std::default_random_engine generator;
+        std::uniform_real_distribution<double> distr(0.0, 20.0);
+        for(int i = 0; i < 5000; i++)
+        {
+            arr[i][0] = distr(generator);
+
+            std::normal_distribution<double> norm(arr[i][0], 5);
+            arr[i][1] = norm(generator);
+        }
 
-        std::normal_distribution<double> norm(arr[i][0], 5);
-        arr[i][1] = norm(generator);
+        network.train(arr);
     }
 
-    network.train(arr);
+    if(savePath)
+        network.save(savePath);
 
     for(int i = 0; i < 15; i++)
     {
@@ -48,6 +224,8 @@ int main(int argc, char** argv)
         std::cout << output << "=f(" << i << ")" << std::endl;
     }
 
-    network.getSamples(5000);
+    sample(network, samplesPath, compress, static_cast<int>(numSamples));
+    writeMetrics(network, metricsPath);
+    writeTrace(tracePath);
 }
 
@@ -0,0 +1,32 @@
+
+#pragma once
+
+#ifndef CHECKPOINT_EXCEPTION_H
+#define CHECKPOINT_EXCEPTION_H
+
+#include<exception>
+#include<stdexcept>
+#include<string>
+
+namespace depnet
+{
+
+    /**
+     * An exception type which is thrown when a sampler checkpoint cannot be 
+     * saved or restored, e.g. because it was taken from a network with different variables.
+     */
+    class CheckpointException : public std::runtime_error
+    {
+    public:
+        CheckpointException(std::string message) : std::runtime_error(message) {}
+
+        virtual const char* what() const throw()
+        {
+            return std::runtime_error::what();
+        }
+    };
+}
+
+
+#endif
+
@@ -5,6 +5,8 @@
 #define CONVERSION_EXCEPTION_H
 
 #include<exception>
+#include<stdexcept>
+#include<string>
 
 namespace depnet
 {
@@ -19,7 +21,7 @@ namespace depnet
 
         virtual const char* what() const throw()
         {
-            return std::exception::what();
+            return std::runtime_error::what();
         }
     };
 }
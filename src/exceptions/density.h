@@ -5,6 +5,8 @@
 #define DENSITY_EXCEPTION_H
 
 #include<exception>
+#include<stdexcept>
+#include<string>
 
 namespace depnet
 {
@@ -21,7 +23,7 @@ namespace depnet
 
         virtual const char* what() const throw()
         {
-            return std::exception::what();
+            return std::runtime_error::what();
         }
 
     };
@@ -3,6 +3,8 @@
 #ifndef FACTORY_H
 #define FACTORY_H
 
+#include<cstdint>
+
 #include "mcmc/gibbs_sampler.h"
 #include "mcmc/gibbs_iterator.h"
 #include "var_spec.h"
@@ -21,11 +23,26 @@ namespace depnet
          * specification to a conditional model
          * @param network A map from a variable to a conditional model for that variable
          * @param numChains The number of chains to run concurrently
+         * @param seed Keys the sampler's random number generator
          * @return A sampler over the specified network
          */
         virtual std::shared_ptr<GibbsSampler> createSampler(
             const std::map<std::shared_ptr<VariableSpecification>, 
-                std::shared_ptr<ConditionalModel> >& network, unsigned int numChains) const = 0;
+                std::shared_ptr<ConditionalModel> >& network, unsigned int numChains,
+                std::uint64_t seed) const = 0;
+
+        /**
+         * Creates a sampler keyed with seed 0
+         * @param network A map from a variable to a conditional model for that variable
+         * @param numChains The number of chains to run concurrently
+         * @return A sampler over the specified network
+         */
+        std::shared_ptr<GibbsSampler> createSampler(
+            const std::map<std::shared_ptr<VariableSpecification>, 
+                std::shared_ptr<ConditionalModel> >& network, unsigned int numChains) const
+        {
+            return this->createSampler(network, numChains, 0);
+        }
 
         /**
          * Creates an iterator over a Gibbs sampler.
@@ -38,6 +55,26 @@ namespace depnet
         virtual std::shared_ptr<GibbsIterator> createSampleIterator(
             std::shared_ptr<GibbsSampler> sampler, int warmUpPeriod = 0, int interval = 0) const = 0;
 
+        /**
+         * Creates an untrained conditional model of a named type
+         * @param modelType The type of model, as reported by ConditionalModel::getModelType
+         * @param indep The independent variables of the model
+         * @param dep The dependent variable of the model
+         * @return The newly created model. Throws ConversionException if the type is unknown.
+         */
+        virtual std::shared_ptr<ConditionalModel> createModel(const std::string& modelType,
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+            std::shared_ptr<VariableSpecification> dep) const = 0;
+
+        /**
+         * Chooses the type of conditional model to train for a variable
+         * @param indep The independent variables of the model
+         * @param dep The dependent variable of the model
+         * @return A type accepted by Factory::createModel
+         */
+        virtual std::string chooseModelType(const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+            std::shared_ptr<VariableSpecification> dep) const = 0;
+
         /**
          * Creates a variable specification of the appropriate type.
          * @return A pointer to the newly created variable specification.
@@ -0,0 +1,533 @@
+
+#include "csv_reader.h"
+#include "standard_factory.h"
+#include "exceptions/conversion.h"
+#include "parallel.h"
+
+#include<algorithm>
+#include<cmath>
+#include<cstdint>
+#include<cstdlib>
+#include<cstring>
+#include<functional>
+#include<limits>
+#include<set>
+#include<sstream>
+#include<unordered_set>
+
+namespace depnet
+{
+    namespace
+    {
+        /** A field within a line, excluding any surrounding quotes */
+        struct Field
+        {
+            const char* begin;
+            const char* end;
+            bool hasEscapes;
+        };
+
+        /** Counts and summary statistics for one column within one chunk */
+        struct ColumnStats
+        {
+            ColumnStats() : count(0), hasText(false), allInteger(true),
+                minVal(std::numeric_limits<double>::infinity()),
+                maxVal(-std::numeric_limits<double>::infinity()) { }
+
+            std::size_t count;
+            bool hasText;
+            bool allInteger;
+            double minVal;
+            double maxVal;
+
+            /** Distinct numeric values, abandoned once there are too many to be ordinal */
+            std::set<double> values;
+        };
+
+        /** How a column is coded in the training layout */
+        enum class ColumnKind { Continuous, Boolean, Ordinal, Text };
+
+        /** The byte range of one chunk and the rows it holds */
+        struct Chunk
+        {
+            const char* begin;
+            const char* end;
+            std::size_t firstRow;
+            std::size_t numRows;
+        };
+
+        /** The first missing field of a chunk, by row within the chunk, if there is one */
+        struct MissingField
+        {
+            bool found;
+            std::size_t row;
+            std::size_t col;
+        };
+
+        const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        /**
+         * Parses a decimal number. Numbers whose mantissa and exponent are exactly representable
+         * are computed with a single multiply or divide, which is correctly rounded; anything else
+         * falls back to strtod.
+         * @return True if the whole field is a number
+         */
+        bool parseNumber(const char* begin, const char* end, double& value)
+        {
+            const char* p = begin;
+            bool negative = false;
+            if(p != end && (*p == '-' || *p == '+'))
+                negative = *p++ == '-';
+
+            std::uint64_t mantissa = 0;
+            int digits = 0, exponent = 0;
+            bool anyDigits = false, truncated = false;
+            for(; p != end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+            {
+                if(digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa != 0;
+                }
+                else
+                {
+                    exponent++;
+                    truncated = true;
+                }
+            }
+            if(p != end && *p == '.')
+            {
+                for(++p; p != end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+                {
+                    if(digits < 19)
+                    {
+                        mantissa = mantissa * 10 + (*p - '0');
+                        digits += mantissa != 0;
+                        exponent--;
+                    }
+                    else
+                        truncated = true;
+                }
+            }
+            if(!anyDigits)
+                return false;
+
+            if(p != end && (*p == 'e' || *p == 'E'))
+            {
+                ++p;
+                bool negativeExponent = false;
+                if(p != end && (*p == '-' || *p == '+'))
+                    negativeExponent = *p++ == '-';
+                if(p == end || *p < '0' || *p > '9')
+                    return false;
+                int explicitExponent = 0;
+                for(; p != end && *p >= '0' && *p <= '9'; ++p)
+                    explicitExponent = std::min(explicitExponent * 10 + (*p - '0'), 100000);
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            }
+            if(p != end)
+                return false;
+
+            if(!truncated && mantissa < (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+            {
+                value = static_cast<double>(mantissa);
+                value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+                value = negative ? -value : value;
+                return true;
+            }
+
+            std::string text(begin, end);
+            value = std::strtod(text.c_str(), NULL);
+            return true;
+        }
+
+        bool isMissing(const Field& field)
+        {
+            std::size_t length = field.end - field.begin;
+            return length == 0 ||
+                (length == 1 && *field.begin == '?') ||
+                (length == 2 && std::strncmp(field.begin, "NA", 2) == 0) ||
+                (length == 3 && std::strncmp(field.begin, "NaN", 3) == 0);
+        }
+
+        /**
+         * Finds the first missing field of a row
+         * @return The column of the field, or the number of fields if none is missing
+         */
+        std::size_t findMissing(const std::vector<Field>& fields)
+        {
+            std::size_t col = 0;
+            while(col < fields.size() && !isMissing(fields[col]))
+                col++;
+            return col;
+        }
+
+        std::string fieldText(const Field& field)
+        {
+            std::string text(field.begin, field.end);
+            if(field.hasEscapes)
+            {
+                std::string::size_type position = 0;
+                while((position = text.find("\"\"", position)) != std::string::npos)
+                    text.erase(position++, 1);
+            }
+            return text;
+        }
+
+        /**
+         * Splits a line into fields, honouring double quotes
+         * @return A pointer to the start of the next line
+         */
+        const char* splitLine(const char* begin, const char* end, char delimiter, std::vector<Field>& fields)
+        {
+            fields.clear();
+            const char* p = begin;
+            while(true)
+            {
+                Field field = {p, p, false};
+                if(p != end && *p == '"')
+                {
+                    field.begin = ++p;
+                    while(p != end && *p != '\n')
+                    {
+                        if(*p == '"')
+                        {
+                            if(p + 1 != end && p[1] == '"')
+                            {
+                                field.hasEscapes = true;
+                                p += 2;
+                                continue;
+                            }
+                            break;
+                        }
+                        ++p;
+                    }
+                    field.end = p;
+                    if(p != end && *p == '"')
+                        ++p;
+                    while(p != end && *p != delimiter && *p != '\n')
+                        ++p;
+                }
+                else
+                {
+                    while(p != end && *p != delimiter && *p != '\n')
+                        ++p;
+                    field.end = p;
+                    if(field.end != field.begin && field.end[-1] == '\r')
+                        field.end--;
+                }
+                fields.push_back(field);
+
+                if(p == end || *p == '\n')
+                    return p == end ? p : p + 1;
+                ++p;
+            }
+        }
+
+        bool isBlank(const char* begin, const char* end)
+        {
+            for(const char* p = begin; p != end && *p != '\n'; ++p)
+                if(*p != '\r' && *p != ' ' && *p != '\t')
+                    return false;
+            return true;
+        }
+
+        const char* nextLine(const char* p, const char* end)
+        {
+            p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            return p == NULL ? end : p + 1;
+        }
+
+        /**
+         * Visits each non-blank line of a chunk, checking that it has the expected number of fields.
+         * Lines with a missing field are skipped if skipMissing is set, and are not counted.
+         */
+        void forEachRow(const Chunk& chunk, char delimiter, std::size_t numCols, bool skipMissing,
+                const std::function<void(std::size_t, const std::vector<Field>&)>& visit)
+        {
+            std::vector<Field> fields;
+            std::size_t row = 0;
+            for(const char* line = chunk.begin; line < chunk.end; )
+            {
+                if(isBlank(line, chunk.end))
+                {
+                    line = nextLine(line, chunk.end);
+                    continue;
+                }
+
+                line = splitLine(line, chunk.end, delimiter, fields);
+                if(fields.size() != numCols)
+                {
+                    std::ostringstream message;
+                    message << "Expecting " << numCols << " fields in each row, found " << fields.size() << ".";
+                    throw ConversionException(message.str());
+                }
+                if(skipMissing && findMissing(fields) != numCols)
+                    continue;
+                visit(row++, fields);
+            }
+        }
+
+        std::string formatNumber(double value)
+        {
+            std::ostringstream text;
+            text.precision(17);
+            text << value;
+            return text.str();
+        }
+    }
+
+    CsvOptions::CsvOptions() : delimiter('\0'), hasHeader(true), numThreads(0),
+        maxOrdinalLevels(20), maxTextLevels(100000), missing(MissingPolicy::DropRow) { }
+
+    CsvReader::CsvReader(CsvOptions options, std::shared_ptr<Factory> factory) :
+        options(options), factory(factory ? factory : std::make_shared<StandardFactory>()) { }
+
+    void CsvReader::read(const std::string& path)
+    {
+        this->read(MappedBuffer::mapFile(path));
+    }
+
+    void CsvReader::read(std::shared_ptr<const MappedBuffer> buffer)
+    {
+        const char* start = buffer->data();
+        const char* end = start + buffer->size();
+        while(start < end && isBlank(start, end))
+            start = nextLine(start, end);
+        if(start == end)
+            throw ConversionException("Expecting at least one line of delimited text.");
+
+        // detecting the delimiter from the first line
+        const char* firstEnd = nextLine(start, end);
+        char delimiter = this->options.delimiter;
+        if(delimiter == '\0')
+            delimiter = std::find(start, firstEnd, '\t') != firstEnd ? '\t' : ',';
+
+        std::vector<Field> fields;
+        splitLine(start, end, delimiter, fields);
+        std::size_t numCols = fields.size();
+
+        std::vector<std::string> names(numCols);
+        for(std::size_t col = 0; col < numCols; col++)
+        {
+            std::ostringstream name;
+            if(this->options.hasHeader)
+                name << fieldText(fields[col]);
+            else
+                name << "V" << col + 1;
+            names[col] = name.str();
+        }
+        const char* body = this->options.hasHeader ? firstEnd : start;
+
+        // splitting the body into byte ranges which start and end on line boundaries
+        unsigned int numThreads = this->options.numThreads;
+        if(numThreads == 0)
+            numThreads = getDefaultThreads();
+        std::size_t bodySize = end - body;
+        numThreads = std::max<std::size_t>(1, std::min<std::size_t>(numThreads, bodySize / 65536));
+
+        std::vector<Chunk> chunks;
+        const char* chunkStart = body;
+        for(unsigned int thread = 1; thread <= numThreads; thread++)
+        {
+            const char* chunkEnd = thread == numThreads ? end :
+                nextLine(std::max(chunkStart, body + bodySize * thread / numThreads), end);
+            Chunk chunk = {chunkStart, chunkEnd, 0, 0};
+            chunks.push_back(chunk);
+            chunkStart = chunkEnd;
+        }
+
+        // first pass: counting rows and summarizing each column
+        std::size_t maxOrdinalLevels = this->options.maxOrdinalLevels;
+        bool dropMissing = this->options.missing == MissingPolicy::DropRow;
+        std::vector<std::vector<ColumnStats> > chunkStats(chunks.size(), std::vector<ColumnStats>(numCols));
+        std::vector<MissingField> chunkMissing(chunks.size(), MissingField());
+        parallelFor(chunks.size(), numThreads, [&](std::size_t chunk) {
+            std::vector<ColumnStats>& stats = chunkStats[chunk];
+            forEachRow(chunks[chunk], delimiter, numCols, dropMissing, [&](std::size_t row, const std::vector<Field>& fields) {
+                std::size_t missingCol = findMissing(fields);
+                if(missingCol != numCols && !chunkMissing[chunk].found)
+                {
+                    MissingField first = {true, row, missingCol};
+                    chunkMissing[chunk] = first;
+                }
+                for(std::size_t col = 0; col < numCols; col++)
+                {
+                    ColumnStats& column = stats[col];
+                    double value;
+                    if(column.hasText || isMissing(fields[col]))
+                        continue;
+                    if(!parseNumber(fields[col].begin, fields[col].end, value))
+                    {
+                        column.hasText = true;
+                        continue;
+                    }
+
+                    column.count++;
+                    column.minVal = std::min(column.minVal, value);
+                    column.maxVal = std::max(column.maxVal, value);
+                    column.allInteger = column.allInteger && value == std::floor(value);
+                    if(column.allInteger && column.values.size() <= maxOrdinalLevels)
+                        column.values.insert(value);
+                }
+                chunks[chunk].numRows = row + 1;
+            });
+        });
+
+        std::size_t numRows = 0;
+        for(auto it = chunks.begin(); it != chunks.end(); ++it)
+        {
+            it->firstRow = numRows;
+            numRows += it->numRows;
+        }
+
+        // only rejected files get this far with missing values; rows are numbered from 1 after any header
+        for(std::size_t chunk = 0; chunk < chunks.size(); chunk++)
+            if(chunkMissing[chunk].found)
+                throw ConversionException("Column " + names[chunkMissing[chunk].col] + " is missing a value in row " +
+                    std::to_string(chunks[chunk].firstRow + chunkMissing[chunk].row + 1) + ".");
+
+        // merging the summaries and classifying each column
+        std::vector<ColumnStats> stats(numCols);
+        std::vector<ColumnKind> kinds(numCols, ColumnKind::Continuous);
+        std::vector<std::vector<double> > ordinalValues(numCols);
+        bool anyText = false;
+        for(std::size_t col = 0; col < numCols; col++)
+        {
+            ColumnStats& column = stats[col];
+            for(auto it = chunkStats.begin(); it != chunkStats.end(); ++it)
+            {
+                const ColumnStats& part = (*it)[col];
+                column.count += part.count;
+                column.hasText = column.hasText || part.hasText;
+                column.allInteger = column.allInteger && part.allInteger;
+                column.minVal = std::min(column.minVal, part.minVal);
+                column.maxVal = std::max(column.maxVal, part.maxVal);
+                if(column.values.size() <= maxOrdinalLevels)
+                    column.values.insert(part.values.begin(), part.values.end());
+            }
+
+            if(column.hasText)
+            {
+                kinds[col] = ColumnKind::Text;
+                anyText = true;
+            }
+            else if(column.count > 0 && column.allInteger && column.minVal >= 0 && column.maxVal <= 1)
+                kinds[col] = ColumnKind::Boolean;
+            else if(column.count > 0 && column.allInteger && column.values.size() <= maxOrdinalLevels)
+            {
+                kinds[col] = ColumnKind::Ordinal;
+                ordinalValues[col].assign(column.values.begin(), column.values.end());
+            }
+        }
+
+        // text columns need a second pass to collect their levels before anything can be coded
+        std::vector<std::shared_ptr<const LevelDictionary> > textLevels(numCols);
+        if(anyText)
+        {
+            std::vector<std::vector<std::unordered_set<std::string> > > chunkLevels(chunks.size(),
+                    std::vector<std::unordered_set<std::string> >(numCols));
+            parallelFor(chunks.size(), numThreads, [&](std::size_t chunk) {
+                std::vector<std::unordered_set<std::string> >& levels = chunkLevels[chunk];
+                forEachRow(chunks[chunk], delimiter, numCols, true, [&](std::size_t row, const std::vector<Field>& fields) {
+                    for(std::size_t col = 0; col < numCols; col++)
+                    {
+                        if(kinds[col] != ColumnKind::Text)
+                            continue;
+                        levels[col].insert(fieldText(fields[col]));
+                        if(levels[col].size() > this->options.maxTextLevels)
+                            throw ConversionException("Column " + names[col] + " has too many distinct values.");
+                    }
+                });
+            });
+
+            for(std::size_t col = 0; col < numCols; col++)
+            {
+                if(kinds[col] != ColumnKind::Text)
+                    continue;
+
+                std::set<std::string> sorted;
+                for(auto it = chunkLevels.begin(); it != chunkLevels.end(); ++it)
+                    sorted.insert((*it)[col].begin(), (*it)[col].end());
+                if(sorted.size() > this->options.maxTextLevels)
+                    throw ConversionException("Column " + names[col] + " has too many distinct values.");
+
+                textLevels[col] = LevelDictionary::intern(std::vector<std::string>(sorted.begin(), sorted.end()));
+            }
+        }
+
+        // final pass: writing each chunk's rows straight into its slice of the training layout
+        this->data.resize(boost::extents[numRows][numCols]);
+        boost::multi_array<double, 2>& data = this->data;
+        parallelFor(chunks.size(), numThreads, [&](std::size_t chunk) {
+            std::size_t firstRow = chunks[chunk].firstRow;
+            forEachRow(chunks[chunk], delimiter, numCols, true, [&](std::size_t row, const std::vector<Field>& fields) {
+                double* out = &data[firstRow + row][0];
+                for(std::size_t col = 0; col < numCols; col++)
+                {
+                    const Field& field = fields[col];
+                    double value;
+                    switch(kinds[col])
+                    {
+                    case ColumnKind::Text:
+                        out[col] = textLevels[col]->getCode(fieldText(field));
+                        break;
+                    case ColumnKind::Ordinal:
+                        parseNumber(field.begin, field.end, value);
+                        out[col] = std::lower_bound(ordinalValues[col].begin(), ordinalValues[col].end(), value) -
+                            ordinalValues[col].begin();
+                        break;
+                    default:
+                        parseNumber(field.begin, field.end, value);
+                        out[col] = value;
+                    }
+                }
+            });
+        });
+
+        this->varSpecs.clear();
+        for(std::size_t col = 0; col < numCols; col++)
+        {
+            std::shared_ptr<VariableSpecification> spec = this->factory->createVariableSpec();
+            spec->setName(names[col]);
+            switch(kinds[col])
+            {
+            case ColumnKind::Text:
+                spec->setLevelDictionary(textLevels[col]);
+                spec->setDiscrete(true);
+                break;
+            case ColumnKind::Boolean:
+                spec->setLevels(std::vector<std::string>{"0", "1"});
+                spec->setBoolean(true);
+                spec->setDiscrete(true);
+                break;
+            case ColumnKind::Ordinal:
+            {
+                std::vector<std::string> levels;
+                for(auto it = ordinalValues[col].begin(); it != ordinalValues[col].end(); ++it)
+                    levels.push_back(formatNumber(*it));
+                spec->setLevels(levels);
+                spec->setOrdinal(true);
+                spec->setDiscrete(true);
+                break;
+            }
+            default:
+                if(stats[col].count > 0)
+                    spec->setRange(stats[col].minVal, stats[col].maxVal);
+            }
+            this->varSpecs.push_back(spec);
+        }
+    }
+
+    const std::vector<std::shared_ptr<VariableSpecification> >& CsvReader::getVariableSpecs() const
+    {
+        return this->varSpecs;
+    }
+
+    const boost::multi_array<double, 2>& CsvReader::getData() const
+    {
+        return this->data;
+    }
+}
+
@@ -0,0 +1,121 @@
+#pragma once
+
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include<cstddef>
+#include<memory>
+#include<string>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "factory.h"
+#include "mapped_buffer.h"
+
+namespace depnet
+{
+    /**
+     * What CsvReader does with a row holding an empty field or one of the tokens NA, NaN and ?
+     */
+    enum class MissingPolicy
+    {
+        /** Leaves the row out of the data and of type inference */
+        DropRow,
+
+        /** Throws ConversionException naming the first missing column and its row */
+        Reject
+    };
+
+    /**
+     * Controls how delimited text is split and how column types are inferred
+     */
+    struct CsvOptions
+    {
+        /** Creates options with defaults suitable for comma or tab separated files with a header row */
+        CsvOptions();
+
+        /** The field separator, or '\0' to detect a tab or comma from the header line */
+        char delimiter;
+
+        /** Indicates that the first line names the columns */
+        bool hasHeader;
+
+        /** The number of threads to parse with, or 0 to use every hardware thread */
+        unsigned int numThreads;
+
+        /** Integer-valued columns with at most this many distinct values are treated as ordinal */
+        std::size_t maxOrdinalLevels;
+
+        /** Text columns with more distinct values than this are rejected */
+        std::size_t maxTextLevels;
+
+        /** How rows with missing values are handled, dropping them by default */
+        MissingPolicy missing;
+    };
+
+    /**
+     * Reads comma or tab separated values into the training layout expected by DependencyNetwork::train,
+     * inferring a VariableSpecification for each column.
+     *
+     * The file is memory-mapped and split into byte ranges on line boundaries, which are parsed
+     * concurrently. Columns are classified as follows: any non-numeric value makes a column strictly
+     * discrete with its distinct values as levels; numeric columns containing only 0 and 1 are Boolean;
+     * other integer columns with few distinct values are ordinal; everything else is continuous with its
+     * observed range. Empty fields and the tokens NA, NaN and ? are missing, and rows holding them are
+     * handled according to CsvOptions::missing, so that the data never contains NaN. Quoted fields are supported, but may not span lines.
+     */
+    class CsvReader
+    {
+    public:
+        /**
+         * Creates a reader
+         * @param options Controls parsing and type inference
+         * @param factory Used to create variable specifications
+         */
+        explicit CsvReader(CsvOptions options = CsvOptions(),
+            std::shared_ptr<Factory> factory = std::shared_ptr<Factory>());
+
+        /**
+         * Reads and types a delimited file. Throws ConversionException if the file cannot be read,
+         * a row has the wrong number of fields, or a value is missing and CsvOptions::missing is Reject.
+         * @param path The file to read
+         */
+        void read(const std::string& path);
+
+        /**
+         * Reads and types delimited text held in memory
+         * @param buffer The text to read
+         */
+        void read(std::shared_ptr<const MappedBuffer> buffer);
+
+        /**
+         * Retrieves the inferred variables, one per column
+         * @return Variable specifications in column order
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> >& getVariableSpecs() const;
+
+        /**
+         * Retrieves the parsed data with discrete values replaced by level indices
+         * @return A 2D array with rows as instances and columns in the same order as the variables
+         */
+        const boost::multi_array<double, 2>& getData() const;
+
+    private:
+        /** Controls parsing and type inference */
+        CsvOptions options;
+
+        /** Used to create variable specifications */
+        std::shared_ptr<Factory> factory;
+
+        /** The inferred variables */
+        std::vector<std::shared_ptr<VariableSpecification> > varSpecs;
+
+        /** The parsed data */
+        boost::multi_array<double, 2> data;
+    };
+}
+
+#endif
+
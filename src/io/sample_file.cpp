@@ -0,0 +1,342 @@
+
+#include "sample_file.h"
+#include "binary_io.h"
+#include "exceptions/conversion.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<cstring>
+
+#ifdef DEPNET_HAVE_ZLIB
+#include<zlib.h>
+#endif
+
+namespace depnet
+{
+    namespace
+    {
+        const char SAMPLE_FILE_MAGIC[4] = {'D', 'N', 'S', 'F'};
+        const std::uint32_t SAMPLE_FILE_VERSION = 1;
+
+        /**
+         * Encodes a column of values. Grouping the bytes of each double by significance before
+         * deflating places the slowly varying sign, exponent and high mantissa bytes together.
+         */
+        void encodeColumn(ColumnCodec codec, const double* values, std::size_t count, std::vector<char>& encoded)
+        {
+            const char* bytes = reinterpret_cast<const char*>(values);
+            std::size_t size = count * sizeof(double);
+            if(codec == ColumnCodec::Raw)
+            {
+                encoded.assign(bytes, bytes + size);
+                return;
+            }
+
+#ifdef DEPNET_HAVE_ZLIB
+            std::vector<char> shuffled(size);
+            for(std::size_t index = 0; index < count; index++)
+                for(std::size_t byte = 0; byte < sizeof(double); byte++)
+                    shuffled[byte * count + index] = bytes[index * sizeof(double) + byte];
+
+            uLongf encodedSize = compressBound(size);
+            encoded.resize(encodedSize);
+            if(compress2(reinterpret_cast<Bytef*>(encoded.data()), &encodedSize,
+                        reinterpret_cast<const Bytef*>(shuffled.data()), size, Z_BEST_SPEED) != Z_OK)
+                throw ConversionException("Unable to compress a column of samples.");
+            encoded.resize(encodedSize);
+#else
+            throw ConversionException("Compressed sample columns require depnet to be built with zlib.");
+#endif
+        }
+
+        void decodeColumn(ColumnCodec codec, const char* encoded, std::size_t encodedSize,
+                std::size_t count, double* values)
+        {
+            std::size_t size = count * sizeof(double);
+            if(codec == ColumnCodec::Raw)
+            {
+                if(encodedSize != size)
+                    throw ConversionException("Sample file column has an unexpected size.");
+                std::memcpy(values, encoded, size);
+                return;
+            }
+
+#ifdef DEPNET_HAVE_ZLIB
+            std::vector<char> shuffled(size);
+            uLongf decodedSize = size;
+            if(uncompress(reinterpret_cast<Bytef*>(shuffled.data()), &decodedSize,
+                        reinterpret_cast<const Bytef*>(encoded), encodedSize) != Z_OK || decodedSize != size)
+                throw ConversionException("Unable to decompress a column of samples.");
+
+            char* bytes = reinterpret_cast<char*>(values);
+            for(std::size_t index = 0; index < count; index++)
+                for(std::size_t byte = 0; byte < sizeof(double); byte++)
+                    bytes[index * sizeof(double) + byte] = shuffled[byte * count + index];
+#else
+            throw ConversionException("Compressed sample columns require depnet to be built with zlib.");
+#endif
+        }
+    }
+
+    SampleFileOptions::SampleFileOptions() : stripeRows(65536), defaultCodec(ColumnCodec::Raw) { }
+
+    SampleFileWriter::SampleFileWriter(const std::string& path, const std::vector<std::string>& names,
+            SampleFileOptions options) :
+        out(path.c_str(), std::ios::binary | std::ios::trunc), numCols(names.size()),
+        stripeRows(std::max<std::size_t>(options.stripeRows, 1)), filling(0), fillingRows(0),
+        pendingRows(0), numRows(0), closing(false), closed(false)
+    {
+        if(!this->out)
+            throw ConversionException("Unable to create " + path + ".");
+
+        for(std::size_t col = 0; col < this->numCols; col++)
+        {
+            ColumnCodec codec = col < options.codecs.size() ? options.codecs[col] : options.defaultCodec;
+#ifndef DEPNET_HAVE_ZLIB
+            if(codec == ColumnCodec::Deflate)
+                throw ConversionException("Compressed sample columns require depnet to be built with zlib.");
+#endif
+            this->codecs.push_back(codec);
+        }
+
+        binary_io::writeHeader(this->out, SAMPLE_FILE_MAGIC, SAMPLE_FILE_VERSION);
+        binary_io::write<std::uint32_t>(this->out, this->numCols);
+        for(std::size_t col = 0; col < this->numCols; col++)
+        {
+            binary_io::writeString(this->out, names[col]);
+            binary_io::write(this->out, this->codecs[col]);
+        }
+
+        this->stripes[0].resize(this->stripeRows * this->numCols);
+        this->stripes[1].resize(this->stripeRows * this->numCols);
+        this->writer = std::thread(&SampleFileWriter::writeLoop, this);
+    }
+
+    SampleFileWriter::~SampleFileWriter()
+    {
+        try
+        {
+            this->close();
+        }
+        catch(...) { }
+    }
+
+    bool SampleFileWriter::append(const double* rows, std::size_t numRows, std::size_t numCols)
+    {
+        if(numCols != this->numCols)
+            throw ConversionException("Sample width does not match the number of columns in the file.");
+        if(this->closed)
+            throw ConversionException("Unable to append to a closed sample file.");
+
+        for(std::size_t row = 0; row < numRows; row++)
+        {
+            // transposing into the column-major stripe
+            double* stripe = this->stripes[this->filling].data() + this->fillingRows;
+            const double* values = rows + row * numCols;
+            for(std::size_t col = 0; col < numCols; col++)
+                stripe[col * this->stripeRows] = values[col];
+
+            this->numRows++;
+            if(++this->fillingRows == this->stripeRows)
+                this->flushStripe();
+        }
+        return true;
+    }
+
+    SampleCallback SampleFileWriter::callback()
+    {
+        return [this](const double* rows, std::size_t numRows, std::size_t numCols)
+        {
+            return this->append(rows, numRows, numCols);
+        };
+    }
+
+    void SampleFileWriter::flushStripe()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        {
+            // the sampler stalls here whenever the writer thread falls behind
+            TraceSpan span("SampleFileWriter hand-off", "queue");
+            this->stripeWritten.wait(lock, [this]() { return this->pendingRows == 0 || this->error; });
+        }
+        lock.unlock();
+        this->checkError();
+
+        lock.lock();
+        this->pendingRows = this->fillingRows;
+        this->filling = 1 - this->filling;
+        this->fillingRows = 0;
+        lock.unlock();
+        this->stripeReady.notify_one();
+    }
+
+    void SampleFileWriter::close()
+    {
+        if(this->closed)
+            return;
+        this->closed = true;
+
+        // the writer thread must be joined even if the final stripe cannot be handed over
+        std::exception_ptr failure;
+        try
+        {
+            if(this->fillingRows > 0)
+                this->flushStripe();
+        }
+        catch(...)
+        {
+            failure = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->closing = true;
+        }
+        this->stripeReady.notify_one();
+        this->writer.join();
+        if(failure)
+            std::rethrow_exception(failure);
+        this->checkError();
+
+        binary_io::write<std::uint32_t>(this->out, 0);
+        binary_io::write<std::uint64_t>(this->out, this->numRows);
+        this->out.close();
+        if(this->out.fail())
+            throw ConversionException("Unable to finish writing the sample file.");
+    }
+
+    std::uint64_t SampleFileWriter::getNumRows() const
+    {
+        return this->numRows;
+    }
+
+    void SampleFileWriter::writeLoop()
+    {
+        std::vector<char> encoded;
+        while(true)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->stripeReady.wait(lock, [this]() { return this->pendingRows > 0 || this->closing; });
+            if(this->pendingRows == 0)
+                return;
+            std::size_t numRows = this->pendingRows;
+            const double* stripe = this->stripes[1 - this->filling].data();
+            lock.unlock();
+
+            try
+            {
+                TraceSpan span("SampleFileWriter::writeStripe", "io");
+                binary_io::write<std::uint32_t>(this->out, numRows);
+                for(std::size_t col = 0; col < this->numCols; col++)
+                {
+                    encodeColumn(this->codecs[col], stripe + col * this->stripeRows, numRows, encoded);
+                    binary_io::write<std::uint64_t>(this->out, encoded.size());
+                    this->out.write(encoded.data(), encoded.size());
+                }
+                if(!this->out)
+                    throw ConversionException("Unable to write to the sample file.");
+            }
+            catch(...)
+            {
+                lock.lock();
+                this->error = std::current_exception();
+                this->pendingRows = 0;
+                lock.unlock();
+                this->stripeWritten.notify_one();
+                return;
+            }
+
+            lock.lock();
+            this->pendingRows = 0;
+            lock.unlock();
+            this->stripeWritten.notify_one();
+        }
+    }
+
+    void SampleFileWriter::checkError()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(this->error)
+            std::rethrow_exception(this->error);
+    }
+
+    SampleFileReader::SampleFileReader(const std::string& path) :
+        buffer(MappedBuffer::mapFile(path)), numRows(0)
+    {
+        binary_io::MemoryReader reader(this->buffer);
+        char magic[4];
+        for(int i = 0; i < 4; i++)
+            magic[i] = reader.read<char>();
+        std::uint32_t version = reader.read<std::uint32_t>();
+        if(!std::equal(magic, magic + 4, SAMPLE_FILE_MAGIC))
+            throw ConversionException("Binary input is not in the expected DNSF format.");
+        if(version == 0 || version > SAMPLE_FILE_VERSION)
+            throw ConversionException("Unsupported binary format version " + std::to_string(version) + ".");
+
+        std::uint32_t numCols = reader.read<std::uint32_t>();
+        for(std::uint32_t col = 0; col < numCols; col++)
+        {
+            this->names.push_back(reader.readString());
+            this->codecs.push_back(reader.read<ColumnCodec>());
+        }
+
+        std::uint64_t stripeTotal = 0;
+        while(std::uint32_t rows = reader.read<std::uint32_t>())
+        {
+            this->stripeRows.push_back(rows);
+            stripeTotal += rows;
+            for(std::uint32_t col = 0; col < numCols; col++)
+            {
+                Block block;
+                block.size = reader.read<std::uint64_t>();
+                block.offset = reader.tell();
+                reader.skip(block.size);
+                this->blocks.push_back(block);
+            }
+        }
+
+        this->numRows = reader.read<std::uint64_t>();
+        if(this->numRows != stripeTotal)
+            throw ConversionException("Sample file row count does not match its stripes.");
+    }
+
+    const std::vector<std::string>& SampleFileReader::getNames() const
+    {
+        return this->names;
+    }
+
+    std::uint64_t SampleFileReader::getNumRows() const
+    {
+        return this->numRows;
+    }
+
+    std::vector<double> SampleFileReader::readColumn(std::size_t column) const
+    {
+        if(column >= this->names.size())
+            throw ConversionException("Sample file column index is out of range.");
+
+        std::vector<double> values(this->numRows);
+        std::size_t position = 0;
+        for(std::size_t stripe = 0; stripe < this->stripeRows.size(); stripe++)
+        {
+            const Block& block = this->blocks[stripe * this->names.size() + column];
+            decodeColumn(this->codecs[column], this->buffer->data() + block.offset, block.size,
+                    this->stripeRows[stripe], values.data() + position);
+            position += this->stripeRows[stripe];
+        }
+        return values;
+    }
+
+    boost::multi_array<double, 2> SampleFileReader::readAll() const
+    {
+        boost::multi_array<double, 2> samples(boost::extents[this->numRows][this->names.size()]);
+        for(std::size_t col = 0; col < this->names.size(); col++)
+        {
+            std::vector<double> values = this->readColumn(col);
+            for(std::size_t row = 0; row < values.size(); row++)
+                samples[row][col] = values[row];
+        }
+        return samples;
+    }
+}
+
@@ -0,0 +1,238 @@
+#pragma once
+
+#ifndef SAMPLE_FILE_H
+#define SAMPLE_FILE_H
+
+#include<condition_variable>
+#include<cstddef>
+#include<cstdint>
+#include<exception>
+#include<fstream>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "sample_buffer.h"
+#include "mapped_buffer.h"
+
+namespace depnet
+{
+    /**
+     * How a column of samples is stored within each stripe of a sample file
+     */
+    enum class ColumnCodec : std::uint8_t
+    {
+        /** Values are stored as native doubles */
+        Raw = 0,
+
+        /** The bytes of each value are grouped by significance and then deflated with zlib */
+        Deflate = 1
+    };
+
+    /**
+     * Controls the layout of a sample file
+     */
+    struct SampleFileOptions
+    {
+        /** Creates options for uncompressed stripes of 65536 rows */
+        SampleFileOptions();
+
+        /** The number of rows buffered and written together. Two stripes are held in memory. */
+        std::size_t stripeRows;
+
+        /** The codec used for columns without an entry in SampleFileOptions::codecs */
+        ColumnCodec defaultCodec;
+
+        /** Per-column codecs in variable order, which may be shorter than the number of columns */
+        std::vector<ColumnCodec> codecs;
+    };
+
+    /**
+     * Writes samples to a columnar binary file. Rows are transposed into a stripe in memory,
+     * and full stripes are encoded and written by a background thread while the next stripe fills,
+     * so the sampler only waits on the disk if it persistently outpaces it.
+     *
+     * The file starts with a "DNSF" header, the column names and codecs, followed by stripes each
+     * holding a row count and one length-prefixed block per column. A zero row count ends the stripes
+     * and is followed by the total number of rows.
+     */
+    class SampleFileWriter
+    {
+    public:
+        /**
+         * Creates a file and starts the writer thread.
+         * Throws ConversionException if the file cannot be created or a codec is unavailable.
+         * @param path The file to write
+         * @param names The names of the columns, in variable order
+         * @param options Controls stripe size and compression
+         */
+        SampleFileWriter(const std::string& path, const std::vector<std::string>& names,
+            SampleFileOptions options = SampleFileOptions());
+
+        /** Finishes the file if SampleFileWriter::close has not been called, discarding any error */
+        ~SampleFileWriter();
+
+        /**
+         * Appends rows, matching the signature of SampleCallback.
+         * Rethrows any failure from the writer thread as a ConversionException.
+         * @param rows numRows * numCols values in row-major order
+         * @param numRows The number of rows
+         * @param numCols The number of values in each row, which must match the number of columns
+         * @return true, so that sampling continues
+         */
+        bool append(const double* rows, std::size_t numRows, std::size_t numCols);
+
+        /**
+         * Creates a callback which appends blocks to this file, for use with DependencyNetwork::getSamples
+         * @return A callback referring to this writer, which must outlive it
+         */
+        SampleCallback callback();
+
+        /**
+         * Writes any partial stripe, ends the file and stops the writer thread.
+         * Rethrows any failure from the writer thread as a ConversionException.
+         */
+        void close();
+
+        /**
+         * Retrieves the number of rows appended so far
+         * @return The number of rows
+         */
+        std::uint64_t getNumRows() const;
+
+    private:
+        /** Writers own a file and a thread, and are never copied */
+        SampleFileWriter(const SampleFileWriter&);
+        SampleFileWriter& operator=(const SampleFileWriter&);
+
+        /** Hands the filling stripe to the writer thread, waiting for the previous one to be written */
+        void flushStripe();
+
+        /** Encodes and writes stripes until closed */
+        void writeLoop();
+
+        /** Rethrows a failure captured on the writer thread */
+        void checkError();
+
+        /** The file being written */
+        std::ofstream out;
+
+        /** The number of values in each row */
+        std::size_t numCols;
+
+        /** The number of rows in a full stripe */
+        std::size_t stripeRows;
+
+        /** The codec of each column */
+        std::vector<ColumnCodec> codecs;
+
+        /** Two column-major stripes, one filling while the other is written */
+        std::vector<double> stripes[2];
+
+        /** The index of the stripe being filled */
+        int filling;
+
+        /** The number of rows in the stripe being filled */
+        std::size_t fillingRows;
+
+        /** The number of rows in the stripe handed to the writer thread, or 0 if there is none */
+        std::size_t pendingRows;
+
+        /** The number of rows appended */
+        std::uint64_t numRows;
+
+        /** Indicates that no more stripes will be handed over */
+        bool closing;
+
+        /** Indicates that the file has been finished */
+        bool closed;
+
+        /** A failure on the writer thread */
+        std::exception_ptr error;
+
+        /** Guards the handover between the sampling and writer threads */
+        std::mutex mutex;
+
+        /** Signalled when a stripe is handed over or the writer is closing */
+        std::condition_variable stripeReady;
+
+        /** Signalled when the writer thread finishes with a stripe */
+        std::condition_variable stripeWritten;
+
+        /** Encodes and writes stripes */
+        std::thread writer;
+    };
+
+    /**
+     * Reads a file written by SampleFileWriter. The file is memory-mapped and only the
+     * stripes of requested columns are decoded.
+     */
+    class SampleFileReader
+    {
+    public:
+        /**
+         * Opens a sample file, indexing its stripes.
+         * Throws ConversionException if the file is not a complete sample file.
+         * @param path The file to read
+         */
+        explicit SampleFileReader(const std::string& path);
+
+        /**
+         * Retrieves the column names
+         * @return The names in variable order
+         */
+        const std::vector<std::string>& getNames() const;
+
+        /**
+         * Retrieves the number of rows in the file
+         * @return The number of rows
+         */
+        std::uint64_t getNumRows() const;
+
+        /**
+         * Decodes a single column
+         * @param column The index of the column
+         * @return Every value of the column, in row order
+         */
+        std::vector<double> readColumn(std::size_t column) const;
+
+        /**
+         * Decodes every column
+         * @return A 2D array with samples in rows and variables in columns
+         */
+        boost::multi_array<double, 2> readAll() const;
+
+    private:
+        /** The location of one column's block within one stripe */
+        struct Block
+        {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        /** The mapped file */
+        std::shared_ptr<const MappedBuffer> buffer;
+
+        /** The column names */
+        std::vector<std::string> names;
+
+        /** The codec of each column */
+        std::vector<ColumnCodec> codecs;
+
+        /** The number of rows in each stripe */
+        std::vector<std::size_t> stripeRows;
+
+        /** The block of each column in each stripe, stripe-major */
+        std::vector<Block> blocks;
+
+        /** The number of rows in the file */
+        std::uint64_t numRows;
+    };
+}
+
+#endif
+
@@ -0,0 +1,104 @@
+
+#include "level_dictionary.h"
+#include "exceptions/conversion.h"
+
+#include<algorithm>
+#include<mutex>
+#include<unordered_map>
+
+namespace depnet
+{
+    namespace
+    {
+        /** The fewest entries the pool holds before expired ones are swept */
+        const std::size_t MIN_SWEEP_SIZE = 64;
+
+        /**
+         * Dictionaries currently alive, keyed by a hash of their level list, so that the pool holds no copy 
+         * of the names. Entries of expired dictionaries are swept once the pool has doubled since the last sweep.
+         */
+        struct InternPool
+        {
+            InternPool() : sweepSize(MIN_SWEEP_SIZE) { }
+
+            std::unordered_multimap<std::size_t, std::weak_ptr<const LevelDictionary> > entries;
+            std::size_t sweepSize;
+            std::mutex mutex;
+        };
+
+        InternPool& internPool()
+        {
+            static InternPool pool;
+            return pool;
+        }
+
+        std::size_t hashLevels(const std::vector<std::string>& levels)
+        {
+            std::size_t seed = levels.size();
+            for(auto it = levels.begin(); it != levels.end(); ++it)
+                seed ^= std::hash<std::string>()(*it) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    }
+
+    LevelDictionary::LevelDictionary(const std::vector<std::string>& levels) : levels(levels)
+    {
+        this->codes.reserve(this->levels.size());
+        for(std::size_t code = 0; code < this->levels.size(); code++)
+        {
+            if(!this->codes.insert(std::make_pair(&this->levels[code], static_cast<int>(code))).second)
+                throw ConversionException("Level " + this->levels[code] + " is repeated.");
+        }
+    }
+
+    std::shared_ptr<const LevelDictionary> LevelDictionary::intern(const std::vector<std::string>& levels)
+    {
+        InternPool& pool = internPool();
+        std::size_t hash = hashLevels(levels);
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto range = pool.entries.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            std::shared_ptr<const LevelDictionary> dictionary = it->second.lock();
+            if(dictionary && dictionary->getLevels() == levels)
+                return dictionary;
+        }
+
+        std::shared_ptr<const LevelDictionary> dictionary(new LevelDictionary(levels));
+        if(pool.entries.size() >= pool.sweepSize)
+        {
+            for(auto it = pool.entries.begin(); it != pool.entries.end(); )
+            {
+                if(it->second.expired())
+                    it = pool.entries.erase(it);
+                else
+                    ++it;
+            }
+            pool.sweepSize = std::max(MIN_SWEEP_SIZE, 2 * pool.entries.size());
+        }
+        pool.entries.insert(std::make_pair(hash, std::weak_ptr<const LevelDictionary>(dictionary)));
+        return dictionary;
+    }
+
+    std::shared_ptr<const LevelDictionary> LevelDictionary::empty()
+    {
+        static std::shared_ptr<const LevelDictionary> dictionary = LevelDictionary::intern(std::vector<std::string>());
+        return dictionary;
+    }
+
+    void LevelDictionary::write(std::ostream& out) const
+    {
+        binary_io::write<std::uint32_t>(out, this->levels.size());
+        for(auto it = this->levels.begin(); it != this->levels.end(); ++it)
+            binary_io::writeString(out, *it);
+    }
+
+    std::shared_ptr<const LevelDictionary> LevelDictionary::read(binary_io::MemoryReader& in)
+    {
+        std::vector<std::string> levels(in.read<std::uint32_t>());
+        for(auto it = levels.begin(); it != levels.end(); ++it)
+            *it = in.readString();
+        return LevelDictionary::intern(levels);
+    }
+}
+
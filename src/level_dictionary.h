@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef LEVEL_DICTIONARY_H
+#define LEVEL_DICTIONARY_H
+
+#include<cstddef>
+#include<functional>
+#include<memory>
+#include<ostream>
+#include<string>
+#include<unordered_map>
+#include<vector>
+
+#include "binary_io.h"
+
+namespace depnet
+{
+    /**
+     * An immutable, two-way mapping between the names of a discrete variable's levels and their integer codes.
+     * Codes are positions in the level list, so lookups in either direction take constant time.
+     * Dictionaries are interned: every specification with the same level list shares one instance,
+     * so thousands of variables over the same categories (e.g. "no"/"yes") hold a single copy.
+     */
+    class LevelDictionary
+    {
+    public:
+        /**
+         * Retrieves the shared dictionary for a list of levels, creating it if necessary.
+         * Throws ConversionException if a level name is repeated.
+         * @param levels The names of the levels in code order
+         * @return A dictionary shared with every other caller interning the same list
+         */
+        static std::shared_ptr<const LevelDictionary> intern(const std::vector<std::string>& levels);
+
+        /**
+         * Retrieves the shared dictionary with no levels
+         * @return An empty dictionary
+         */
+        static std::shared_ptr<const LevelDictionary> empty();
+
+        /**
+         * Writes the level names, length-prefixed
+         * @param out The stream to write to
+         */
+        void write(std::ostream& out) const;
+
+        /**
+         * Reads and interns a dictionary written by LevelDictionary::write
+         * @param in The reader to read from
+         * @return The shared dictionary
+         */
+        static std::shared_ptr<const LevelDictionary> read(binary_io::MemoryReader& in);
+
+        /**
+         * Retrieves the name of a level
+         * @param code The level's code, which must be less than LevelDictionary::size
+         * @return The level's name
+         */
+        const std::string& getLevel(std::size_t code) const
+        {
+            return this->levels[code];
+        }
+
+        /**
+         * Looks up the code of a level by name
+         * @param level The name of the level
+         * @return The level's code, or -1 if there is no such level
+         */
+        int getCode(const std::string& level) const
+        {
+            auto it = this->codes.find(&level);
+            return it == this->codes.end() ? -1 : it->second;
+        }
+
+        /**
+         * Retrieves every level name
+         * @return The names in code order
+         */
+        const std::vector<std::string>& getLevels() const
+        {
+            return this->levels;
+        }
+
+        /**
+         * Retrieves the number of levels
+         * @return The number of levels
+         */
+        std::size_t size() const
+        {
+            return this->levels.size();
+        }
+
+    private:
+        /** Hashes the string a key points to, so that keys can refer to the level list without copying it */
+        struct Hash
+        {
+            std::size_t operator()(const std::string* key) const
+            {
+                return std::hash<std::string>()(*key);
+            }
+        };
+
+        /** Compares the strings two keys point to */
+        struct Equal
+        {
+            bool operator()(const std::string* a, const std::string* b) const
+            {
+                return *a == *b;
+            }
+        };
+
+        /** Dictionaries are only created by LevelDictionary::intern */
+        explicit LevelDictionary(const std::vector<std::string>& levels);
+        LevelDictionary(const LevelDictionary&);
+        LevelDictionary& operator=(const LevelDictionary&);
+
+        /** The level names in code order */
+        std::vector<std::string> levels;
+
+        /** The code of each level, keyed by pointers into the level list */
+        std::unordered_map<const std::string*, int, Hash, Equal> codes;
+    };
+}
+
+#endif
+
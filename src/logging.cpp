@@ -0,0 +1,102 @@
+
+#include "logging.h"
+
+#include<iostream>
+
+namespace depnet
+{
+    const char* logLevelName(LogLevel level)
+    {
+        switch(level)
+        {
+            case LogLevel::Trace: return "TRACE";
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO";
+            case LogLevel::Warn: return "WARN";
+            case LogLevel::Error: return "ERROR";
+            default: return "OFF";
+        }
+    }
+
+    StreamLogSink::StreamLogSink(std::ostream& stream) : stream(stream) { }
+
+    void StreamLogSink::write(const LogRecord& record)
+    {
+        this->stream << "[" << logLevelName(record.level) << "] "
+            << record.file << ":" << record.line << " " << record.message << std::endl;
+    }
+
+    // warnings and errors go to standard error unless configured otherwise
+    std::atomic<int> Logger::level(static_cast<int>(LogLevel::Warn));
+    std::atomic<int> Logger::numSinks(1);
+
+    std::vector<std::shared_ptr<LogSink> >& Logger::sinks()
+    {
+        static std::vector<std::shared_ptr<LogSink> > registered(
+            1, std::shared_ptr<LogSink>(new StreamLogSink(std::cerr)));
+        return registered;
+    }
+
+    std::mutex& Logger::sinkMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    bool Logger::isEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= Logger::level.load(std::memory_order_relaxed) &&
+            Logger::numSinks.load(std::memory_order_relaxed) > 0;
+    }
+
+    void Logger::setLevel(LogLevel level)
+    {
+        Logger::level.store(static_cast<int>(level));
+    }
+
+    LogLevel Logger::getLevel()
+    {
+        return static_cast<LogLevel>(Logger::level.load());
+    }
+
+    void Logger::addSink(std::shared_ptr<LogSink> sink)
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex());
+        sinks().push_back(sink);
+        numSinks.store(sinks().size());
+    }
+
+    void Logger::clearSinks()
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex());
+        sinks().clear();
+        numSinks.store(0);
+    }
+
+    void Logger::write(LogLevel level, const char* file, int line, const std::string& message)
+    {
+        LogRecord record = {level, file, line, message};
+
+        std::lock_guard<std::mutex> lock(sinkMutex());
+        for(auto sinkIt = sinks().begin(); sinkIt != sinks().end(); ++sinkIt)
+            (*sinkIt)->write(record);
+    }
+
+    LogRateLimiter::LogRateLimiter(int maxPerSecond) :
+        maxPerSecond(maxPerSecond), windowStart(0), count(0) { }
+
+    bool LogRateLimiter::allow()
+    {
+        typedef std::chrono::steady_clock clock;
+        long long now = clock::now().time_since_epoch().count();
+        long long window = std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)).count();
+
+        long long start = this->windowStart.load(std::memory_order_relaxed);
+        if(now - start >= window &&
+                this->windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+            this->count.store(0, std::memory_order_relaxed);
+
+        return this->count.fetch_add(1, std::memory_order_relaxed) < this->maxPerSecond;
+    }
+}
+
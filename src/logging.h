@@ -0,0 +1,262 @@
+#pragma once
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include<atomic>
+#include<chrono>
+#include<memory>
+#include<mutex>
+#include<ostream>
+#include<sstream>
+#include<string>
+#include<vector>
+
+/** Numeric log levels, usable in preprocessor comparisons */
+#define DEPNET_LOG_LEVEL_TRACE 0
+#define DEPNET_LOG_LEVEL_DEBUG 1
+#define DEPNET_LOG_LEVEL_INFO 2
+#define DEPNET_LOG_LEVEL_WARN 3
+#define DEPNET_LOG_LEVEL_ERROR 4
+#define DEPNET_LOG_LEVEL_OFF 5
+
+/**
+ * The lowest level compiled into the binary. Statements below this level expand to nothing,
+ * so their arguments are never evaluated. Override with -DDEPNET_LOG_LEVEL=DEPNET_LOG_LEVEL_TRACE.
+ */
+#ifndef DEPNET_LOG_LEVEL
+#define DEPNET_LOG_LEVEL DEPNET_LOG_LEVEL_INFO
+#endif
+
+namespace depnet
+{
+    /** Severity of a log record */
+    enum class LogLevel : int
+    {
+        Trace = DEPNET_LOG_LEVEL_TRACE,
+        Debug = DEPNET_LOG_LEVEL_DEBUG,
+        Info = DEPNET_LOG_LEVEL_INFO,
+        Warn = DEPNET_LOG_LEVEL_WARN,
+        Error = DEPNET_LOG_LEVEL_ERROR,
+        Off = DEPNET_LOG_LEVEL_OFF
+    };
+
+    /**
+     * Retrieves a short upper-case name for a log level
+     * @param level The level to name
+     * @return The name of the level, e.g. "WARN"
+     */
+    const char* logLevelName(LogLevel level);
+
+    /** A single message passed to each LogSink */
+    struct LogRecord
+    {
+        /** The severity of the message */
+        LogLevel level;
+
+        /** The source file which produced the message */
+        const char* file;
+
+        /** The line in the source file which produced the message */
+        int line;
+
+        /** The formatted message */
+        std::string message;
+    };
+
+    /**
+     * A destination for log records. Logger calls every sink while holding a single lock, so records
+     * reach a sink one at a time even when they are logged from several threads, and implementations
+     * need not be thread-safe. A sink must not log from write, which would deadlock.
+     */
+    class LogSink
+    {
+    public:
+        virtual ~LogSink() { }
+
+        /**
+         * Handles a single log record
+         * @param record The record to write
+         */
+        virtual void write(const LogRecord& record) = 0;
+    };
+
+    /**
+     * Writes log records as lines of text to a stream
+     */
+    class StreamLogSink : public LogSink
+    {
+    public:
+        /**
+         * Creates a sink which writes to a stream
+         * @param stream The stream to write to, which must outlive the sink
+         */
+        explicit StreamLogSink(std::ostream& stream);
+
+        /**
+         * Writes a record formatted as "[LEVEL] file:line message"
+         * @param record The record to write
+         */
+        void write(const LogRecord& record);
+
+    private:
+        /** The stream to write to */
+        std::ostream& stream;
+    };
+
+    /**
+     * Process-wide log configuration and dispatch. Levels below DEPNET_LOG_LEVEL are removed
+     * at compile time; the remaining levels can be filtered further at runtime with Logger::setLevel.
+     */
+    class Logger
+    {
+    public:
+        /**
+         * Indicates if a record at the specified level would be written
+         * @param level The level of a prospective record
+         * @return true if the level is at or above the runtime threshold and a sink is registered
+         */
+        static bool isEnabled(LogLevel level);
+
+        /**
+         * Establishes the runtime threshold. Levels below DEPNET_LOG_LEVEL cannot be enabled this way.
+         * @param level The lowest level to write
+         */
+        static void setLevel(LogLevel level);
+
+        /**
+         * Retrieves the runtime threshold
+         * @return The lowest level that will be written
+         */
+        static LogLevel getLevel();
+
+        /**
+         * Registers an additional sink which will receive every record that passes the threshold
+         * @param sink The sink to add
+         */
+        static void addSink(std::shared_ptr<LogSink> sink);
+
+        /**
+         * Removes all registered sinks, including the default standard error sink
+         */
+        static void clearSinks();
+
+        /**
+         * Dispatches a record to every registered sink, one record at a time across all threads
+         * @param level The severity of the message
+         * @param file The source file which produced the message
+         * @param line The line in the source file which produced the message
+         * @param message The formatted message
+         */
+        static void write(LogLevel level, const char* file, int line, const std::string& message);
+
+    private:
+        /** The runtime threshold */
+        static std::atomic<int> level;
+
+        /** The number of registered sinks, checked without locking */
+        static std::atomic<int> numSinks;
+
+        /** Registered sinks */
+        static std::vector<std::shared_ptr<LogSink> >& sinks();
+
+        /** Guards sinks and serializes writes */
+        static std::mutex& sinkMutex();
+    };
+
+    /**
+     * Limits how often a single log statement may fire.
+     * Allows up to maxPerSecond records in each one-second window and drops the rest.
+     */
+    class LogRateLimiter
+    {
+    public:
+        /**
+         * Creates a rate limiter
+         * @param maxPerSecond The number of records permitted in each one-second window
+         */
+        explicit LogRateLimiter(int maxPerSecond);
+
+        /**
+         * Claims a slot in the current window
+         * @return true if the record should be written, false if it should be dropped
+         */
+        bool allow();
+
+    private:
+        /** The number of records permitted in each window */
+        int maxPerSecond;
+
+        /** The start of the current window in steady clock ticks */
+        std::atomic<long long> windowStart;
+
+        /** The number of records claimed in the current window */
+        std::atomic<int> count;
+    };
+}
+
+/** Formats and dispatches a record if the level is enabled at runtime */
+#define DEPNET_LOG_AT(level, expr) \
+    do { \
+        if(depnet::Logger::isEnabled(level)) \
+        { \
+            std::ostringstream depnetLogStream; \
+            depnetLogStream << expr; \
+            depnet::Logger::write(level, __FILE__, __LINE__, depnetLogStream.str()); \
+        } \
+    } while(0)
+
+/** Writes at most maxPerSecond records per second from this statement */
+#define DEPNET_LOG_RATE_LIMITED_AT(level, maxPerSecond, expr) \
+    do { \
+        static depnet::LogRateLimiter depnetLogLimiter(maxPerSecond); \
+        if(depnet::Logger::isEnabled(level) && depnetLogLimiter.allow()) \
+        { \
+            std::ostringstream depnetLogStream; \
+            depnetLogStream << expr; \
+            depnet::Logger::write(level, __FILE__, __LINE__, depnetLogStream.str()); \
+        } \
+    } while(0)
+
+#define DEPNET_LOG_DISABLED() do { } while(0)
+
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_TRACE
+#define DEPNET_TRACE(expr) DEPNET_LOG_AT(depnet::LogLevel::Trace, expr)
+#define DEPNET_TRACE_LIMITED(maxPerSecond, expr) DEPNET_LOG_RATE_LIMITED_AT(depnet::LogLevel::Trace, maxPerSecond, expr)
+#else
+#define DEPNET_TRACE(expr) DEPNET_LOG_DISABLED()
+#define DEPNET_TRACE_LIMITED(maxPerSecond, expr) DEPNET_LOG_DISABLED()
+#endif
+
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_DEBUG
+#define DEPNET_DEBUG(expr) DEPNET_LOG_AT(depnet::LogLevel::Debug, expr)
+#define DEPNET_DEBUG_LIMITED(maxPerSecond, expr) DEPNET_LOG_RATE_LIMITED_AT(depnet::LogLevel::Debug, maxPerSecond, expr)
+#else
+#define DEPNET_DEBUG(expr) DEPNET_LOG_DISABLED()
+#define DEPNET_DEBUG_LIMITED(maxPerSecond, expr) DEPNET_LOG_DISABLED()
+#endif
+
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_INFO
+#define DEPNET_INFO(expr) DEPNET_LOG_AT(depnet::LogLevel::Info, expr)
+#define DEPNET_INFO_LIMITED(maxPerSecond, expr) DEPNET_LOG_RATE_LIMITED_AT(depnet::LogLevel::Info, maxPerSecond, expr)
+#else
+#define DEPNET_INFO(expr) DEPNET_LOG_DISABLED()
+#define DEPNET_INFO_LIMITED(maxPerSecond, expr) DEPNET_LOG_DISABLED()
+#endif
+
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_WARN
+#define DEPNET_WARN(expr) DEPNET_LOG_AT(depnet::LogLevel::Warn, expr)
+#define DEPNET_WARN_LIMITED(maxPerSecond, expr) DEPNET_LOG_RATE_LIMITED_AT(depnet::LogLevel::Warn, maxPerSecond, expr)
+#else
+#define DEPNET_WARN(expr) DEPNET_LOG_DISABLED()
+#define DEPNET_WARN_LIMITED(maxPerSecond, expr) DEPNET_LOG_DISABLED()
+#endif
+
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_ERROR
+#define DEPNET_ERROR(expr) DEPNET_LOG_AT(depnet::LogLevel::Error, expr)
+#else
+#define DEPNET_ERROR(expr) DEPNET_LOG_DISABLED()
+#endif
+
+#endif
+
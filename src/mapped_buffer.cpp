@@ -0,0 +1,96 @@
+
+#include "mapped_buffer.h"
+#include "exceptions/conversion.h"
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+namespace depnet
+{
+    std::shared_ptr<MappedBuffer> MappedBuffer::mapFile(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            throw ConversionException("Unable to open " + path + ".");
+        return mapDescriptor(fd, path);
+    }
+
+    std::shared_ptr<MappedBuffer> MappedBuffer::mapSharedMemory(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if(fd < 0)
+            throw ConversionException("Unable to open shared memory segment " + name + ".");
+        return mapDescriptor(fd, name);
+    }
+
+    void MappedBuffer::publishSharedMemory(const std::string& name, const char* data, std::size_t size)
+    {
+        // processes may still map the old segment, so it is unlinked rather than truncated and rewritten
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if(fd < 0)
+            throw ConversionException("Unable to create shared memory segment " + name + ".");
+
+        bool written = ftruncate(fd, size) == 0;
+        for(std::size_t offset = 0; written && offset < size; )
+        {
+            ssize_t count = write(fd, data + offset, size - offset);
+            written = count > 0;
+            offset += written ? count : 0;
+        }
+        close(fd);
+        if(!written)
+        {
+            shm_unlink(name.c_str());
+            throw ConversionException("Unable to write shared memory segment " + name + ".");
+        }
+    }
+
+    void MappedBuffer::unlinkSharedMemory(const std::string& name)
+    {
+        shm_unlink(name.c_str());
+    }
+
+    std::shared_ptr<MappedBuffer> MappedBuffer::mapDescriptor(int fd, const std::string& name)
+    {
+        struct stat info;
+        if(fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw ConversionException("Unable to determine the size of " + name + ".");
+        }
+
+        std::size_t size = info.st_size;
+        void* mapped = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+        close(fd);
+        if(mapped == MAP_FAILED)
+            throw ConversionException("Unable to map " + name + " into memory.");
+
+        std::shared_ptr<MappedBuffer> buffer(new MappedBuffer(static_cast<const char*>(mapped), size, 
+                    std::shared_ptr<const void>()));
+        buffer->isMapped = mapped != NULL;
+        return buffer;
+    }
+
+    MappedBuffer::MappedBuffer(const char* data, std::size_t size, std::shared_ptr<const void> owner) :
+        bytes(data), length(size), isMapped(false), owner(owner) { }
+
+    MappedBuffer::~MappedBuffer()
+    {
+        if(this->isMapped)
+            munmap(const_cast<char*>(this->bytes), this->length);
+    }
+
+    const char* MappedBuffer::data() const
+    {
+        return this->bytes;
+    }
+
+    std::size_t MappedBuffer::size() const
+    {
+        return this->length;
+    }
+}
+
@@ -0,0 +1,106 @@
+#pragma once
+
+#ifndef MAPPED_BUFFER_H
+#define MAPPED_BUFFER_H
+
+#include<cstddef>
+#include<memory>
+#include<string>
+
+namespace depnet
+{
+    /**
+     * A read-only region of memory holding serialized data, either a memory-mapped file or 
+     * memory owned by some other object. Models loaded from the buffer may refer to it in place,
+     * so they hold a shared pointer to it for as long as they are alive.
+     */
+    class MappedBuffer
+    {
+    public:
+        /**
+         * Maps a file read-only into memory.
+         * Throws ConversionException if the file cannot be opened or mapped.
+         * @param path The file to map
+         * @return A buffer over the file's contents, unmapped when the last reference is released
+         */
+        static std::shared_ptr<MappedBuffer> mapFile(const std::string& path);
+
+        /**
+         * Maps a POSIX shared memory segment read-only into memory. Every process mapping the
+         * segment shares the same physical pages, so N processes hold one copy of the data.
+         * Throws ConversionException if the segment cannot be opened or mapped.
+         * @param name The name of the segment, e.g. "/depnet_model", as passed to shm_open
+         * @return A buffer over the segment, unmapped when the last reference is released
+         */
+        static std::shared_ptr<MappedBuffer> mapSharedMemory(const std::string& name);
+
+        /**
+         * Creates or replaces a POSIX shared memory segment holding a copy of some data.
+         * A segment being replaced is unlinked and a new one created, so processes which already map it
+         * keep the old contents. The segment persists until MappedBuffer::unlinkSharedMemory is called, even
+         * after every process has unmapped it. Throws ConversionException if the segment cannot be written.
+         * @param name The name of the segment
+         * @param data The first byte to copy
+         * @param size The number of bytes to copy
+         */
+        static void publishSharedMemory(const std::string& name, const char* data, std::size_t size);
+
+        /**
+         * Removes a shared memory segment's name. Processes which have already mapped it keep their mappings.
+         * @param name The name of the segment
+         */
+        static void unlinkSharedMemory(const std::string& name);
+
+        /**
+         * Wraps memory owned elsewhere, such as a string or a shared memory segment
+         * @param data The first byte of the region
+         * @param size The number of bytes in the region
+         * @param owner Kept alive for as long as the buffer is alive. May be null if 
+         * the caller guarantees the memory outlives every model loaded from it.
+         */
+        MappedBuffer(const char* data, std::size_t size, std::shared_ptr<const void> owner);
+
+        /** Releases the mapping, if this buffer created one */
+        ~MappedBuffer();
+
+        /**
+         * Retrieves the start of the region
+         * @return A pointer to the first byte
+         */
+        const char* data() const;
+
+        /**
+         * Retrieves the length of the region
+         * @return The number of bytes
+         */
+        std::size_t size() const;
+
+    private:
+        /**
+         * Maps an open descriptor read-only, closing the descriptor
+         * @param fd The descriptor of a file or shared memory segment
+         * @param name The name of the file or segment, for error messages
+         * @return A buffer over the mapping
+         */
+        static std::shared_ptr<MappedBuffer> mapDescriptor(int fd, const std::string& name);
+
+        /** Buffers are shared, never copied */
+        MappedBuffer(const MappedBuffer&);
+        MappedBuffer& operator=(const MappedBuffer&);
+
+        /** The first byte of the region */
+        const char* bytes;
+
+        /** The number of bytes in the region */
+        std::size_t length;
+
+        /** Indicates that the region was created by mmap and must be unmapped */
+        bool isMapped;
+
+        /** Keeps externally owned memory alive */
+        std::shared_ptr<const void> owner;
+    };
+}
+
+#endif
+
@@ -21,6 +21,19 @@ namespace depnet
        virtual SampleType const operator++() = 0;
        virtual SampleType const operator++(int) = 0;
        virtual SampleType const operator*() const = 0;
+
+       /**
+        * Captures the state of the underlying sampler and the iterator's position
+        * @param checkpoint The checkpoint to populate
+        */
+       virtual void saveCheckpoint(SamplerCheckpoint& checkpoint) const = 0;
+
+       /**
+        * Resumes the underlying sampler and the iterator's position from a checkpoint.
+        * The current sample is cleared until the iterator is next advanced.
+        * @param checkpoint The checkpoint to resume from
+        */
+       virtual void restoreCheckpoint(const SamplerCheckpoint& checkpoint) = 0;
     private:
        virtual SampleType const dereference() const = 0;
     };
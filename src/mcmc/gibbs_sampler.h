@@ -5,8 +5,12 @@
 #define GIBBS_SAMPLER_H
 
 #include "var_spec.h"
+#include "metrics.h"
 #include "models/conditional_model.h"
+#include "sampler_checkpoint.h"
+#include "scan_policy.h"
 
+#include<cstdint>
 #include<memory>
 #include<vector>
 
@@ -35,15 +39,54 @@ namespace depnet
          * the same order as sampling should be performed
          */
         virtual void setSampleOrder(std::vector<std::shared_ptr<VariableSpecification> > sampleOrder) = 0;
+
+        /**
+         * Establishes the policy which decides which variables in the sample order each sweep updates.
+         * A systematic scan, visiting each variable once in sample order, is used by default.
+         * @param policy The scheduling policy to use for subsequent sweeps
+         */
+        virtual void setScanPolicy(std::shared_ptr<ScanPolicy> policy) = 0;
     
         /** 
-         * Sweeps through all variables, holding their Markov blankets 
+         * Sweeps through the variables chosen by the scan policy, holding their Markov blankets 
          * constant, and samples a new value for each. 
          * Chains are sampled in succession, so the first call to this function 
          * will return a sample from the first chain, the second call from the second chain, and so on.
          * @return An assignment from variable metadata to value
          */
         virtual SampleType sample() = 0;
+
+        /**
+         * Captures the state of every chain and the position of the random number generator
+         * @param checkpoint The checkpoint to populate
+         */
+        virtual void saveCheckpoint(SamplerCheckpoint& checkpoint) const = 0;
+
+        /**
+         * Replaces the state of every chain with one captured by GibbsSampler::saveCheckpoint.
+         * Throws CheckpointException if the checkpoint was taken over different variables.
+         * @param checkpoint The checkpoint to resume from
+         */
+        virtual void restoreCheckpoint(const SamplerCheckpoint& checkpoint) = 0;
+
+        /**
+         * Records that the most recent sample was returned to a caller, 
+         * rather than discarded during warm up or thinning
+         */
+        virtual void acceptSample() = 0;
+
+        /**
+         * Retrieves counters for each chain
+         * @return The sweeps and accepted samples of each chain
+         */
+        virtual std::vector<ChainMetrics> getChainMetrics() const = 0;
+
+        /**
+         * Retrieves the number of updates of a variable which reused an earlier prediction
+         * @param var The variable to report on
+         * @return The number of cache hits across every chain
+         */
+        virtual std::uint64_t getCacheHits(std::shared_ptr<VariableSpecification> var) const = 0;
     };
 }
 
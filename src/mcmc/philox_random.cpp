@@ -0,0 +1,159 @@
+
+#include "philox_random.h"
+
+#include<algorithm>
+#include<cmath>
+
+namespace depnet
+{
+    namespace
+    {
+        const std::uint32_t PHILOX_M0 = 0xD2511F53;
+        const std::uint32_t PHILOX_M1 = 0xCD9E8D57;
+        const std::uint32_t PHILOX_W0 = 0x9E3779B9;
+        const std::uint32_t PHILOX_W1 = 0xBB67AE85;
+        const int PHILOX_ROUNDS = 10;
+
+        inline void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo)
+        {
+            std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+            hi = static_cast<std::uint32_t>(product >> 32);
+            lo = static_cast<std::uint32_t>(product);
+        }
+
+        // converts two 32-bit words to a double in (0, 1) with 53 bits of precision
+        inline double toUnitInterval(std::uint32_t a, std::uint32_t b)
+        {
+            std::uint64_t bits = (static_cast<std::uint64_t>(a >> 5) << 26) | (b >> 6);
+            return (bits + 0.5) / 9007199254740992.0;
+        }
+    }
+
+    PhiloxRandom::PhiloxRandom(std::uint64_t seed) : seed(seed) { }
+
+    std::uint64_t PhiloxRandom::getSeed() const
+    {
+        return this->seed;
+    }
+
+    void PhiloxRandom::block(const std::uint32_t counter[4], const std::uint32_t key[2], std::uint32_t out[4])
+    {
+        std::uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for(int round = 0; round < PHILOX_ROUNDS; round++)
+        {
+            std::uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(PHILOX_M0, c0, hi0, lo0);
+            mulhilo(PHILOX_M1, c2, hi1, lo1);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    void PhiloxRandom::streamBlock(const RandomStream& stream, std::uint32_t index, std::uint32_t out[4]) const
+    {
+        // the low word of the counter walks through the stream, the remaining words identify it
+        std::uint32_t counter[4] = {index, stream.variable,
+            static_cast<std::uint32_t>(stream.sweep), stream.chain};
+        std::uint32_t key[2] = {static_cast<std::uint32_t>(this->seed),
+            static_cast<std::uint32_t>(this->seed >> 32) ^ static_cast<std::uint32_t>(stream.sweep >> 32)};
+        PhiloxRandom::block(counter, key, out);
+    }
+
+    void PhiloxRandom::uniform(const RandomStream& stream, double* out, std::size_t n) const
+    {
+        std::uint32_t bits[4];
+        std::size_t i = 0;
+        for(std::uint32_t index = 0; i < n; index++)
+        {
+            this->streamBlock(stream, index, bits);
+            out[i++] = toUnitInterval(bits[0], bits[1]);
+            if(i < n)
+                out[i++] = toUnitInterval(bits[2], bits[3]);
+        }
+    }
+
+    double PhiloxRandom::uniform(const RandomStream& stream) const
+    {
+        std::uint32_t bits[4];
+        this->streamBlock(stream, 0, bits);
+        return toUnitInterval(bits[0], bits[1]);
+    }
+
+    void PhiloxRandom::normal(const RandomStream& stream, double mean, double stddev,
+            double* out, std::size_t n) const
+    {
+        const double twoPi = 6.283185307179586476925286766559;
+        std::uint32_t bits[4];
+        std::size_t i = 0;
+        for(std::uint32_t index = 0; i < n; index++)
+        {
+            this->streamBlock(stream, index, bits);
+            double radius = std::sqrt(-2.0 * std::log(toUnitInterval(bits[0], bits[1])));
+            double angle = twoPi * toUnitInterval(bits[2], bits[3]);
+            out[i++] = mean + stddev * radius * std::cos(angle);
+            if(i < n)
+                out[i++] = mean + stddev * radius * std::sin(angle);
+        }
+    }
+
+    void PhiloxRandom::categorical(const RandomStream& stream, const double* weights,
+            std::size_t numCategories, int* out, std::size_t n) const
+    {
+        if(numCategories == 0)
+        {
+            std::fill(out, out + n, 0);
+            return;
+        }
+
+        double total = 0;
+        for(std::size_t category = 0; category < numCategories; category++)
+            total += std::max(weights[category], 0.0);
+
+        double draws[2];
+        std::uint32_t bits[4];
+        std::size_t i = 0;
+        for(std::uint32_t index = 0; i < n; index++)
+        {
+            this->streamBlock(stream, index, bits);
+            draws[0] = toUnitInterval(bits[0], bits[1]);
+            draws[1] = toUnitInterval(bits[2], bits[3]);
+            for(int draw = 0; draw < 2 && i < n; draw++)
+            {
+                // degenerate weights fall back to a uniform choice
+                if(!(total > 0))
+                {
+                    out[i++] = std::min<std::size_t>(draws[draw] * numCategories, numCategories - 1);
+                    continue;
+                }
+
+                double target = draws[draw] * total, cumulative = 0;
+                std::size_t category = 0;
+                for(; category + 1 < numCategories; category++)
+                {
+                    cumulative += std::max(weights[category], 0.0);
+                    if(target < cumulative)
+                        break;
+                }
+                out[i++] = category;
+            }
+        }
+    }
+
+    int PhiloxRandom::categorical(const RandomStream& stream, const double* weights,
+            std::size_t numCategories) const
+    {
+        int category;
+        this->categorical(stream, weights, numCategories, &category, 1);
+        return category;
+    }
+}
+
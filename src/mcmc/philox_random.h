@@ -0,0 +1,118 @@
+#pragma once
+
+#ifndef PHILOX_RANDOM_H
+#define PHILOX_RANDOM_H
+
+#include<cstddef>
+#include<cstdint>
+
+namespace depnet
+{
+    /**
+     * Identifies an independent stream of random numbers within a sampling run.
+     * Every (chain, sweep, variable) triple maps to its own stream, so draws do not depend on
+     * the order in which chains or variables are visited, or on how many threads do the visiting.
+     */
+    struct RandomStream
+    {
+        /** The Gibbs chain making the draw */
+        std::uint32_t chain;
+
+        /** The sweep number within the chain */
+        std::uint64_t sweep;
+
+        /** The variable being sampled */
+        std::uint32_t variable;
+    };
+
+    /**
+     * A stateless counter-based random number generator implementing Philox4x32-10.
+     * See Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3" (SC 2011).
+     * Each output block is a pure function of the seed, a stream and a block index,
+     * so the generator can be shared between threads without synchronization.
+     */
+    class PhiloxRandom
+    {
+    public:
+        /**
+         * Creates a generator
+         * @param seed Selects one of 2^64 independent families of streams
+         */
+        explicit PhiloxRandom(std::uint64_t seed = 0);
+
+        /**
+         * Retrieves the seed used to key the generator
+         * @return The seed supplied during construction
+         */
+        std::uint64_t getSeed() const;
+
+        /**
+         * Applies the Philox4x32-10 bijection to a raw counter and key
+         * @param counter The 128-bit counter as four 32-bit words
+         * @param key The 64-bit key as two 32-bit words
+         * @param out The 128-bit output block as four 32-bit words
+         */
+        static void block(const std::uint32_t counter[4], const std::uint32_t key[2], std::uint32_t out[4]);
+
+        /**
+         * Fills an array with values uniformly distributed on the open interval (0, 1)
+         * @param stream The stream to draw from
+         * @param out The destination for n values
+         * @param n The number of values to draw
+         */
+        void uniform(const RandomStream& stream, double* out, std::size_t n) const;
+
+        /**
+         * Draws a single value uniformly distributed on the open interval (0, 1).
+         * This is the first value that PhiloxRandom::uniform would produce for the same stream.
+         * @param stream The stream to draw from
+         * @return A uniform variate
+         */
+        double uniform(const RandomStream& stream) const;
+
+        /**
+         * Fills an array with normally distributed values using the Box-Muller transform
+         * @param stream The stream to draw from
+         * @param mean The mean of the distribution
+         * @param stddev The standard deviation of the distribution
+         * @param out The destination for n values
+         * @param n The number of values to draw
+         */
+        void normal(const RandomStream& stream, double mean, double stddev, double* out, std::size_t n) const;
+
+        /**
+         * Fills an array with category indices drawn in proportion to a set of weights
+         * @param stream The stream to draw from
+         * @param weights Non-negative, not necessarily normalized weights for each category
+         * @param numCategories The number of weights
+         * @param out The destination for n category indices in [0, numCategories)
+         * @param n The number of values to draw
+         */
+        void categorical(const RandomStream& stream, const double* weights, std::size_t numCategories,
+                int* out, std::size_t n) const;
+
+        /**
+         * Draws a single category index in proportion to a set of weights
+         * @param stream The stream to draw from
+         * @param weights Non-negative, not necessarily normalized weights for each category
+         * @param numCategories The number of weights
+         * @return A category index in [0, numCategories)
+         */
+        int categorical(const RandomStream& stream, const double* weights, std::size_t numCategories) const;
+
+    private:
+        /**
+         * Produces the output block at a position within a stream
+         * @param stream The stream to draw from
+         * @param index The position of the block within the stream
+         * @param out The 128-bit output block
+         */
+        void streamBlock(const RandomStream& stream, std::uint32_t index, std::uint32_t out[4]) const;
+
+        /** The seed the generator was keyed with */
+        std::uint64_t seed;
+    };
+}
+
+#endif
+
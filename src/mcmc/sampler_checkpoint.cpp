@@ -0,0 +1,76 @@
+
+#include "sampler_checkpoint.h"
+#include "binary_io.h"
+#include "exceptions/checkpoint.h"
+#include "exceptions/conversion.h"
+
+#include<set>
+
+namespace depnet
+{
+    namespace
+    {
+        const char CHECKPOINT_MAGIC[4] = {'D', 'N', 'C', 'K'};
+        const std::uint32_t CHECKPOINT_VERSION = 2;
+    }
+
+    SamplerCheckpoint::SamplerCheckpoint() : 
+        seed(0), currentChain(0), totalSamples(0), numSamples(0) { }
+
+    unsigned int SamplerCheckpoint::getNumChains() const
+    {
+        return this->sweeps.size();
+    }
+
+    void SamplerCheckpoint::write(std::ostream& out) const
+    {
+        // chains are matched to variables by name when restored, so every name must be distinct
+        std::set<std::string> names;
+        for(auto nameIt = this->variableNames.begin(); nameIt != this->variableNames.end(); ++nameIt)
+            if(!names.insert(*nameIt).second)
+                throw CheckpointException("Checkpoint cannot be written because variable name '" + *nameIt +
+                    "' is used more than once.");
+
+        binary_io::writeHeader(out, CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+        binary_io::write(out, this->seed);
+        binary_io::write(out, this->currentChain);
+        binary_io::write(out, this->totalSamples);
+        binary_io::write(out, this->numSamples);
+
+        binary_io::write<std::uint32_t>(out, this->variableNames.size());
+        for(auto nameIt = this->variableNames.begin(); nameIt != this->variableNames.end(); ++nameIt)
+            binary_io::writeString(out, *nameIt);
+
+        binary_io::writeVector(out, this->sweeps);
+        binary_io::writeVector(out, this->chainStates);
+        binary_io::writeVector(out, this->scanState);
+    }
+
+    void SamplerCheckpoint::read(std::istream& in)
+    {
+        std::uint32_t version = binary_io::readHeader(in, CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+        this->seed = binary_io::read<std::uint64_t>(in);
+        this->currentChain = binary_io::read<std::uint32_t>(in);
+        this->totalSamples = binary_io::read<std::int64_t>(in);
+        this->numSamples = binary_io::read<std::int64_t>(in);
+
+        // names are appended as they are read so that a corrupt count cannot allocate ahead of the input
+        std::uint32_t numNames = binary_io::read<std::uint32_t>(in);
+        this->variableNames.clear();
+        for(std::uint32_t name = 0; name < numNames; name++)
+            this->variableNames.push_back(binary_io::readString(in));
+
+        this->sweeps = binary_io::readVector<std::uint64_t>(in);
+        this->chainStates = binary_io::readVector<double>(in);
+        this->scanState.clear();
+        if(version >= 2)
+            this->scanState = binary_io::readVector<double>(in);
+
+        if(this->sweeps.empty())
+            throw CheckpointException("Checkpoint has no chains.");
+        if(this->chainStates.size() != this->sweeps.size() * this->variableNames.size() ||
+                this->currentChain >= this->sweeps.size())
+            throw ConversionException("Checkpoint chain states are inconsistent with its chain and variable counts.");
+    }
+}
+
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef SAMPLER_CHECKPOINT_H
+#define SAMPLER_CHECKPOINT_H
+
+#include<cstdint>
+#include<istream>
+#include<ostream>
+#include<string>
+#include<vector>
+
+namespace depnet
+{
+    /**
+     * A snapshot of Gibbs sampling state which can be written to a compact binary 
+     * form and used to resume sampling later, possibly in another process.
+     * Variables are identified by name, so the network being resumed must use the same variable names.
+     */
+    struct SamplerCheckpoint
+    {
+        /** Creates an empty checkpoint */
+        SamplerCheckpoint();
+
+        /** The seed of the sampler's random number generator */
+        std::uint64_t seed;
+
+        /** The chain that will be sampled from on the next iteration */
+        std::uint32_t currentChain;
+
+        /** Variable names in the sampler's stable variable order */
+        std::vector<std::string> variableNames;
+
+        /** The number of sweeps completed by each chain, which positions each chain's random streams */
+        std::vector<std::uint64_t> sweeps;
+
+        /** The current assignment of each chain, numChains rows of variableNames.size() values */
+        std::vector<double> chainStates;
+
+        /** The number of samples drawn by the iterator, including warm up and autocorrelation */
+        std::int64_t totalSamples;
+
+        /** The number of valid samples returned by the iterator */
+        std::int64_t numSamples;
+
+        /** Adaptation state of the sampler's scan policy, see ScanPolicy::saveState */
+        std::vector<double> scanState;
+
+        /**
+         * Retrieves the number of chains captured in this checkpoint
+         * @return The number of chains
+         */
+        unsigned int getNumChains() const;
+
+        /**
+         * Writes the checkpoint in binary form.
+         * Throws CheckpointException if two variables share a name, since chains could not be matched to them on restore.
+         * @param out The stream to write to, which should be opened in binary mode
+         */
+        void write(std::ostream& out) const;
+
+        /**
+         * Replaces the contents of this checkpoint with one read from a stream.
+         * Throws ConversionException if the stream does not contain a valid checkpoint.
+         * @param in The stream to read from, which should be opened in binary mode
+         */
+        void read(std::istream& in);
+    };
+}
+
+#endif
+
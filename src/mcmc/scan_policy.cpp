@@ -0,0 +1,153 @@
+
+#include "scan_policy.h"
+
+#include<algorithm>
+#include<cmath>
+
+namespace depnet
+{
+    void SystematicScan::schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+            const RandomStream& stream, std::vector<std::size_t>& visits)
+    {
+        visits.resize(costs.size());
+        for(std::size_t position = 0; position < costs.size(); position++)
+            visits[position] = position;
+    }
+
+    void SystematicScan::observe(std::size_t position, double previous, double current) { }
+
+    void SystematicScan::saveState(std::vector<double>& state) const
+    {
+        state.clear();
+    }
+
+    void SystematicScan::restoreState(const std::vector<double>& state) { }
+
+    std::shared_ptr<ScanPolicy> SystematicScan::clone() const
+    {
+        return std::make_shared<SystematicScan>();
+    }
+
+    void RandomScan::schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+            const RandomStream& stream, std::vector<std::size_t>& visits)
+    {
+        std::vector<double> draws(costs.size());
+        random.uniform(stream, draws.data(), draws.size());
+
+        visits.resize(costs.size());
+        for(std::size_t visit = 0; visit < costs.size(); visit++)
+            visits[visit] = std::min<std::size_t>(draws[visit] * costs.size(), costs.size() - 1);
+    }
+
+    void RandomScan::observe(std::size_t position, double previous, double current) { }
+
+    void RandomScan::saveState(std::vector<double>& state) const
+    {
+        state.clear();
+    }
+
+    void RandomScan::restoreState(const std::vector<double>& state) { }
+
+    std::shared_ptr<ScanPolicy> RandomScan::clone() const
+    {
+        return std::make_shared<RandomScan>();
+    }
+
+    AdaptiveScan::AdaptiveScan(std::uint64_t adaptSweeps, double minWeight) :
+        adaptSweeps(adaptSweeps), minWeight(minWeight), numSweeps(0) { }
+
+    void AdaptiveScan::schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+            const RandomStream& stream, std::vector<std::size_t>& visits)
+    {
+        if(this->moments.size() != costs.size())
+            this->moments.assign(costs.size(), PairMoments());
+        this->numSweeps++;
+
+        std::vector<double> weights;
+        this->getWeights(costs, weights);
+
+        std::vector<int> chosen(costs.size());
+        random.categorical(stream, weights.data(), weights.size(), chosen.data(), chosen.size());
+        visits.assign(chosen.begin(), chosen.end());
+    }
+
+    void AdaptiveScan::observe(std::size_t position, double previous, double current)
+    {
+        if(this->numSweeps > this->adaptSweeps || position >= this->moments.size())
+            return;
+
+        PairMoments& pair = this->moments[position];
+        pair.count++;
+        pair.sumPrevious += previous;
+        pair.sumCurrent += current;
+        pair.sumPrevious2 += previous * previous;
+        pair.sumCurrent2 += current * current;
+        pair.sumCross += previous * current;
+    }
+
+    void AdaptiveScan::saveState(std::vector<double>& state) const
+    {
+        state.assign(1, static_cast<double>(this->numSweeps));
+        for(auto it = this->moments.begin(); it != this->moments.end(); ++it)
+        {
+            double values[STATE_WIDTH] = {it->count, it->sumPrevious, it->sumCurrent,
+                it->sumPrevious2, it->sumCurrent2, it->sumCross};
+            state.insert(state.end(), values, values + STATE_WIDTH);
+        }
+    }
+
+    void AdaptiveScan::restoreState(const std::vector<double>& state)
+    {
+        if(state.empty())
+            return;
+
+        this->numSweeps = static_cast<std::uint64_t>(state[0]);
+        this->moments.resize((state.size() - 1) / STATE_WIDTH);
+        for(std::size_t position = 0; position < this->moments.size(); position++)
+        {
+            const double* values = &state[1 + position * STATE_WIDTH];
+            PairMoments pair = {values[0], values[1], values[2], values[3], values[4], values[5]};
+            this->moments[position] = pair;
+        }
+    }
+
+    std::shared_ptr<ScanPolicy> AdaptiveScan::clone() const
+    {
+        return std::make_shared<AdaptiveScan>(this->adaptSweeps, this->minWeight);
+    }
+
+    double AdaptiveScan::getAutocorrelation(std::size_t position) const
+    {
+        if(position >= this->moments.size() || this->moments[position].count < 2)
+            return 0;
+
+        const PairMoments& pair = this->moments[position];
+        double n = pair.count;
+        double covariance = pair.sumCross / n - (pair.sumPrevious / n) * (pair.sumCurrent / n);
+        double varPrevious = pair.sumPrevious2 / n - (pair.sumPrevious / n) * (pair.sumPrevious / n);
+        double varCurrent = pair.sumCurrent2 / n - (pair.sumCurrent / n) * (pair.sumCurrent / n);
+        if(!(varPrevious > 1e-12 && varCurrent > 1e-12))
+            return 0;
+
+        return std::max(0.0, std::min(0.99, covariance / std::sqrt(varPrevious * varCurrent)));
+    }
+
+    void AdaptiveScan::getWeights(const std::vector<double>& costs, std::vector<double>& weights) const
+    {
+        weights.resize(costs.size());
+        double total = 0;
+        for(std::size_t position = 0; position < costs.size(); position++)
+        {
+            double rho = this->getAutocorrelation(position);
+            double tau = (1 + rho) / (1 - rho);
+            weights[position] = tau / std::max(costs[position], 1e-12);
+            total += weights[position];
+        }
+
+        // mix with a uniform floor so that no variable is starved
+        double uniform = 1.0 / std::max<std::size_t>(costs.size(), 1);
+        for(auto it = weights.begin(); it != weights.end(); ++it)
+            *it = this->minWeight * uniform + (1 - this->minWeight) * (*it / total);
+    }
+}
+
@@ -0,0 +1,156 @@
+#pragma once
+
+#ifndef SCAN_POLICY_H
+#define SCAN_POLICY_H
+
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<vector>
+
+#include "philox_random.h"
+
+namespace depnet
+{
+    /**
+     * Decides which variables a Gibbs sweep updates, and in what order.
+     * Variables are referred to by their position in the sampler's sample order
+     * (see GibbsSampler::setSampleOrder), so a policy can only reorder or repeat the variables it is given.
+     */
+    class ScanPolicy
+    {
+    public:
+        virtual ~ScanPolicy() { }
+
+        /**
+         * Produces the sequence of updates for a single sweep
+         * @param costs The relative cost of updating each variable, in sample order
+         * @param random The sampler's random number generator
+         * @param stream A stream reserved for scheduling the current sweep of the current chain
+         * @param visits Cleared and filled with positions in the sample order, one per update
+         */
+        virtual void schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+                const RandomStream& stream, std::vector<std::size_t>& visits) = 0;
+
+        /**
+         * Records the outcome of a single update, allowing the policy to estimate mixing
+         * @param position The position of the updated variable in the sample order
+         * @param previous The value of the variable before the update
+         * @param current The value of the variable after the update
+         */
+        virtual void observe(std::size_t position, double previous, double current) = 0;
+
+        /**
+         * Captures any adaptation state so that it can be checkpointed
+         * @param state Cleared and filled with the policy's state
+         */
+        virtual void saveState(std::vector<double>& state) const = 0;
+
+        /**
+         * Restores adaptation state captured by ScanPolicy::saveState
+         * @param state The state to restore
+         */
+        virtual void restoreState(const std::vector<double>& state) = 0;
+
+        /**
+         * Creates a policy with the same settings but no adaptation state, so that every sampler adapts on its own
+         * @return The new policy
+         */
+        virtual std::shared_ptr<ScanPolicy> clone() const = 0;
+    };
+
+    /**
+     * Updates every variable exactly once per sweep, in sample order
+     */
+    class SystematicScan : public ScanPolicy
+    {
+    public:
+        void schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+                const RandomStream& stream, std::vector<std::size_t>& visits);
+        void observe(std::size_t position, double previous, double current);
+        void saveState(std::vector<double>& state) const;
+        void restoreState(const std::vector<double>& state);
+        std::shared_ptr<ScanPolicy> clone() const;
+    };
+
+    /**
+     * Makes as many updates per sweep as there are variables, choosing each variable uniformly at random
+     */
+    class RandomScan : public ScanPolicy
+    {
+    public:
+        void schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+                const RandomStream& stream, std::vector<std::size_t>& visits);
+        void observe(std::size_t position, double previous, double current);
+        void saveState(std::vector<double>& state) const;
+        void restoreState(const std::vector<double>& state);
+        std::shared_ptr<ScanPolicy> clone() const;
+    };
+
+    /**
+     * A random scan which visits slowly mixing, cheap variables more often.
+     * The lag-1 autocorrelation rho of each variable is estimated from consecutive updates,
+     * and each variable is chosen with probability proportional to its integrated autocorrelation
+     * time (1 + rho) / (1 - rho) divided by its update cost. Adaptation stops after a fixed number
+     * of sweeps so that the selection probabilities, and therefore the stationary distribution, are fixed
+     * once warm up is over.
+     */
+    class AdaptiveScan : public ScanPolicy
+    {
+    public:
+        /**
+         * Creates an adaptive scan policy
+         * @param adaptSweeps The number of sweeps over which autocorrelation is estimated before the
+         * selection probabilities are frozen. Should not exceed the warm up period.
+         * @param minWeight The smallest selection probability of any variable, as a fraction of uniform
+         * probability, guaranteeing that every variable keeps being visited
+         */
+        explicit AdaptiveScan(std::uint64_t adaptSweeps = 500, double minWeight = 0.1);
+
+        void schedule(const std::vector<double>& costs, const PhiloxRandom& random,
+                const RandomStream& stream, std::vector<std::size_t>& visits);
+        void observe(std::size_t position, double previous, double current);
+        void saveState(std::vector<double>& state) const;
+        void restoreState(const std::vector<double>& state);
+        std::shared_ptr<ScanPolicy> clone() const;
+
+        /**
+         * Computes the current selection weights
+         * @param costs The relative cost of updating each variable, in sample order
+         * @param weights Filled with a normalized selection probability for each variable
+         */
+        void getWeights(const std::vector<double>& costs, std::vector<double>& weights) const;
+
+        /**
+         * Estimates the lag-1 autocorrelation of a variable from the updates observed so far
+         * @param position The position of the variable in the sample order
+         * @return The autocorrelation, clamped to [0, 0.99], or 0 if too few updates have been observed
+         */
+        double getAutocorrelation(std::size_t position) const;
+
+    private:
+        /** Running sums over consecutive pairs of values for one variable */
+        struct PairMoments
+        {
+            double count, sumPrevious, sumCurrent, sumPrevious2, sumCurrent2, sumCross;
+        };
+
+        /** The number of values stored per variable by saveState */
+        static const std::size_t STATE_WIDTH = 6;
+
+        /** The number of sweeps to adapt over */
+        std::uint64_t adaptSweeps;
+
+        /** The smallest selection probability as a fraction of uniform */
+        double minWeight;
+
+        /** The number of sweeps scheduled so far */
+        std::uint64_t numSweeps;
+
+        /** Moments of consecutive values for each variable in sample order */
+        std::vector<PairMoments> moments;
+    };
+}
+
+#endif
+
@@ -1,5 +1,6 @@
 
 #include "standard_gibbs_iterator.h"
+#include "logging.h"
 
 namespace depnet
 {
@@ -14,6 +15,39 @@ namespace depnet
     {
     }
 
+    SampleType const StandardGibbsIterator::operator++()
+    {
+        this->increment();
+        return this->sample;
+    }
+
+    SampleType const StandardGibbsIterator::operator++(int)
+    {
+        SampleType previous = this->sample;
+        this->increment();
+        return previous;
+    }
+
+    SampleType const StandardGibbsIterator::operator*() const
+    {
+        return this->dereference();
+    }
+
+    void StandardGibbsIterator::saveCheckpoint(SamplerCheckpoint& checkpoint) const
+    {
+        this->sampler->saveCheckpoint(checkpoint);
+        checkpoint.totalSamples = this->totalSamples;
+        checkpoint.numSamples = this->numSamples;
+    }
+
+    void StandardGibbsIterator::restoreCheckpoint(const SamplerCheckpoint& checkpoint)
+    {
+        this->sampler->restoreCheckpoint(checkpoint);
+        this->totalSamples = checkpoint.totalSamples;
+        this->numSamples = checkpoint.numSamples;
+        this->sample = SampleType();
+    }
+
     void StandardGibbsIterator::increment()
     {
         while(totalSamples < warmUp)
@@ -21,16 +55,20 @@ namespace depnet
             this->sampler->sample();
             totalSamples++;
         }
-        while(totalSamples % autoCorrInterval != 0)
+        while(autoCorrInterval > 0 && totalSamples % autoCorrInterval != 0)
         {
             this->sampler->sample();
             totalSamples++;
         }
 
         this->sample = this->sampler->sample(); 
-            totalSamples++;
+        this->sampler->acceptSample();
+        totalSamples++;
+        numSamples++;
+#if DEPNET_LOG_LEVEL <= DEPNET_LOG_LEVEL_TRACE
         for(auto sampleIt = this->sample->begin(); sampleIt != this->sample->end(); sampleIt++)
-            std::cout << sampleIt->first->getName() << "=" << sampleIt->second << std::endl;
+            DEPNET_TRACE(sampleIt->first->getName() << "=" << sampleIt->second);
+#endif
     }
 
     SampleType const StandardGibbsIterator::dereference() const
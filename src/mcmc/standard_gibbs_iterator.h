@@ -35,6 +35,37 @@ namespace depnet
         /** Destroys the Gibbs iterator */
         ~StandardGibbsIterator();
 
+        /**
+         * Advances to the next valid sample
+         * @return The new current sample
+         */
+        SampleType const operator++();
+
+        /**
+         * Advances to the next valid sample
+         * @return The sample that was current before advancing
+         */
+        SampleType const operator++(int);
+
+        /**
+         * Retrieves the sample at the current position
+         * @return The most recent valid sample produced by the sampler
+         */
+        SampleType const operator*() const;
+
+        /**
+         * Captures the state of the underlying sampler along with the warm up and interval counters
+         * @param checkpoint The checkpoint to populate
+         */
+        void saveCheckpoint(SamplerCheckpoint& checkpoint) const;
+
+        /**
+         * Resumes the underlying sampler and the warm up and interval counters from a checkpoint,
+         * so a resumed run does not repeat warm up
+         * @param checkpoint The checkpoint to resume from
+         */
+        void restoreCheckpoint(const SamplerCheckpoint& checkpoint);
+
      private:
         friend class boost::iterator_core_access;
 
@@ -1,47 +1,78 @@
 
 #include "standard_gibbs_sampler.h"
-#include<random>
-#include<iostream>
+#include "exceptions/checkpoint.h"
+#include "tracing.h"
+#include<algorithm>
+#include<cmath>
 #include<limits>
+#include<stdexcept>
+#include<string>
 
 namespace depnet
 {
+    namespace
+    {
+        // the random stream of each sweep reserved for the scan policy, distinct from any variable's stream
+        const std::uint32_t SCHEDULE_STREAM = std::numeric_limits<std::uint32_t>::max();
+    }
+
     StandardGibbsSampler::StandardGibbsSampler(const std::map<std::shared_ptr<VariableSpecification>, 
                             std::shared_ptr<ConditionalModel> >& network,
             unsigned int numChains,
             boost::optional<const std::map<std::shared_ptr<VariableSpecification>, double> > evidence,
-            boost::optional<std::map<unsigned int, SampleType> > initialSamples) :
-                numChains(numChains), currentChain(0), models(network)
+            boost::optional<std::map<unsigned int, SampleType> > initialSamples,
+            std::uint64_t seed) :
+                variables(stableOrder(network)), numChains(numChains), currentChain(0), 
+                models(network), sweeps(numChains, 1), random(seed), scanPolicy(new SystematicScan()),
+                cacheHits(variables.size(), 0), lastChain(0)
     {
-        // for now just initializing an arbitrary sample order and saving the Markov blanket
-        for(auto it = network.begin(); it != network.end(); ++it)
+        // sampling in name order by default, saving the Markov blanket of each variable
+        sampleOrder = this->variables;
+        for(auto it = this->variables.begin(); it != this->variables.end(); ++it)
         {
-            sampleOrder.push_back(it->first);
-            this->markovBlankets[it->first] = it->second->getIndependentVars();
+            this->variableIds[*it] = it - this->variables.begin();
+            this->markovBlankets[*it] = network.at(*it)->getIndependentVars();
         }
+        for(auto it = this->variables.begin(); it != this->variables.end(); ++it)
+        {
+            std::vector<std::uint32_t> blanket;
+            for(auto predictorIt = this->markovBlankets[*it].begin(); 
+                    predictorIt != this->markovBlankets[*it].end(); ++predictorIt)
+                blanket.push_back(this->variableIds.at(*predictorIt));
+            this->blanketIds.push_back(blanket);
+            this->traceNames.push_back(tracing::intern((*it)->getName()));
+        }
+        this->refreshCosts();
+        this->resetCaches();
 
         // initialize each chain with a random initial setting if no initial samples were identified
         if(!initialSamples)
         {
-            std::default_random_engine generator;
             for(unsigned int curChain = 0; curChain < numChains; curChain++)
             {
                 SampleType curSample(new std::map<std::shared_ptr<VariableSpecification>, double>());
                 for(auto varSpec = sampleOrder.begin(); varSpec != sampleOrder.end(); varSpec++)
                 {
+                    // sweep 0 of each chain is reserved for initialization
+                    RandomStream stream = {curChain, 0, this->variableIds[*varSpec]};
+                    double draw = this->random.uniform(stream);
                     if((*varSpec)->isDiscrete())
                     {
-                        curSample->insert(std::make_pair(*varSpec, rand() % (*varSpec)->getNumLevels()));
+                        int numLevels = (*varSpec)->getNumLevels();
+                        if(numLevels == 0 && (*varSpec)->isBoolean())
+                            numLevels = 2;
+                        curSample->insert(std::make_pair(*varSpec, std::floor(draw * numLevels)));
                     } else // generate from the allowable range
                     {
                         double minVal, maxVal;
                         (*varSpec)->getRange(minVal, maxVal); // can be inf
-                        std::uniform_real_distribution<double> distr(0.0, 10.0);
-                            //std::isinf(minVal) ? std::numeric_limits<double>::min() : minVal,
-                            //std::isinf(maxVal) ? std::numeric_limits<double>::max() : maxVal);
+                        if(std::isinf(minVal) || std::isinf(maxVal))
+                        {
+                            minVal = 0.0;
+                            maxVal = 10.0;
+                        }
 
-                        double val = distr(generator);
-                        curSample->insert(std::make_pair(*varSpec, val));
+                        curSample->insert(std::make_pair(*varSpec, minVal + draw * (maxVal - minVal)));
                     }
                 }
 
@@ -49,10 +80,157 @@ namespace depnet
             }
         } else
         {
+            for(auto chainIt = initialSamples->begin(); chainIt != initialSamples->end(); ++chainIt)
+                for(auto valueIt = chainIt->second->begin(); valueIt != chainIt->second->end(); ++valueIt)
+                    if(!isValidValue(*valueIt->first, valueIt->second))
+                        throw std::invalid_argument("Initial value " + std::to_string(valueIt->second) + 
+                            " is not a level of '" + valueIt->first->getName() + "'.");
             this->currentSamples = std::move(*initialSamples);
         }
     }
 
+    StandardGibbsSampler::StandardGibbsSampler(const std::map<std::shared_ptr<VariableSpecification>, 
+                            std::shared_ptr<ConditionalModel> >& network,
+            const SamplerCheckpoint& checkpoint) :
+        StandardGibbsSampler(network, checkpoint.getNumChains(), boost::none, 
+            checkpointSamples(stableOrder(network), checkpoint), checkpoint.seed)
+    {
+        this->sweeps = checkpoint.sweeps;
+        this->currentChain = checkpoint.currentChain;
+
+        // the policy which will resume the scan is usually set after construction
+        this->scanPolicy->restoreState(checkpoint.scanState);
+        this->pendingScanState = checkpoint.scanState;
+    }
+
+    std::vector<std::shared_ptr<VariableSpecification> > StandardGibbsSampler::stableOrder(
+            const std::map<std::shared_ptr<VariableSpecification>, std::shared_ptr<ConditionalModel> >& network)
+    {
+        std::vector<std::shared_ptr<VariableSpecification> > ordered;
+        for(auto it = network.begin(); it != network.end(); ++it)
+            ordered.push_back(it->first);
+
+        std::stable_sort(ordered.begin(), ordered.end(), 
+            [](const std::shared_ptr<VariableSpecification>& a, const std::shared_ptr<VariableSpecification>& b)
+            {
+                return a->getName() < b->getName();
+            });
+        return ordered;
+    }
+
+    std::map<unsigned int, SampleType> StandardGibbsSampler::checkpointSamples(
+            const std::vector<std::shared_ptr<VariableSpecification> >& variables, 
+            const SamplerCheckpoint& checkpoint)
+    {
+        if(checkpoint.variableNames.size() != variables.size())
+            throw CheckpointException("Checkpoint has " + std::to_string(checkpoint.variableNames.size()) + 
+                " variables, but the network has " + std::to_string(variables.size()) + ".");
+        for(std::size_t varIndex = 0; varIndex < variables.size(); varIndex++)
+        {
+            if(checkpoint.variableNames[varIndex] != variables[varIndex]->getName())
+                throw CheckpointException("Checkpoint variable '" + checkpoint.variableNames[varIndex] + 
+                    "' does not match network variable '" + variables[varIndex]->getName() + "'.");
+        }
+        if(checkpoint.sweeps.empty() || checkpoint.currentChain >= checkpoint.sweeps.size() ||
+                checkpoint.chainStates.size() != checkpoint.sweeps.size() * variables.size())
+            throw CheckpointException("Checkpoint chain states are inconsistent with its chain and variable counts.");
+
+        std::map<unsigned int, SampleType> samples;
+        auto value = checkpoint.chainStates.begin();
+        for(unsigned int chain = 0; chain < checkpoint.getNumChains(); chain++)
+        {
+            SampleType chainSample(new std::map<std::shared_ptr<VariableSpecification>, double>());
+            for(auto varIt = variables.begin(); varIt != variables.end(); ++varIt, ++value)
+            {
+                if(!isValidValue(**varIt, *value))
+                    throw CheckpointException("Checkpoint value " + std::to_string(*value) + 
+                        " is not a level of '" + (*varIt)->getName() + "'.");
+                chainSample->insert(std::make_pair(*varIt, *value));
+            }
+            samples.insert(std::make_pair(chain, chainSample));
+        }
+        return samples;
+    }
+
+    bool StandardGibbsSampler::isValidValue(const VariableSpecification& var, double value)
+    {
+        if(!var.isDiscrete())
+            return true;
+        int numLevels = var.getNumLevels();
+        if(numLevels == 0 && var.isBoolean())
+            numLevels = 2;
+        if(!(value >= 0) || std::floor(value) != value)
+            return false;
+        return numLevels <= 0 || value < numLevels;
+    }
+
+    void StandardGibbsSampler::saveCheckpoint(SamplerCheckpoint& checkpoint) const
+    {
+        checkpoint.seed = this->random.getSeed();
+        checkpoint.currentChain = this->currentChain;
+        checkpoint.sweeps = this->sweeps;
+        this->scanPolicy->saveState(checkpoint.scanState);
+
+        checkpoint.variableNames.clear();
+        for(auto varIt = this->variables.begin(); varIt != this->variables.end(); ++varIt)
+            checkpoint.variableNames.push_back((*varIt)->getName());
+
+        checkpoint.chainStates.clear();
+        for(unsigned int chain = 0; chain < this->numChains; chain++)
+        {
+            const SampleType& chainSample = this->currentSamples.at(chain);
+            for(auto varIt = this->variables.begin(); varIt != this->variables.end(); ++varIt)
+                checkpoint.chainStates.push_back(chainSample->at(*varIt));
+        }
+    }
+
+    void StandardGibbsSampler::restoreCheckpoint(const SamplerCheckpoint& checkpoint)
+    {
+        this->currentSamples = checkpointSamples(this->variables, checkpoint);
+        this->numChains = checkpoint.getNumChains();
+        this->sweeps = checkpoint.sweeps;
+        this->currentChain = checkpoint.currentChain;
+        this->random = PhiloxRandom(checkpoint.seed);
+        this->scanPolicy->restoreState(checkpoint.scanState);
+        this->pendingScanState.clear();
+        this->resetCaches();
+    }
+
+    void StandardGibbsSampler::resetCaches()
+    {
+        PredictionCache empty;
+        empty.clock = 0;
+        empty.changedAt.assign(this->variables.size(), 0);
+        empty.cachedAt.assign(this->variables.size(), 0);
+        empty.results.resize(this->variables.size());
+        empty.candidates.resize(this->variables.size());
+        this->caches.assign(this->numChains, empty);
+        this->acceptedSamples.resize(this->numChains, 0);
+    }
+
+    void StandardGibbsSampler::acceptSample()
+    {
+        this->acceptedSamples[this->lastChain]++;
+    }
+
+    std::vector<ChainMetrics> StandardGibbsSampler::getChainMetrics() const
+    {
+        std::vector<ChainMetrics> chains(this->numChains);
+        for(unsigned int chain = 0; chain < this->numChains; chain++)
+        {
+            // sweep 0 of each chain is its initialization
+            chains[chain].sweeps = this->sweeps[chain] - 1;
+            chains[chain].acceptedSamples = this->acceptedSamples[chain];
+        }
+        return chains;
+    }
+
+    std::uint64_t StandardGibbsSampler::getCacheHits(std::shared_ptr<VariableSpecification> var) const
+    {
+        auto it = this->variableIds.find(var);
+        return it == this->variableIds.end() ? 0 : this->cacheHits[it->second];
+    }
+
     std::vector<std::shared_ptr<VariableSpecification> > const& StandardGibbsSampler::getSampleOrder() const
     {
         return this->sampleOrder;
@@ -61,25 +239,95 @@ namespace depnet
     void StandardGibbsSampler::setSampleOrder(std::vector<std::shared_ptr<VariableSpecification> > sampleOrder)
     {
         this->sampleOrder = std::move(sampleOrder);
+        this->refreshCosts();
+    }
+
+    void StandardGibbsSampler::setScanPolicy(std::shared_ptr<ScanPolicy> policy)
+    {
+        this->scanPolicy = policy;
+        this->scanPolicy->restoreState(this->pendingScanState);
+    }
+
+    void StandardGibbsSampler::refreshCosts()
+    {
+        this->updateCosts.clear();
+        for(auto varIt = this->sampleOrder.begin(); varIt != this->sampleOrder.end(); ++varIt)
+            this->updateCosts.push_back(this->models[*varIt]->getPredictCost());
     }
 
     SampleType StandardGibbsSampler::sample()
     {
+        TraceSpan span("sweep", "sampler");
+        this->pendingScanState.clear();
         SampleType curChainSample = this->currentSamples[this->currentChain];
-        for(auto varIt = sampleOrder.begin(); varIt != sampleOrder.end(); ++varIt)
+        std::uint64_t sweep = this->sweeps[this->currentChain]++;
+
+        RandomStream scheduleStream = {this->currentChain, sweep, SCHEDULE_STREAM};
+        this->scanPolicy->schedule(this->updateCosts, this->random, scheduleStream, this->visits);
+        std::vector<std::uint32_t> repeats(this->variables.size(), 0);
+        PredictionCache& cache = this->caches[this->currentChain];
+        for(auto visitIt = this->visits.begin(); visitIt != this->visits.end(); ++visitIt)
         {
-            // build up a vector of values representing the Markov blanket
-            std::vector<std::shared_ptr<VariableSpecification> > markovBlanket = this->markovBlankets[*varIt];
-            std::vector<double> indepVars;
-            for(auto predictorIt = markovBlanket.begin(); 
-                predictorIt != markovBlanket.end(); predictorIt++)
+            auto varIt = this->sampleOrder.begin() + *visitIt;
+            std::uint32_t variableId = this->variableIds[*varIt];
+            std::shared_ptr<ConditionalModel>& model = this->models[*varIt];
+            bool drawsLevel = (*varIt)->isDiscrete() && model->supportsClassDensity();
+            bool drawsValue = !drawsLevel && model->supportsValueDensity();
+
+            // reuse the last prediction if nothing in the Markov blanket has changed since it was made
+            bool cached = cache.cachedAt[variableId] > 0;
+            const std::vector<std::uint32_t>& blanket = this->blanketIds[variableId];
+            for(auto predictorIt = blanket.begin(); cached && predictorIt != blanket.end(); ++predictorIt)
+                cached = cache.changedAt[*predictorIt] < cache.cachedAt[variableId];
+
+            std::vector<double>& result = cache.results[variableId];
+            if(cached)
+                this->cacheHits[variableId]++;
+            else
+            {
+                TraceSpan predictSpan("predict", "sampler", this->traceNames[variableId]);
+
+                // build up a vector of values representing the Markov blanket
+                const std::vector<std::shared_ptr<VariableSpecification> >& markovBlanket = this->markovBlankets[*varIt];
+                std::vector<double> indepVars;
+                for(auto predictorIt = markovBlanket.begin(); 
+                    predictorIt != markovBlanket.end(); predictorIt++)
+                {
+                    indepVars.push_back((*curChainSample)[*predictorIt]);
+                }
+
+                if(drawsLevel)
+                    model->getClassDensity(indepVars, result);
+                else if(drawsValue)
+                    model->getValueDensity(indepVars, cache.candidates[variableId], result);
+                else
+                    result.assign(1, model->predict(indepVars));
+                cache.cachedAt[variableId] = cache.clock + 1;
+            }
+
+            // discrete variables are drawn from their posterior rather than set to the most likely level,
+            // and continuous variables with a value density are drawn from its candidates
+            double newVal;
+            if(drawsLevel || drawsValue)
+            {
+                // repeated visits within a sweep draw from distinct streams
+                RandomStream stream = {this->currentChain, sweep, 
+                    variableId + static_cast<std::uint32_t>(repeats[variableId]++ * this->variables.size())};
+                newVal = this->random.categorical(stream, result.data(), result.size());
+                if(drawsValue)
+                    newVal = cache.candidates[variableId][static_cast<std::size_t>(newVal)];
+            } else
             {
-                indepVars.push_back((*curChainSample)[*predictorIt]);
+                newVal = result[0];
             }
-            double newVal = this->models[*varIt]->predict(indepVars);
-            (*curChainSample)[*varIt] = newVal;
+            double& value = (*curChainSample)[*varIt];
+            this->scanPolicy->observe(*visitIt, value, newVal);
+            if(newVal != value)
+                cache.changedAt[variableId] = ++cache.clock;
+            value = newVal;
         }
 
+        this->lastChain = this->currentChain;
         this->currentChain = (this->currentChain + 1) % this->numChains;
         return curChainSample;
     }
@@ -7,7 +7,9 @@
 #include "var_spec.h"
 #include "models/conditional_model.h"
 #include "gibbs_sampler.h"
+#include "philox_random.h"
 
+#include<cstdint>
 #include<memory>
 #include<vector>
 
@@ -32,6 +34,8 @@ namespace depnet
          * @param initialSamples Samples to use when initializing each chain.
          * Supplying reasonable initial samples is recommended when the data involves 
          * unbounded (hasRange() is false) VariableSpecification instances
+         * @param seed Keys the counter-based generator used for initialization and discrete draws.
+         * Samples are reproducible for a given seed regardless of how chains are scheduled.
          */
         StandardGibbsSampler(const std::map<std::shared_ptr<VariableSpecification>, 
                                 std::shared_ptr<ConditionalModel> >& network,
@@ -39,7 +43,20 @@ namespace depnet
                 boost::optional<const std::map<std::shared_ptr<VariableSpecification>, double> > evidence =
                     boost::optional<const std::map<std::shared_ptr<VariableSpecification>, double> >(),
                 boost::optional<std::map<unsigned int, SampleType> > initialSamples = 
-                    boost::optional<std::map<unsigned int, SampleType> >());
+                    boost::optional<std::map<unsigned int, SampleType> >(),
+                std::uint64_t seed = 0);
+
+        /**
+         * Creates a Gibbs sampler which resumes from a checkpoint. The chains are 
+         * restored through the initial samples of the primary constructor. The checkpoint's scan state is 
+         * kept until the first sample, and restored into a policy passed to setScanPolicy before then.
+         * Throws CheckpointException if the checkpoint was taken over different variables.
+         * @param network The network to draw samples from, with the same variable names as the checkpoint
+         * @param checkpoint The checkpoint to resume from
+         */
+        StandardGibbsSampler(const std::map<std::shared_ptr<VariableSpecification>, 
+                                std::shared_ptr<ConditionalModel> >& network,
+                const SamplerCheckpoint& checkpoint);
 
         /**
          * Retrieves variables metadata in the order that sampling is performed
@@ -53,17 +70,117 @@ namespace depnet
          * the same order as sampling should be performed
          */
         void setSampleOrder(std::vector<std::shared_ptr<VariableSpecification> > sampleOrder);
+
+        /**
+         * Establishes the policy which decides which variables in the sample order each sweep updates.
+         * A systematic scan, visiting each variable once in sample order, is used by default.
+         * @param policy The scheduling policy to use for subsequent sweeps
+         */
+        void setScanPolicy(std::shared_ptr<ScanPolicy> policy);
     
         /** 
-         * Sweeps through all variables, holding their Markov blankets 
+         * Sweeps through the variables chosen by the scan policy, holding their Markov blankets 
          * constant, and samples a new value for each. 
          * Chains are sampled in succession, so the first call to this function 
          * will return a sample from the first chain, the second call from the second chain, and so on.
          * @return An assignment from variable metadata to value
          */
         SampleType sample();
+
+        /**
+         * Captures the state of every chain, keyed by variable name, and each chain's sweep count
+         * @param checkpoint The checkpoint to populate
+         */
+        void saveCheckpoint(SamplerCheckpoint& checkpoint) const;
+
+        /**
+         * Replaces the state of every chain with one captured by StandardGibbsSampler::saveCheckpoint
+         * @param checkpoint The checkpoint to resume from
+         */
+        void restoreCheckpoint(const SamplerCheckpoint& checkpoint);
+
+        /**
+         * Counts the most recent sample as accepted by the chain which produced it
+         */
+        void acceptSample();
+
+        /**
+         * Retrieves counters for each chain
+         * @return The sweeps and accepted samples of each chain
+         */
+        std::vector<ChainMetrics> getChainMetrics() const;
+
+        /**
+         * Retrieves the number of updates of a variable which reused an earlier prediction
+         * @param var The variable to report on
+         * @return The number of cache hits across every chain
+         */
+        std::uint64_t getCacheHits(std::shared_ptr<VariableSpecification> var) const;
         
     private:
+        /**
+         * Remembers the latest prediction for each variable of a chain. Predictions are deterministic
+         * given the Markov blanket, so an update may reuse one if no variable in the blanket changed since.
+         */
+        struct PredictionCache
+        {
+            /** Counts changes to the chain's values */
+            std::uint64_t clock;
+
+            /** The clock at which each variable last changed value */
+            std::vector<std::uint64_t> changedAt;
+
+            /** One more than the clock at which each variable's prediction was made, or 0 if there is none */
+            std::vector<std::uint64_t> cachedAt;
+
+            /** The latest prediction for each variable: a class density, the weights of a value density, 
+                or a single predicted value */
+            std::vector<std::vector<double> > results;
+
+            /** The candidate values of each variable drawn from a value density */
+            std::vector<std::vector<double> > candidates;
+        };
+
+        /**
+         * Discards every cached prediction and sizes the per-chain counters for the current number of chains
+         */
+        void resetCaches();
+
+        /**
+         * Orders the variables of a network by name, giving identifiers which are stable across processes
+         * @param network The network whose variables should be ordered
+         * @return The variables sorted by name
+         */
+        static std::vector<std::shared_ptr<VariableSpecification> > stableOrder(
+                const std::map<std::shared_ptr<VariableSpecification>, std::shared_ptr<ConditionalModel> >& network);
+
+        /**
+         * Builds chain assignments from a checkpoint
+         * @param variables The variables of the network in stable order
+         * @param checkpoint The checkpoint to read chain states from
+         * @return The assignment of each chain
+         */
+        static std::map<unsigned int, SampleType> checkpointSamples(
+                const std::vector<std::shared_ptr<VariableSpecification> >& variables, 
+                const SamplerCheckpoint& checkpoint);
+
+        /**
+         * Checks that a value can be assigned to a variable. Discrete variables take whole level codes
+         * in [0, levels), as the models' encoders and class densities assume.
+         * @param var The variable
+         * @param value The value to check
+         * @return false if the variable is discrete and the value is not one of its level codes
+         */
+        static bool isValidValue(const VariableSpecification& var, double value);
+
+        /**
+         * Recomputes the update cost of each variable in the sample order
+         */
+        void refreshCosts();
+
+        /** The variables of the network in stable order; the position of each is its identifier */
+        std::vector<std::shared_ptr<VariableSpecification> > variables;
+
         /** The order that new values should be sampled in */
         std::vector<std::shared_ptr<VariableSpecification> > sampleOrder;
 
@@ -84,6 +201,45 @@ namespace depnet
 
         /** A cache consisting of Markov blankets for each node in the network */
         std::map<std::shared_ptr<VariableSpecification>, std::vector<std::shared_ptr<VariableSpecification> > > markovBlankets;
+
+        /** A stable identifier for each variable, used to select its random stream */
+        std::map<std::shared_ptr<VariableSpecification>, std::uint32_t> variableIds;
+
+        /** The number of sweeps completed by each chain, used to select random streams */
+        std::vector<std::uint64_t> sweeps;
+
+        /** Counter-based generator shared by all chains */
+        PhiloxRandom random;
+
+        /** Decides which variables each sweep updates */
+        std::shared_ptr<ScanPolicy> scanPolicy;
+
+        /** The scan state of the checkpoint the sampler was created from, until the first sample */
+        std::vector<double> pendingScanState;
+
+        /** The relative cost of updating each variable, in sample order */
+        std::vector<double> updateCosts;
+
+        /** Scratch space for the updates scheduled in the current sweep */
+        std::vector<std::size_t> visits;
+
+        /** The name of each variable interned for trace spans, indexed by identifier */
+        std::vector<const char*> traceNames;
+
+        /** The identifiers of the Markov blanket of each variable, indexed by identifier */
+        std::vector<std::vector<std::uint32_t> > blanketIds;
+
+        /** The cached predictions of each chain */
+        std::vector<PredictionCache> caches;
+
+        /** The number of updates of each variable which reused a cached prediction, indexed by identifier */
+        std::vector<std::uint64_t> cacheHits;
+
+        /** The number of samples accepted from each chain */
+        std::vector<std::uint64_t> acceptedSamples;
+
+        /** The chain which produced the most recent sample */
+        unsigned int lastChain;
     };
 }
 
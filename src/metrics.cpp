@@ -0,0 +1,106 @@
+
+#include "metrics.h"
+
+#include<cstdio>
+
+namespace depnet
+{
+    namespace
+    {
+        std::atomic<std::size_t> nextShard(0);
+    }
+
+    ShardedCounter::ShardedCounter()
+    {
+        this->reset();
+    }
+
+    std::uint64_t ShardedCounter::get() const
+    {
+        std::uint64_t total = 0;
+        for(std::size_t shard = 0; shard < NUM_SHARDS; shard++)
+            total += this->shards[shard].value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void ShardedCounter::reset()
+    {
+        for(std::size_t shard = 0; shard < NUM_SHARDS; shard++)
+            this->shards[shard].value.store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t ShardedCounter::currentShard()
+    {
+        static thread_local std::size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+        return shard;
+    }
+
+    CandidateMetrics::CandidateMetrics() : validationLoss(0), nanosecondsPerPredict(0), trainSeconds(0) { }
+
+    VariableMetrics::VariableMetrics() : trainSeconds(0), numNodes(0), maxDepth(0), 
+        predictCalls(0), predictNanoseconds(0), cacheHits(0) { }
+
+    double VariableMetrics::getNanosecondsPerPredict() const
+    {
+        return this->predictCalls == 0 ? 0.0 : static_cast<double>(this->predictNanoseconds) / this->predictCalls;
+    }
+
+    ChainMetrics::ChainMetrics() : sweeps(0), acceptedSamples(0) { }
+
+    void NetworkMetrics::writeJson(std::ostream& out) const
+    {
+        out << "{\"variables\": [";
+        for(std::size_t index = 0; index < this->variables.size(); index++)
+        {
+            const VariableMetrics& var = this->variables[index];
+            out << (index > 0 ? ", " : "") << "{\"name\": ";
+            writeJsonString(out, var.name);
+            out << ", \"model_type\": ";
+            writeJsonString(out, var.modelType);
+            out << ", \"train_seconds\": " << var.trainSeconds 
+                << ", \"num_nodes\": " << var.numNodes 
+                << ", \"max_depth\": " << var.maxDepth
+                << ", \"predict_calls\": " << var.predictCalls 
+                << ", \"predict_nanoseconds\": " << var.predictNanoseconds
+                << ", \"nanoseconds_per_predict\": " << var.getNanosecondsPerPredict()
+                << ", \"cache_hits\": " << var.cacheHits << ", \"candidates\": [";
+            for(std::size_t candidate = 0; candidate < var.candidates.size(); candidate++)
+            {
+                const CandidateMetrics& metrics = var.candidates[candidate];
+                out << (candidate > 0 ? ", " : "") << "{\"model_type\": ";
+                writeJsonString(out, metrics.modelType);
+                out << ", \"validation_loss\": " << metrics.validationLoss
+                    << ", \"nanoseconds_per_predict\": " << metrics.nanosecondsPerPredict
+                    << ", \"train_seconds\": " << metrics.trainSeconds << "}";
+            }
+            out << "]}";
+        }
+        out << "], \"chains\": [";
+        for(std::size_t index = 0; index < this->chains.size(); index++)
+        {
+            out << (index > 0 ? ", " : "") << "{\"sweeps\": " << this->chains[index].sweeps 
+                << ", \"accepted_samples\": " << this->chains[index].acceptedSamples << "}";
+        }
+        out << "]}";
+    }
+
+    void writeJsonString(std::ostream& out, const std::string& value)
+    {
+        out << '"';
+        for(auto it = value.begin(); it != value.end(); ++it)
+        {
+            unsigned char c = *it;
+            if(c == '"' || c == '\\')
+                out << '\\' << c;
+            else if(c < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            } else
+                out << c;
+        }
+        out << '"';
+    }
+}
+
@@ -0,0 +1,194 @@
+#pragma once
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include<atomic>
+#include<chrono>
+#include<cstddef>
+#include<cstdint>
+#include<ostream>
+#include<string>
+#include<vector>
+
+namespace depnet
+{
+    /**
+     * A counter which threads increment without contending on a shared cache line.
+     * Each thread adds into its own padded shard with a relaxed atomic, and readers sum the shards,
+     * so counting on hot paths costs an uncontended add rather than a lock.
+     */
+    class ShardedCounter
+    {
+    public:
+        /** Creates a counter at zero */
+        ShardedCounter();
+
+        /**
+         * Adds to the calling thread's shard
+         * @param amount The amount to add
+         */
+        void add(std::uint64_t amount)
+        {
+            this->shards[currentShard()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        /**
+         * Sums every shard. Concurrent additions may or may not be included.
+         * @return The total
+         */
+        std::uint64_t get() const;
+
+        /** Returns the counter to zero */
+        void reset();
+
+    private:
+        ShardedCounter(const ShardedCounter&);
+        ShardedCounter& operator=(const ShardedCounter&);
+
+        /** The number of shards; threads beyond this share shards round-robin */
+        static const std::size_t NUM_SHARDS = 16;
+
+        /** A shard padded to a typical cache line */
+        struct Shard
+        {
+            std::atomic<std::uint64_t> value;
+            char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+        };
+
+        /**
+         * Retrieves the shard assigned to the calling thread on its first use of any counter
+         * @return The index of the thread's shard
+         */
+        static std::size_t currentShard();
+
+        /** The per-thread partial sums */
+        Shard shards[NUM_SHARDS];
+    };
+
+    /** Counts the predictions made by a conditional model and the time spent in them */
+    struct PredictCounters
+    {
+        /** Calls to ConditionalModel::predict or ConditionalModel::getClassDensity */
+        ShardedCounter calls;
+
+        /** Wall-clock nanoseconds spent in those calls */
+        ShardedCounter nanoseconds;
+    };
+
+    /**
+     * Times a prediction from construction to destruction and adds it to a model's counters
+     */
+    class ScopedPredictTimer
+    {
+    public:
+        explicit ScopedPredictTimer(PredictCounters& counters) : 
+            counters(counters), start(std::chrono::steady_clock::now()) { }
+
+        ~ScopedPredictTimer()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - this->start;
+            this->counters.calls.add(1);
+            this->counters.nanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+    private:
+        PredictCounters& counters;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /** The measurements of one candidate model evaluated during model selection */
+    struct CandidateMetrics
+    {
+        CandidateMetrics();
+
+        /** The type of the candidate model */
+        std::string modelType;
+
+        /** The mean squared error, or the mean log loss of a discrete variable, on held-out rows */
+        double validationLoss;
+
+        /** The mean cost of a prediction on held-out rows */
+        double nanosecondsPerPredict;
+
+        /** Seconds spent training the candidate on the training split */
+        double trainSeconds;
+    };
+
+    /** A snapshot of the counters describing one variable's conditional model */
+    struct VariableMetrics
+    {
+        VariableMetrics();
+
+        /** The name of the variable */
+        std::string name;
+
+        /** The type of the variable's model, e.g. "rdf", or empty if the network is untrained */
+        std::string modelType;
+
+        /** Seconds spent training the model, or 0 if it was loaded */
+        double trainSeconds;
+
+        /** The number of nodes across every tree of a forest, or 0 for other models */
+        std::uint64_t numNodes;
+
+        /** The depth of the deepest tree of a forest, or 0 for other models */
+        int maxDepth;
+
+        /** Predictions made by the model, from any thread */
+        std::uint64_t predictCalls;
+
+        /** Nanoseconds spent in those predictions */
+        std::uint64_t predictNanoseconds;
+
+        /** Gibbs updates which reused a prediction because the variable's Markov blanket was unchanged */
+        std::uint64_t cacheHits;
+
+        /** The candidates evaluated when the model was selected automatically, or empty otherwise */
+        std::vector<CandidateMetrics> candidates;
+
+        /**
+         * Retrieves the mean cost of a prediction
+         * @return Nanoseconds per prediction, or 0 if no predictions were made
+         */
+        double getNanosecondsPerPredict() const;
+    };
+
+    /** A snapshot of the counters describing one Gibbs chain */
+    struct ChainMetrics
+    {
+        ChainMetrics();
+
+        /** Sweeps completed by the chain, including warm up and thinning */
+        std::uint64_t sweeps;
+
+        /** Samples from the chain returned after warm up and thinning */
+        std::uint64_t acceptedSamples;
+    };
+
+    /** A snapshot of the counters describing a dependency network */
+    struct NetworkMetrics
+    {
+        /** One entry per variable, in the order used for training and sampling */
+        std::vector<VariableMetrics> variables;
+
+        /** One entry per chain of the current sampler */
+        std::vector<ChainMetrics> chains;
+
+        /**
+         * Writes the snapshot as a JSON object with "variables" and "chains" arrays
+         * @param out The stream to write to
+         */
+        void writeJson(std::ostream& out) const;
+    };
+
+    /**
+     * Writes a string as a quoted JSON string, escaping quotes, backslashes and control characters
+     * @param out The stream to write to
+     * @param value The string to write
+     */
+    void writeJsonString(std::ostream& out, const std::string& value);
+}
+
+#endif
+
@@ -0,0 +1,294 @@
+#include "model_selection.h"
+#include "parallel.h"
+#include "logging.h"
+#include "tracing.h"
+#include "exceptions/conversion.h"
+#include "models/table_model.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cmath>
+#include<limits>
+#include<numeric>
+#include<random>
+
+namespace depnet
+{
+    namespace
+    {
+        /** The most held-out rows used to measure the latency of a candidate */
+        const std::size_t MAX_LATENCY_ROWS = 256;
+
+        /** The default largest probability table of a candidate, 64 MiB */
+        const std::uint64_t DEFAULT_TABLE_BUDGET = std::uint64_t(1) << 26;
+
+        /** A candidate model of one variable */
+        struct Candidate
+        {
+            Candidate() : variable(0), failed(false) { }
+
+            std::size_t variable;
+            std::shared_ptr<ConditionalModel> model;
+            CandidateMetrics metrics;
+            bool failed;
+        };
+
+        /**
+         * Copies a set of rows of a data matrix
+         */
+        void copyRows(const boost::const_multi_array_ref<double, 2>& data, const std::vector<std::size_t>& rows,
+                boost::multi_array<double, 2>& out)
+        {
+            out.resize(boost::extents[rows.size()][data.shape()[1]]);
+            for(std::size_t row = 0; row < rows.size(); row++)
+                std::copy(data[rows[row]].begin(), data[rows[row]].end(), out[row].begin());
+        }
+
+        /**
+         * Extracts the independent values of a row
+         */
+        void independentValues(const boost::multi_array<double, 2>& data, std::size_t row, std::size_t dependentIndex,
+                std::vector<double>& values)
+        {
+            values.clear();
+            for(std::size_t col = 0; col < data.shape()[1]; col++)
+                if(col != dependentIndex)
+                    values.push_back(data[row][col]);
+        }
+
+        /**
+         * Measures the mean squared error of a continuous variable, or the mean log loss of a discrete one
+         */
+        double validationLoss(const ConditionalModel& model, const VariableSpecification& var,
+                const boost::multi_array<double, 2>& validation, std::size_t dependentIndex)
+        {
+            std::vector<double> values, posterior;
+            double total = 0;
+            std::size_t counted = 0;
+            for(std::size_t row = 0; row < validation.shape()[0]; row++)
+            {
+                double target = validation[row][dependentIndex];
+                if(!std::isfinite(target))
+                    continue;
+                independentValues(validation, row, dependentIndex, values);
+                if(var.isDiscrete())
+                {
+                    model.getClassDensity(values, posterior);
+                    if(!(target >= 0 && target < posterior.size()))
+                        continue;
+                    total -= std::log(std::max(posterior[static_cast<std::size_t>(target)], 1e-12));
+                } else
+                {
+                    double error = model.predict(values) - target;
+                    total += error * error;
+                }
+                counted++;
+            }
+            return counted > 0 ? total / counted : 0;
+        }
+
+        /**
+         * Measures the mean time of the predictions a sampler would make
+         */
+        double measureLatency(const ConditionalModel& model, const VariableSpecification& var,
+                const boost::multi_array<double, 2>& validation, std::size_t dependentIndex)
+        {
+            std::size_t numRows = std::min<std::size_t>(validation.shape()[0], MAX_LATENCY_ROWS);
+            std::vector<std::vector<double> > rows(numRows);
+            for(std::size_t row = 0; row < numRows; row++)
+                independentValues(validation, row, dependentIndex, rows[row]);
+
+            std::vector<double> posterior;
+            volatile double sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(std::size_t row = 0; row < numRows; row++)
+            {
+                if(var.isDiscrete())
+                {
+                    model.getClassDensity(rows[row], posterior);
+                    sink = posterior[0];
+                } else
+                    sink = model.predict(rows[row]);
+            }
+            (void) sink;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return numRows > 0 ? std::chrono::duration<double, std::nano>(elapsed).count() / numRows : 0;
+        }
+    }
+
+    ModelSelectionOptions::ModelSelectionOptions() : validationFraction(0.2), tolerance(0.02), 
+        latencyBudget(0), tableBudget(DEFAULT_TABLE_BUDGET), numThreads(0), seed(0)
+    {
+        this->candidates.push_back("rdf");
+        this->candidates.push_back("gbt");
+        this->candidates.push_back("fast");
+        this->candidates.push_back("cpt");
+    }
+
+    ModelSelector::ModelSelector(std::shared_ptr<Factory> factory, const ModelSelectionOptions& options) :
+        factory(factory), options(options) { }
+
+    ModelSelection ModelSelector::select(const std::vector<std::shared_ptr<VariableSpecification> >& varSpecs,
+            const boost::const_multi_array_ref<double, 2>& data) const
+    {
+        TraceSpan span("ModelSelector::select", "network");
+        std::size_t numVars = varSpecs.size();
+
+        // holding out a random subset of rows, keeping at least one row on each side
+        std::vector<std::size_t> order(data.shape()[0]);
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937_64 generator(this->options.seed);
+        std::shuffle(order.begin(), order.end(), generator);
+        std::size_t numValidation = static_cast<std::size_t>(std::lround(order.size() * this->options.validationFraction));
+        numValidation = order.size() < 2 ? 0 : std::min(std::max<std::size_t>(numValidation, 1), order.size() - 1);
+        boost::multi_array<double, 2> training, validation;
+        copyRows(data, std::vector<std::size_t>(order.begin() + numValidation, order.end()), training);
+        copyRows(data, std::vector<std::size_t>(order.begin(), order.begin() + numValidation), validation);
+
+        std::vector<std::vector<std::shared_ptr<VariableSpecification> > > indepVars(numVars);
+        std::vector<Candidate> candidates;
+        for(std::size_t var = 0; var < numVars; var++)
+        {
+            for(std::size_t other = 0; other < numVars; other++)
+                if(other != var)
+                    indepVars[var].push_back(varSpecs[other]);
+
+            for(auto it = this->options.candidates.begin(); it != this->options.candidates.end(); ++it)
+            {
+                Candidate candidate;
+                candidate.variable = var;
+                candidate.metrics.modelType = *it == "fast" ? (varSpecs[var]->isDiscrete() ? "logistic" : "linear") : *it;
+
+                // tables are zero-filled in full when trained, and candidates train at once, so large ones are skipped
+                if(candidate.metrics.modelType == "cpt" && 
+                        TableConditionalModel::getTableBytes(indepVars[var], varSpecs[var]) > this->options.tableBudget)
+                    continue;
+
+                // types which cannot model the variable are not candidates
+                try
+                {
+                    candidate.model = this->factory->createModel(candidate.metrics.modelType, indepVars[var], varSpecs[var]);
+                }
+                catch(const ConversionException& e)
+                {
+                    continue;
+                }
+                if(varSpecs[var]->isDiscrete() && !candidate.model->supportsClassDensity())
+                    continue;
+                candidates.push_back(candidate);
+            }
+        }
+
+        parallelFor(candidates.size(), this->options.numThreads, [&](std::size_t index) {
+            Candidate& candidate = candidates[index];
+            try
+            {
+                auto start = std::chrono::steady_clock::now();
+                candidate.model->train(training, candidate.variable);
+                candidate.metrics.trainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                candidate.metrics.validationLoss = validationLoss(*candidate.model, *varSpecs[candidate.variable], 
+                    validation, candidate.variable);
+                candidate.failed = !std::isfinite(candidate.metrics.validationLoss);
+            }
+            catch(const std::exception& e)
+            {
+                DEPNET_WARN("Candidate " << candidate.metrics.modelType << " for " 
+                        << varSpecs[candidate.variable]->getName() << " failed: " << e.what());
+                candidate.failed = true;
+            }
+        });
+
+        for(auto it = candidates.begin(); it != candidates.end(); ++it)
+            if(!it->failed)
+                it->metrics.nanosecondsPerPredict = measureLatency(*it->model, *varSpecs[it->variable], validation, it->variable);
+
+        // the cheapest acceptable candidate of each variable
+        std::vector<std::vector<std::size_t> > byVariable(numVars);
+        std::vector<double> bestLoss(numVars, std::numeric_limits<double>::infinity());
+        for(std::size_t index = 0; index < candidates.size(); index++)
+        {
+            if(candidates[index].failed)
+                continue;
+            byVariable[candidates[index].variable].push_back(index);
+            bestLoss[candidates[index].variable] = std::min(bestLoss[candidates[index].variable], 
+                candidates[index].metrics.validationLoss);
+        }
+
+        auto excessLoss = [&](std::size_t index) {
+            std::size_t var = candidates[index].variable;
+            return (candidates[index].metrics.validationLoss - bestLoss[var]) / std::max(std::fabs(bestLoss[var]), 1e-12);
+        };
+
+        std::vector<std::size_t> chosen(numVars, candidates.size());
+        double totalLatency = 0;
+        for(std::size_t var = 0; var < numVars; var++)
+        {
+            if(byVariable[var].empty())
+                throw ConversionException("No candidate model could be trained for '" + varSpecs[var]->getName() + "'.");
+            for(auto it = byVariable[var].begin(); it != byVariable[var].end(); ++it)
+            {
+                if(excessLoss(*it) > this->options.tolerance)
+                    continue;
+                if(chosen[var] == candidates.size() || 
+                        candidates[*it].metrics.nanosecondsPerPredict < candidates[chosen[var]].metrics.nanosecondsPerPredict)
+                    chosen[var] = *it;
+            }
+            totalLatency += candidates[chosen[var]].metrics.nanosecondsPerPredict;
+        }
+
+        // trading accuracy for speed where it costs the least, until the budget is met
+        while(this->options.latencyBudget > 0 && totalLatency > this->options.latencyBudget)
+        {
+            std::size_t bestSwap = candidates.size();
+            double bestRatio = std::numeric_limits<double>::infinity();
+            for(std::size_t var = 0; var < numVars; var++)
+            {
+                const CandidateMetrics& current = candidates[chosen[var]].metrics;
+                for(auto it = byVariable[var].begin(); it != byVariable[var].end(); ++it)
+                {
+                    double saved = current.nanosecondsPerPredict - candidates[*it].metrics.nanosecondsPerPredict;
+                    if(saved <= 0)
+                        continue;
+                    double ratio = std::max(excessLoss(*it) - excessLoss(chosen[var]), 0.0) / saved;
+                    if(ratio < bestRatio)
+                    {
+                        bestRatio = ratio;
+                        bestSwap = *it;
+                    }
+                }
+            }
+            if(bestSwap == candidates.size())
+            {
+                DEPNET_WARN("The cheapest models take " << totalLatency << "ns per sweep, over the budget of " 
+                        << this->options.latencyBudget << "ns");
+                break;
+            }
+
+            std::size_t var = candidates[bestSwap].variable;
+            totalLatency += candidates[bestSwap].metrics.nanosecondsPerPredict - candidates[chosen[var]].metrics.nanosecondsPerPredict;
+            chosen[var] = bestSwap;
+        }
+
+        // the chosen models are retrained on every row
+        ModelSelection selection;
+        selection.models.resize(numVars);
+        selection.trainSeconds.resize(numVars);
+        selection.candidates.resize(numVars);
+        for(std::size_t index = 0; index < candidates.size(); index++)
+            selection.candidates[candidates[index].variable].push_back(candidates[index].metrics);
+
+        parallelFor(numVars, this->options.numThreads, [&](std::size_t var) {
+            auto start = std::chrono::steady_clock::now();
+            selection.models[var] = this->factory->createModel(candidates[chosen[var]].metrics.modelType, indepVars[var], varSpecs[var]);
+            selection.models[var]->train(data, var);
+            selection.trainSeconds[var] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+
+        for(std::size_t var = 0; var < numVars; var++)
+            DEPNET_DEBUG("Selected " << candidates[chosen[var]].metrics.modelType << " for " << varSpecs[var]->getName()
+                    << " with validation loss " << candidates[chosen[var]].metrics.validationLoss << " and "
+                    << candidates[chosen[var]].metrics.nanosecondsPerPredict << "ns per prediction");
+        return selection;
+    }
+}
+
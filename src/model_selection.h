@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef MODEL_SELECTION_H
+#define MODEL_SELECTION_H
+
+#include<cstdint>
+#include<memory>
+#include<string>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "metrics.h"
+#include "factory.h"
+#include "models/conditional_model.h"
+
+namespace depnet
+{
+    /**
+     * Controls how ModelSelector evaluates and chooses conditional models
+     */
+    struct ModelSelectionOptions
+    {
+        /** Selects among forests, boosted trees, linear or logistic models and probability tables */
+        ModelSelectionOptions();
+
+        /** 
+         * The types of model to evaluate, as accepted by Factory::createModel. "fast" stands for "linear" 
+         * or "logistic" depending on the variable. Types which do not apply to a variable are skipped.
+         */
+        std::vector<std::string> candidates;
+
+        /** The fraction of rows held out to measure validation loss */
+        double validationFraction;
+
+        /** A candidate is acceptable if its validation loss is within this fraction of the best candidate's */
+        double tolerance;
+
+        /** The largest total cost in nanoseconds of predicting every variable once, or 0 for no budget */
+        double latencyBudget;
+
+        /** The largest probability table in bytes a "cpt" candidate may allocate; larger tables are not candidates */
+        std::uint64_t tableBudget;
+
+        /** The number of candidates trained at once, or 0 for one per core */
+        unsigned int numThreads;
+
+        /** Seeds the choice of held-out rows */
+        std::uint64_t seed;
+    };
+
+    /** The models chosen for a set of variables and the measurements behind each choice */
+    struct ModelSelection
+    {
+        /** The chosen model of each variable, trained on every row */
+        std::vector<std::shared_ptr<ConditionalModel> > models;
+
+        /** The seconds spent training each chosen model on every row */
+        std::vector<double> trainSeconds;
+
+        /** The candidates evaluated for each variable */
+        std::vector<std::vector<CandidateMetrics> > candidates;
+    };
+
+    /**
+     * Chooses a conditional model for each variable by training candidates on part of the data and 
+     * measuring them on the rest. Each variable gets the cheapest candidate whose validation loss is within 
+     * a tolerance of its best candidate's. If the chosen models together exceed the latency budget, 
+     * the choices which give up the least loss per nanosecond saved are replaced by cheaper candidates 
+     * until the budget is met. Candidates are trained in parallel, while their latency is measured 
+     * one at a time so that measurements do not compete for cores.
+     */
+    class ModelSelector
+    {
+    public:
+        /**
+         * Creates a selector
+         * @param factory Creates the candidate models
+         * @param options Controls the candidates, the split and the budget
+         */
+        ModelSelector(std::shared_ptr<Factory> factory, const ModelSelectionOptions& options);
+
+        /**
+         * Chooses and trains a model for each variable
+         * @param varSpecs The variables, in column order
+         * @param data The training data, with one column per variable
+         * @return The chosen models, trained on every row, with the measurements of each candidate
+         */
+        ModelSelection select(const std::vector<std::shared_ptr<VariableSpecification> >& varSpecs,
+            const boost::const_multi_array_ref<double, 2>& data) const;
+
+    private:
+        /** Creates the candidate models */
+        std::shared_ptr<Factory> factory;
+
+        /** Controls the candidates, the split and the budget */
+        ModelSelectionOptions options;
+    };
+}
+
+#endif
+
@@ -0,0 +1,506 @@
+#include "boosted_model.h"
+#include "flat_trees.h"
+#include "parallel.h"
+#include "exceptions/density.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<cmath>
+#include<mutex>
+
+namespace depnet
+{
+    namespace
+    {
+        /** The L2 penalty on leaf values, which also keeps leaves with little curvature from growing large */
+        const double LEAF_PENALTY = 1.0;
+
+        /** The fewest training rows on either side of a split */
+        const std::size_t MIN_LEAF_ROWS = 5;
+
+        /** A node of a tree under construction; a leaf has no feature */
+        struct TreeNode
+        {
+            TreeNode(double gradient, double hessian, std::size_t rows) : 
+                feature(-1), bin(0), threshold(0), left(0), right(0), 
+                gradient(gradient), hessian(hessian), rows(rows) { }
+
+            int feature;
+            int bin;
+            double threshold;
+            std::size_t left;
+            std::size_t right;
+
+            /** The sums of the gradients and hessians of the node's rows, and their number */
+            double gradient;
+            double hessian;
+            std::size_t rows;
+        };
+
+        /** The best split found for a node */
+        struct Split
+        {
+            Split() : gain(0), feature(-1), bin(0), leftGradient(0), leftHessian(0), leftRows(0) { }
+
+            double gain;
+            int feature;
+            int bin;
+            double leftGradient;
+            double leftHessian;
+            std::size_t leftRows;
+        };
+
+        /**
+         * Computes the score of a leaf minimizing the penalized second-order approximation of the loss
+         */
+        double leafValue(double gradient, double hessian, double learningRate)
+        {
+            return -gradient / (hessian + LEAF_PENALTY) * learningRate;
+        }
+
+        /**
+         * Scores how well a set of rows is fit by a single leaf
+         */
+        double leafScore(double gradient, double hessian)
+        {
+            return gradient * gradient / (hessian + LEAF_PENALTY);
+        }
+
+        /**
+         * Grows a tree depth-wise, splitting every open node of a level from one pass over the rows per feature
+         * @param bins The bin of each row, feature by feature
+         * @param thresholds The upper bound of each bin of each feature but the last
+         * @param gradients The gradient of the loss at each row
+         * @param hessians The second derivative of the loss at each row
+         * @param maxDepth The greatest depth of the tree
+         * @param numThreads The number of threads building histograms
+         * @param tree The nodes of the tree, with the root first
+         * @param rowLeaf The leaf holding each row once the tree is grown
+         */
+        void growTree(const std::vector<std::uint8_t>& bins, const std::vector<std::vector<double> >& thresholds,
+                const std::vector<double>& gradients, const std::vector<double>& hessians, int maxDepth, 
+                unsigned int numThreads, std::vector<TreeNode>& tree, std::vector<std::size_t>& rowLeaf)
+        {
+            std::size_t numRows = gradients.size();
+            double gradient = 0, hessian = 0;
+            for(std::size_t row = 0; row < numRows; row++)
+            {
+                gradient += gradients[row];
+                hessian += hessians[row];
+            }
+            tree.assign(1, TreeNode(gradient, hessian, numRows));
+            rowLeaf.assign(numRows, 0);
+
+            std::vector<std::size_t> open(1, 0);
+            for(int depth = 0; depth < maxDepth && !open.empty(); depth++)
+            {
+                std::vector<int> slotOf(tree.size(), -1);
+                for(std::size_t slot = 0; slot < open.size(); slot++)
+                    slotOf[open[slot]] = slot;
+
+                std::vector<Split> best(open.size());
+                std::mutex bestMutex;
+                parallelFor(thresholds.size(), numThreads, [&](std::size_t feature) {
+                    std::size_t numBins = thresholds[feature].size() + 1;
+                    if(numBins < 2)
+                        return;
+
+                    // one histogram of gradient and hessian sums per open node
+                    std::vector<double> gradientSums(open.size() * numBins), hessianSums(open.size() * numBins);
+                    std::vector<std::size_t> counts(open.size() * numBins);
+                    const std::uint8_t* featureBins = bins.data() + feature * numRows;
+                    for(std::size_t row = 0; row < numRows; row++)
+                    {
+                        int slot = slotOf[rowLeaf[row]];
+                        if(slot < 0)
+                            continue;
+                        std::size_t cell = slot * numBins + featureBins[row];
+                        gradientSums[cell] += gradients[row];
+                        hessianSums[cell] += hessians[row];
+                        counts[cell]++;
+                    }
+
+                    std::vector<Split> local(open.size());
+                    for(std::size_t slot = 0; slot < open.size(); slot++)
+                    {
+                        const TreeNode& node = tree[open[slot]];
+                        double parentScore = leafScore(node.gradient, node.hessian);
+                        double leftGradient = 0, leftHessian = 0;
+                        std::size_t leftRows = 0;
+                        for(std::size_t bin = 0; bin + 1 < numBins; bin++)
+                        {
+                            std::size_t cell = slot * numBins + bin;
+                            leftGradient += gradientSums[cell];
+                            leftHessian += hessianSums[cell];
+                            leftRows += counts[cell];
+                            if(leftRows < MIN_LEAF_ROWS || node.rows - leftRows < MIN_LEAF_ROWS)
+                                continue;
+
+                            double gain = leafScore(leftGradient, leftHessian) + 
+                                leafScore(node.gradient - leftGradient, node.hessian - leftHessian) - parentScore;
+                            if(gain > local[slot].gain)
+                            {
+                                local[slot].gain = gain;
+                                local[slot].feature = feature;
+                                local[slot].bin = bin;
+                                local[slot].leftGradient = leftGradient;
+                                local[slot].leftHessian = leftHessian;
+                                local[slot].leftRows = leftRows;
+                            }
+                        }
+                    }
+
+                    // ties go to the lowest feature, so the tree does not depend on thread timing
+                    std::lock_guard<std::mutex> lock(bestMutex);
+                    for(std::size_t slot = 0; slot < open.size(); slot++)
+                    {
+                        if(local[slot].feature < 0)
+                            continue;
+                        if(local[slot].gain > best[slot].gain || 
+                                (local[slot].gain == best[slot].gain && local[slot].feature < best[slot].feature))
+                            best[slot] = local[slot];
+                    }
+                });
+
+                std::vector<std::size_t> next;
+                for(std::size_t slot = 0; slot < open.size(); slot++)
+                {
+                    const Split& split = best[slot];
+                    if(split.feature < 0)
+                        continue;
+
+                    TreeNode parent = tree[open[slot]];
+                    TreeNode left(split.leftGradient, split.leftHessian, split.leftRows);
+                    TreeNode right(parent.gradient - split.leftGradient, parent.hessian - split.leftHessian, 
+                            parent.rows - split.leftRows);
+                    tree[open[slot]].feature = split.feature;
+                    tree[open[slot]].bin = split.bin;
+                    tree[open[slot]].threshold = thresholds[split.feature][split.bin];
+                    tree[open[slot]].left = tree.size();
+                    tree[open[slot]].right = tree.size() + 1;
+                    next.push_back(tree.size());
+                    next.push_back(tree.size() + 1);
+                    tree.push_back(left);
+                    tree.push_back(right);
+                }
+
+                // rows of nodes split at this depth move to a child
+                for(std::size_t row = 0; row < numRows; row++)
+                {
+                    const TreeNode& node = tree[rowLeaf[row]];
+                    if(node.feature >= 0)
+                        rowLeaf[row] = bins[node.feature * numRows + row] <= node.bin ? node.left : node.right;
+                }
+                open.swap(next);
+            }
+        }
+
+        /**
+         * Appends a tree in alglib's flat layout: a leaf is (-1, value) and an inner node 
+         * (feature, threshold, offset of the right child from the start of the tree)
+         * @param tree The nodes of the tree
+         * @param node The node to append along with its descendants
+         * @param treeStart The position of the tree's size in out
+         * @param learningRate The factor applied to each leaf
+         * @param out The node array to append to
+         */
+        void flattenTree(const std::vector<TreeNode>& tree, std::size_t node, std::size_t treeStart, 
+                double learningRate, std::vector<double>& out)
+        {
+            if(tree[node].feature < 0)
+            {
+                out.push_back(-1);
+                out.push_back(leafValue(tree[node].gradient, tree[node].hessian, learningRate));
+                return;
+            }
+
+            std::size_t position = out.size();
+            out.push_back(tree[node].feature);
+            out.push_back(tree[node].threshold);
+            out.push_back(0);
+            flattenTree(tree, tree[node].left, treeStart, learningRate, out);
+            out[position + 2] = out.size() - treeStart;
+            flattenTree(tree, tree[node].right, treeStart, learningRate, out);
+        }
+    }
+
+    BoostedTreeModel::BoostedTreeModel(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep, int numRounds, int maxDepth,
+            double learningRate, int maxBins, unsigned int numThreads) :
+        independentVars(indep), dependentVar(dep), numRounds(numRounds), maxDepth(maxDepth), 
+        learningRate(learningRate), maxBins(std::min(std::max(maxBins, 2), 256)), numThreads(numThreads),
+        initialScores(getNumClasses(), 0.0), numTrees(0), nodes(NULL), numNodes(0) { }
+
+    const std::vector<std::shared_ptr<VariableSpecification> > & BoostedTreeModel::getIndependentVars()
+    {
+        return this->independentVars;
+    }
+
+    const std::shared_ptr<VariableSpecification> BoostedTreeModel::getDependentVar()
+    {
+        return this->dependentVar;
+    }
+
+    void BoostedTreeModel::getClassDensity(const std::vector<double>& indep, 
+            std::vector<double> & posterior) const
+    {
+        if(!this->dependentVar->isDiscrete())
+            throw DensityEstimationUnsupported(std::string("Cannot retrieve class densities for ") +
+                         "a non-discrete probability distribution.");
+
+        ScopedPredictTimer timer(this->predictCounters);
+        posterior.resize(this->getNumClasses());
+        this->score(indep.data(), posterior.data());
+
+        double maxScore = *std::max_element(posterior.begin(), posterior.end());
+        double total = 0;
+        for(auto it = posterior.begin(); it != posterior.end(); ++it)
+        {
+            *it = std::exp(*it - maxScore);
+            total += *it;
+        }
+        for(auto it = posterior.begin(); it != posterior.end(); ++it)
+            *it /= total;
+    }
+
+    bool BoostedTreeModel::supportsClassDensity()
+    {
+        return this->dependentVar->isDiscrete();
+    }
+
+    double BoostedTreeModel::predict(const std::vector<double>& indep) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        std::vector<double> scores(this->getNumClasses());
+        this->score(indep.data(), scores.data());
+        if(!this->dependentVar->isDiscrete())
+            return scores[0];
+        return std::max_element(scores.begin(), scores.end()) - scores.begin();
+    }
+
+    double BoostedTreeModel::getPredictCost() const
+    {
+        if(this->numTrees == 0)
+            return 1.0;
+
+        // each prediction walks one root-to-leaf path per tree
+        double nodesPerTree = static_cast<double>(this->numNodes) / this->numTrees / 2;
+        return this->numTrees * std::log2(2 + nodesPerTree);
+    }
+
+    void BoostedTreeModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+        flat_trees::measure(this->nodes, this->numTrees, metrics);
+    }
+
+    void BoostedTreeModel::train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex)
+    {
+        TraceSpan span("BoostedTreeModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        int numClasses = this->getNumClasses();
+        std::size_t numFeatures = this->independentVars.size();
+        unsigned int numThreads = this->numThreads > 0 ? this->numThreads : getDefaultThreads();
+
+        // dropping rows without a usable dependent value
+        std::vector<std::size_t> rows;
+        std::vector<double> targets;
+        for(std::size_t row = 0; row < data.shape()[0]; row++)
+        {
+            double target = data[row][dependentIndex];
+            if(numClasses == 1 ? std::isfinite(target) : (target >= 0 && target < numClasses))
+            {
+                rows.push_back(row);
+                targets.push_back(numClasses == 1 ? target : std::floor(target));
+            }
+        }
+        std::size_t numRows = rows.size();
+
+        // the scores start at the mean, or at the log of each level's smoothed frequency
+        this->initialScores.assign(numClasses, 0.0);
+        if(numClasses == 1)
+        {
+            for(auto it = targets.begin(); it != targets.end(); ++it)
+                this->initialScores[0] += *it;
+            this->initialScores[0] = numRows > 0 ? this->initialScores[0] / numRows : 0;
+        } else
+        {
+            std::vector<double> counts(numClasses, 1.0);
+            for(auto it = targets.begin(); it != targets.end(); ++it)
+                counts[static_cast<int>(*it)]++;
+            for(int level = 0; level < numClasses; level++)
+                this->initialScores[level] = std::log(counts[level] / (numRows + numClasses));
+        }
+
+        // each feature is divided into bins at its distinct values, or at quantiles if there are too many;
+        // missing values sort past every threshold, into the last bin, as they do at prediction time
+        std::vector<std::vector<double> > thresholds(numFeatures);
+        std::vector<std::uint8_t> bins(numFeatures * numRows);
+        {
+            TraceSpan binSpan("binFeatures", "model");
+            parallelFor(numFeatures, numThreads, [&](std::size_t feature) {
+                std::size_t column = feature < static_cast<std::size_t>(dependentIndex) ? feature : feature + 1;
+                std::vector<double> values;
+                for(std::size_t row = 0; row < numRows; row++)
+                    if(std::isfinite(data[rows[row]][column]))
+                        values.push_back(data[rows[row]][column]);
+                std::sort(values.begin(), values.end());
+
+                std::vector<double> distinct(values);
+                distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+                std::vector<double>& featureThresholds = thresholds[feature];
+                if(distinct.size() <= static_cast<std::size_t>(this->maxBins))
+                {
+                    for(std::size_t index = 1; index < distinct.size(); index++)
+                        featureThresholds.push_back((distinct[index - 1] + distinct[index]) / 2);
+                } else
+                {
+                    for(int bin = 1; bin < this->maxBins; bin++)
+                    {
+                        double quantile = values[bin * values.size() / this->maxBins];
+                        if(featureThresholds.empty() || quantile > featureThresholds.back())
+                            featureThresholds.push_back(quantile);
+                    }
+                }
+
+                for(std::size_t row = 0; row < numRows; row++)
+                {
+                    double value = data[rows[row]][column];
+                    bins[feature * numRows + row] = std::upper_bound(featureThresholds.begin(), 
+                        featureThresholds.end(), value) - featureThresholds.begin();
+                }
+            });
+        }
+
+        this->ownedNodes.clear();
+        this->numTrees = 0;
+        this->nodeBuffer.reset();
+        std::vector<double> scores(numRows * numClasses);
+        for(std::size_t row = 0; row < numRows; row++)
+            std::copy(this->initialScores.begin(), this->initialScores.end(), scores.begin() + row * numClasses);
+
+        std::vector<double> probabilities(numClasses == 1 ? 0 : numRows * numClasses);
+        std::vector<double> gradients(numRows), hessians(numRows);
+        std::vector<TreeNode> tree;
+        std::vector<std::size_t> rowLeaf;
+        for(int round = 0; round < this->numRounds && numRows > 0 && numFeatures > 0; round++)
+        {
+            TraceSpan roundSpan("boostRound", "model");
+
+            // every tree of a round fits the softmax of the scores at the start of the round
+            for(std::size_t row = 0; row < numRows && numClasses > 1; row++)
+            {
+                const double* rowScores = scores.data() + row * numClasses;
+                double* rowProbabilities = probabilities.data() + row * numClasses;
+                double maxScore = *std::max_element(rowScores, rowScores + numClasses);
+                double total = 0;
+                for(int level = 0; level < numClasses; level++)
+                    total += rowProbabilities[level] = std::exp(rowScores[level] - maxScore);
+                for(int level = 0; level < numClasses; level++)
+                    rowProbabilities[level] /= total;
+            }
+
+            for(int level = 0; level < numClasses; level++)
+            {
+                for(std::size_t row = 0; row < numRows; row++)
+                {
+                    if(numClasses == 1)
+                    {
+                        gradients[row] = scores[row] - targets[row];
+                        hessians[row] = 1;
+                    } else
+                    {
+                        double probability = probabilities[row * numClasses + level];
+                        gradients[row] = probability - (targets[row] == level ? 1 : 0);
+                        hessians[row] = std::max(probability * (1 - probability), 1e-6);
+                    }
+                }
+
+                growTree(bins, thresholds, gradients, hessians, this->maxDepth, numThreads, tree, rowLeaf);
+                std::size_t treeStart = this->ownedNodes.size();
+                this->ownedNodes.push_back(0);
+                flattenTree(tree, 0, treeStart, this->learningRate, this->ownedNodes);
+                this->ownedNodes[treeStart] = this->ownedNodes.size() - treeStart;
+                this->numTrees++;
+
+                for(std::size_t row = 0; row < numRows; row++)
+                {
+                    const TreeNode& leaf = tree[rowLeaf[row]];
+                    scores[row * numClasses + level] += leafValue(leaf.gradient, leaf.hessian, this->learningRate);
+                }
+            }
+        }
+        this->nodes = this->ownedNodes.data();
+        this->numNodes = this->ownedNodes.size();
+
+        DEPNET_DEBUG("Boosted " << this->numTrees << " trees with " << this->numNodes << " values for " 
+                << this->dependentVar->getName() << " from " << numRows << " rows");
+    }
+
+    std::string BoostedTreeModel::getModelType() const
+    {
+        return "gbt";
+    }
+
+    void BoostedTreeModel::save(binary_io::OffsetStream& out) const
+    {
+        binary_io::writeVector(out, this->initialScores);
+        binary_io::write<std::uint64_t>(out, this->numTrees);
+        binary_io::write<std::uint64_t>(out, this->numNodes);
+        binary_io::pad(out, sizeof(double));
+        out.write(reinterpret_cast<const char*>(this->nodes), this->numNodes * sizeof(double));
+    }
+
+    void BoostedTreeModel::load(binary_io::MemoryReader& in)
+    {
+        std::uint64_t numClasses = in.read<std::uint64_t>();
+        if(numClasses != static_cast<std::uint64_t>(this->getNumClasses()))
+            throw ConversionException("Saved boosted trees do not match the levels of their variable.");
+        const double* initialScores = in.view<double>(numClasses);
+        this->initialScores.assign(initialScores, initialScores + numClasses);
+        std::uint64_t numTrees = in.read<std::uint64_t>();
+        std::uint64_t numNodes = in.read<std::uint64_t>();
+
+        // prediction only reads the node array, so it is used in place once every tree has been walked,
+        // since score follows features and offsets without bounds checks
+        in.align(sizeof(double));
+        const double* nodes = in.view<double>(numNodes);
+        flat_trees::validate(nodes, numNodes, numTrees, this->independentVars.size(), 0);
+        this->numTrees = numTrees;
+        this->numNodes = numNodes;
+        this->nodes = nodes;
+        this->ownedNodes.clear();
+        this->nodeBuffer = in.getBuffer();
+    }
+
+    void BoostedTreeModel::score(const double* values, double* scores) const
+    {
+        int numClasses = this->initialScores.size();
+        std::copy(this->initialScores.begin(), this->initialScores.end(), scores);
+
+        const double* tree = this->nodes;
+        for(std::size_t index = 0; index < this->numTrees; index++)
+        {
+            const double* node = tree + 1;
+            while(node[0] != -1)
+                node = values[static_cast<std::size_t>(node[0])] < node[1] ? node + 3 : tree + static_cast<std::size_t>(node[2]);
+            scores[index % numClasses] += node[1];
+            tree += static_cast<std::size_t>(tree[0]);
+        }
+    }
+
+    int BoostedTreeModel::getNumClasses() const
+    {
+        if(!this->dependentVar->isDiscrete())
+            return 1;
+        if(this->dependentVar->isBoolean() && this->dependentVar->getNumLevels() == 0)
+            return 2;
+        return std::max(this->dependentVar->getNumLevels(), 1);
+    }
+}
+
@@ -0,0 +1,179 @@
+#pragma once
+
+#ifndef BOOSTED_MODEL_H
+#define BOOSTED_MODEL_H
+
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "mapped_buffer.h"
+#include "conditional_model.h"
+
+namespace depnet 
+{
+    /**
+     * A model used for regression or classification based on gradient-boosted decision trees.
+     * Trees are grown depth-wise over histograms of binned feature values, and each round fits the
+     * gradient of the squared error for a continuous variable or of the softmax log-loss, one tree per level, 
+     * for a discrete variable. Independent variables are split on their values, and strictly discrete 
+     * variables on their level index. Histograms are built in parallel across features.
+     *
+     * Trees are stored in alglib's flat decision forest layout: each tree is its size followed by nodes 
+     * in preorder, a leaf being (-1, value) and an inner node (feature, threshold, offset of the right child) 
+     * with the left child following it. A leaf holds the tree's contribution to the score.
+     */
+    class BoostedTreeModel : public ConditionalModel 
+    {
+    public:
+        /**
+         * Creates an untrained boosted model
+         * @param indep The independent variables, in the order their columns are supplied
+         * @param dep The dependent variable
+         * @param numRounds The number of boosting rounds, each adding one tree per level of a discrete variable
+         * @param maxDepth The greatest depth of each tree
+         * @param learningRate The factor applied to each tree's leaves
+         * @param maxBins The largest number of bins a feature is divided into, at most 256
+         * @param numThreads The number of threads building histograms, or 0 for one per core
+         */
+        BoostedTreeModel(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep, int numRounds = 100, int maxDepth = 4,
+                double learningRate = 0.1, int maxBins = 64, unsigned int numThreads = 0);
+
+        /**
+         * Retrieves the independent variables in the order they were specified during initialization
+         * @return The variables required for prediction in the same order that they should be specified for prediction
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> > & getIndependentVars();
+
+        /**
+         * Retrieves the dependent variable being modeled
+         * @return The variable this model builds predictions for
+         */
+        const std::shared_ptr<VariableSpecification> getDependentVar();
+
+        /**
+         * Retrieves the softmax of the scores of each level. 
+         * Throws DensityEstimationUnsupported for a continuous dependent variable.
+         * @param indep The independent variables to use as evidence
+         * @param posterior A reference in which to store a K-dimensional vector of posterior probabilities.
+         * K is the number of levels of the dependent variable.
+         */
+        void getClassDensity(const std::vector<double>& indep, 
+                std::vector<double> & posterior) const;
+
+        /**
+         * Indicates that class densities are supported for discrete dependent variables
+         * @return true if the dependent variable is discrete
+         */
+        bool supportsClassDensity();
+        
+        /**
+         * Predicts the dependent variable, or its level with the highest score if it is discrete
+         * @param indep A 1D input vector of length K, where K is the number of independent variables
+         */
+        double predict(const std::vector<double>& indep) const;
+
+        /**
+         * Estimates the cost of a prediction as the number of trees times the average tree depth
+         * @return The relative cost of a prediction, or 1 before training
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number of nodes and greatest depth across the trees, 
+         * and the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
+        /**
+         * Boosts trees from a 2D array. Rows whose dependent value is missing, or not a level 
+         * of a discrete variable, are ignored.
+         * @param data A 2D array with the independent variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The index of the dependent value in data
+         */
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct boosted models
+         * @return "gbt"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the initial scores and the node array in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores trees written by BoostedTreeModel::save. The node array is used in place 
+         * from the reader's buffer, which is kept alive for the lifetime of this model.
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
+
+    private:
+        /**
+         * Adds up the scores of an instance
+         * @param values One value per independent variable
+         * @param scores An array to fill with one score per class
+         */
+        void score(const double* values, double* scores) const;
+
+        /**
+         * Retrieves the number of scores per instance
+         * @return 1 when the dependent variable is continuous, otherwise its number of levels
+         */
+        int getNumClasses() const;
+
+        /** The sequence of independent variables to fit a model against */
+        std::vector<std::shared_ptr<VariableSpecification> > independentVars;
+    
+        /** The variable to build a predictor for */
+        std::shared_ptr<VariableSpecification> dependentVar;
+
+        /** The number of boosting rounds */
+        int numRounds;
+
+        /** The greatest depth of each tree */
+        int maxDepth;
+
+        /** The factor applied to each tree's leaves */
+        double learningRate;
+
+        /** The largest number of bins per feature */
+        int maxBins;
+
+        /** The number of threads building histograms, or 0 for one per core */
+        unsigned int numThreads;
+
+        /** The score of each class before any tree is added */
+        std::vector<double> initialScores;
+
+        /** The number of trees; tree i adds to the score of class i modulo the number of classes */
+        std::size_t numTrees;
+
+        /** The node array built during training, empty when loaded in place */
+        std::vector<double> ownedNodes;
+
+        /** The node array used for prediction, either ownedNodes or memory in nodeBuffer */
+        const double* nodes;
+
+        /** The length of the node array */
+        std::size_t numNodes;
+
+        /** The memory holding the node array when it was loaded in place */
+        std::shared_ptr<const MappedBuffer> nodeBuffer;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
+    };
+}
+
+#endif
+
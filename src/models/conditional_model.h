@@ -4,8 +4,16 @@
 #ifndef CONDITIONAL_MODEL_H
 #define CONDITIONAL_MODEL_H
 
+#include<algorithm>
 #include<boost/multi_array.hpp>
 #include<memory>
+#include<ostream>
+#include<string>
+
+#include "var_spec.h"
+#include "binary_io.h"
+#include "metrics.h"
+#include "exceptions/density.h"
 
 namespace depnet 
 {
@@ -57,14 +65,90 @@ namespace depnet
          */
         virtual double predict(const std::vector<double>& indep) const = 0;
 
+        /**
+         * Predicts the dependent variable for a batch of instances. Models with per-call setup, 
+         * such as acquiring a query buffer, override this to pay for it once per batch.
+         * @param indep A 2D array with one row per instance and one column per independent variable
+         * @param out An array with room for one prediction per row
+         */
+        virtual void predictBatch(const boost::const_multi_array_ref<double, 2>& indep, double* out) const
+        {
+            std::vector<double> values(indep.shape()[1]);
+            for(std::size_t row = 0; row < indep.shape()[0]; row++)
+            {
+                std::copy(indep[row].begin(), indep[row].end(), values.begin());
+                out[row] = this->predict(values);
+            }
+        }
+
+        /**
+         * Indicates if this model can describe the dependent variable as a discrete distribution over 
+         * observed values, which lets a sampler draw a value of a continuous variable rather than its mean
+         * @return true if ConditionalModel::getValueDensity is supported, false otherwise
+         */
+        virtual bool supportsValueDensity() const { return false; }
+
+        /**
+         * Retrieves a discrete distribution over candidate values of the dependent variable
+         * given a set of independent variables. Throws DensityEstimationUnsupported unless 
+         * ConditionalModel::supportsValueDensity is true.
+         * @param indep The independent variables to use as evidence
+         * @param values A reference in which to store the candidate values
+         * @param weights A reference in which to store one non-negative weight per candidate value
+         */
+        virtual void getValueDensity(const std::vector<double>& indep, 
+                std::vector<double>& values, std::vector<double>& weights) const
+        {
+            throw DensityEstimationUnsupported("Value densities are not supported by " + this->getModelType() + " models.");
+        }
+
+        /**
+         * Estimates the relative cost of a single call to ConditionalModel::predict or 
+         * ConditionalModel::getClassDensity, used to schedule Gibbs updates. 
+         * Only ratios between models are meaningful.
+         * @return A positive cost, 1 unless a model overrides it
+         */
+        virtual double getPredictCost() const { return 1.0; }
+
+        /**
+         * Fills in the model's structure and prediction counters, leaving fields a model 
+         * does not track untouched
+         * @param metrics The metrics of the model's dependent variable
+         */
+        virtual void getMetrics(VariableMetrics& metrics) const { }
+
         /**
          * Trains the model from a 2D data matrix.
          * @param data A 2D array of doubles representing continuous values 
          * or discrete factor levels. Data instances should stored in rows and features should be stored in columns.
+         * Any boost::multi_array may be passed, or a reference to memory owned elsewhere, such as a NumPy array.
          * @param dependentIndex The index of the dependent variable in the multi_array
          */
-        virtual void train(const boost::multi_array<double, 2>& data, 
+        virtual void train(const boost::const_multi_array_ref<double, 2>& data, 
             boost::multi_array<double, 2>::index dependentIndex) = 0;
+
+        /**
+         * Retrieves a short name identifying the kind of model, used by Factory::createModel
+         * to reconstruct the model when a network is loaded
+         * @return The model type, e.g. "rdf"
+         */
+        virtual std::string getModelType() const = 0;
+
+        /**
+         * Writes the model's parameters and learned state in binary form. 
+         * Large arrays should be aligned with binary_io::pad so they can be used in place when loaded.
+         * @param out The stream to write to, whose offset 0 is the start of the model's data
+         */
+        virtual void save(binary_io::OffsetStream& out) const = 0;
+
+        /**
+         * Restores the parameters and learned state written by ConditionalModel::save, 
+         * replacing any state from training. Implementations may refer to the reader's buffer in place.
+         * The reader is limited to the model's data, so fields appended by newer versions of a model
+         * can be detected with binary_io::MemoryReader::remaining.
+         * @param in A reader positioned at the start of the model's data
+         */
+        virtual void load(binary_io::MemoryReader& in) = 0;
     };
 
 }
@@ -0,0 +1,90 @@
+#include "flat_trees.h"
+#include "exceptions/conversion.h"
+
+#include<algorithm>
+#include<cmath>
+#include<string>
+#include<vector>
+
+namespace depnet
+{
+    namespace
+    {
+        /** Reads an index stored as a double, which must be a whole number below limit */
+        bool toIndex(double value, std::size_t limit, std::size_t& index)
+        {
+            if(!(value >= 0 && value < limit) || std::floor(value) != value)
+                return false;
+            index = static_cast<std::size_t>(value);
+            return true;
+        }
+    }
+
+    void flat_trees::validate(const double* values, std::size_t numValues, std::size_t numTrees, 
+        std::size_t numFeatures, std::size_t numClasses)
+    {
+        std::vector<std::size_t> pending;
+        std::size_t offset = 0;
+        for(std::size_t tree = 0; tree < numTrees; tree++)
+        {
+            std::size_t size;
+            if(offset >= numValues || !toIndex(values[offset], numValues - offset + 1, size) || size < 3)
+                throw ConversionException("Saved tree " + std::to_string(tree) + " overruns its node array.");
+            std::size_t end = offset + size;
+
+            // children follow their parent, so every walk moves forward and stays within the tree. a valid 
+            // tree has fewer nodes than values, which also bounds walks of trees whose children are shared.
+            std::size_t numNodes = 0;
+            pending.assign(1, offset + 1);
+            while(!pending.empty())
+            {
+                std::size_t node = pending.back();
+                pending.pop_back();
+                if(++numNodes > size || node + 1 >= end)
+                    throw ConversionException("Saved tree " + std::to_string(tree) + " overruns its node array.");
+
+                std::size_t index;
+                if(values[node] == -1)
+                {
+                    if(numClasses > 0 && !toIndex(values[node + 1], numClasses, index))
+                        throw ConversionException("Saved tree " + std::to_string(tree) + " has a leaf with an invalid class.");
+                    continue;
+                }
+
+                if(node + 2 >= end || !toIndex(values[node], numFeatures, index) || 
+                        !toIndex(values[node + 2], size, index) || offset + index <= node)
+                    throw ConversionException("Saved tree " + std::to_string(tree) + 
+                        " has a node with an invalid feature or child.");
+                pending.push_back(offset + index);
+                pending.push_back(node + 3);
+            }
+            offset = end;
+        }
+    }
+
+    void flat_trees::measure(const double* values, std::size_t numTrees, VariableMetrics& metrics)
+    {
+        metrics.numNodes = 0;
+        metrics.maxDepth = 0;
+
+        std::vector<std::pair<std::size_t, int> > pending;
+        std::size_t offset = 0;
+        for(std::size_t tree = 0; tree < numTrees; tree++)
+        {
+            pending.push_back(std::make_pair(offset + 1, 1));
+            while(!pending.empty())
+            {
+                std::size_t node = pending.back().first;
+                int depth = pending.back().second;
+                pending.pop_back();
+                metrics.numNodes++;
+                metrics.maxDepth = std::max(metrics.maxDepth, depth);
+                if(values[node] == -1)
+                    continue;
+                pending.push_back(std::make_pair(node + 3, depth + 1));
+                pending.push_back(std::make_pair(offset + static_cast<std::size_t>(std::lround(values[node + 2])), depth + 1));
+            }
+            offset += static_cast<std::size_t>(std::lround(values[offset]));
+        }
+    }
+}
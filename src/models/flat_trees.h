@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef FLAT_TREES_H
+#define FLAT_TREES_H
+
+#include<cstddef>
+
+#include "metrics.h"
+
+namespace depnet
+{
+    /**
+     * Operations on decision trees stored in alglib's flat decision forest layout, shared by RandomForestModel 
+     * and BoostedTreeModel. Each tree is its size followed by nodes in preorder: a leaf is (-1, value) and 
+     * an inner node (feature, threshold, offset of the right child from the start of the tree), 
+     * with the left child following it.
+     */
+    namespace flat_trees
+    {
+        /**
+         * Checks that trees loaded from a file or shared memory can be walked without leaving their array,
+         * since prediction follows features and offsets without bounds checks
+         * @param values The trees, one after another
+         * @param numValues The number of values the trees may occupy
+         * @param numTrees The number of trees
+         * @param numFeatures The number of features an inner node may split on
+         * @param numClasses The number of classes a leaf may hold, or 0 if leaves hold arbitrary values
+         * @throws ConversionException if a tree overruns the array or a node's feature, class or child is invalid
+         */
+        void validate(const double* values, std::size_t numValues, std::size_t numTrees, 
+            std::size_t numFeatures, std::size_t numClasses);
+
+        /**
+         * Counts the nodes of a set of trees and measures the deepest path through them
+         * @param values The trees, one after another
+         * @param numTrees The number of trees
+         * @param metrics Receives the number of nodes and the greatest depth, counting the root as 1
+         */
+        void measure(const double* values, std::size_t numTrees, VariableMetrics& metrics);
+    }
+}
+
+#endif
+
@@ -0,0 +1,314 @@
+#include "knn_model.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cmath>
+
+namespace depnet
+{
+    KnnConditionalModel::KnnConditionalModel(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep, int numNeighbours) :
+        independentVars(indep), dependentVar(dep), numNeighbours(std::max(numNeighbours, 1)), encoder(indep),
+        means(encoder.getWidth(), 0.0), scales(encoder.getWidth(), 1.0) { }
+
+    KnnConditionalModel::BufferLease::BufferLease(const KnnConditionalModel& model) : model(model)
+    {
+        {
+            std::lock_guard<std::mutex> lock(model.poolMutex);
+            if(!model.pool.empty())
+            {
+                this->buffer = std::move(model.pool.back());
+                model.pool.pop_back();
+            }
+        }
+
+        // copying the tree happens outside the lock, once per concurrent thread
+        if(!this->buffer)
+        {
+            this->buffer.reset(new QueryBuffer());
+            this->buffer->tree = model.tree;
+            this->buffer->point.setlength(std::max(model.encoder.getWidth(), 1));
+        }
+    }
+
+    KnnConditionalModel::BufferLease::~BufferLease()
+    {
+        std::lock_guard<std::mutex> lock(this->model.poolMutex);
+        this->model.pool.push_back(std::move(this->buffer));
+    }
+
+    const std::vector<std::shared_ptr<VariableSpecification> > & KnnConditionalModel::getIndependentVars()
+    {
+        return this->independentVars;
+    }
+
+    const std::shared_ptr<VariableSpecification> KnnConditionalModel::getDependentVar()
+    {
+        return this->dependentVar;
+    }
+
+    void KnnConditionalModel::getClassDensity(const std::vector<double>& indep, 
+            std::vector<double> & posterior) const
+    {
+        if(!this->dependentVar->isDiscrete())
+            throw DensityEstimationUnsupported(std::string("Cannot retrieve class densities for ") +
+                "the continuous variable " + this->dependentVar->getName());
+
+        ScopedPredictTimer timer(this->predictCounters);
+        std::vector<std::size_t> neighbours;
+        {
+            BufferLease lease(*this);
+            this->query(indep.data(), lease.get(), neighbours);
+        }
+
+        int numLevels = this->dependentVar->getNumLevels();
+        if(this->dependentVar->isBoolean() && numLevels == 0)
+            numLevels = 2;
+        posterior.assign(std::max(numLevels, 1), 0.0);
+        std::size_t counted = 0;
+        for(auto it = neighbours.begin(); it != neighbours.end(); ++it)
+        {
+            double level = this->targets[*it];
+            if(level >= 0 && level < posterior.size())
+            {
+                posterior[static_cast<std::size_t>(level)]++;
+                counted++;
+            }
+        }
+
+        // without any neighbour every level is equally likely
+        for(auto it = posterior.begin(); it != posterior.end(); ++it)
+            *it = counted > 0 ? *it / counted : 1.0 / posterior.size();
+    }
+
+    bool KnnConditionalModel::supportsClassDensity()
+    {
+        return this->dependentVar->isDiscrete();
+    }
+
+    double KnnConditionalModel::predict(const std::vector<double>& indep) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        std::vector<std::size_t> neighbours;
+        BufferLease lease(*this);
+        this->query(indep.data(), lease.get(), neighbours);
+        return this->summarize(neighbours);
+    }
+
+    void KnnConditionalModel::predictBatch(const boost::const_multi_array_ref<double, 2>& indep, double* out) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> values(indep.shape()[1]);
+        std::vector<std::size_t> neighbours;
+        {
+            BufferLease lease(*this);
+            for(std::size_t row = 0; row < indep.shape()[0]; row++)
+            {
+                std::copy(indep[row].begin(), indep[row].end(), values.begin());
+                this->query(values.data(), lease.get(), neighbours);
+                out[row] = this->summarize(neighbours);
+            }
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        this->predictCounters.calls.add(indep.shape()[0]);
+        this->predictCounters.nanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    bool KnnConditionalModel::supportsValueDensity() const
+    {
+        return true;
+    }
+
+    void KnnConditionalModel::getValueDensity(const std::vector<double>& indep, 
+            std::vector<double>& values, std::vector<double>& weights) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        std::vector<std::size_t> neighbours;
+        {
+            BufferLease lease(*this);
+            this->query(indep.data(), lease.get(), neighbours);
+        }
+
+        values.clear();
+        for(auto it = neighbours.begin(); it != neighbours.end(); ++it)
+            values.push_back(this->targets[*it]);
+        if(values.empty())
+            values.push_back(0);
+        weights.assign(values.size(), 1.0);
+    }
+
+    double KnnConditionalModel::getPredictCost() const
+    {
+        // each neighbour costs roughly one descent through the tree
+        return this->numNeighbours * std::log2(2 + this->targets.size()) * (1.0 + this->encoder.getWidth() / 4.0);
+    }
+
+    void KnnConditionalModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+    }
+
+    void KnnConditionalModel::train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex)
+    {
+        TraceSpan span("KnnConditionalModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        int numFeatures = this->encoder.getWidth();
+        std::size_t stride = numFeatures + 1;
+
+        std::vector<double> encoded;
+        this->encoder.encodeRows(data, dependentIndex, encoded);
+
+        // dropping instances with missing values, which the kd-tree rejects
+        this->points.clear();
+        this->targets.clear();
+        for(std::size_t row = 0; row < data.shape()[0]; row++)
+        {
+            const double* instance = encoded.data() + row * stride;
+            if(!std::all_of(instance, instance + stride, [](double value) { return std::isfinite(value); }))
+                continue;
+            this->points.insert(this->points.end(), instance, instance + numFeatures);
+            this->targets.push_back(instance[numFeatures]);
+        }
+
+        // standardizing the features so that each contributes equally to distances
+        std::size_t numRows = this->targets.size();
+        this->means.assign(numFeatures, 0.0);
+        this->scales.assign(numFeatures, 1.0);
+        for(int feature = 0; feature < numFeatures && numRows > 0; feature++)
+        {
+            double sum = 0, sumSquares = 0;
+            for(std::size_t row = 0; row < numRows; row++)
+                sum += this->points[row * numFeatures + feature];
+            double mean = sum / numRows;
+            for(std::size_t row = 0; row < numRows; row++)
+            {
+                double deviation = this->points[row * numFeatures + feature] - mean;
+                sumSquares += deviation * deviation;
+            }
+            double deviation = std::sqrt(sumSquares / numRows);
+            this->means[feature] = mean;
+            this->scales[feature] = deviation > 0 ? 1 / deviation : 1;
+            for(std::size_t row = 0; row < numRows; row++)
+                this->points[row * numFeatures + feature] = (this->points[row * numFeatures + feature] - mean) * this->scales[feature];
+        }
+
+        this->buildTree();
+        DEPNET_DEBUG("Indexed " << numRows << " instances for " << this->dependentVar->getName());
+    }
+
+    std::string KnnConditionalModel::getModelType() const
+    {
+        return "knn";
+    }
+
+    void KnnConditionalModel::save(binary_io::OffsetStream& out) const
+    {
+        binary_io::write<std::uint64_t>(out, this->numNeighbours);
+        binary_io::writeVector(out, this->means);
+        binary_io::writeVector(out, this->scales);
+        binary_io::writeVector(out, this->targets);
+        binary_io::writeVector(out, this->points);
+    }
+
+    void KnnConditionalModel::load(binary_io::MemoryReader& in)
+    {
+        std::size_t numFeatures = this->encoder.getWidth();
+        this->numNeighbours = static_cast<int>(in.read<std::uint64_t>());
+        std::vector<double>* arrays[] = {&this->means, &this->scales, &this->targets, &this->points};
+        for(std::vector<double>* array : arrays)
+        {
+            std::uint64_t size = in.read<std::uint64_t>();
+            const double* values = in.view<double>(size);
+            array->assign(values, values + size);
+        }
+
+        if(this->numNeighbours < 1 || this->means.size() != numFeatures || this->scales.size() != numFeatures
+                || this->points.size() != this->targets.size() * numFeatures)
+            throw ConversionException("Saved nearest-neighbour model does not match its variables.");
+        this->buildTree();
+    }
+
+    void KnnConditionalModel::query(const double* values, QueryBuffer& buffer, std::vector<std::size_t>& neighbours) const
+    {
+        neighbours.clear();
+        int numFeatures = this->encoder.getWidth();
+
+        // without features, every instance is equally near
+        if(numFeatures == 0)
+        {
+            for(std::size_t row = 0; row < this->targets.size(); row++)
+                neighbours.push_back(row);
+            return;
+        }
+        if(this->targets.empty())
+            return;
+
+        double* point = buffer.point.getcontent();
+        this->encoder.encode(values, point);
+        for(int feature = 0; feature < numFeatures; feature++)
+        {
+            // a missing value is treated as the mean, so it does not affect distances
+            point[feature] = std::isfinite(point[feature]) ? (point[feature] - this->means[feature]) * this->scales[feature] : 0;
+        }
+
+        alglib::ae_int_t found = alglib::kdtreequeryknn(buffer.tree, buffer.point, this->numNeighbours, true);
+        alglib::kdtreequeryresultstags(buffer.tree, buffer.tags);
+        for(alglib::ae_int_t neighbour = 0; neighbour < found; neighbour++)
+            neighbours.push_back(buffer.tags[neighbour]);
+    }
+
+    double KnnConditionalModel::summarize(const std::vector<std::size_t>& neighbours) const
+    {
+        if(neighbours.empty())
+            return 0;
+
+        if(!this->dependentVar->isDiscrete())
+        {
+            double sum = 0;
+            for(auto it = neighbours.begin(); it != neighbours.end(); ++it)
+                sum += this->targets[*it];
+            return sum / neighbours.size();
+        }
+
+        // ties are broken in favour of the lowest level
+        std::map<double, std::size_t> counts;
+        for(auto it = neighbours.begin(); it != neighbours.end(); ++it)
+            counts[this->targets[*it]]++;
+        auto best = counts.begin();
+        for(auto it = counts.begin(); it != counts.end(); ++it)
+            if(it->second > best->second)
+                best = it;
+        return best->first;
+    }
+
+    void KnnConditionalModel::buildTree()
+    {
+        std::size_t numFeatures = this->encoder.getWidth();
+        std::size_t numRows = this->targets.size();
+        {
+            std::lock_guard<std::mutex> lock(this->poolMutex);
+            this->pool.clear();
+        }
+        if(numFeatures == 0 || numRows == 0)
+        {
+            this->tree = alglib::kdtree();
+            return;
+        }
+
+        alglib::real_2d_array xy;
+        xy.setcontent(numRows, numFeatures, this->points.data());
+        alglib::integer_1d_array tags;
+        tags.setlength(numRows);
+        for(std::size_t row = 0; row < numRows; row++)
+            tags[row] = row;
+        alglib::kdtreebuildtagged(xy, tags, numRows, numFeatures, 0, 2, this->tree);
+    }
+}
+
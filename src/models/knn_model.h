@@ -0,0 +1,248 @@
+#pragma once
+
+#ifndef KNN_MODEL_H
+#define KNN_MODEL_H
+
+#include<map>
+#include<memory>
+#include<mutex>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "alglib/alglibmisc.h"
+#include "var_spec.h"
+#include "conditional_model.h"
+#include "one_hot_encoder.h"
+
+namespace depnet 
+{
+    /**
+     * A k-nearest-neighbour model over an alglib kd-tree. Independent variables are encoded as in 
+     * OneHotEncoder and scaled to unit variance, and the dependent values of the k nearest training 
+     * instances form the conditional distribution: a sampler draws one neighbour's value, rather than
+     * their mean, and a discrete variable's class density is the frequency of each level among them.
+     * Suited to variables with few, mostly continuous, independent variables.
+     *
+     * A kd-tree keeps its query state inside the tree, so queries run against copies of the tree held in 
+     * a pool of query buffers. Each call borrows a buffer, and ConditionalModel::predictBatch borrows one 
+     * for the whole batch; the pool grows to the number of threads querying at once.
+     */
+    class KnnConditionalModel : public ConditionalModel 
+    {
+    public:
+        /**
+         * Creates an untrained nearest-neighbour model
+         * @param indep The independent variables, in the order their columns are supplied
+         * @param dep The dependent variable
+         * @param numNeighbours The number of neighbours describing each conditional distribution
+         */
+        KnnConditionalModel(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep, int numNeighbours = 10);
+
+        /**
+         * Retrieves the independent variables in the order they were specified during initialization
+         * @return The variables required for prediction in the same order that they should be specified for prediction
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> > & getIndependentVars();
+
+        /**
+         * Retrieves the dependent variable being modeled
+         * @return The variable this model builds predictions for
+         */
+        const std::shared_ptr<VariableSpecification> getDependentVar();
+
+        /**
+         * Retrieves the frequency of each level among the nearest neighbours
+         * @param indep The independent variables to use as evidence
+         * @param posterior A reference in which to store a K-dimensional vector of posterior probabilities.
+         * K is the number of levels of the dependent variable.
+         */
+        void getClassDensity(const std::vector<double>& indep, 
+                std::vector<double> & posterior) const;
+
+        /**
+         * Indicates that class densities are supported for discrete dependent variables
+         * @return true if the dependent variable is discrete
+         */
+        bool supportsClassDensity();
+        
+        /**
+         * Predicts the mean of the neighbours' values, or their most frequent level for a discrete variable
+         * @param indep A 1D input vector of length K, where K is the number of independent variables
+         */
+        double predict(const std::vector<double>& indep) const;
+
+        /**
+         * Predicts a batch of instances with a single query buffer
+         * @param indep A 2D array with one row per instance and one column per independent variable
+         * @param out An array with room for one prediction per row
+         */
+        void predictBatch(const boost::const_multi_array_ref<double, 2>& indep, double* out) const;
+
+        /**
+         * Indicates that the neighbours' values are available as a value density
+         * @return true
+         */
+        bool supportsValueDensity() const;
+
+        /**
+         * Retrieves the values of the nearest neighbours, each with a weight of 1
+         * @param indep The independent variables to use as evidence
+         * @param values A reference in which to store the neighbours' values
+         * @param weights A reference in which to store one weight per neighbour
+         */
+        void getValueDensity(const std::vector<double>& indep, 
+                std::vector<double>& values, std::vector<double>& weights) const;
+
+        /**
+         * Estimates the cost of a prediction from the depth of the tree and the number of neighbours
+         * @return The relative cost of a prediction
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
+        /**
+         * Indexes the training instances. Instances with a missing or infinite value are ignored.
+         * @param data A 2D array with the independent variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The index of the dependent value in data
+         */
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct nearest-neighbour models
+         * @return "knn"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the number of neighbours, the feature means and scales, and the training instances in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores instances written by KnnConditionalModel::save and rebuilds the kd-tree over them
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
+
+    private:
+        /**
+         * A copy of the kd-tree with room for a query and its results, used by one thread at a time
+         */
+        struct QueryBuffer
+        {
+            /** A copy of the model's tree, which holds the state of the latest query */
+            alglib::kdtree tree;
+
+            /** The scaled features of the query */
+            alglib::real_1d_array point;
+
+            /** The indices of the neighbours found by the latest query */
+            alglib::integer_1d_array tags;
+        };
+
+        /**
+         * Returns a borrowed query buffer to the pool when it goes out of scope
+         */
+        class BufferLease
+        {
+        public:
+            /**
+             * Borrows a buffer from a model's pool, copying the model's tree if the pool is empty
+             * @param model The model to borrow from
+             */
+            explicit BufferLease(const KnnConditionalModel& model);
+
+            /**
+             * Returns the buffer to the pool
+             */
+            ~BufferLease();
+
+            /**
+             * Retrieves the borrowed buffer
+             * @return The buffer, which belongs to this lease until it is destroyed
+             */
+            QueryBuffer& get()
+            {
+                return *this->buffer;
+            }
+
+        private:
+            BufferLease(const BufferLease&);
+            BufferLease& operator=(const BufferLease&);
+
+            /** The model which owns the pool */
+            const KnnConditionalModel& model;
+
+            /** The borrowed buffer */
+            std::unique_ptr<QueryBuffer> buffer;
+        };
+
+        /**
+         * Finds the nearest neighbours of an instance
+         * @param values One value per independent variable
+         * @param buffer The buffer to query with
+         * @param neighbours A reference in which to store the indices of the neighbours in targets
+         */
+        void query(const double* values, QueryBuffer& buffer, std::vector<std::size_t>& neighbours) const;
+
+        /**
+         * Summarizes a set of neighbours as a prediction
+         * @param neighbours The indices of the neighbours in targets
+         * @return The mean of the neighbours' values, or the most frequent level for a discrete variable
+         */
+        double summarize(const std::vector<std::size_t>& neighbours) const;
+
+        /**
+         * Builds the kd-tree over the stored instances and empties the pool of query buffers
+         */
+        void buildTree();
+
+        /** The sequence of independent variables to fit a model against */
+        std::vector<std::shared_ptr<VariableSpecification> > independentVars;
+    
+        /** The variable to build a predictor for */
+        std::shared_ptr<VariableSpecification> dependentVar;
+
+        /** The number of neighbours describing each conditional distribution */
+        int numNeighbours;
+
+        /** Maps independent values to features */
+        OneHotEncoder encoder;
+
+        /** The mean of each feature in the training data */
+        std::vector<double> means;
+
+        /** The factor applied to each feature, the inverse of its standard deviation in the training data */
+        std::vector<double> scales;
+
+        /** The scaled features of each training instance, in row-major order */
+        std::vector<double> points;
+
+        /** The dependent value of each training instance */
+        std::vector<double> targets;
+
+        /** The tree which query buffers are copied from */
+        alglib::kdtree tree;
+
+        /** Guards the pool of query buffers */
+        mutable std::mutex poolMutex;
+
+        /** Query buffers not currently borrowed by a thread */
+        mutable std::vector<std::unique_ptr<QueryBuffer> > pool;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
+    };
+}
+
+#endif
+
@@ -0,0 +1,127 @@
+#include "linear_model.h"
+#include "alglib/dataanalysis.h"
+#include "exceptions/density.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<cmath>
+
+namespace depnet
+{
+    LinearConditionalModel::LinearConditionalModel(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep) :
+        independentVars(indep), dependentVar(dep), encoder(indep), 
+        weights(encoder.getWidth(), 0.0), intercept(0) { }
+
+    const std::vector<std::shared_ptr<VariableSpecification> > & LinearConditionalModel::getIndependentVars()
+    {
+        return this->independentVars;
+    }
+
+    const std::shared_ptr<VariableSpecification> LinearConditionalModel::getDependentVar()
+    {
+        return this->dependentVar;
+    }
+
+    void LinearConditionalModel::getClassDensity(const std::vector<double>& indep, 
+            std::vector<double> & posterior) const
+    {
+        throw DensityEstimationUnsupported("Linear models do not estimate class densities.");
+    }
+
+    bool LinearConditionalModel::supportsClassDensity()
+    {
+        return false;
+    }
+
+    double LinearConditionalModel::predict(const std::vector<double>& indep) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        double value = this->intercept + this->encoder.dot(indep.data(), this->weights.data());
+        if(!this->dependentVar->isDiscrete())
+            return value;
+
+        int numLevels = std::max(this->dependentVar->getNumLevels(), 2);
+        return std::min<double>(std::max<double>(std::round(value), 0), numLevels - 1);
+    }
+
+    double LinearConditionalModel::getPredictCost() const
+    {
+        // comparable to one tree node per four multiply-adds
+        return 1.0 + this->independentVars.size() / 4.0;
+    }
+
+    void LinearConditionalModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+    }
+
+    void LinearConditionalModel::train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex)
+    {
+        TraceSpan span("LinearConditionalModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        int numFeatures = this->encoder.getWidth();
+        std::size_t numRows = data.shape()[0];
+        this->weights.assign(numFeatures, 0.0);
+
+        double sum = 0;
+        for(std::size_t row = 0; row < numRows; row++)
+            sum += data[row][dependentIndex];
+        this->intercept = numRows > 0 ? sum / numRows : 0;
+
+        // lrbuild requires more rows than coefficients
+        if(numFeatures == 0 || numRows < static_cast<std::size_t>(numFeatures) + 2)
+            return;
+
+        std::vector<double> encoded;
+        this->encoder.encodeRows(data, dependentIndex, encoded);
+        alglib::real_2d_array xy;
+        xy.setcontent(numRows, numFeatures + 1, encoded.data());
+
+        alglib::ae_int_t info;
+        alglib::linearmodel model;
+        alglib::lrreport report;
+        alglib::lrbuild(xy, numRows, numFeatures, info, model, report);
+        if(info != 1)
+        {
+            DEPNET_WARN("Linear regression for " << this->dependentVar->getName() << " failed with code " 
+                    << info << "; predicting the mean");
+            return;
+        }
+
+        alglib::real_1d_array coefficients;
+        alglib::ae_int_t numVars;
+        alglib::lrunpack(model, coefficients, numVars);
+        this->weights.assign(coefficients.getcontent(), coefficients.getcontent() + numVars);
+        this->intercept = coefficients[numVars];
+
+        DEPNET_DEBUG("Trained linear model for " << this->dependentVar->getName() << ": RMS error " << report.rmserror);
+    }
+
+    std::string LinearConditionalModel::getModelType() const
+    {
+        return "linear";
+    }
+
+    void LinearConditionalModel::save(binary_io::OffsetStream& out) const
+    {
+        binary_io::write(out, this->intercept);
+        binary_io::writeVector(out, this->weights);
+    }
+
+    void LinearConditionalModel::load(binary_io::MemoryReader& in)
+    {
+        this->intercept = in.read<double>();
+        std::uint64_t numWeights = in.read<std::uint64_t>();
+        if(numWeights != static_cast<std::uint64_t>(this->encoder.getWidth()))
+            throw ConversionException("Saved linear model does not match its independent variables.");
+        const double* weights = in.view<double>(numWeights);
+        this->weights.assign(weights, weights + numWeights);
+    }
+}
+
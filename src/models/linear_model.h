@@ -0,0 +1,125 @@
+#pragma once
+
+#ifndef LINEAR_MODEL_H
+#define LINEAR_MODEL_H
+
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "conditional_model.h"
+#include "one_hot_encoder.h"
+
+namespace depnet 
+{
+    /**
+     * A least-squares linear regression of a continuous variable on its independent variables, 
+     * fit with alglib's lrbuild. Strictly discrete independent variables are expanded one-hot.
+     * A prediction is a single dot product, so this model suits variables that are nearly linear in their blanket.
+     */
+    class LinearConditionalModel : public ConditionalModel 
+    {
+    public:
+        /**
+         * Creates an untrained linear model
+         * @param indep The independent variables, in the order their columns are supplied
+         * @param dep The dependent variable
+         */
+        LinearConditionalModel(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep);
+
+        /**
+         * Retrieves the independent variables in the order they were specified during initialization
+         * @return The variables required for prediction in the same order that they should be specified for prediction
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> > & getIndependentVars();
+
+        /**
+         * Retrieves the dependent variable being modeled
+         * @return The variable this model builds predictions for
+         */
+        const std::shared_ptr<VariableSpecification> getDependentVar();
+
+        /**
+         * Unsupported; always throws DensityEstimationUnsupported
+         */
+        void getClassDensity(const std::vector<double>& indep, 
+                std::vector<double> & posterior) const;
+
+        /**
+         * Indicates that posterior class densities are not supported
+         * @return false
+         */
+        bool supportsClassDensity();
+        
+        /**
+         * Predicts the conditional mean of the dependent variable. A discrete dependent variable is 
+         * rounded to the nearest level.
+         * @param indep A 1D input vector of length K, where K is the number of independent variables
+         */
+        double predict(const std::vector<double>& indep) const;
+
+        /**
+         * Estimates the cost of a prediction from the number of independent variables
+         * @return The relative cost of a prediction
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
+        /**
+         * Fits the coefficients by least squares. With fewer rows than coefficients the model 
+         * predicts the mean of the dependent variable.
+         * @param data A 2D array with the independent variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The index of the dependent value in data
+         */
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct linear models
+         * @return "linear"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the coefficients in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores coefficients written by LinearConditionalModel::save
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
+
+    private:
+        /** The sequence of independent variables to fit a model against */
+        std::vector<std::shared_ptr<VariableSpecification> > independentVars;
+    
+        /** The variable to build a predictor for */
+        std::shared_ptr<VariableSpecification> dependentVar;
+
+        /** Maps independent values to features */
+        OneHotEncoder encoder;
+
+        /** One coefficient per feature */
+        std::vector<double> weights;
+
+        /** The constant term */
+        double intercept;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
+    };
+}
+
+#endif
+
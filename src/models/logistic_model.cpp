@@ -0,0 +1,163 @@
+#include "logistic_model.h"
+#include "alglib/dataanalysis.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<cmath>
+
+namespace depnet
+{
+    LogisticConditionalModel::LogisticConditionalModel(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep) :
+        independentVars(indep), dependentVar(dep), encoder(indep), 
+        coefficients((getNumClasses() - 1) * (encoder.getWidth() + 1), 0.0) { }
+
+    const std::vector<std::shared_ptr<VariableSpecification> > & LogisticConditionalModel::getIndependentVars()
+    {
+        return this->independentVars;
+    }
+
+    const std::shared_ptr<VariableSpecification> LogisticConditionalModel::getDependentVar()
+    {
+        return this->dependentVar;
+    }
+
+    void LogisticConditionalModel::getClassDensity(const std::vector<double>& indep, 
+            std::vector<double> & posterior) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        int numClasses = this->getNumClasses();
+        std::size_t stride = this->encoder.getWidth() + 1;
+        posterior.resize(numClasses);
+
+        double maxLogit = 0;
+        for(int level = 0; level < numClasses - 1; level++)
+        {
+            const double* classCoefficients = this->coefficients.data() + level * stride;
+            posterior[level] = classCoefficients[stride - 1] + this->encoder.dot(indep.data(), classCoefficients);
+            maxLogit = std::max(maxLogit, posterior[level]);
+        }
+        posterior[numClasses - 1] = 0;
+
+        // subtracting the largest log-odds keeps the exponentials finite
+        double total = 0;
+        for(int level = 0; level < numClasses; level++)
+        {
+            posterior[level] = std::exp(posterior[level] - maxLogit);
+            total += posterior[level];
+        }
+        for(int level = 0; level < numClasses; level++)
+            posterior[level] /= total;
+    }
+
+    bool LogisticConditionalModel::supportsClassDensity()
+    {
+        return true;
+    }
+
+    double LogisticConditionalModel::predict(const std::vector<double>& indep) const
+    {
+        std::vector<double> posterior;
+        this->getClassDensity(indep, posterior);
+        return std::max_element(posterior.begin(), posterior.end()) - posterior.begin();
+    }
+
+    double LogisticConditionalModel::getPredictCost() const
+    {
+        return (this->getNumClasses() - 1) * (1.0 + this->independentVars.size() / 4.0);
+    }
+
+    void LogisticConditionalModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+    }
+
+    void LogisticConditionalModel::train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex)
+    {
+        TraceSpan span("LogisticConditionalModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        int numClasses = this->getNumClasses();
+        int numFeatures = this->encoder.getWidth();
+        std::size_t stride = numFeatures + 1;
+
+        std::vector<double> encoded;
+        this->encoder.encodeRows(data, dependentIndex, encoded);
+
+        // dropping rows without a valid level, which alglib rejects
+        std::vector<double> counts(numClasses, 0.0);
+        std::size_t numRows = 0;
+        for(std::size_t row = 0; row < data.shape()[0]; row++)
+        {
+            double level = encoded[row * stride + numFeatures];
+            if(!(level >= 0 && level < numClasses))
+                continue;
+            std::copy(encoded.begin() + row * stride, encoded.begin() + (row + 1) * stride, encoded.begin() + numRows * stride);
+            counts[static_cast<int>(level)]++;
+            numRows++;
+        }
+
+        // the fallback uses only the constant terms: the log-odds of each level's smoothed frequency
+        this->coefficients.assign((numClasses - 1) * stride, 0.0);
+        for(int level = 0; level < numClasses - 1; level++)
+            this->coefficients[level * stride + numFeatures] = std::log((counts[level] + 1) / (counts[numClasses - 1] + 1));
+
+        // mnltrainh requires more rows than coefficients per class
+        if(numFeatures == 0 || numRows < static_cast<std::size_t>(numFeatures) + 2)
+            return;
+
+        alglib::real_2d_array xy;
+        xy.setcontent(numRows, stride, encoded.data());
+        alglib::ae_int_t info;
+        alglib::logitmodel model;
+        alglib::mnlreport report;
+        alglib::mnltrainh(xy, numRows, numFeatures, numClasses, info, model, report);
+        if(info != 1)
+        {
+            DEPNET_WARN("Logistic regression for " << this->dependentVar->getName() << " failed with code " 
+                    << info << "; predicting level frequencies");
+            return;
+        }
+
+        alglib::real_2d_array unpacked;
+        alglib::ae_int_t numVars, numUnpackedClasses;
+        alglib::mnlunpack(model, unpacked, numVars, numUnpackedClasses);
+        for(int level = 0; level < numClasses - 1; level++)
+            for(std::size_t feature = 0; feature < stride; feature++)
+                this->coefficients[level * stride + feature] = unpacked[level][feature];
+
+        DEPNET_DEBUG("Trained logistic model for " << this->dependentVar->getName() 
+                << " in " << report.ngrad << " gradient and " << report.nhess << " Hessian evaluations");
+    }
+
+    std::string LogisticConditionalModel::getModelType() const
+    {
+        return "logistic";
+    }
+
+    void LogisticConditionalModel::save(binary_io::OffsetStream& out) const
+    {
+        binary_io::writeVector(out, this->coefficients);
+    }
+
+    void LogisticConditionalModel::load(binary_io::MemoryReader& in)
+    {
+        std::uint64_t numCoefficients = in.read<std::uint64_t>();
+        if(numCoefficients != static_cast<std::uint64_t>((this->getNumClasses() - 1) * (this->encoder.getWidth() + 1)))
+            throw ConversionException("Saved logistic model does not match its variables.");
+        const double* coefficients = in.view<double>(numCoefficients);
+        this->coefficients.assign(coefficients, coefficients + numCoefficients);
+    }
+
+    int LogisticConditionalModel::getNumClasses() const
+    {
+        if(this->dependentVar->isBoolean() && this->dependentVar->getNumLevels() == 0)
+            return 2;
+        return std::max(this->dependentVar->getNumLevels(), 2);
+    }
+}
+
@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef LOGISTIC_MODEL_H
+#define LOGISTIC_MODEL_H
+
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "conditional_model.h"
+#include "one_hot_encoder.h"
+
+namespace depnet 
+{
+    /**
+     * A multinomial logistic regression of a discrete variable on its independent variables,
+     * fit with alglib's mnltrainh. Strictly discrete independent variables are expanded one-hot.
+     * The class density costs one dot product per level, so this model suits discrete variables 
+     * whose log-odds are nearly linear in their blanket.
+     */
+    class LogisticConditionalModel : public ConditionalModel 
+    {
+    public:
+        /**
+         * Creates an untrained logistic model
+         * @param indep The independent variables, in the order their columns are supplied
+         * @param dep The dependent variable, which must be discrete
+         */
+        LogisticConditionalModel(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep);
+
+        /**
+         * Retrieves the independent variables in the order they were specified during initialization
+         * @return The variables required for prediction in the same order that they should be specified for prediction
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> > & getIndependentVars();
+
+        /**
+         * Retrieves the dependent variable being modeled
+         * @return The variable this model builds predictions for
+         */
+        const std::shared_ptr<VariableSpecification> getDependentVar();
+
+        /**
+         * Retrieves the posterior density of the dependent variable given a set of independent variables
+         * @param indep The independent variables to use as evidence
+         * @param posterior A reference in which to store a K-dimensional vector of posterior probabilities.
+         * K is the number of levels of the dependent variable.
+         */
+        void getClassDensity(const std::vector<double>& indep, 
+                std::vector<double> & posterior) const;
+
+        /**
+         * Indicates that posterior class densities are supported
+         * @return true
+         */
+        bool supportsClassDensity();
+        
+        /**
+         * Predicts the most likely level of the dependent variable
+         * @param indep A 1D input vector of length K, where K is the number of independent variables
+         */
+        double predict(const std::vector<double>& indep) const;
+
+        /**
+         * Estimates the cost of a prediction from the number of independent variables and levels
+         * @return The relative cost of a prediction
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
+        /**
+         * Fits the coefficients by maximum likelihood. Rows whose dependent value is not a level are ignored.
+         * With fewer rows than alglib requires the model predicts the smoothed frequency of each level.
+         * @param data A 2D array with the independent variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The index of the dependent value in data
+         */
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct logistic models
+         * @return "logistic"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the coefficients in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores coefficients written by LogisticConditionalModel::save
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
+
+    private:
+        /**
+         * Retrieves the number of classes the model distinguishes
+         * @return The number of levels of the dependent variable, and 2 for a boolean without levels
+         */
+        int getNumClasses() const;
+
+        /** The sequence of independent variables to fit a model against */
+        std::vector<std::shared_ptr<VariableSpecification> > independentVars;
+    
+        /** The variable to build a predictor for */
+        std::shared_ptr<VariableSpecification> dependentVar;
+
+        /** Maps independent values to features */
+        OneHotEncoder encoder;
+
+        /** 
+         * The coefficients of every class but the last, whose log-odds are fixed at 0. Each class 
+         * holds one coefficient per feature followed by its constant term.
+         */
+        std::vector<double> coefficients;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
+    };
+}
+
+#endif
+
@@ -0,0 +1,62 @@
+
+#include "one_hot_encoder.h"
+
+#include<algorithm>
+
+namespace depnet
+{
+    OneHotEncoder::OneHotEncoder(const std::vector<std::shared_ptr<VariableSpecification> >& vars) : width(0)
+    {
+        for(auto it = vars.begin(); it != vars.end(); ++it)
+        {
+            bool strictlyDiscrete = (*it)->isDiscrete() && !(*it)->isBoolean() && !(*it)->isOrdinal();
+            int levels = strictlyDiscrete ? std::max((*it)->getNumLevels(), 1) : 0;
+            this->offsets.push_back(this->width);
+            this->numLevels.push_back(levels);
+            this->width += std::max(levels, 1);
+        }
+    }
+
+    void OneHotEncoder::encode(const double* values, double* features) const
+    {
+        std::fill(features, features + this->width, 0.0);
+        for(std::size_t var = 0; var < this->offsets.size(); var++)
+        {
+            int levels = this->numLevels[var];
+            if(levels == 0)
+                features[this->offsets[var]] = values[var];
+            else if(values[var] >= 0 && values[var] < levels)
+                features[this->offsets[var] + static_cast<int>(values[var])] = 1;
+        }
+    }
+
+    void OneHotEncoder::encodeRows(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex, std::vector<double>& encoded) const
+    {
+        std::size_t rowWidth = this->width + 1;
+        encoded.assign(data.shape()[0] * rowWidth, 0.0);
+        for(std::size_t row = 0; row < data.shape()[0]; row++)
+        {
+            double* out = encoded.data() + row * rowWidth;
+            std::size_t var = 0;
+            for(std::size_t col = 0; col < data.shape()[1]; col++)
+            {
+                double value = data[row][col];
+                if(static_cast<boost::multi_array<double, 2>::index>(col) == dependentIndex)
+                {
+                    out[this->width] = value;
+                    continue;
+                }
+
+                // unknown levels leave every indicator at zero
+                int levels = this->numLevels[var];
+                if(levels == 0)
+                    out[this->offsets[var]] = value;
+                else if(value >= 0 && value < levels)
+                    out[this->offsets[var] + static_cast<int>(value)] = 1;
+                var++;
+            }
+        }
+    }
+}
+
@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef ONE_HOT_ENCODER_H
+#define ONE_HOT_ENCODER_H
+
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+
+namespace depnet
+{
+    /**
+     * Maps the independent variables of a model to numeric features: one indicator feature per level for 
+     * strictly discrete variables, and the value itself for continuous, ordinal and boolean variables.
+     * Used by models which are linear in their features, where a level index carries no meaningful order.
+     */
+    class OneHotEncoder
+    {
+    public:
+        /**
+         * Creates an encoder for a set of variables
+         * @param vars The variables, in the order their values are supplied
+         */
+        explicit OneHotEncoder(const std::vector<std::shared_ptr<VariableSpecification> >& vars);
+
+        /**
+         * Retrieves the number of features
+         * @return The total width of the encoded variables
+         */
+        int getWidth() const
+        {
+            return this->width;
+        }
+
+        /**
+         * Encodes training data in row-major order, one row of getWidth() + 1 values per instance, 
+         * with the dependent value in the last position
+         * @param data Training data with the encoded variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The column of the dependent variable
+         * @param encoded The array to size and fill
+         */
+        void encodeRows(const boost::const_multi_array_ref<double, 2>& data, 
+                boost::multi_array<double, 2>::index dependentIndex, std::vector<double>& encoded) const;
+
+        /**
+         * Encodes the values of a single instance
+         * @param values One value per variable
+         * @param features The array to fill, with room for getWidth() features
+         */
+        void encode(const double* values, double* features) const;
+
+        /**
+         * Computes the dot product of the encoded features of an instance with a vector of weights,
+         * without materializing the indicator features
+         * @param values One value per variable
+         * @param weights One weight per feature
+         * @return The weighted sum of the instance's features
+         */
+        double dot(const double* values, const double* weights) const
+        {
+            double sum = 0;
+            for(std::size_t var = 0; var < this->offsets.size(); var++)
+            {
+                int levels = this->numLevels[var];
+                if(levels == 0)
+                    sum += weights[this->offsets[var]] * values[var];
+                else if(values[var] >= 0 && values[var] < levels)
+                    sum += weights[this->offsets[var] + static_cast<int>(values[var])];
+            }
+            return sum;
+        }
+
+    private:
+        /** The first feature of each variable */
+        std::vector<int> offsets;
+
+        /** The number of indicator features of each variable, or 0 for a variable used as a value */
+        std::vector<int> numLevels;
+
+        /** The total number of features */
+        int width;
+    };
+}
+
+#endif
+
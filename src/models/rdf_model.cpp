@@ -1,32 +1,118 @@
 
 #include "rdf_model.h"
+#include "flat_trees.h"
 #include "alglib/dataanalysis.h"
+#include<algorithm>
+#include<cmath>
+#include<numeric>
 #include<vector>
 #include<boost/multi_array.hpp>
-#include<iostream>
 #include "exceptions/density.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
 
 namespace depnet
 {
+    namespace
+    {
+        // times each tree alglib builds, reading the clock only while tracing is enabled
+        alglib_impl::ae_int64_t startTree()
+        {
+            return tracing::isEnabled() ? static_cast<alglib_impl::ae_int64_t>(tracing::now()) : -1;
+        }
+
+        void finishTree(alglib_impl::ae_int64_t start)
+        {
+            if(start >= 0)
+                tracing::record("dfbuildtree", "alglib", start);
+        }
+
+        bool registerTreeHooks()
+        {
+            alglib_impl::dfsettreehooks(startTree, finishTree);
+            return true;
+        }
+
+        /** The number of folds training rows are divided into when ranking levels out of fold */
+        const std::size_t NUM_RANK_FOLDS = 5;
+
+        /** Assigns a row to a fold by hashing its index, so that rows in a periodic order do not share folds */
+        std::size_t rankFold(std::size_t row)
+        {
+            return ((static_cast<std::uint64_t>(row) * 0x9E3779B97F4A7C15ull) >> 32) % NUM_RANK_FOLDS;
+        }
+
+        /** Ranks levels by their mean outcome, shrunk toward the mean of every level by smoothing pseudo-rows */
+        void rankByMean(const std::vector<double>& sums, const std::vector<double>& counts, double smoothing,
+            std::vector<double>& ranks)
+        {
+            double total = std::accumulate(sums.begin(), sums.end(), 0.0);
+            double numValid = std::accumulate(counts.begin(), counts.end(), 0.0);
+            double prior = numValid > 0 ? total / numValid : 0;
+            std::vector<double> means(sums.size());
+            for(std::size_t level = 0; level < sums.size(); level++)
+                means[level] = (sums[level] + prior * smoothing) / (counts[level] + smoothing);
+
+            std::vector<int> order(sums.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&means](int a, int b) { return means[a] < means[b]; });
+
+            ranks.resize(sums.size());
+            for(std::size_t rank = 0; rank < order.size(); rank++)
+                ranks[order[rank]] = rank;
+        }
+    }
+
     RandomForestModel::RandomForestModel(
             const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
             std::shared_ptr<VariableSpecification> dep,
-            float trainRatio, int numTrees) : 
+            float trainRatio, int numTrees, int maxOneHotLevels) : 
             independentVars(indep), dependentVar(dep),
-            trainRatio(trainRatio), numTrees(numTrees) { }
+            trainRatio(trainRatio), numTrees(numTrees), maxOneHotLevels(maxOneHotLevels) { }
 
     RandomForestModel::~RandomForestModel() { }
 
     double RandomForestModel::predict(const std::vector<double>& indep) const
     {
+        ScopedPredictTimer timer(this->predictCounters);
         alglib::real_1d_array indepArray;
-        indepArray.setcontent(indep.size(), indep.data());
+        this->encodeIndependent(indep, indepArray);
 
         alglib::real_1d_array depArray;
         alglib::dfprocess(this->forest, indepArray, depArray);
 
-        // todo: pick most likely value if discrete
-        return depArray[0];
+        if(!this->dependentVar->isDiscrete())
+            return depArray[0];
+
+        // pick the most likely level of a discrete variable
+        int bestLevel = 0;
+        for(int level = 1; level < depArray.length(); level++)
+        {
+            if(depArray[level] > depArray[bestLevel])
+                bestLevel = level;
+        }
+        return bestLevel;
+    }
+
+    double RandomForestModel::getPredictCost() const
+    {
+        const alglib_impl::decisionforest* df = this->forest.c_ptr();
+        if(df->ntrees <= 0)
+            return 1.0;
+
+        // each prediction walks one root-to-leaf path per tree. bufsize counts doubles, and ALGLIB stores
+        // a leaf in two and a split in three, so a tree takes about five doubles per leaf.
+        double leavesPerTree = static_cast<double>(df->bufsize) / df->ntrees / 5;
+        return df->ntrees * std::log2(2 + leavesPerTree);
+    }
+
+    void RandomForestModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+        const alglib_impl::decisionforest* df = this->forest.c_ptr();
+        flat_trees::measure(df->trees.ptr.p_double, df->ntrees, metrics);
     }
 
     const std::vector<std::shared_ptr<VariableSpecification> > & RandomForestModel::getIndependentVars()
@@ -46,17 +132,14 @@ namespace depnet
             throw DensityEstimationUnsupported(std::string("Cannot retrieve class densities for ") +
                          "a non-discrete probability distribution.");
 
+        ScopedPredictTimer timer(this->predictCounters);
         alglib::real_1d_array indepArray;
-        indepArray.setcontent(indep.size(), indep.data());
+        this->encodeIndependent(indep, indepArray);
 
         alglib::real_1d_array depArray;
         alglib::dfprocess(this->forest, indepArray, depArray);
         
-        posterior.clear();
-        for(unsigned int level = 0; level < this->dependentVar->getNumLevels(); level++)
-        {
-            posterior.push_back(depArray[level]);
-        }
+        posterior.assign(depArray.getcontent(), depArray.getcontent() + depArray.length());
     }
 
     bool RandomForestModel::supportsClassDensity()
@@ -64,17 +147,27 @@ namespace depnet
         return this->dependentVar->isDiscrete();
     }
 
-    void RandomForestModel::train(const array_type& data, array_type::index dependentIndex)
+    void RandomForestModel::train(const array_ref_type& data, array_type::index dependentIndex)
     {
+        TraceSpan span("RandomForestModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        static const bool treeHooksRegistered = registerTreeHooks();
+        (void) treeHooksRegistered;
         int numFeatures;
         std::vector<double> encoded;
+        std::vector<LevelRanks> foldRanks;
+        this->rankLevels(data, dependentIndex, foldRanks);
+
         // encode the data in a alglib-compatible manner
-        this->encodeData(data, dependentIndex, encoded, numFeatures);
+        {
+            TraceSpan encodeSpan("encodeData", "model");
+            this->encodeData(data, dependentIndex, foldRanks, encoded, numFeatures);
+        }
 
         // load the encoded data into alglib's 2D array
         alglib::real_2d_array dataArray;
         dataArray.setcontent(data.size(), numFeatures, encoded.data());
-        std::cout << "Training w/ data: " << std::endl << dataArray.tostring(3) << std::endl;
+        DEPNET_TRACE("Training w/ data: " << std::endl << dataArray.tostring(3));
 
         alglib::ae_int_t returnCode;
         alglib::dfreport trainReport;
@@ -82,29 +175,115 @@ namespace depnet
         alglib::dfbuildrandomdecisionforest(dataArray, 
                     data.size(), // number of training samples
                     numFeatures - 1,  // number of features
-                    1, // todo: number of classes/levels of the dependent variable
+                    this->getNumClasses(), // 1 for regression, otherwise the levels of the dependent variable
                     this->numTrees, 
                     this->trainRatio, 
                     returnCode, // success or failure code
                     this->forest, // decision forest, set by reference
                     trainReport); // report on training errors
+        this->forestBuffer.reset();
 
-        //std::cout << trainReport << std::endl;
+        DEPNET_DEBUG("Trained forest for " << this->dependentVar->getName() << ": return code " 
+                << returnCode << ", RMS error " << trainReport.rmserror << ", OOB RMS error " << trainReport.oobrmserror);
         // todo: check return code and record training errors
     }
 
-    void RandomForestModel::encodeData(const array_type& data, 
-            array_type::index dependentIndex,
+    namespace
+    {
+        // node arrays used in place are owned by the mapped buffer, not alglib
+        void keepInPlace(void* ptr) { }
+    }
+
+    std::string RandomForestModel::getModelType() const
+    {
+        return "rdf";
+    }
+
+    void RandomForestModel::save(binary_io::OffsetStream& out) const
+    {
+        const alglib_impl::decisionforest* df = this->forest.c_ptr();
+        binary_io::write(out, this->trainRatio);
+        binary_io::write<std::int32_t>(out, this->numTrees);
+        binary_io::write<std::int64_t>(out, df->nvars);
+        binary_io::write<std::int64_t>(out, df->nclasses);
+        binary_io::write<std::int64_t>(out, df->ntrees);
+        binary_io::write<std::int64_t>(out, df->bufsize);
+        binary_io::write<std::int64_t>(out, df->trees.cnt);
+
+        binary_io::pad(out, sizeof(double));
+        out.write(reinterpret_cast<const char*>(df->trees.ptr.p_double), df->trees.cnt * sizeof(double));
+
+        binary_io::write<std::int32_t>(out, this->maxOneHotLevels);
+        binary_io::write<std::uint32_t>(out, this->levelRanks.size());
+        for(auto it = this->levelRanks.begin(); it != this->levelRanks.end(); ++it)
+            binary_io::writeVector(out, *it);
+    }
+
+    void RandomForestModel::load(binary_io::MemoryReader& in)
+    {
+        this->trainRatio = in.read<float>();
+        this->numTrees = in.read<std::int32_t>();
+
+        std::int64_t nvars = in.read<std::int64_t>();
+        std::int64_t nclasses = in.read<std::int64_t>();
+        std::int64_t ntrees = in.read<std::int64_t>();
+        std::int64_t bufsize = in.read<std::int64_t>();
+        std::int64_t numNodes = in.read<std::int64_t>();
+
+        in.align(sizeof(double));
+        if(nvars < 1 || nclasses < 1 || ntrees < 1 || bufsize < ntrees || bufsize > numNodes ||
+                static_cast<std::uint64_t>(numNodes) > in.remaining() / sizeof(double))
+            throw ConversionException("Saved forest has inconsistent sizes.");
+        const double* nodes = in.view<double>(numNodes);
+
+        this->levelRanks.assign(this->independentVars.size(), std::vector<double>());
+        this->maxOneHotLevels = in.read<std::int32_t>();
+        std::uint32_t numRanked = in.read<std::uint32_t>();
+        if(numRanked != this->independentVars.size())
+            throw ConversionException("Saved forest does not match its independent variables.");
+        for(auto it = this->levelRanks.begin(); it != this->levelRanks.end(); ++it)
+        {
+            std::uint64_t numLevels = in.read<std::uint64_t>();
+            const double* ranks = in.view<double>(numLevels);
+            it->assign(ranks, ranks + numLevels);
+        }
+
+        // dfprocess follows features, classes and offsets without bounds checks, so every tree is walked once here
+        int numFeatures = 0;
+        for(auto it = this->independentVars.begin(); it != this->independentVars.end(); ++it)
+            numFeatures += this->encodedWidth(**it);
+        if(nvars != numFeatures || nclasses != std::max(this->getNumClasses(), 1))
+            throw ConversionException("Saved forest does not match the encoding of its variables.");
+        flat_trees::validate(nodes, bufsize, ntrees, nvars, nclasses > 1 ? nclasses : 0);
+
+        // point the forest at the node array in place; prediction only reads it
+        alglib_impl::decisionforest* df = this->forest.c_ptr();
+        df->nvars = nvars;
+        df->nclasses = nclasses;
+        df->ntrees = ntrees;
+        df->bufsize = bufsize;
+        alglib_impl::ae_vector_clear(&df->trees);
+        df->trees.cnt = numNodes;
+        df->trees.datatype = alglib_impl::DT_REAL;
+        df->trees.data.ptr = const_cast<double*>(nodes);
+        df->trees.data.deallocator = keepInPlace;
+        df->trees.ptr.p_double = const_cast<double*>(nodes);
+        this->forestBuffer = in.getBuffer();
+    }
+
+    void RandomForestModel::encodeData(const array_ref_type& data, 
+            array_type::index dependentIndex, const std::vector<LevelRanks>& foldRanks,
             std::vector<double>& encoded, int& numFeatures)
     {
         // to encode discrete values, we need to create a boolean feature for each level
-        // here, we count the number of new features as expanded under this rule
+        // here, we count the number of new features as expanded under this rule.
+        // the dependent variable always occupies the last column, as a class index when discrete
         numFeatures = 0;
         for(auto it = independentVars.begin(); it != independentVars.end(); ++it) 
         {
-            numFeatures += it->get()->isDiscrete() ? it->get()->getLevels().size() : 1;
+            numFeatures += this->encodedWidth(**it);
         }
-        numFeatures += dependentVar->isDiscrete() ? dependentVar->getLevels().size() : 1;
+        numFeatures += 1;
 
         // storing expanded features in row-major format, filling with zeros, avoiding the 
         // need to set inactive discrete levels to 0 explicitly
@@ -115,39 +294,178 @@ namespace depnet
             int featureCounter = 0;
             for(array_type::index colIndex = 0; colIndex < data.shape()[1]; colIndex++)
             {
-                std::shared_ptr<VariableSpecification> var = colIndex != dependentIndex ? *varIt : dependentVar;
-                int strictlyDiscrete = var->isDiscrete() && !var->isBoolean() && !var->isOrdinal();
-                int numLevels = strictlyDiscrete ? var->getLevels().size() : 1;
+                if(colIndex == dependentIndex)
+                {
+                    encoded[rowIndex * numFeatures + numFeatures - 1] = data[rowIndex][colIndex];
+                    continue;
+                }
+
+                std::shared_ptr<VariableSpecification> var = *varIt;
+                int numLevels = this->encodedWidth(*var);
+                bool strictlyDiscrete = numLevels > 1;
+
+                // high-cardinality variables occupy a single feature holding the rank of their level out of fold
+                if(this->isNativelyCoded(*var))
+                {
+                    encoded[rowIndex * numFeatures + featureCounter] = rankOf(
+                        foldRanks[rankFold(rowIndex)][varIt - independentVars.begin()], data[rowIndex][colIndex]);
+                    ++varIt;
+                    featureCounter += numLevels;
+                    continue;
+                }
 
-                int currCounter = colIndex == dependentIndex ? independentVars.size() : featureCounter;
+                // codes outside the level set, such as missing values, leave every level feature at 0
+                if(strictlyDiscrete && !(data[rowIndex][colIndex] >= 0 && data[rowIndex][colIndex] < numLevels))
+                {
+                    ++varIt;
+                    featureCounter += numLevels;
+                    continue;
+                }
 
                 // in the discrete case, a variable is represented by |L| features, where L is the level set.
                 // we need set the appropriate element of the L-element vector to 'true' and leave the other |L| elements 'false'/0
-                int writePosition = rowIndex * numFeatures + currCounter + 
+                int writePosition = rowIndex * numFeatures + featureCounter + 
                             (strictlyDiscrete ? data[rowIndex][colIndex] : 0);
                 double writeValue = strictlyDiscrete ? 1 : data[rowIndex][colIndex];
-                /*
-                std::cout << "Dependent? " << (colIndex == dependentIndex) << std::endl;
-                std::cout << "Strictly discrete? " << strictlyDiscrete << std::endl;
-                std::cout << "Current counter " << currCounter << std::endl;
-                std::cout << "rowIndex=" << rowIndex << ", numfeatures=" << numFeatures 
-                    << ", featureCtr=" << featureCounter << std::endl;
-                std::cout << "Write position " << writePosition << std::endl;
-                std::cout << "Write value " << writeValue << std::endl;
-                */
+                DEPNET_TRACE("Strictly discrete? " << strictlyDiscrete 
+                    << ", rowIndex=" << rowIndex << ", numfeatures=" << numFeatures 
+                    << ", featureCtr=" << featureCounter 
+                    << ", write position " << writePosition 
+                    << ", write value " << writeValue);
 
                 encoded[writePosition] = writeValue;
 
-                // advance to the next variable, skipped if this column was the 
-                // dependent since we're iterating over only independent variables
-                if(colIndex != dependentIndex)
+                // advance to the next independent variable
+                ++varIt;
+                featureCounter += numLevels;
+            }
+        }
+    }
+
+    void RandomForestModel::encodeIndependent(const std::vector<double>& indep, 
+            alglib::real_1d_array& encoded) const
+    {
+        int numFeatures = 0;
+        for(auto it = independentVars.begin(); it != independentVars.end(); ++it) 
+            numFeatures += this->encodedWidth(**it);
+
+        encoded.setlength(numFeatures);
+        double* out = encoded.getcontent();
+        std::fill(out, out + numFeatures, 0.0);
+
+        int featureCounter = 0;
+        for(std::size_t varIndex = 0; varIndex < independentVars.size(); varIndex++)
+        {
+            int numLevels = this->encodedWidth(*independentVars[varIndex]);
+            if(this->isNativelyCoded(*independentVars[varIndex]))
+                out[featureCounter] = rankOf(this->levelRanks[varIndex], indep[varIndex]);
+            else if(numLevels > 1)
+            {
+                if(indep[varIndex] >= 0 && indep[varIndex] < numLevels)
+                    out[featureCounter + static_cast<int>(indep[varIndex])] = 1;
+            }
+            else
+                out[featureCounter] = indep[varIndex];
+            featureCounter += numLevels;
+        }
+    }
+
+    int RandomForestModel::encodedWidth(const VariableSpecification& var) const
+    {
+        bool strictlyDiscrete = var.isDiscrete() && !var.isBoolean() && !var.isOrdinal();
+        return strictlyDiscrete && !this->isNativelyCoded(var) ? std::max(var.getNumLevels(), 1) : 1;
+    }
+
+    bool RandomForestModel::isNativelyCoded(const VariableSpecification& var) const
+    {
+        bool strictlyDiscrete = var.isDiscrete() && !var.isBoolean() && !var.isOrdinal();
+        return strictlyDiscrete && var.getNumLevels() > this->maxOneHotLevels;
+    }
+
+    void RandomForestModel::rankLevels(const array_ref_type& data, array_type::index dependentIndex, 
+            std::vector<LevelRanks>& foldRanks)
+    {
+        // levels are shrunk toward the overall mean by this many pseudo-observations, 
+        // so that rare levels are not ranked at the extremes on the strength of a few rows
+        const double smoothing = 1.0;
+        int numClasses = this->getNumClasses();
+
+        double majorityClass = 0;
+        if(numClasses > 2)
+        {
+            std::vector<double> classCounts(numClasses);
+            for(array_type::index rowIndex = 0; rowIndex < data.size(); rowIndex++)
+            {
+                double value = data[rowIndex][dependentIndex];
+                if(value >= 0 && value < numClasses)
+                    classCounts[static_cast<int>(value)]++;
+            }
+            majorityClass = std::max_element(classCounts.begin(), classCounts.end()) - classCounts.begin();
+        }
+
+        this->levelRanks.assign(this->independentVars.size(), std::vector<double>());
+        foldRanks.assign(NUM_RANK_FOLDS, this->levelRanks);
+        array_type::index colIndex = 0;
+        for(std::size_t varIndex = 0; varIndex < this->independentVars.size(); varIndex++, colIndex++)
+        {
+            if(colIndex == dependentIndex)
+                colIndex++;
+            const VariableSpecification& var = *this->independentVars[varIndex];
+            if(!this->isNativelyCoded(var))
+                continue;
+
+            // the sums of each fold, with the totals over every row in the last position
+            int numLevels = var.getNumLevels();
+            std::vector<std::vector<double> > sums(NUM_RANK_FOLDS + 1, std::vector<double>(numLevels));
+            std::vector<std::vector<double> > counts(NUM_RANK_FOLDS + 1, std::vector<double>(numLevels));
+            for(array_type::index rowIndex = 0; rowIndex < data.size(); rowIndex++)
+            {
+                double level = data[rowIndex][colIndex];
+                if(!(level >= 0 && level < numLevels))
+                    continue;
+                double target = data[rowIndex][dependentIndex];
+                if(numClasses > 2)
+                    target = target == majorityClass;
+                std::size_t fold = rankFold(rowIndex);
+                sums[fold][static_cast<int>(level)] += target;
+                counts[fold][static_cast<int>(level)]++;
+                sums[NUM_RANK_FOLDS][static_cast<int>(level)] += target;
+                counts[NUM_RANK_FOLDS][static_cast<int>(level)]++;
+            }
+
+            // ranks from every row, then for each fold from the rows outside it
+            for(std::size_t fold = 0; fold <= NUM_RANK_FOLDS; fold++)
+            {
+                std::vector<double> levelSums = sums[NUM_RANK_FOLDS], levelCounts = counts[NUM_RANK_FOLDS];
+                if(fold < NUM_RANK_FOLDS)
                 {
-                    ++varIt;
-                    featureCounter++;
+                    for(int level = 0; level < numLevels; level++)
+                    {
+                        levelSums[level] -= sums[fold][level];
+                        levelCounts[level] -= counts[fold][level];
+                    }
                 }
+                rankByMean(levelSums, levelCounts, smoothing, 
+                    fold < NUM_RANK_FOLDS ? foldRanks[fold][varIndex] : this->levelRanks[varIndex]);
             }
         }
     }
 
+    double RandomForestModel::rankOf(const std::vector<double>& ranks, double level)
+    {
+        if(!(level >= 0 && level < ranks.size()))
+            return (ranks.size() - 1) / 2.0;
+        return ranks[static_cast<std::size_t>(level)];
+    }
+
+    int RandomForestModel::getNumClasses() const
+    {
+        if(!this->dependentVar->isDiscrete())
+            return 1;
+        if(this->dependentVar->isBoolean() && this->dependentVar->getNumLevels() == 0)
+            return 2;
+        return this->dependentVar->getNumLevels();
+    }
+
 }
 
@@ -18,6 +18,7 @@ namespace depnet
 {
  
     typedef boost::multi_array<double, 2> array_type; 
+    typedef boost::const_multi_array_ref<double, 2> array_ref_type;
 
     /**
      * A model used for regression or classification based on Random Decision Forests.
@@ -37,11 +38,17 @@ namespace depnet
          * Experiment with values in the range [0.05, 0.66] with the low end being very noisy and the high end 
          * running the risk of overfitting.
          * @param numTrees The number of trees in the forest. Recommended to be in the range [50, 100], defaulting to 100.
+         * @param maxOneHotLevels Strictly discrete independent variables with up to this many levels are expanded
+         * into one feature per level. Variables with more levels are coded natively as a single feature holding the 
+         * level's rank, with levels ranked by their mean dependent value, so the encoded matrix does not grow with
+         * the number of levels. A dependent variable with more than two classes is summarized by its most common 
+         * class, so a single order of levels cannot separate every class; raise this limit when the levels 
+         * of such a variable matter to its rarer classes.
          */
         explicit RandomForestModel(
                     const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
                     std::shared_ptr<VariableSpecification> dep, 
-                    float trainRatio, int numTrees = 100);
+                    float trainRatio, int numTrees = 100, int maxOneHotLevels = 32);
 
         /** Destroys a random forest model */
         ~RandomForestModel();
@@ -90,6 +97,19 @@ namespace depnet
          */
         double predict(const std::vector<double>& indep) const;
 
+        /**
+         * Estimates the cost of a prediction as the number of trees times the average tree depth
+         * @return The relative cost of a prediction, or 1 before training
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number of nodes and greatest depth across the forest's trees, 
+         * and the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
         /**
          * Trains the model from a 2D array of independent variable 
          * samples and a 1D array of dependent values using a random decision forest.
@@ -98,21 +118,94 @@ namespace depnet
          * columns in the same order that indep metadata was supplied during construction.
          * @param dependentIndex The index of the dependent value in data
          */
-        void train(const array_type& data, array_type::index dependentIndex);
+        void train(const array_ref_type& data, array_type::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct random forests
+         * @return "rdf"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the training parameters and the forest's node array in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores a forest written by RandomForestModel::save. The node array is used in place 
+         * from the reader's buffer, which is kept alive for the lifetime of this model.
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
 
     private:
 
+        /** The ranks of the levels of each independent variable, indexed by variable, then by level */
+        typedef std::vector<std::vector<double> > LevelRanks;
+
         /** 
          * Encodes a set of independent variables in an alglib-compatible format
          * @param data The data matrix to encode
          * @param dependentIndex The index of the dependent variable in the data matrix
+         * @param foldRanks The level ranks each fold of rows is encoded with, as computed by rankLevels
          * @param encoded The array to dynamically allocate and use to store the alglib-compatible data in
          * @param numRecords The number of rows, or data instances in the array view
          * @param origFeatures The number of columns, or features, in the original (pre-expansion) matrix
          * @param numFeatures The number of features in the expanded representation.
          */
-        void encodeData(const array_type& data, array_type::index dependentIndex,
-                std::vector<double>& encoded, int& numFeatures);
+        void encodeData(const array_ref_type& data, array_type::index dependentIndex,
+                const std::vector<LevelRanks>& foldRanks, std::vector<double>& encoded, int& numFeatures);
+
+        /**
+         * Encodes a single instantiation of the independent variables in the same 
+         * layout that was used for training
+         * @param indep The independent variable values, in the order supplied during construction
+         * @param encoded The array to size and fill with the expanded features
+         */
+        void encodeIndependent(const std::vector<double>& indep, alglib::real_1d_array& encoded) const;
+
+        /**
+         * Retrieves the number of encoded features used to represent a variable
+         * @param var The variable to encode
+         * @return The number of levels of a strictly discrete variable expanded one-hot, or 1 otherwise
+         */
+        int encodedWidth(const VariableSpecification& var) const;
+
+        /**
+         * Indicates if a variable is strictly discrete with too many levels to expand one-hot
+         * @param var The variable to encode
+         * @return true if the variable is coded as a single ranked feature
+         */
+        bool isNativelyCoded(const VariableSpecification& var) const;
+
+        /**
+         * Ranks the levels of each natively coded independent variable by the mean of the dependent
+         * variable (or, for a dependent with more than two classes, the frequency of its most common class),
+         * shrunk toward the overall mean, so that a single threshold split separates levels with similar outcomes.
+         * The ranks used for prediction come from every row. Training rows are divided into folds and each 
+         * fold is encoded with ranks from the other folds, so that no row's own outcome places its level, 
+         * which would let the forest overfit levels seen in only a few rows.
+         * @param data The training data
+         * @param dependentIndex The index of the dependent value in data
+         * @param foldRanks The ranks to encode each fold of training rows with
+         */
+        void rankLevels(const array_ref_type& data, array_type::index dependentIndex, 
+                std::vector<LevelRanks>& foldRanks);
+
+        /**
+         * Encodes the level of a natively coded variable as its rank
+         * @param ranks The rank of each level of the variable
+         * @param level The level index
+         * @return The rank of the level, or the middle rank for an unknown level
+         */
+        static double rankOf(const std::vector<double>& ranks, double level);
+
+        /**
+         * Retrieves the number of classes the forest is trained with
+         * @return 1 when the dependent variable is continuous, otherwise its number of levels
+         */
+        int getNumClasses() const;
 
         /** The sequence of independent variables to fit a model against */
         std::vector<std::shared_ptr<VariableSpecification> > independentVars;
@@ -126,8 +219,20 @@ namespace depnet
         /** The number of trees to train */
         int numTrees;
 
+        /** The largest number of levels expanded one-hot */
+        int maxOneHotLevels;
+
+        /** The rank of each level of each natively coded independent variable, empty for other variables */
+        LevelRanks levelRanks;
+
         /** Decision forest which is built at train-time and used for prediction. */
         alglib::decisionforest forest;
+
+        /** The memory holding the forest's node array when it was loaded in place */
+        std::shared_ptr<const MappedBuffer> forestBuffer;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
     };
 
 }
@@ -0,0 +1,197 @@
+#include "table_model.h"
+#include "exceptions/conversion.h"
+#include "logging.h"
+#include "tracing.h"
+
+#include<algorithm>
+#include<limits>
+
+namespace depnet
+{
+    namespace
+    {
+        /** The most cells a table may have, which keeps every index exactly representable */
+        const std::uint64_t MAX_CELLS = std::uint64_t(1) << 40;
+    }
+
+    TableConditionalModel::TableConditionalModel(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep, double smoothing) :
+        independentVars(indep), dependentVar(dep), smoothing(smoothing), 
+        numClasses(getRadix(*dep)), table(NULL), numCells(0)
+    {
+        if(getTableBytes(indep, dep) == 0)
+            throw ConversionException("A probability table for '" + dep->getName() + 
+                "' requires discrete variables with known levels and a table small enough to address.");
+        for(auto it = indep.begin(); it != indep.end(); ++it)
+            this->radices.push_back(getRadix(**it));
+        this->marginal.assign(this->numClasses, 1.0 / this->numClasses);
+    }
+
+    std::uint64_t TableConditionalModel::getTableBytes(
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+            std::shared_ptr<VariableSpecification> dep)
+    {
+        std::uint64_t numCells = getRadix(*dep);
+        for(auto it = indep.begin(); it != indep.end() && numCells > 0; ++it)
+        {
+            std::uint64_t radix = getRadix(**it);
+            numCells = radix > 0 && numCells <= MAX_CELLS / radix ? numCells * radix : 0;
+        }
+        return numCells * sizeof(double);
+    }
+
+    const std::vector<std::shared_ptr<VariableSpecification> > & TableConditionalModel::getIndependentVars()
+    {
+        return this->independentVars;
+    }
+
+    const std::shared_ptr<VariableSpecification> TableConditionalModel::getDependentVar()
+    {
+        return this->dependentVar;
+    }
+
+    void TableConditionalModel::getClassDensity(const std::vector<double>& indep, 
+            std::vector<double> & posterior) const
+    {
+        ScopedPredictTimer timer(this->predictCounters);
+        std::int64_t cell = this->table ? this->locate(indep.data()) : -1;
+        const double* distribution = cell >= 0 ? this->table + cell : this->marginal.data();
+        posterior.assign(distribution, distribution + this->numClasses);
+    }
+
+    bool TableConditionalModel::supportsClassDensity()
+    {
+        return true;
+    }
+
+    double TableConditionalModel::predict(const std::vector<double>& indep) const
+    {
+        std::vector<double> posterior;
+        this->getClassDensity(indep, posterior);
+        return std::max_element(posterior.begin(), posterior.end()) - posterior.begin();
+    }
+
+    double TableConditionalModel::getPredictCost() const
+    {
+        // encoding the combination costs about as much as one tree node per four variables
+        return 1.0 + this->independentVars.size() / 4.0;
+    }
+
+    void TableConditionalModel::getMetrics(VariableMetrics& metrics) const
+    {
+        metrics.predictCalls = this->predictCounters.calls.get();
+        metrics.predictNanoseconds = this->predictCounters.nanoseconds.get();
+    }
+
+    void TableConditionalModel::train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex)
+    {
+        TraceSpan span("TableConditionalModel::train", "model", 
+                tracing::isEnabled() ? tracing::intern(this->dependentVar->getName()) : NULL);
+        this->numCells = getTableBytes(this->independentVars, this->dependentVar) / sizeof(double);
+        this->ownedTable.assign(this->numCells, 0.0);
+        this->tableBuffer.reset();
+
+        std::vector<double> marginalCounts(this->numClasses, 0.0);
+        std::vector<double> values(this->independentVars.size());
+        std::size_t numCounted = 0;
+        for(std::size_t row = 0; row < data.shape()[0]; row++)
+        {
+            double level = data[row][dependentIndex];
+            if(!(level >= 0 && level < this->numClasses))
+                continue;
+
+            std::size_t var = 0;
+            for(std::size_t col = 0; col < data.shape()[1]; col++)
+                if(static_cast<boost::multi_array<double, 2>::index>(col) != dependentIndex)
+                    values[var++] = data[row][col];
+            std::int64_t cell = this->locate(values.data());
+            if(cell < 0)
+                continue;
+
+            this->ownedTable[cell + static_cast<std::size_t>(level)]++;
+            marginalCounts[static_cast<std::size_t>(level)]++;
+            numCounted++;
+        }
+
+        // normalizing the smoothed counts of each combination into a distribution
+        for(std::uint64_t cell = 0; cell < this->numCells; cell += this->numClasses)
+        {
+            double total = 0;
+            for(std::uint64_t level = 0; level < this->numClasses; level++)
+                total += this->ownedTable[cell + level] += this->smoothing;
+            for(std::uint64_t level = 0; level < this->numClasses; level++)
+                this->ownedTable[cell + level] = total > 0 ? this->ownedTable[cell + level] / total : 1.0 / this->numClasses;
+        }
+        for(std::uint64_t level = 0; level < this->numClasses; level++)
+        {
+            this->marginal[level] = (marginalCounts[level] + this->smoothing) / 
+                (numCounted + this->smoothing * this->numClasses);
+            if(!(this->marginal[level] >= 0))
+                this->marginal[level] = 1.0 / this->numClasses;
+        }
+        this->table = this->ownedTable.data();
+
+        DEPNET_DEBUG("Counted " << numCounted << " rows into " << this->numCells / this->numClasses 
+                << " combinations for " << this->dependentVar->getName());
+    }
+
+    std::string TableConditionalModel::getModelType() const
+    {
+        return "cpt";
+    }
+
+    void TableConditionalModel::save(binary_io::OffsetStream& out) const
+    {
+        binary_io::write(out, this->smoothing);
+        binary_io::writeVector(out, this->marginal);
+        binary_io::write<std::uint64_t>(out, this->table ? this->numCells : 0);
+        binary_io::pad(out, sizeof(double));
+        if(this->table)
+            out.write(reinterpret_cast<const char*>(this->table), this->numCells * sizeof(double));
+    }
+
+    void TableConditionalModel::load(binary_io::MemoryReader& in)
+    {
+        this->smoothing = in.read<double>();
+        std::uint64_t numClasses = in.read<std::uint64_t>();
+        if(numClasses != this->numClasses)
+            throw ConversionException("Saved probability table does not match the levels of its variable.");
+        const double* marginal = in.view<double>(numClasses);
+        this->marginal.assign(marginal, marginal + numClasses);
+
+        std::uint64_t numCells = in.read<std::uint64_t>();
+        if(numCells != 0 && numCells != getTableBytes(this->independentVars, this->dependentVar) / sizeof(double))
+            throw ConversionException("Saved probability table does not match its variables.");
+
+        // prediction only reads the table, so it is used in place
+        in.align(sizeof(double));
+        this->numCells = numCells;
+        this->table = numCells > 0 ? in.view<double>(numCells) : NULL;
+        this->ownedTable.clear();
+        this->tableBuffer = in.getBuffer();
+    }
+
+    std::uint64_t TableConditionalModel::getRadix(const VariableSpecification& var)
+    {
+        if(!var.isDiscrete())
+            return 0;
+        if(var.isBoolean() && var.getNumLevels() == 0)
+            return 2;
+        return std::max(var.getNumLevels(), 0);
+    }
+
+    std::int64_t TableConditionalModel::locate(const double* values) const
+    {
+        std::uint64_t code = 0;
+        for(std::size_t var = 0; var < this->radices.size(); var++)
+        {
+            if(!(values[var] >= 0 && values[var] < this->radices[var]))
+                return -1;
+            code = code * this->radices[var] + static_cast<std::uint64_t>(values[var]);
+        }
+        return code * this->numClasses;
+    }
+}
+
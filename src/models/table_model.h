@@ -0,0 +1,173 @@
+#pragma once
+
+#ifndef TABLE_MODEL_H
+#define TABLE_MODEL_H
+
+#include<cstdint>
+#include<memory>
+#include<vector>
+
+#include<boost/multi_array.hpp>
+
+#include "var_spec.h"
+#include "mapped_buffer.h"
+#include "conditional_model.h"
+
+namespace depnet 
+{
+    /**
+     * A conditional probability table of a discrete variable given discrete independent variables.
+     * Training counts each combination of levels in a single pass, and the smoothed distributions are 
+     * packed into a flat array indexed by the mixed-radix code of the independent levels, 
+     * so a class density is a single lookup.
+     * Only suited to variables whose independent variables have a small joint state space; 
+     * see TableConditionalModel::getTableBytes.
+     */
+    class TableConditionalModel : public ConditionalModel 
+    {
+    public:
+        /**
+         * Creates an untrained table
+         * @param indep The independent variables, in the order their columns are supplied, 
+         * which must all be discrete with known levels
+         * @param dep The dependent variable, which must be discrete
+         * @param smoothing The pseudo-count added to every level of every combination
+         */
+        TableConditionalModel(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep, double smoothing = 1.0);
+
+        /**
+         * Computes the memory needed by a table, used to decide whether a table is worth building
+         * @param indep The independent variables
+         * @param dep The dependent variable
+         * @return The size of the table in bytes, or 0 if a variable is not discrete with known levels 
+         * or the table could not be addressed
+         */
+        static std::uint64_t getTableBytes(const std::vector<std::shared_ptr<VariableSpecification> >& indep, 
+                std::shared_ptr<VariableSpecification> dep);
+
+        /**
+         * Retrieves the independent variables in the order they were specified during initialization
+         * @return The variables required for prediction in the same order that they should be specified for prediction
+         */
+        const std::vector<std::shared_ptr<VariableSpecification> > & getIndependentVars();
+
+        /**
+         * Retrieves the dependent variable being modeled
+         * @return The variable this model builds predictions for
+         */
+        const std::shared_ptr<VariableSpecification> getDependentVar();
+
+        /**
+         * Looks up the distribution of the dependent variable. Combinations including an unknown level
+         * use the marginal distribution of the dependent variable.
+         * @param indep The independent variables to use as evidence
+         * @param posterior A reference in which to store a K-dimensional vector of posterior probabilities.
+         * K is the number of levels of the dependent variable.
+         */
+        void getClassDensity(const std::vector<double>& indep, 
+                std::vector<double> & posterior) const;
+
+        /**
+         * Indicates that posterior class densities are supported
+         * @return true
+         */
+        bool supportsClassDensity();
+        
+        /**
+         * Predicts the most likely level of the dependent variable
+         * @param indep A 1D input vector of length K, where K is the number of independent variables
+         */
+        double predict(const std::vector<double>& indep) const;
+
+        /**
+         * Estimates the cost of a prediction, a single lookup
+         * @return The relative cost of a prediction
+         */
+        double getPredictCost() const;
+
+        /**
+         * Reports the number and duration of predictions
+         * @param metrics The metrics to fill in
+         */
+        void getMetrics(VariableMetrics& metrics) const;
+
+        /**
+         * Counts each combination of levels. Rows with a value that is not a level are ignored.
+         * @param data A 2D array with the independent variables in order and the dependent variable at dependentIndex
+         * @param dependentIndex The index of the dependent value in data
+         */
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex);
+
+        /**
+         * Retrieves the model type used to reconstruct tables
+         * @return "cpt"
+         */
+        std::string getModelType() const;
+
+        /**
+         * Writes the smoothing, the marginal distribution and the table in binary form
+         * @param out The stream to write to
+         */
+        void save(binary_io::OffsetStream& out) const;
+
+        /**
+         * Restores a table written by TableConditionalModel::save. The table is used in place 
+         * from the reader's buffer, which is kept alive for the lifetime of this model.
+         * @param in A reader positioned at the start of the model's data
+         */
+        void load(binary_io::MemoryReader& in);
+
+    private:
+        /**
+         * Retrieves the number of levels of a discrete variable
+         * @param var The variable
+         * @return The number of levels, 2 for a boolean without levels, or 0 if the variable is not tabulable
+         */
+        static std::uint64_t getRadix(const VariableSpecification& var);
+
+        /**
+         * Computes the position of a combination of levels in the table
+         * @param values One value per independent variable
+         * @return The index of the combination's first cell, or -1 if a value is not a level
+         */
+        std::int64_t locate(const double* values) const;
+
+        /** The sequence of independent variables to fit a model against */
+        std::vector<std::shared_ptr<VariableSpecification> > independentVars;
+    
+        /** The variable to build a predictor for */
+        std::shared_ptr<VariableSpecification> dependentVar;
+
+        /** The pseudo-count added to every cell */
+        double smoothing;
+
+        /** The number of levels of each independent variable, the last varying fastest in the table */
+        std::vector<std::uint64_t> radices;
+
+        /** The number of levels of the dependent variable */
+        std::uint64_t numClasses;
+
+        /** The smoothed marginal distribution of the dependent variable */
+        std::vector<double> marginal;
+
+        /** The table built during training, empty when loaded in place */
+        std::vector<double> ownedTable;
+
+        /** One distribution per combination of independent levels, either ownedTable or memory in tableBuffer */
+        const double* table;
+
+        /** The number of cells in the table */
+        std::uint64_t numCells;
+
+        /** The memory holding the table when it was loaded in place */
+        std::shared_ptr<const MappedBuffer> tableBuffer;
+
+        /** Counts predictions from every thread */
+        mutable PredictCounters predictCounters;
+    };
+}
+
+#endif
+
@@ -0,0 +1,73 @@
+#include "parallel.h"
+#include "alglib/smp.h"
+
+#include<algorithm>
+#include<atomic>
+#include<exception>
+#include<vector>
+
+namespace depnet
+{
+    namespace
+    {
+        /** Set while the current thread runs tasks of parallelFor, so that nested calls run inline */
+        thread_local bool inParallelFor = false;
+
+        /** Runs lanes [begin, end) by splitting them in halves between the threads of the pool */
+        void runLanes(unsigned int begin, unsigned int end, const std::function<void(unsigned int)>& lane, 
+            alglib_impl::ae_state* state)
+        {
+            if(end - begin == 1)
+            {
+                lane(begin);
+                return;
+            }
+            unsigned int mid = begin + (end - begin) / 2;
+            alglib_impl::ae_smp_invoke(
+                [&](alglib_impl::ae_state* s) { runLanes(begin, mid, lane, s); },
+                [&](alglib_impl::ae_state* s) { runLanes(mid, end, lane, s); },
+                state);
+        }
+    }
+
+    unsigned int getDefaultThreads()
+    {
+        return static_cast<unsigned int>(alglib_impl::ae_cores_count());
+    }
+
+    void parallelFor(std::size_t numTasks, unsigned int numThreads, const std::function<void(std::size_t)>& task)
+    {
+        if(numThreads == 0)
+            numThreads = getDefaultThreads();
+        numThreads = static_cast<unsigned int>(std::min<std::size_t>(numThreads, numTasks));
+        if(numThreads <= 1 || inParallelFor)
+        {
+            for(std::size_t index = 0; index < numTasks; index++)
+                task(index);
+            return;
+        }
+
+        // each lane takes indices in turn, so lanes which start late or run slow tasks take fewer
+        std::atomic<std::size_t> next(0);
+        std::vector<std::exception_ptr> errors(numThreads);
+        alglib_impl::ae_state state;
+        alglib_impl::ae_state_init(&state);
+        runLanes(0, numThreads, [&](unsigned int lane) {
+            // a thread waiting in the pool may run a lane of another call, so the flag is restored after
+            bool nested = inParallelFor;
+            inParallelFor = true;
+            try
+            {
+                for(std::size_t index = next++; index < numTasks; index = next++)
+                    task(index);
+            }
+            catch(...) { errors[lane] = std::current_exception(); }
+            inParallelFor = nested;
+        }, &state);
+        alglib_impl::ae_state_clear(&state);
+
+        for(auto it = errors.begin(); it != errors.end(); ++it)
+            if(*it)
+                std::rethrow_exception(*it);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include<cstddef>
+#include<functional>
+
+namespace depnet
+{
+    /**
+     * Retrieves the number of threads to use when a caller does not specify one
+     * @return The number of threads of the shared pool, including the caller: one per hardware thread 
+     * unless changed with alglib::setnworkers
+     */
+    unsigned int getDefaultThreads();
+
+    /**
+     * Runs a task for each index in [0, numTasks) on up to numThreads threads, which take indices 
+     * in turn so that uneven tasks balance. The threads are the caller and the persistent pool which also 
+     * runs ALGLIB's SMP functions (see alglib_impl::ae_smp_invoke), so no threads are created per call.
+     * Tasks run on the calling thread when only one thread is used, and calls made from within a task
+     * run inline rather than competing for the pool with their caller.
+     * Once every thread has finished, the first exception thrown by a task, if any, is rethrown.
+     * @param numTasks The number of indices
+     * @param numThreads The largest number of threads to use, or 0 for getDefaultThreads()
+     * @param task Processes one index
+     */
+    void parallelFor(std::size_t numTasks, unsigned int numThreads, const std::function<void(std::size_t)>& task);
+}
+
+#endif
+
@@ -1,30 +1,235 @@
 
 #include "dependency_network_wrap.h"
 #include "exceptions/conversion.h"
+#include "io/csv_reader.h"
+#include "standard_var_spec.h"
+#include "python/gil.h"
+#include "python/numeric_buffer.h"
+#include "parallel.h"
 
+#include<algorithm>
+#include<functional>
 #include<boost/multi_array.hpp>
 #include<boost/python/extract.hpp>
+#include<boost/python/errors.hpp>
 #include<memory>
+#include<mutex>
 #include<sstream>
 
 namespace depnet
 {
+    namespace
+    {
+        /** The number of rows each parallel task predicts at once */
+        const std::size_t ROWS_PER_TASK = 256;
+    }
+
     PythonDependencyNetwork::PythonDependencyNetwork(const boost::python::list& var_specs) : 
         DependencyNetwork()
     {
-       this->varSpecs = to_std_vector<std::shared_ptr<VariableSpecification> >(var_specs);
+        for(boost::python::ssize_t index = 0; index < boost::python::len(var_specs); index++)
+        {
+            boost::python::extract<std::string> nameExtractor(var_specs[index]);
+            if(!nameExtractor.check())
+            {
+                this->varSpecs.push_back(
+                    boost::python::extract<std::shared_ptr<VariableSpecification> >(var_specs[index]));
+                continue;
+            }
+
+            std::shared_ptr<VariableSpecification> spec(new StandardVariableSpecification());
+            spec->setName(nameExtractor());
+            this->varSpecs.push_back(spec);
+        }
     }
 
-    void PythonDependencyNetwork::train(const boost::python::list& samples)
+    void PythonDependencyNetwork::train(const boost::python::object& samples)
     {
+        boost::python::extract<boost::python::list> listExtractor(samples);
+        if(listExtractor.check())
+        {
+            boost::multi_array<double, 2> samplesArr;
+            this->convertData(listExtractor(), this->getNumVariables(), samplesArr);
+            ScopedGILRelease release;
+            std::lock_guard<std::mutex> lock(this->stateMutex);
+            this->checkNumColumns(samplesArr.shape()[1]);
+            DependencyNetwork::train(samplesArr);
+            return;
+        }
+
+        NumericBuffer buffer(samples.ptr(), 2);
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->checkNumColumns(buffer.shape(1));
+        if(buffer.isContiguousDouble())
+        {
+            boost::const_multi_array_ref<double, 2> samplesRef(buffer.data(), 
+                boost::extents[buffer.shape(0)][buffer.shape(1)]);
+            DependencyNetwork::train(samplesRef);
+            return;
+        }
+
         boost::multi_array<double, 2> samplesArr;
-        this->convertData(samples, samplesArr);
+        buffer.copyTo(samplesArr);
         DependencyNetwork::train(samplesArr);
     }
 
+    void PythonDependencyNetwork::trainCsv(const std::string& path)
+    {
+        ScopedGILRelease release;
+        CsvReader reader;
+        reader.read(path);
+
+        // the variables are read by other threads with the GIL released, so they are only replaced under the lock
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->varSpecs = reader.getVariableSpecs();
+        DependencyNetwork::train(reader.getData());
+    }
+
+    std::size_t PythonDependencyNetwork::getNumVariables() const
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        return this->varSpecs.size();
+    }
+
+    void PythonDependencyNetwork::checkNumColumns(std::size_t numCols) const
+    {
+        if(numCols != this->varSpecs.size())
+        {
+            std::stringstream ss;
+            ss << "Training data has " << numCols << " columns, but " << 
+                        this->varSpecs.size() << " variables were specified.";
+            throw ConversionException(ss.str());
+        }
+    }
+
+    boost::python::list PythonDependencyNetwork::getVariableNames() const
+    {
+        std::vector<std::string> names;
+        {
+            ScopedGILRelease release;
+            std::lock_guard<std::mutex> lock(this->stateMutex);
+            for(auto it = this->varSpecs.begin(); it != this->varSpecs.end(); ++it)
+                names.push_back((*it)->getName());
+        }
+
+        boost::python::list result;
+        for(auto it = names.begin(); it != names.end(); ++it)
+            result.append(*it);
+        return result;
+    }
+
+    void PythonDependencyNetwork::setModelType(const std::string& name, const std::string& modelType)
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        std::dynamic_pointer_cast<StandardFactory>(this->getFactory())->setModelType(name, modelType);
+    }
+
+    void PythonDependencyNetwork::setDefaultModelType(const std::string& modelType)
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        std::dynamic_pointer_cast<StandardFactory>(this->getFactory())->setDefaultModelType(modelType);
+    }
+
+    void PythonDependencyNetwork::setTableBudget(std::uint64_t bytes)
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        std::dynamic_pointer_cast<StandardFactory>(this->getFactory())->setTableBudget(bytes);
+    }
+
+    void PythonDependencyNetwork::enableModelSelection(const boost::python::list& candidates, double tolerance, 
+        double latencyBudget)
+    {
+        std::shared_ptr<ModelSelectionOptions> options(new ModelSelectionOptions());
+        if(boost::python::len(candidates) > 0)
+        {
+            options->candidates.clear();
+            for(boost::python::ssize_t i = 0; i < boost::python::len(candidates); i++)
+                options->candidates.push_back(boost::python::extract<std::string>(candidates[i]));
+        }
+        options->tolerance = tolerance;
+        options->latencyBudget = latencyBudget;
+
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->setModelSelection(options);
+    }
+
+    void PythonDependencyNetwork::disableModelSelection()
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->setModelSelection(std::shared_ptr<ModelSelectionOptions>());
+    }
+
+    NetworkMetrics PythonDependencyNetwork::lockedMetrics() const
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        return this->metrics();
+    }
+
+    boost::python::dict PythonDependencyNetwork::getMetrics() const
+    {
+        NetworkMetrics snapshot = this->lockedMetrics();
+        boost::python::list variables;
+        for(auto it = snapshot.variables.begin(); it != snapshot.variables.end(); ++it)
+        {
+            boost::python::dict var;
+            var["name"] = it->name;
+            var["model_type"] = it->modelType;
+            var["train_seconds"] = it->trainSeconds;
+            var["num_nodes"] = it->numNodes;
+            var["max_depth"] = it->maxDepth;
+            var["predict_calls"] = it->predictCalls;
+            var["predict_nanoseconds"] = it->predictNanoseconds;
+            var["nanoseconds_per_predict"] = it->getNanosecondsPerPredict();
+            var["cache_hits"] = it->cacheHits;
+
+            boost::python::list candidates;
+            for(auto candidateIt = it->candidates.begin(); candidateIt != it->candidates.end(); ++candidateIt)
+            {
+                boost::python::dict candidate;
+                candidate["model_type"] = candidateIt->modelType;
+                candidate["validation_loss"] = candidateIt->validationLoss;
+                candidate["nanoseconds_per_predict"] = candidateIt->nanosecondsPerPredict;
+                candidate["train_seconds"] = candidateIt->trainSeconds;
+                candidates.append(candidate);
+            }
+            var["candidates"] = candidates;
+            variables.append(var);
+        }
+
+        boost::python::list chains;
+        for(auto it = snapshot.chains.begin(); it != snapshot.chains.end(); ++it)
+        {
+            boost::python::dict chain;
+            chain["sweeps"] = it->sweeps;
+            chain["accepted_samples"] = it->acceptedSamples;
+            chains.append(chain);
+        }
+
+        boost::python::dict metrics;
+        metrics["variables"] = variables;
+        metrics["chains"] = chains;
+        return metrics;
+    }
+
+    std::string PythonDependencyNetwork::getMetricsJson() const
+    {
+        std::ostringstream out;
+        this->lockedMetrics().writeJson(out);
+        return out.str();
+    }
+
     void PythonDependencyNetwork::convertData(
-        const boost::python::list& samples, boost::multi_array<double, 2>& cSamples)
+        const boost::python::list& samples, std::size_t numVars, boost::multi_array<double, 2>& cSamples)
     {
+        cSamples.resize(boost::extents[boost::python::len(samples)][numVars]);
         for(boost::python::ssize_t recordIndex = 0; 
                 recordIndex < boost::python::len(samples); recordIndex++) 
         {
@@ -35,22 +240,197 @@ namespace depnet
                 throw ConversionException("Expecting a training data to be supplied as a list of lists.");
             boost::python::list record = listExtractor();
 
-            if(boost::python::len(record) != this->varSpecs.size())
+            if(boost::python::len(record) != numVars)
             {
                 std::stringstream ss;
                 ss << "Training sample " << (recordIndex + 1) << " has " << 
                             boost::python::len(record) << " features, but " << 
-                            this->varSpecs.size() << " variables were specified.";
+                            numVars << " variables were specified.";
                 throw ConversionException(ss.str());
             }
 
-            for(auto specIt = this->varSpecs.begin(); 
-                specIt != this->varSpecs.end(); ++specIt)
-            {
+            for(std::size_t varIndex = 0; varIndex < numVars; varIndex++)
+                cSamples[recordIndex][varIndex] = boost::python::extract<double>(record[varIndex]);
+        }
+    }
+
+    std::shared_ptr<VariableSpecification> PythonDependencyNetwork::findVariable(const std::string& name) const
+    {
+        for(auto it = this->varSpecs.begin(); it != this->varSpecs.end(); ++it)
+            if((*it)->getName() == name)
+                return *it;
+        throw ConversionException("The network has no variable named " + name + ".");
+    }
+
+    void PythonDependencyNetwork::predictBatch(const std::string& name, const boost::python::object& indep, 
+            const boost::python::object& out) const
+    {
+        NumericBuffer indepBuffer(indep.ptr(), 2);
+        NumericBuffer outBuffer(out.ptr(), 1, true);
 
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        std::shared_ptr<ConditionalModel> model = this->getModel(this->findVariable(name));
+        std::size_t numIndep = model->getIndependentVars().size();
+        if(indepBuffer.shape(1) != numIndep || outBuffer.shape(0) != indepBuffer.shape(0))
+            throw ConversionException("Expecting one row per instance with a column per independent variable, "
+                "and an output element per row.");
+
+        std::size_t numRows = indepBuffer.shape(0);
+        parallelFor((numRows + ROWS_PER_TASK - 1) / ROWS_PER_TASK, 0, [&](std::size_t task) {
+            std::size_t begin = task * ROWS_PER_TASK, end = std::min(numRows, begin + ROWS_PER_TASK);
+            boost::multi_array<double, 2> values(boost::extents[end - begin][numIndep]);
+            std::vector<double> predictions(end - begin);
+            for(std::size_t row = begin; row < end; row++)
+                for(std::size_t col = 0; col < numIndep; col++)
+                    values[row - begin][col] = indepBuffer.get(row, col);
+            model->predictBatch(values, predictions.data());
+            for(std::size_t row = begin; row < end; row++)
+                outBuffer.set(row, 0, predictions[row - begin]);
+        });
+    }
+
+    void PythonDependencyNetwork::classDensityBatch(const std::string& name, const boost::python::object& indep, 
+            const boost::python::object& out) const
+    {
+        NumericBuffer indepBuffer(indep.ptr(), 2);
+        NumericBuffer outBuffer(out.ptr(), 2, true);
+
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        std::shared_ptr<VariableSpecification> var = this->findVariable(name);
+        std::shared_ptr<ConditionalModel> model = this->getModel(var);
+        std::size_t numIndep = model->getIndependentVars().size();
+        if(indepBuffer.shape(1) != numIndep || outBuffer.shape(0) != indepBuffer.shape(0))
+            throw ConversionException("Expecting one row per instance with a column per independent variable, "
+                "and an output row per instance.");
+
+        std::size_t numRows = indepBuffer.shape(0);
+        parallelFor((numRows + ROWS_PER_TASK - 1) / ROWS_PER_TASK, 0, [&](std::size_t task) {
+            std::size_t begin = task * ROWS_PER_TASK, end = std::min(numRows, begin + ROWS_PER_TASK);
+            std::vector<double> values(numIndep), posterior;
+            for(std::size_t row = begin; row < end; row++)
+            {
+                for(std::size_t col = 0; col < numIndep; col++)
+                    values[col] = indepBuffer.get(row, col);
+                model->getClassDensity(values, posterior);
+                if(posterior.size() != outBuffer.shape(1))
+                    throw ConversionException("Expecting an output column per level of " + var->getName() + ".");
+                for(std::size_t level = 0; level < posterior.size(); level++)
+                    outBuffer.set(row, level, posterior[level]);
             }
+        });
+    }
+
+    long PythonDependencyNetwork::fillSamples(const boost::python::object& out)
+    {
+        NumericBuffer outBuffer(out.ptr(), 2, true);
+
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        if(outBuffer.shape(1) != this->varSpecs.size())
+            throw ConversionException("Expecting an output column per variable.");
+
+        std::size_t filled = 0;
+        return this->getSamples(outBuffer.shape(0), 
+            [&](const double* rows, std::size_t numRows, std::size_t numCols)
+            {
+                for(std::size_t row = 0; row < numRows; row++, filled++)
+                    for(std::size_t col = 0; col < numCols; col++)
+                        outBuffer.set(filled, col, rows[row * numCols + col]);
+                return true;
+            });
+    }
+
+    SampleBlockIterator::SampleBlockIterator(PythonDependencyNetwork& network, long numSamples, int blockSize) :
+        network(&network), remaining(numSamples), blockSize(std::max(blockSize, 1)) { }
+
+    boost::python::object SampleBlockIterator::next()
+    {
+        if(this->remaining <= 0)
+        {
+            PyErr_SetNone(PyExc_StopIteration);
+            boost::python::throw_error_already_set();
+        }
+
+        std::size_t numRows = std::min<long>(this->remaining, this->blockSize);
+        std::size_t numCols = this->network->getNumVariables();
+        boost::python::object bytes(boost::python::handle<>(
+            PyByteArray_FromStringAndSize(NULL, numRows * numCols * sizeof(double))));
+        double* out = reinterpret_cast<double*>(PyByteArray_AsString(bytes.ptr()));
+
+        {
+            ScopedGILRelease release;
+            std::lock_guard<std::mutex> lock(this->network->stateMutex);
+
+            // the block was sized without the lock, so another thread may have retrained on other variables since
+            if(this->network->getVariableSpecs().size() != numCols)
+                throw ConversionException("The network's variables changed while its samples were being drawn.");
+            this->network->getSamples(numRows, 
+                [&out](const double* rows, std::size_t numRows, std::size_t numCols)
+                {
+                    out = std::copy(rows, rows + numRows * numCols, out);
+                    return true;
+                }, numRows);
         }
+        this->remaining -= numRows;
+
+        boost::python::object view(boost::python::handle<>(PyMemoryView_FromObject(bytes.ptr())));
+        return view.attr("cast")("d", boost::python::make_tuple(numRows, numCols));
+    }
+
+    boost::python::object PythonDependencyNetwork::getState() const
+    {
+        std::string bytes;
+        {
+            ScopedGILRelease release;
+            std::lock_guard<std::mutex> lock(this->stateMutex);
+            std::ostringstream out;
+            this->save(out);
+            bytes = out.str();
+        }
+        return boost::python::object(boost::python::handle<>(PyBytes_FromStringAndSize(bytes.data(), bytes.size())));
     }
-}
 
+    void PythonDependencyNetwork::setState(const boost::python::object& state)
+    {
+        char* data;
+        Py_ssize_t size;
+        if(PyBytes_AsStringAndSize(state.ptr(), &data, &size) != 0)
+            boost::python::throw_error_already_set();
+
+        // the bytes object may be released as soon as unpickling finishes, so the models need their own copy
+        std::shared_ptr<std::string> bytes(new std::string(data, size));
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->load(std::make_shared<MappedBuffer>(bytes->data(), bytes->size(), bytes));
+    }
+
+    void PythonDependencyNetwork::saveFile(const std::string& path) const
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->save(path);
+    }
 
+    void PythonDependencyNetwork::loadFile(const std::string& path)
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->load(path);
+    }
+
+    void PythonDependencyNetwork::saveToSharedMemory(const std::string& name) const
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->saveSharedMemory(name);
+    }
+
+    void PythonDependencyNetwork::loadFromSharedMemory(const std::string& name)
+    {
+        ScopedGILRelease release;
+        std::lock_guard<std::mutex> lock(this->stateMutex);
+        this->loadSharedMemory(name);
+    }
+}
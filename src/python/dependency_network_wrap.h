@@ -6,11 +6,13 @@
 
 #include "dependency_network.h"
 
+#include<mutex>
 #include<vector>
 
-#include<boost/python/numeric.hpp>
+#include<boost/python/dict.hpp>
 #include<boost/python/tuple.hpp>
 #include<boost/python/list.hpp>
+#include<boost/python/object.hpp>
 #include<boost/python/stl_iterator.hpp>
 
 namespace depnet
@@ -33,24 +35,229 @@ namespace depnet
         /**
          * Creates a dependency network from a set of 
          * variable specifitions organized in a dictionary
-         * @param var_specs A sequence of VariableSpecificationWrap instances
+         * @param var_specs A sequence of VariableSpecificationWrap instances, or of
+         * names for continuous variables
          */
         PythonDependencyNetwork(const boost::python::list& var_specs);
 
         /**
          * Trains the network with a 2D numpy array with data instances 
-         * in rows and features in columns.
+         * in rows and features in columns. Any float64 or float32 array exporting the buffer protocol 
+         * is accepted; C-contiguous float64 arrays are used in place, and other layouts are converted 
+         * in a single pass. A list of lists is also accepted, but converted element by element.
+         * The global interpreter lock is released while the models are trained.
          * @param samples Instantiations of all variables to use when learning conditional models
          */
-        void train(const boost::python::list& samples);
+        void train(const boost::python::object& samples);
+
+        /**
+         * Trains the network on a comma or tab separated file with a header row,
+         * replacing the variable specifications with those inferred from the file
+         * @param path The file to read
+         * @see CsvReader
+         */
+        void trainCsv(const std::string& path);
+
+        /**
+         * Retrieves the names of the network's variables in column order
+         * @return A list of variable names
+         */
+        boost::python::list getVariableNames() const;
+
+        /**
+         * Establishes the type of model trained for a variable during subsequent calls to train
+         * @param name The name of the variable
+         * @param modelType "rdf", "gbt", "linear", "logistic", "knn", "cpt" or "fast"
+         * @see StandardFactory::setModelType
+         */
+        void setModelType(const std::string& name, const std::string& modelType);
+
+        /**
+         * Establishes the type of model trained for variables without a type of their own
+         * @param modelType "rdf", "gbt", "linear", "logistic", "knn", "cpt" or "fast"
+         * @see StandardFactory::setDefaultModelType
+         */
+        void setDefaultModelType(const std::string& modelType);
+
+        /**
+         * Establishes the largest probability table chosen automatically for a discrete variable
+         * @param bytes The memory budget of a single table, or 0 to disable
+         * @see StandardFactory::setTableBudget
+         */
+        void setTableBudget(std::uint64_t bytes);
+
+        /**
+         * Chooses each variable's model during subsequent calls to train by comparing candidates on held-out rows
+         * @param candidates The model types to compare, or an empty list for the default candidates
+         * @param tolerance The relative validation loss accepted in exchange for a cheaper model
+         * @param latencyBudget The largest total nanoseconds of predicting every variable once, or 0 for no budget
+         * @see DependencyNetwork::setModelSelection
+         */
+        void enableModelSelection(const boost::python::list& candidates, double tolerance, double latencyBudget);
+
+        /**
+         * Returns to the factory's choice of models during subsequent calls to train
+         */
+        void disableModelSelection();
+
+        /**
+         * Takes a snapshot of the network's counters
+         * @return A dict with a "variables" list of per-variable dicts and a "chains" list of per-chain dicts,
+         * keyed as in NetworkMetrics::writeJson
+         * @see DependencyNetwork::metrics
+         */
+        boost::python::dict getMetrics() const;
+
+        /**
+         * Takes a snapshot of the network's counters as JSON
+         * @return The JSON written by NetworkMetrics::writeJson
+         */
+        std::string getMetricsJson() const;
+
+        /**
+         * Predicts a variable for a batch of instances, filling a preallocated array. 
+         * Rows are divided between threads with the global interpreter lock released.
+         * @param name The name of the variable to predict
+         * @param indep A 2D array with one row per instance and one column per independent variable 
+         * of the variable's model, i.e. every other variable in network order
+         * @param out A 1D array with one element per instance
+         */
+        void predictBatch(const std::string& name, const boost::python::object& indep, 
+            const boost::python::object& out) const;
+
+        /**
+         * Computes the class density of a discrete variable for a batch of instances, filling a preallocated array.
+         * Rows are divided between threads with the global interpreter lock released.
+         * @param name The name of the variable
+         * @param indep A 2D array with one row per instance and one column per independent variable
+         * @param out A 2D array with one row per instance and one column per level of the variable
+         */
+        void classDensityBatch(const std::string& name, const boost::python::object& indep, 
+            const boost::python::object& out) const;
+
+        /**
+         * Fills a preallocated array with samples, with the global interpreter lock released
+         * @param out A 2D array with one row per sample and one column per variable
+         * @return The number of samples drawn
+         */
+        long fillSamples(const boost::python::object& out);
+
+        /**
+         * Serializes the network in the binary format written by DependencyNetwork::save, for pickling
+         * @return The serialized network as bytes
+         */
+        boost::python::object getState() const;
+
+        /**
+         * Replaces the network with one serialized by PythonDependencyNetwork::getState
+         * @param state The serialized network as bytes
+         */
+        void setState(const boost::python::object& state);
+
+        /**
+         * Saves the network to a file, as DependencyNetwork::save, with the global interpreter lock released
+         * @param path The file to write
+         */
+        void saveFile(const std::string& path) const;
+
+        /**
+         * Loads a network saved to a file, as DependencyNetwork::load, with the global interpreter lock released
+         * @param path The file to load
+         */
+        void loadFile(const std::string& path);
+
+        /**
+         * Publishes the network to a shared memory segment, as DependencyNetwork::saveSharedMemory, 
+         * with the global interpreter lock released
+         * @param name The name of the segment
+         */
+        void saveToSharedMemory(const std::string& name) const;
+
+        /**
+         * Loads a network from a shared memory segment, as DependencyNetwork::loadSharedMemory, 
+         * with the global interpreter lock released
+         * @param name The name of the segment
+         */
+        void loadFromSharedMemory(const std::string& name);
+
+        /**
+         * Looks up a variable by name, throwing ConversionException if there is none. The state lock must be held.
+         * @param name The name of the variable
+         * @return The variable's specification
+         */
+        std::shared_ptr<VariableSpecification> findVariable(const std::string& name) const;
     private:
+        /**
+         * Counts the network's variables under the state lock, releasing the global interpreter lock to take it
+         * @return The number of variables
+         */
+        std::size_t getNumVariables() const;
+
+        /**
+         * Throws ConversionException unless training data has a column per variable. The state lock must be held.
+         * @param numCols The number of columns in the training data
+         */
+        void checkNumColumns(std::size_t numCols) const;
+
+        /**
+         * Takes a snapshot of the network's counters under the state lock, 
+         * releasing the global interpreter lock to take it
+         * @return The snapshot
+         */
+        NetworkMetrics lockedMetrics() const;
+
         /**
          * Converts a 2-dimensional list of samples from Python's 
          * representation to the internal numeric-only representation
          * @param samples The samples to convert from the Pythonic representation
+         * @param numVars The number of values expected in each sample
          * @param cSamples The array to be populated with the samples
          */
-        void convertData(const boost::python::list& samples, boost::multi_array<double, 2>& cSamples);
+        void convertData(const boost::python::list& samples, std::size_t numVars, 
+            boost::multi_array<double, 2>& cSamples);
+
+        /**
+         * Serializes every access to the variables, models, sampler and factory. Training, loading, prediction
+         * and sampling run with the global interpreter lock released, so the global interpreter lock alone does 
+         * not protect this state. It is only locked once the global interpreter lock has been released, 
+         * so the two cannot deadlock.
+         */
+        mutable std::mutex stateMutex;
+
+        friend class SampleBlockIterator;
+    };
+
+    /**
+     * A Python iterator which draws samples from a network in blocks. Each block is returned as a 
+     * 2D float64 memoryview over a new bytearray, which NumPy can wrap without copying (numpy.asarray).
+     * The global interpreter lock is released while each block is drawn.
+     */
+    class SampleBlockIterator
+    {
+    public:
+        /**
+         * Creates an iterator over a trained network
+         * @param network The network to draw from, which must outlive the iterator
+         * @param numSamples The total number of samples to draw
+         * @param blockSize The number of samples in each block
+         */
+        SampleBlockIterator(PythonDependencyNetwork& network, long numSamples, int blockSize);
+
+        /**
+         * Draws the next block, raising StopIteration once every sample has been drawn
+         * @return A memoryview of shape (rows, variables)
+         */
+        boost::python::object next();
+
+    private:
+        /** The network being sampled */
+        PythonDependencyNetwork* network;
+
+        /** The number of samples still to draw */
+        long remaining;
+
+        /** The number of samples in each block */
+        int blockSize;
     };
 
 }
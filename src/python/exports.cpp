@@ -1,5 +1,6 @@
 
 #include "python/dependency_network_wrap.h"
+#include "tracing.h"
 
 #include<locale>
 #include<cctype>
@@ -9,11 +10,81 @@
 
 using namespace boost::python;
 
+namespace
+{
+    object passThrough(const object& self)
+    {
+        return self;
+    }
+
+    /** Pickles networks through the compact binary format rather than by reconstruction */
+    struct DependencyNetworkPickle : pickle_suite
+    {
+        static tuple getinitargs(const depnet::PythonDependencyNetwork& network)
+        {
+            return make_tuple(list());
+        }
+
+        static tuple getstate(const depnet::PythonDependencyNetwork& network)
+        {
+            return make_tuple(network.getState());
+        }
+
+        static void setstate(depnet::PythonDependencyNetwork& network, tuple state)
+        {
+            network.setState(state[0]);
+        }
+    };
+
+    void writeTrace(const std::string& path)
+    {
+        depnet::tracing::writeChromeTrace(path);
+    }
+
+    depnet::SampleBlockIterator sampleBlocks(depnet::PythonDependencyNetwork& network, 
+        long numSamples, int blockSize)
+    {
+        return depnet::SampleBlockIterator(network, numSamples, blockSize);
+    }
+}
+
 BOOST_PYTHON_MODULE(pydepnet)
 {
     class_<depnet::PythonDependencyNetwork, boost::noncopyable>("DependencyNetwork",
         init<boost::python::list const&>())
         .def("train", &depnet::PythonDependencyNetwork::train)
+        .def("train_csv", &depnet::PythonDependencyNetwork::trainCsv)
+        .def("variable_names", &depnet::PythonDependencyNetwork::getVariableNames)
+        .def("set_model_type", &depnet::PythonDependencyNetwork::setModelType, (arg("variable"), arg("model_type")))
+        .def("set_default_model_type", &depnet::PythonDependencyNetwork::setDefaultModelType, (arg("model_type")))
+        .def("set_table_budget", &depnet::PythonDependencyNetwork::setTableBudget, (arg("bytes")))
+        .def("enable_model_selection", &depnet::PythonDependencyNetwork::enableModelSelection,
+            (arg("candidates") = list(), arg("tolerance") = 0.02, arg("latency_budget") = 0.0))
+        .def("disable_model_selection", &depnet::PythonDependencyNetwork::disableModelSelection)
+        .def("metrics", &depnet::PythonDependencyNetwork::getMetrics)
+        .def("metrics_json", &depnet::PythonDependencyNetwork::getMetricsJson)
+        .def("predict", &depnet::PythonDependencyNetwork::predictBatch, 
+            (arg("variable"), arg("indep"), arg("out")))
+        .def("class_density", &depnet::PythonDependencyNetwork::classDensityBatch, 
+            (arg("variable"), arg("indep"), arg("out")))
+        .def("sample", &depnet::PythonDependencyNetwork::fillSamples, (arg("out")))
+        .def("sample_blocks", &sampleBlocks, (arg("num_samples"), arg("block_size") = 1024),
+            with_custodian_and_ward_postcall<0, 1>())
+        .def("save", &depnet::PythonDependencyNetwork::saveFile, (arg("path")))
+        .def("load", &depnet::PythonDependencyNetwork::loadFile, (arg("path")))
+        .def("save_shared_memory", &depnet::PythonDependencyNetwork::saveToSharedMemory, (arg("name")))
+        .def("load_shared_memory", &depnet::PythonDependencyNetwork::loadFromSharedMemory, (arg("name")))
+        .def_pickle(DependencyNetworkPickle())
+    ;
+
+    def("unlink_shared_memory", &depnet::MappedBuffer::unlinkSharedMemory, (arg("name")));
+    def("set_tracing", &depnet::tracing::setEnabled, (arg("enabled")));
+    def("write_trace", &writeTrace, (arg("path")));
+    def("clear_trace", &depnet::tracing::clear);
+
+    class_<depnet::SampleBlockIterator>("SampleBlockIterator", no_init)
+        .def("__iter__", &passThrough)
+        .def("__next__", &depnet::SampleBlockIterator::next)
     ;
 }
 
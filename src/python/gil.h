@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef GIL_H
+#define GIL_H
+
+#include<Python.h>
+
+namespace depnet
+{
+    /**
+     * Releases the Python global interpreter lock for the lifetime of the object, so that other Python
+     * threads can run while the C++ engine works. No Python objects may be touched while it is released.
+     */
+    class ScopedGILRelease
+    {
+    public:
+        /** Releases the lock */
+        ScopedGILRelease() : state(PyEval_SaveThread()) { }
+
+        /** Reacquires the lock */
+        ~ScopedGILRelease()
+        {
+            PyEval_RestoreThread(this->state);
+        }
+
+    private:
+        ScopedGILRelease(const ScopedGILRelease&);
+        ScopedGILRelease& operator=(const ScopedGILRelease&);
+
+        /** The thread state saved when the lock was released */
+        PyThreadState* state;
+    };
+}
+
+#endif
+
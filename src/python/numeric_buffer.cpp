@@ -0,0 +1,67 @@
+
+#include "numeric_buffer.h"
+#include "exceptions/conversion.h"
+
+#include<cstring>
+#include<sstream>
+
+namespace depnet
+{
+    NumericBuffer::NumericBuffer(PyObject* object, int ndim, bool writable)
+    {
+        int flags = PyBUF_STRIDES | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+        if(PyObject_GetBuffer(object, &this->view, flags) != 0)
+        {
+            PyErr_Clear();
+            throw ConversionException(writable ? 
+                "Expecting a writable array supporting the buffer protocol, such as a NumPy array." :
+                "Expecting an array supporting the buffer protocol, such as a NumPy array.");
+        }
+
+        // only native byte order is accepted; '@', '=' and '<' on little-endian hosts all describe it
+        const char* format = this->view.format ? this->view.format : "B";
+        if(*format == '@' || *format == '=' || (*format == '<' && PY_LITTLE_ENDIAN) || (*format == '>' && PY_BIG_ENDIAN))
+            format++;
+
+        this->isFloat = std::strcmp(format, "f") == 0;
+        bool isDouble = std::strcmp(format, "d") == 0;
+        if(this->view.ndim != ndim || !(isDouble || this->isFloat))
+        {
+            std::ostringstream message;
+            message << "Expecting a " << ndim << " dimensional array of float64 or float32 values, found " << 
+                this->view.ndim << " dimensions of type '" << format << "'.";
+            PyBuffer_Release(&this->view);
+            throw ConversionException(message.str());
+        }
+    }
+
+    NumericBuffer::~NumericBuffer()
+    {
+        PyBuffer_Release(&this->view);
+    }
+
+    std::size_t NumericBuffer::shape(int dim) const
+    {
+        return dim < this->view.ndim ? this->view.shape[dim] : 1;
+    }
+
+    bool NumericBuffer::isContiguousDouble() const
+    {
+        return !this->isFloat && PyBuffer_IsContiguous(&this->view, 'C');
+    }
+
+    double* NumericBuffer::data() const
+    {
+        return static_cast<double*>(this->view.buf);
+    }
+
+    void NumericBuffer::copyTo(boost::multi_array<double, 2>& out) const
+    {
+        std::size_t numRows = this->shape(0), numCols = this->shape(1);
+        out.resize(boost::extents[numRows][numCols]);
+        for(std::size_t row = 0; row < numRows; row++)
+            for(std::size_t col = 0; col < numCols; col++)
+                out[row][col] = this->get(row, col);
+    }
+}
+
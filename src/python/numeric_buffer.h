@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef NUMERIC_BUFFER_H
+#define NUMERIC_BUFFER_H
+
+#include<Python.h>
+
+#include<cstddef>
+
+#include<boost/multi_array.hpp>
+
+namespace depnet
+{
+    /**
+     * A view of a one or two dimensional float64 or float32 array exported through the Python buffer protocol,
+     * such as a NumPy array or a memoryview. Elements are addressed through the exporter's strides, so
+     * non-contiguous slices are read without a copy. The exporter cannot be resized while the view exists,
+     * so the view may be read after the global interpreter lock has been released.
+     */
+    class NumericBuffer
+    {
+    public:
+        /**
+         * Acquires a view of an object's buffer.
+         * Throws ConversionException if the object does not export a buffer of the expected shape and type.
+         * @param object The object exporting the buffer
+         * @param ndim The required number of dimensions, 1 or 2
+         * @param writable Indicates that values will be written to the buffer
+         */
+        NumericBuffer(PyObject* object, int ndim, bool writable = false);
+
+        /** Releases the view */
+        ~NumericBuffer();
+
+        /**
+         * Retrieves the length of a dimension
+         * @param dim The dimension
+         * @return The number of elements along the dimension
+         */
+        std::size_t shape(int dim) const;
+
+        /**
+         * Indicates if the buffer holds C-contiguous float64 values, which can be used in place
+         * @return true if the buffer can be referenced as a row-major array of doubles
+         */
+        bool isContiguousDouble() const;
+
+        /**
+         * Retrieves the first element of a contiguous float64 buffer
+         * @return A pointer to the values
+         */
+        double* data() const;
+
+        /**
+         * Reads an element
+         * @param row The index along the first dimension
+         * @param col The index along the second dimension, 0 for one dimensional buffers
+         * @return The element as a double
+         */
+        double get(std::size_t row, std::size_t col = 0) const
+        {
+            const char* element = this->element(row, col);
+            return this->isFloat ? *reinterpret_cast<const float*>(element) : *reinterpret_cast<const double*>(element);
+        }
+
+        /**
+         * Writes an element
+         * @param row The index along the first dimension
+         * @param col The index along the second dimension, 0 for one dimensional buffers
+         * @param value The value to store
+         */
+        void set(std::size_t row, std::size_t col, double value)
+        {
+            char* element = this->element(row, col);
+            if(this->isFloat)
+                *reinterpret_cast<float*>(element) = static_cast<float>(value);
+            else
+                *reinterpret_cast<double*>(element) = value;
+        }
+
+        /**
+         * Copies a two dimensional buffer into an array, converting to double
+         * @param out Resized to the shape of the buffer and filled
+         */
+        void copyTo(boost::multi_array<double, 2>& out) const;
+
+    private:
+        NumericBuffer(const NumericBuffer&);
+        NumericBuffer& operator=(const NumericBuffer&);
+
+        /** Locates an element through the buffer's strides */
+        char* element(std::size_t row, std::size_t col) const
+        {
+            char* start = static_cast<char*>(this->view.buf) + row * this->view.strides[0];
+            return this->view.ndim > 1 ? start + col * this->view.strides[1] : start;
+        }
+
+        /** The exported buffer */
+        Py_buffer view;
+
+        /** Indicates that elements are float32 rather than float64 */
+        bool isFloat;
+    };
+}
+
+#endif
+
@@ -0,0 +1,85 @@
+
+#include "sample_buffer.h"
+#include "tracing.h"
+
+#include<algorithm>
+
+namespace depnet
+{
+    SampleBuffer::SampleBuffer(std::size_t numCols, std::size_t capacity) :
+        numCols(numCols), capacity(std::max<std::size_t>(capacity, 1)), head(0), count(0),
+        closed(false), data(std::max<std::size_t>(capacity, 1) * numCols) { }
+
+    SampleBuffer::~SampleBuffer() { }
+
+    bool SampleBuffer::push(const double* row)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(!this->closed && this->count == this->capacity)
+        {
+            // the producer stalls until the consumer drains a row
+            TraceSpan span("SampleBuffer::push wait", "queue");
+            this->notFull.wait(lock, [this]() { return this->closed || this->count < this->capacity; });
+        }
+        if(this->closed)
+            return false;
+
+        std::size_t tail = (this->head + this->count) % this->capacity;
+        std::copy(row, row + this->numCols, this->data.begin() + tail * this->numCols);
+        this->count++;
+
+        lock.unlock();
+        this->notEmpty.notify_one();
+        return true;
+    }
+
+    std::size_t SampleBuffer::pop(double* rows, std::size_t maxRows)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(!this->closed && this->count == 0)
+        {
+            TraceSpan span("SampleBuffer::pop wait", "queue");
+            this->notEmpty.wait(lock, [this]() { return this->closed || this->count > 0; });
+        }
+
+        std::size_t numRows = std::min(maxRows, this->count);
+        for(std::size_t row = 0; row < numRows; row++)
+        {
+            auto src = this->data.begin() + ((this->head + row) % this->capacity) * this->numCols;
+            std::copy(src, src + this->numCols, rows + row * this->numCols);
+        }
+        this->head = (this->head + numRows) % this->capacity;
+        this->count -= numRows;
+
+        lock.unlock();
+        this->notFull.notify_all();
+        return numRows;
+    }
+
+    void SampleBuffer::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->closed = true;
+        }
+        this->notFull.notify_all();
+        this->notEmpty.notify_all();
+    }
+
+    bool SampleBuffer::isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->closed;
+    }
+
+    std::size_t SampleBuffer::getNumCols() const
+    {
+        return this->numCols;
+    }
+
+    std::size_t SampleBuffer::getCapacity() const
+    {
+        return this->capacity;
+    }
+}
+
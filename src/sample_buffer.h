@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include<cstddef>
+#include<vector>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+
+namespace depnet
+{
+    /**
+     * Receives a block of samples as they are produced.
+     * The first argument points to numRows * numCols values stored contiguously in row-major order,
+     * with variables in the same order that they were supplied to the DependencyNetwork.
+     * The block is only valid for the duration of the call.
+     * Returning false stops sampling early.
+     */
+    typedef std::function<bool(const double* rows, std::size_t numRows, std::size_t numCols)> SampleCallback;
+
+    /**
+     * A bounded, thread-safe ring buffer of samples stored as contiguous rows.
+     * Producers block when the buffer is full, which applies back-pressure to the sampler
+     * when the consumer (e.g. a disk writer or Python) falls behind.
+     */
+    class SampleBuffer
+    {
+    public:
+        /**
+         * Creates a ring buffer for samples
+         * @param numCols The number of variables in each sample
+         * @param capacity The maximum number of rows held before producers block
+         */
+        SampleBuffer(std::size_t numCols, std::size_t capacity);
+
+        /** Destroys the buffer */
+        ~SampleBuffer();
+
+        /**
+         * Copies a single row into the buffer, blocking while the buffer is full
+         * @param row A pointer to numCols values
+         * @return false if the buffer has been closed and the row was discarded, true otherwise
+         */
+        bool push(const double* row);
+
+        /**
+         * Moves up to maxRows rows out of the buffer, blocking while the buffer is empty and open
+         * @param rows A destination with room for maxRows * numCols values
+         * @param maxRows The largest number of rows to retrieve
+         * @return The number of rows copied, which is 0 only once the buffer is closed and drained
+         */
+        std::size_t pop(double* rows, std::size_t maxRows);
+
+        /**
+         * Marks the end of the stream. Blocked producers and consumers are woken;
+         * consumers may continue to drain rows that were already buffered.
+         */
+        void close();
+
+        /**
+         * Indicates if SampleBuffer::close has been called
+         * @return true if the buffer is closed, false otherwise
+         */
+        bool isClosed() const;
+
+        /**
+         * Retrieves the number of variables in each row
+         * @return The row width
+         */
+        std::size_t getNumCols() const;
+
+        /**
+         * Retrieves the maximum number of rows that can be held
+         * @return The capacity in rows
+         */
+        std::size_t getCapacity() const;
+
+    private:
+        /** The number of values in each row */
+        std::size_t numCols;
+
+        /** The number of rows which can be stored */
+        std::size_t capacity;
+
+        /** The index of the oldest row in the ring */
+        std::size_t head;
+
+        /** The number of rows currently held */
+        std::size_t count;
+
+        /** Indicates that no more rows will be pushed */
+        bool closed;
+
+        /** Row storage, capacity * numCols values */
+        std::vector<double> data;
+
+        /** Guards all buffer state */
+        mutable std::mutex mutex;
+
+        /** Signalled when a row is removed or the buffer is closed */
+        std::condition_variable notFull;
+
+        /** Signalled when a row is added or the buffer is closed */
+        std::condition_variable notEmpty;
+    };
+}
+
+#endif
+
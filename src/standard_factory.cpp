@@ -1,20 +1,89 @@
 #include "standard_factory.h"
 #include "standard_var_spec.h"
+#include "mcmc/standard_gibbs_sampler.h"
+#include "mcmc/standard_gibbs_iterator.h"
+#include "models/rdf_model.h"
+#include "models/linear_model.h"
+#include "models/logistic_model.h"
+#include "models/knn_model.h"
+#include "models/boosted_model.h"
+#include "models/table_model.h"
+#include "exceptions/conversion.h"
 
 namespace depnet
 {
+    StandardFactory::StandardFactory() : defaultModelType("rdf"), tableBudget(0) { }
 
     std::shared_ptr<GibbsSampler> StandardFactory::createSampler(
         const std::map<std::shared_ptr<VariableSpecification>, 
-            std::shared_ptr<ConditionalModel> >& network, unsigned int numChains) const
+            std::shared_ptr<ConditionalModel> >& network, unsigned int numChains,
+            std::uint64_t seed) const
     {
-
+        return std::shared_ptr<GibbsSampler>(new StandardGibbsSampler(network, numChains, 
+            boost::none, boost::none, seed));
     }
 
     std::shared_ptr<GibbsIterator> StandardFactory::createSampleIterator(
         std::shared_ptr<GibbsSampler> sampler, int warmUpPeriod, int interval) const
     {
+        return std::shared_ptr<GibbsIterator>(new StandardGibbsIterator(sampler, warmUpPeriod, interval));
+    }
 
+    std::shared_ptr<ConditionalModel> StandardFactory::createModel(const std::string& modelType,
+        const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+        std::shared_ptr<VariableSpecification> dep) const
+    {
+        if(modelType == "rdf")
+            return std::shared_ptr<ConditionalModel>(new RandomForestModel(indep, dep, 0.1, 100));
+        if(modelType == "linear")
+            return std::shared_ptr<ConditionalModel>(new LinearConditionalModel(indep, dep));
+        if(modelType == "cpt")
+            return std::shared_ptr<ConditionalModel>(new TableConditionalModel(indep, dep));
+        if(modelType == "gbt")
+            return std::shared_ptr<ConditionalModel>(new BoostedTreeModel(indep, dep));
+        if(modelType == "knn")
+            return std::shared_ptr<ConditionalModel>(new KnnConditionalModel(indep, dep));
+        if(modelType == "logistic")
+        {
+            if(!dep->isDiscrete())
+                throw ConversionException("Logistic models require a discrete variable, but '" 
+                    + dep->getName() + "' is continuous.");
+            return std::shared_ptr<ConditionalModel>(new LogisticConditionalModel(indep, dep));
+        }
+
+        throw ConversionException("Unknown conditional model type '" + modelType + "'.");
+    }
+
+    std::string StandardFactory::chooseModelType(const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+        std::shared_ptr<VariableSpecification> dep) const
+    {
+        auto found = this->modelTypes.find(dep->getName());
+        if(found == this->modelTypes.end() && this->tableBudget > 0)
+        {
+            std::uint64_t tableBytes = TableConditionalModel::getTableBytes(indep, dep);
+            if(tableBytes > 0 && tableBytes <= this->tableBudget)
+                return "cpt";
+        }
+
+        const std::string& modelType = found == this->modelTypes.end() ? this->defaultModelType : found->second;
+        if(modelType == "fast")
+            return dep->isDiscrete() ? "logistic" : "linear";
+        return modelType;
+    }
+
+    void StandardFactory::setDefaultModelType(const std::string& modelType)
+    {
+        this->defaultModelType = modelType;
+    }
+
+    void StandardFactory::setTableBudget(std::uint64_t bytes)
+    {
+        this->tableBudget = bytes;
+    }
+
+    void StandardFactory::setModelType(const std::string& name, const std::string& modelType)
+    {
+        this->modelTypes[name] = modelType;
     }
 
     std::shared_ptr<VariableSpecification> StandardFactory::createVariableSpec() const
@@ -4,6 +4,9 @@
 #ifndef SIMPLE_FACTORY_H
 #define SIMPLE_FACTORY_H
 
+#include<map>
+#include<string>
+
 #include "factory.h"
 #include "mcmc/gibbs_sampler.h"
 #include "mcmc/gibbs_iterator.h"
@@ -17,16 +20,24 @@ namespace depnet
     class StandardFactory : public Factory
     {
     public:
+        /**
+         * Creates a factory which trains random forests for every variable
+         */
+        StandardFactory();
+
         /**
          * Creates a sampler as a map from variable 
          * specification to a conditional model
          * @param network A map from a variable to a conditional model for that variable
          * @param numChains The number of chains to run concurrently
+         * @param seed Keys the sampler's random number generator
          * @return A sampler over the specified network
          */
         std::shared_ptr<GibbsSampler> createSampler(
             const std::map<std::shared_ptr<VariableSpecification>, 
-                std::shared_ptr<ConditionalModel> >& network, unsigned int numChains) const;
+                std::shared_ptr<ConditionalModel> >& network, unsigned int numChains,
+                std::uint64_t seed) const;
+        using Factory::createSampler;
 
         /**
          * Creates an iterator over a Gibbs sampler.
@@ -39,12 +50,65 @@ namespace depnet
         std::shared_ptr<GibbsIterator> createSampleIterator(
             std::shared_ptr<GibbsSampler> sampler, int warmUpPeriod = 0, int interval = 0) const;
 
+        /**
+         * Creates an untrained conditional model of a named type
+         * @param modelType The type of model, as reported by ConditionalModel::getModelType
+         * @param indep The independent variables of the model
+         * @param dep The dependent variable of the model
+         * @return The newly created model. Throws ConversionException if the type is unknown.
+         */
+        std::shared_ptr<ConditionalModel> createModel(const std::string& modelType,
+            const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+            std::shared_ptr<VariableSpecification> dep) const;
+
+        /**
+         * Chooses the type of model for a variable: its own type if one was set by name, 
+         * a probability table ("cpt") if every variable is discrete and the table fits the table budget,
+         * and the default type otherwise. The type "fast" resolves to "linear" for 
+         * continuous variables and "logistic" for discrete ones.
+         * @param indep The independent variables of the model
+         * @param dep The dependent variable of the model
+         * @return A type accepted by StandardFactory::createModel
+         */
+        std::string chooseModelType(const std::vector<std::shared_ptr<VariableSpecification> >& indep,
+            std::shared_ptr<VariableSpecification> dep) const;
+
+        /**
+         * Establishes the type of model trained for variables without a type of their own
+         * @param modelType "rdf", "gbt", "linear", "logistic", "knn", "cpt" or "fast"
+         */
+        void setDefaultModelType(const std::string& modelType);
+
+        /**
+         * Establishes the largest probability table chosen in place of the default type
+         * @param bytes The memory budget of a single table, or 0 to never choose tables automatically
+         * @see TableConditionalModel::getTableBytes
+         */
+        void setTableBudget(std::uint64_t bytes);
+
+        /**
+         * Establishes the type of model trained for a single variable
+         * @param name The name of the variable
+         * @param modelType "rdf", "gbt", "linear", "logistic", "knn", "cpt" or "fast"
+         */
+        void setModelType(const std::string& name, const std::string& modelType);
+
         /**
          * Creates a variable specification of the appropriate type.
          * @return A pointer to the newly created variable specification.
          */
         std::shared_ptr<VariableSpecification> createVariableSpec() const;
 
+    private:
+        /** The type of model trained for variables without a type of their own */
+        std::string defaultModelType;
+
+        /** The largest table chosen automatically, in bytes */
+        std::uint64_t tableBudget;
+
+        /** The type of model trained for each named variable */
+        std::map<std::string, std::string> modelTypes;
+
     };
 }
 
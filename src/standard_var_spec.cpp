@@ -9,8 +9,9 @@ namespace depnet
 {
     StandardVariableSpecification::StandardVariableSpecification() : 
         isBool(false), isOrd(false), isDisc(false), 
-        minVal(std::numeric_limits<double>::max()), 
-        maxVal(std::numeric_limits<double>::max()) { }
+        minVal(-std::numeric_limits<double>::infinity()), 
+        maxVal(std::numeric_limits<double>::infinity()),
+        levels(LevelDictionary::empty()) { }
 
     StandardVariableSpecification::~StandardVariableSpecification() { }
 
@@ -74,25 +75,34 @@ namespace depnet
     const std::map<int, std::string> StandardVariableSpecification::getLevelMap() const
     {
         std::map<int, std::string> levelMap;
-        int levelNum = 0;
-        for(auto levelIt = levels.begin(); levelIt != levels.end(); ++levelIt)
-            levelMap.insert(std::pair<int, std::string>(levelNum, *levelIt));
+        for(std::size_t levelNum = 0; levelNum < this->levels->size(); levelNum++)
+            levelMap.insert(std::pair<int, std::string>(levelNum, this->levels->getLevel(levelNum)));
         return levelMap;
     }
 
     const std::vector<std::string>& StandardVariableSpecification::getLevels() const
     {
-        return this->levels;
+        return this->levels->getLevels();
     }
 
     const int StandardVariableSpecification::getNumLevels() const
     {
-        return this->levels.size();
+        return this->levels->size();
     }
 
     void StandardVariableSpecification::setLevels(std::vector<std::string> levels)
     {
-        this->levels = std::move(levels);
+        this->levels = LevelDictionary::intern(levels);
+    }
+
+    std::shared_ptr<const LevelDictionary> StandardVariableSpecification::getLevelDictionary() const
+    {
+        return this->levels;
+    }
+
+    void StandardVariableSpecification::setLevelDictionary(std::shared_ptr<const LevelDictionary> dictionary)
+    {
+        this->levels = dictionary ? dictionary : LevelDictionary::empty();
     }
 }
 
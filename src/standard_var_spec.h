@@ -4,6 +4,7 @@
 #ifndef STANDARD_VARIABLE_SPECIFICATION_H
 #define STANDARD_VARIABLE_SPECIFICATION_H
 
+#include<memory>
 #include<string>
 #include<vector>
 #include<map>
@@ -108,6 +109,7 @@ namespace depnet {
 
         /**
          * Builds a map from factor level as an integer to a level as a name.
+         * Prefer StandardVariableSpecification::getLevelDictionary, which does not build a new map on every call.
          * @return A mapping from a positive integer factor ID to the 
          * name of the level of that factor.
          */
@@ -134,6 +136,18 @@ namespace depnet {
          * @param levels The names of the levels as strings
          */
         void setLevels(std::vector<std::string> levels);
+
+        /**
+         * Retrieves the interned dictionary of this variable's levels
+         * @return The level dictionary, which is empty if no levels have been established
+         */
+        std::shared_ptr<const LevelDictionary> getLevelDictionary() const;
+
+        /**
+         * Establishes the levels of this variable from an existing dictionary
+         * @param dictionary The level dictionary
+         */
+        void setLevelDictionary(std::shared_ptr<const LevelDictionary> dictionary);
     private:    
 
         /** The name/label of the variable */
@@ -154,8 +168,8 @@ namespace depnet {
         /** Indicates if this is a discrete variable */
         bool isDisc;
 
-        /** Names of variable values for a discrete variable */
-        std::vector<std::string> levels;
+        /** Names of variable values for a discrete variable, shared with other variables over the same levels */
+        std::shared_ptr<const LevelDictionary> levels;
     };
 
 }
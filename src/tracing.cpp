@@ -0,0 +1,279 @@
+
+#include "tracing.h"
+#include "metrics.h"
+#include "exceptions/conversion.h"
+
+#include<chrono>
+#include<cstdio>
+#include<fstream>
+#include<memory>
+#include<mutex>
+#include<set>
+#include<vector>
+
+#include<unistd.h>
+
+namespace depnet
+{
+    namespace tracing
+    {
+        std::atomic<bool> enabled(false);
+
+        namespace
+        {
+            /** A completed span */
+            struct Event
+            {
+                const char* name;
+                const char* category;
+                const char* detail;
+                std::uint64_t start;
+                std::uint64_t duration;
+            };
+
+            const std::size_t CHUNK_EVENTS = 4096;
+
+            // bounds each thread's buffer to about a million events
+            const std::size_t MAX_CHUNKS = 256;
+
+            /** A block of events. Only the owning thread appends, publishing each event through count. */
+            struct Chunk
+            {
+                Chunk() : count(0), next(NULL) { }
+
+                Event events[CHUNK_EVENTS];
+                std::atomic<std::size_t> count;
+                std::atomic<Chunk*> next;
+            };
+
+            /**
+             * The events recorded by one thread. The owner appends without locking; 
+             * readers, and the owner when it frees chunks, hold the mutex.
+             */
+            struct ThreadBuffer
+            {
+                ThreadBuffer(std::uint32_t threadId, std::uint64_t generation) : threadId(threadId), 
+                    head(new Chunk()), tail(head), numChunks(1), generation(generation), dropped(0) { }
+
+                ~ThreadBuffer()
+                {
+                    this->reset(this->generation);
+                    delete this->head;
+                }
+
+                /** Discards every event, keeping the first chunk */
+                void reset(std::uint64_t generation)
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    Chunk* chunk = this->head->next.load(std::memory_order_relaxed);
+                    while(chunk)
+                    {
+                        Chunk* next = chunk->next.load(std::memory_order_relaxed);
+                        delete chunk;
+                        chunk = next;
+                    }
+                    this->head->next.store(NULL, std::memory_order_relaxed);
+                    this->head->count.store(0, std::memory_order_relaxed);
+                    this->tail = this->head;
+                    this->numChunks = 1;
+                    this->dropped.store(0, std::memory_order_relaxed);
+                    this->generation = generation;
+                }
+
+                std::uint32_t threadId;
+                std::mutex mutex;
+                Chunk* head;
+                Chunk* tail;
+                std::size_t numChunks;
+
+                /** The tracing::clear generation the events belong to, written under the mutex */
+                std::uint64_t generation;
+
+                std::atomic<std::uint64_t> dropped;
+            };
+
+            struct Registry
+            {
+                Registry() : nextThreadId(1), generation(0) { }
+
+                std::mutex mutex;
+                std::vector<std::shared_ptr<ThreadBuffer> > buffers;
+                std::uint32_t nextThreadId;
+
+                /** Incremented by tracing::clear, invalidating every buffer */
+                std::atomic<std::uint64_t> generation;
+
+                std::mutex stringsMutex;
+                std::set<std::string> strings;
+            };
+
+            Registry& registry()
+            {
+                static Registry instance;
+                return instance;
+            }
+
+            ThreadBuffer& threadBuffer()
+            {
+                static thread_local std::shared_ptr<ThreadBuffer> buffer;
+                if(!buffer)
+                {
+                    Registry& reg = registry();
+                    std::lock_guard<std::mutex> lock(reg.mutex);
+                    buffer.reset(new ThreadBuffer(reg.nextThreadId++, reg.generation.load()));
+                    reg.buffers.push_back(buffer);
+                }
+                return *buffer;
+            }
+
+            std::vector<std::shared_ptr<ThreadBuffer> > currentBuffers()
+            {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                return reg.buffers;
+            }
+        }
+
+        void setEnabled(bool enable)
+        {
+            enabled.store(enable);
+        }
+
+        std::uint64_t now()
+        {
+            static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        void record(const char* name, const char* category, std::uint64_t start, const char* detail)
+        {
+            if(!isEnabled())
+                return;
+            std::uint64_t end = now();
+
+            ThreadBuffer& buffer = threadBuffer();
+            std::uint64_t generation = registry().generation.load(std::memory_order_acquire);
+            if(buffer.generation != generation)
+                buffer.reset(generation);
+
+            Chunk* chunk = buffer.tail;
+            std::size_t count = chunk->count.load(std::memory_order_relaxed);
+            if(count == CHUNK_EVENTS)
+            {
+                if(buffer.numChunks == MAX_CHUNKS)
+                {
+                    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Chunk* next = new Chunk();
+                chunk->next.store(next, std::memory_order_release);
+                buffer.tail = chunk = next;
+                buffer.numChunks++;
+                count = 0;
+            }
+
+            Event& event = chunk->events[count];
+            event.name = name;
+            event.category = category;
+            event.detail = detail;
+            event.start = start;
+            event.duration = end > start ? end - start : 0;
+            chunk->count.store(count + 1, std::memory_order_release);
+        }
+
+        const char* intern(const std::string& value)
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.stringsMutex);
+            return reg.strings.insert(value).first->c_str();
+        }
+
+        void writeChromeTrace(std::ostream& out)
+        {
+            std::uint64_t generation = registry().generation.load(std::memory_order_acquire);
+            std::vector<std::shared_ptr<ThreadBuffer> > buffers = currentBuffers();
+            int pid = getpid();
+            char timing[64];
+
+            out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+            bool first = true;
+            for(auto it = buffers.begin(); it != buffers.end(); ++it)
+            {
+                ThreadBuffer& buffer = **it;
+                std::lock_guard<std::mutex> lock(buffer.mutex);
+                if(buffer.generation != generation)
+                    continue;
+
+                out << (first ? "" : ",") << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+                    << ", \"tid\": " << buffer.threadId << ", \"args\": {\"name\": \"thread " << buffer.threadId << "\"}}";
+                first = false;
+
+                for(Chunk* chunk = buffer.head; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+                {
+                    std::size_t count = chunk->count.load(std::memory_order_acquire);
+                    for(std::size_t index = 0; index < count; index++)
+                    {
+                        const Event& event = chunk->events[index];
+                        out << "," << std::endl << "{\"name\": ";
+                        writeJsonString(out, event.name);
+                        out << ", \"cat\": ";
+                        writeJsonString(out, event.category);
+                        // timestamps are in microseconds, kept to nanosecond resolution
+                        std::snprintf(timing, sizeof(timing), "\"ts\": %.3f, \"dur\": %.3f", 
+                                event.start / 1000.0, event.duration / 1000.0);
+                        out << ", \"ph\": \"X\", " << timing << ", \"pid\": " << pid << ", \"tid\": " << buffer.threadId;
+                        if(event.detail)
+                        {
+                            out << ", \"args\": {\"detail\": ";
+                            writeJsonString(out, event.detail);
+                            out << "}";
+                        }
+                        out << "}";
+                    }
+                }
+            }
+            out << std::endl << "]}" << std::endl;
+        }
+
+        void writeChromeTrace(const std::string& path)
+        {
+            std::ofstream out(path.c_str());
+            writeChromeTrace(out);
+            out.close();
+            if(out.fail())
+                throw ConversionException("Unable to write the trace to " + path + ".");
+        }
+
+        void clear()
+        {
+            Registry& reg = registry();
+            reg.generation.fetch_add(1, std::memory_order_acq_rel);
+
+            // the registry holds the only reference to the buffer of a thread which has exited
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for(auto it = reg.buffers.begin(); it != reg.buffers.end(); )
+            {
+                if(it->use_count() == 1)
+                    it = reg.buffers.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        std::uint64_t getDroppedEvents()
+        {
+            std::uint64_t generation = registry().generation.load(std::memory_order_acquire);
+            std::vector<std::shared_ptr<ThreadBuffer> > buffers = currentBuffers();
+            std::uint64_t dropped = 0;
+            for(auto it = buffers.begin(); it != buffers.end(); ++it)
+            {
+                std::lock_guard<std::mutex> lock((*it)->mutex);
+                if((*it)->generation == generation)
+                    dropped += (*it)->dropped.load(std::memory_order_relaxed);
+            }
+            return dropped;
+        }
+    }
+}
+
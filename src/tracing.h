@@ -0,0 +1,122 @@
+#pragma once
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include<atomic>
+#include<cstdint>
+#include<ostream>
+#include<string>
+
+namespace depnet
+{
+    /**
+     * Records timed spans into per-thread buffers and exports them in the Chrome trace event format,
+     * which chrome://tracing and Perfetto display as a timeline with one track per thread.
+     * Recording is off by default; while it is off a span costs one relaxed atomic load.
+     * Appending to a thread's buffer takes no lock, so recording does not serialize threads.
+     */
+    namespace tracing
+    {
+        /** Set while spans are being recorded */
+        extern std::atomic<bool> enabled;
+
+        /**
+         * Indicates if spans are being recorded
+         * @return true if recording is on
+         */
+        inline bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Turns recording on or off. Events already recorded are kept until tracing::clear.
+         * @param enable true to record spans
+         */
+        void setEnabled(bool enable);
+
+        /**
+         * Reads the clock used for events
+         * @return Nanoseconds since the first use of the clock in this process
+         */
+        std::uint64_t now();
+
+        /**
+         * Records a span which started at a time given by tracing::now and ends now, if recording is on.
+         * Events beyond a per-thread limit of about a million are dropped and counted.
+         * @param name The name of the span, which must be a string literal or outlive the trace
+         * @param category The category of the span, e.g. "sampler", with the same lifetime requirement
+         * @param start The time the span started
+         * @param detail An optional argument displayed with the span, e.g. from tracing::intern, or NULL
+         */
+        void record(const char* name, const char* category, std::uint64_t start, const char* detail = NULL);
+
+        /**
+         * Keeps a copy of a string for the life of the process, so it can label spans
+         * @param value The string to copy
+         * @return A pointer which stays valid, shared by every call with an equal string
+         */
+        const char* intern(const std::string& value);
+
+        /**
+         * Writes every recorded event as a Chrome trace JSON object
+         * @param out The stream to write to
+         */
+        void writeChromeTrace(std::ostream& out);
+
+        /**
+         * Writes every recorded event to a file, throwing ConversionException if it cannot be written
+         * @param path The file to create or overwrite
+         */
+        void writeChromeTrace(const std::string& path);
+
+        /**
+         * Discards recorded events. Each thread frees its buffer the next time it records, 
+         * and buffers of threads which have exited are freed immediately.
+         */
+        void clear();
+
+        /**
+         * Retrieves the number of events dropped because a thread's buffer was full
+         * @return The number of dropped events since the last tracing::clear
+         */
+        std::uint64_t getDroppedEvents();
+    }
+
+    /**
+     * Records a span from construction to destruction
+     */
+    class TraceSpan
+    {
+    public:
+        /**
+         * Starts a span, if recording is on
+         * @param name The name of the span, which must be a string literal or outlive the trace
+         * @param category The category of the span
+         * @param detail An optional argument displayed with the span, or NULL
+         */
+        TraceSpan(const char* name, const char* category, const char* detail = NULL) :
+            name(name), category(category), detail(detail), 
+            active(tracing::isEnabled()), start(active ? tracing::now() : 0) { }
+
+        ~TraceSpan()
+        {
+            if(this->active)
+                tracing::record(this->name, this->category, this->start, this->detail);
+        }
+
+    private:
+        TraceSpan(const TraceSpan&);
+        TraceSpan& operator=(const TraceSpan&);
+
+        const char* name;
+        const char* category;
+        const char* detail;
+        bool active;
+        std::uint64_t start;
+    };
+}
+
+#endif
+
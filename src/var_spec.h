@@ -4,10 +4,13 @@
 #ifndef VARIABLE_SPECIFICATION_H
 #define VARIABLE_SPECIFICATION_H
 
+#include<memory>
 #include<string>
 #include<vector>
 #include<map>
 
+#include "level_dictionary.h"
+
 namespace depnet {
 
     /**
@@ -95,6 +98,7 @@ namespace depnet {
 
         /**
          * Builds a map from factor level as an integer to a level as a name.
+         * Prefer VariableSpecification::getLevelDictionary, which does not build a new map on every call.
          * @return A mapping from a positive integer factor ID to the 
          * name of the level of that factor.
          */
@@ -121,6 +125,19 @@ namespace depnet {
          * @param levels The names of the levels as strings
          */
         virtual void setLevels(std::vector<std::string> levels) = 0;
+
+        /**
+         * Retrieves the interned dictionary of this variable's levels, which gives constant time 
+         * lookups between level names and codes and may be shared with models and other variables
+         * @return The level dictionary, which is empty if no levels have been established
+         */
+        virtual std::shared_ptr<const LevelDictionary> getLevelDictionary() const = 0;
+
+        /**
+         * Establishes the levels of this variable from an existing dictionary, sharing it rather than copying it
+         * @param dictionary The level dictionary
+         */
+        virtual void setLevelDictionary(std::shared_ptr<const LevelDictionary> dictionary) = 0;
     };
 
 }
@@ -0,0 +1,196 @@
+#include <boost/test/unit_test.hpp>
+#include "alglib/ap.h"
+#include "alglib/linalg.h"
+#include "alglib/statistics.h"
+
+#include<cmath>
+#include<random>
+#include<vector>
+
+namespace
+{
+    std::vector<double> randomVector(int length, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::normal_distribution<double> distr;
+        std::vector<double> values(length);
+        for(int i = 0; i < length; i++)
+            values[i] = distr(generator);
+        return values;
+    }
+
+    alglib::real_2d_array randomMatrix(int rows, int cols, unsigned int seed)
+    {
+        std::vector<double> values = randomVector(rows * cols, seed);
+        alglib::real_2d_array matrix;
+        matrix.setlength(rows, cols);
+        for(int i = 0; i < rows; i++)
+            for(int j = 0; j < cols; j++)
+                matrix[i][j] = values[i * cols + j];
+        return matrix;
+    }
+}
+
+// the CPU feature bits should agree with what the compiler reports for this machine
+BOOST_AUTO_TEST_CASE(test_cpuid)
+{
+    alglib_impl::ae_int_t flags = alglib_impl::ae_cpuid();
+    BOOST_CHECK_EQUAL(flags, alglib_impl::ae_cpuid());
+#if defined(AE_HAS_AVX2_INTRINSICS)
+    BOOST_CHECK_EQUAL((flags & alglib_impl::CPU_AVX2) != 0, __builtin_cpu_supports("avx2") != 0);
+    BOOST_CHECK_EQUAL((flags & alglib_impl::CPU_FMA) != 0, __builtin_cpu_supports("fma") != 0);
+#else
+    BOOST_CHECK_EQUAL(flags & (alglib_impl::CPU_AVX2 | alglib_impl::CPU_FMA), 0);
+#endif
+}
+
+// vector kernels should match plain loops for lengths around the vector width, with and without strides
+BOOST_AUTO_TEST_CASE(test_vector_kernels)
+{
+    const int lengths[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 100};
+    const int strides[] = {1, 3};
+    for(int length : lengths)
+        for(int stride : strides)
+        {
+            std::vector<double> x = randomVector(length * stride, 1);
+            std::vector<double> y = randomVector(length * stride, 2);
+            double alpha = 0.75;
+
+            double expected = 0;
+            for(int i = 0; i < length; i++)
+                expected += x[i * stride] * y[i * stride];
+            double dot = alglib_impl::ae_v_dotproduct(x.data(), stride, y.data(), stride, length);
+            BOOST_CHECK_SMALL(dot - expected, 1e-12 * (1 + length));
+
+            std::vector<double> scaled(length * stride, 0.0);
+            alglib_impl::ae_v_moved(scaled.data(), stride, x.data(), stride, length, alpha);
+            for(int i = 0; i < length; i++)
+                BOOST_CHECK_EQUAL(scaled[i * stride], alpha * x[i * stride]);
+
+            std::vector<double> sum = y;
+            alglib_impl::ae_v_addd(sum.data(), stride, x.data(), stride, length, alpha);
+            for(int i = 0; i < length; i++)
+                BOOST_CHECK_SMALL(sum[i * stride] - (y[i * stride] + alpha * x[i * stride]), 1e-14);
+        }
+}
+
+// matrix products should match a naive triple loop for sizes that straddle the 32x32 block
+BOOST_AUTO_TEST_CASE(test_gemm_kernels)
+{
+    const int sizes[] = {1, 2, 3, 5, 8, 13, 31, 32, 33};
+    for(int m : sizes)
+        for(int k : {1, 7, 32, 33})
+        {
+            int n = (m % 5) + 3;
+            alglib::real_2d_array a = randomMatrix(m, k, 3);
+            alglib::real_2d_array b = randomMatrix(k, n, 4);
+            alglib::real_2d_array c = randomMatrix(m, n, 5);
+            alglib::real_2d_array expected = randomMatrix(m, n, 5);
+            for(int i = 0; i < m; i++)
+                for(int j = 0; j < n; j++)
+                {
+                    double v = 0;
+                    for(int p = 0; p < k; p++)
+                        v += a[i][p] * b[p][j];
+                    expected[i][j] = 1.5 * v - 0.5 * expected[i][j];
+                }
+
+            alglib::rmatrixgemm(m, n, k, 1.5, a, 0, 0, 0, b, 0, 0, 0, -0.5, c, 0, 0);
+            for(int i = 0; i < m; i++)
+                for(int j = 0; j < n; j++)
+                    BOOST_CHECK_SMALL(c[i][j] - expected[i][j], 1e-11);
+        }
+}
+
+namespace
+{
+    /** Restores the arena setting when a test ends */
+    struct ArenaGuard
+    {
+        explicit ArenaGuard(bool enabled) { alglib_impl::ae_set_arena_enabled(enabled); }
+        ~ArenaGuard() { alglib_impl::ae_set_arena_enabled(true); }
+    };
+
+    alglib_impl::ae_alloc_counters allocCounters()
+    {
+        alglib_impl::ae_alloc_counters counters;
+        alglib_impl::ae_get_alloc_counters(&counters);
+        return counters;
+    }
+
+    alglib::real_1d_array toArray(const std::vector<double>& values)
+    {
+        alglib::real_1d_array result;
+        result.setcontent(values.size(), values.data());
+        return result;
+    }
+}
+
+// once the arena has grown, repeated calls should take all of their temporaries from it
+BOOST_AUTO_TEST_CASE(test_arena_steady_state)
+{
+    alglib::real_1d_array x = toArray(randomVector(1000, 6));
+    alglib::real_1d_array y = toArray(randomVector(1000, 7));
+    ArenaGuard guard(true);
+    double rho = alglib::spearmancorr2(x, y);
+
+    alglib_impl::ae_alloc_counters before = allocCounters();
+    for(int i = 0; i < 20; i++)
+        BOOST_CHECK_EQUAL(alglib::spearmancorr2(x, y), rho);
+    alglib_impl::ae_alloc_counters after = allocCounters();
+    BOOST_CHECK_EQUAL(after.heap_allocations, before.heap_allocations);
+    BOOST_CHECK_EQUAL(after.arena_chunks, before.arena_chunks);
+    BOOST_CHECK_GT(after.arena_allocations, before.arena_allocations);
+
+    // without the arena every call goes to the heap
+    alglib_impl::ae_set_arena_enabled(false);
+    before = allocCounters();
+    BOOST_CHECK_EQUAL(alglib::spearmancorr2(x, y), rho);
+    after = allocCounters();
+    BOOST_CHECK_GT(after.heap_allocations, before.heap_allocations);
+    BOOST_CHECK_EQUAL(after.arena_allocations, before.arena_allocations);
+}
+
+// arena blocks swapped into an outer frame should survive the inner frame and the reuse of its memory
+BOOST_AUTO_TEST_CASE(test_arena_swap)
+{
+    using namespace alglib_impl;
+    ArenaGuard guard(true);
+    ae_state state;
+    ae_frame outer, inner, later;
+    ae_vector kept, temp, junk;
+    ae_matrix keptMatrix, tempMatrix;
+    ae_state_init(&state);
+    ae_frame_make(&state, &outer);
+    ae_vector_init(&kept, 0, DT_REAL, &state, ae_true);
+    ae_matrix_init(&keptMatrix, 0, 0, DT_REAL, &state, ae_true);
+
+    ae_frame_make(&state, &inner);
+    ae_int64_t arenaAllocations = allocCounters().arena_allocations;
+    ae_vector_init(&temp, 100, DT_REAL, &state, ae_true);
+    ae_matrix_init(&tempMatrix, 5, 7, DT_REAL, &state, ae_true);
+    BOOST_CHECK_EQUAL(allocCounters().arena_allocations, arenaAllocations + 2);
+    for(int i = 0; i < 100; i++)
+        temp.ptr.p_double[i] = i;
+    for(int i = 0; i < 5; i++)
+        for(int j = 0; j < 7; j++)
+            tempMatrix.ptr.pp_double[i][j] = 10 * i + j;
+    ae_swap_vectors(&kept, &temp);
+    ae_swap_matrices(&keptMatrix, &tempMatrix);
+    ae_frame_leave(&state);
+
+    ae_frame_make(&state, &later);
+    ae_vector_init(&junk, 2000, DT_REAL, &state, ae_true);
+    for(int i = 0; i < 2000; i++)
+        junk.ptr.p_double[i] = -1;
+    ae_frame_leave(&state);
+
+    BOOST_REQUIRE_EQUAL(kept.cnt, 100);
+    for(int i = 0; i < 100; i++)
+        BOOST_CHECK_EQUAL(kept.ptr.p_double[i], i);
+    BOOST_REQUIRE_EQUAL(keptMatrix.rows, 5);
+    for(int i = 0; i < 5; i++)
+        for(int j = 0; j < 7; j++)
+            BOOST_CHECK_EQUAL(keptMatrix.ptr.pp_double[i][j], 10 * i + j);
+    ae_state_clear(&state);
+}
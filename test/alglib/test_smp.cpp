@@ -0,0 +1,117 @@
+#include <boost/test/unit_test.hpp>
+#include "alglib/smp.h"
+#include "alglib/linalg.h"
+#include "alglib/statistics.h"
+
+#include<atomic>
+#include<random>
+
+namespace
+{
+    alglib::real_2d_array randomMatrix(int rows, int cols, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::normal_distribution<double> distr;
+        alglib::real_2d_array matrix;
+        matrix.setlength(rows, cols);
+        for(int i = 0; i < rows; i++)
+            for(int j = 0; j < cols; j++)
+                matrix[i][j] = distr(generator);
+        return matrix;
+    }
+
+    /** Compares every element, or one triangle if triangle is 1 (upper) or -1 (lower) */
+    double maxDifference(const alglib::real_2d_array& a, const alglib::real_2d_array& b, int triangle = 0)
+    {
+        double result = 0;
+        for(int i = 0; i < a.rows(); i++)
+            for(int j = 0; j < a.cols(); j++)
+                if(triangle == 0 || (triangle > 0 ? j >= i : j <= i))
+                    result = std::max(result, std::fabs(a[i][j] - b[i][j]));
+        return result;
+    }
+
+    /** Restores the default number of workers when a test ends */
+    struct WorkerGuard
+    {
+        WorkerGuard(alglib::ae_int_t nworkers) { alglib::setnworkers(nworkers); }
+        ~WorkerGuard() { alglib::setnworkers(0); }
+    };
+
+    void countLeaves(std::atomic<int>& leaves, int begin, int end, alglib_impl::ae_state* state)
+    {
+        if(end - begin == 1)
+        {
+            leaves++;
+            return;
+        }
+        int mid = (begin + end) / 2;
+        alglib_impl::ae_smp_invoke(
+            [&](alglib_impl::ae_state* s) { countLeaves(leaves, begin, mid, s); },
+            [&](alglib_impl::ae_state* s) { countLeaves(leaves, mid, end, s); },
+            state);
+    }
+}
+
+// recursive tasks should all run, and errors raised by a task should reach the caller
+BOOST_AUTO_TEST_CASE(test_smp_invoke)
+{
+    WorkerGuard guard(4);
+    BOOST_CHECK_EQUAL(alglib_impl::ae_cores_count(), 4);
+
+    alglib_impl::ae_state state;
+    alglib_impl::ae_state_init(&state);
+    std::atomic<int> leaves(0);
+    countLeaves(leaves, 0, 1000, &state);
+    BOOST_CHECK_EQUAL(leaves.load(), 1000);
+
+    bool ran = false;
+    BOOST_CHECK_THROW(alglib_impl::ae_smp_invoke(
+        [&](alglib_impl::ae_state* s) { ran = true; },
+        [](alglib_impl::ae_state* s) { alglib_impl::ae_assert(ae_false, "failed task", s); },
+        &state), alglib_impl::ae_error_type);
+    BOOST_CHECK(ran);
+    BOOST_CHECK_EQUAL(std::string(state.error_msg), "failed task");
+    alglib_impl::ae_state_clear(&state);
+}
+
+// parallel products and correlations should match the serial code
+BOOST_AUTO_TEST_CASE(test_smp_linear_algebra)
+{
+    WorkerGuard guard(4);
+    alglib::real_2d_array a = randomMatrix(300, 200, 1);
+    alglib::real_2d_array b = randomMatrix(200, 250, 2);
+
+    alglib::real_2d_array serial, parallel;
+    serial.setlength(300, 250);
+    parallel.setlength(300, 250);
+    alglib::rmatrixgemm(300, 250, 200, 1.5, a, 0, 0, 0, b, 0, 0, 0, 0.0, serial, 0, 0);
+    alglib::smp_rmatrixgemm(300, 250, 200, 1.5, a, 0, 0, 0, b, 0, 0, 0, 0.0, parallel, 0, 0);
+    BOOST_CHECK_SMALL(maxDifference(serial, parallel), 1e-9);
+
+    alglib::real_2d_array bt = randomMatrix(250, 200, 3);
+    alglib::rmatrixgemm(300, 250, 200, 1.0, a, 0, 0, 0, bt, 0, 0, 1, 0.0, serial, 0, 0);
+    alglib::smp_rmatrixgemm(300, 250, 200, 1.0, a, 0, 0, 0, bt, 0, 0, 1, 0.0, parallel, 0, 0);
+    BOOST_CHECK_SMALL(maxDifference(serial, parallel), 1e-9);
+
+    serial.setlength(200, 200);
+    parallel.setlength(200, 200);
+    for(int upper = 0; upper < 2; upper++)
+    {
+        alglib::rmatrixsyrk(200, 300, 1.0, a, 0, 0, 1, 0.0, serial, 0, 0, upper == 1);
+        alglib::smp_rmatrixsyrk(200, 300, 1.0, a, 0, 0, 1, 0.0, parallel, 0, 0, upper == 1);
+        BOOST_CHECK_SMALL(maxDifference(serial, parallel, upper == 1 ? 1 : -1), 1e-9);
+    }
+
+    alglib::pearsoncorrm(a, serial);
+    alglib::smp_pearsoncorrm(a, parallel);
+    BOOST_CHECK_SMALL(maxDifference(serial, parallel), 1e-12);
+    alglib::covm2(a, a, serial);
+    alglib::smp_covm2(a, a, parallel);
+    BOOST_CHECK_SMALL(maxDifference(serial, parallel), 1e-12);
+
+    // the cross-correlation of a matrix with itself is its correlation matrix
+    alglib::pearsoncorrm(a, serial);
+    alglib::smp_pearsoncorrm2(a, a, parallel);
+    BOOST_CHECK_SMALL(maxDifference(serial, parallel), 1e-12);
+}
@@ -0,0 +1,127 @@
+#include <boost/test/unit_test.hpp>
+#include "io/csv_reader.h"
+#include "dependency_network.h"
+#include "exceptions/conversion.h"
+
+#include<cmath>
+#include<sstream>
+
+namespace
+{
+    std::shared_ptr<depnet::MappedBuffer> textBuffer(const std::string& text)
+    {
+        std::shared_ptr<std::string> owner(new std::string(text));
+        return std::make_shared<depnet::MappedBuffer>(owner->data(), owner->size(), owner);
+    }
+}
+
+// each column should be typed from its values and coded into the training layout
+BOOST_AUTO_TEST_CASE(test_csv_schema_inference)
+{
+    depnet::CsvReader reader;
+    reader.read(textBuffer(
+        "height,smoker,grade,colour\r\n"
+        "1.5,1,3,red\r\n"
+        "2.25e1,0,1,\"blue, dark\"\r\n"
+        "\r\n"
+        "-3,0,2,red\r\n"
+        "100,NA,2,red\r\n"));
+
+    const auto& specs = reader.getVariableSpecs();
+    const auto& data = reader.getData();
+    BOOST_REQUIRE_EQUAL(specs.size(), 4);
+    BOOST_REQUIRE_EQUAL(data.shape()[0], 3);
+
+    double minVal, maxVal;
+    BOOST_CHECK_EQUAL(specs[0]->getName(), "height");
+    BOOST_CHECK(!specs[0]->isDiscrete());
+    specs[0]->getRange(minVal, maxVal);
+    BOOST_CHECK_EQUAL(minVal, -3);
+    BOOST_CHECK_EQUAL(maxVal, 22.5);
+
+    BOOST_CHECK(specs[1]->isBoolean());
+    BOOST_CHECK(specs[1]->isDiscrete());
+    BOOST_CHECK_EQUAL(data[2][1], 0);
+
+    BOOST_CHECK(specs[2]->isOrdinal());
+    BOOST_CHECK_EQUAL(specs[2]->getNumLevels(), 3);
+
+    BOOST_CHECK(specs[3]->isDiscrete() && !specs[3]->isOrdinal() && !specs[3]->isBoolean());
+    BOOST_REQUIRE_EQUAL(specs[3]->getNumLevels(), 2);
+    BOOST_CHECK_EQUAL(specs[3]->getLevels()[0], "blue, dark");
+
+    BOOST_CHECK_EQUAL(data[0][0], 1.5);
+    BOOST_CHECK_EQUAL(data[1][0], 22.5);
+    BOOST_CHECK_EQUAL(data[0][2], 2);
+    BOOST_CHECK_EQUAL(data[1][2], 0);
+    BOOST_CHECK_EQUAL(data[0][3], 1);
+    BOOST_CHECK_EQUAL(data[1][3], 0);
+}
+
+// a file split across several threads should produce the same rows, in order, as a single thread
+BOOST_AUTO_TEST_CASE(test_csv_parallel_chunks)
+{
+    std::ostringstream text;
+    text.precision(17);
+    text << "a\tb\n";
+    for(int row = 0; row < 50000; row++)
+        text << row << "\t" << row * 0.125 << "\n";
+
+    depnet::CsvOptions options;
+    options.numThreads = 4;
+    depnet::CsvReader reader(options);
+    reader.read(textBuffer(text.str()));
+
+    const auto& data = reader.getData();
+    BOOST_REQUIRE_EQUAL(data.shape()[0], 50000);
+    BOOST_REQUIRE_EQUAL(data.shape()[1], 2);
+    for(int row = 0; row < 50000; row++)
+    {
+        BOOST_REQUIRE_EQUAL(data[row][0], row);
+        BOOST_REQUIRE_EQUAL(data[row][1], row * 0.125);
+    }
+    BOOST_CHECK(!reader.getVariableSpecs()[0]->isDiscrete());
+}
+
+// rows with the wrong number of fields should be rejected
+BOOST_AUTO_TEST_CASE(test_csv_ragged_rows)
+{
+    depnet::CsvReader reader;
+    BOOST_CHECK_THROW(reader.read(textBuffer("a,b\n1,2\n3\n")), depnet::ConversionException);
+}
+
+// rows with missing values should be dropped by default, so that the data can be trained on directly,
+// or rejected with the column and row of the first missing value
+BOOST_AUTO_TEST_CASE(test_csv_missing_values)
+{
+    std::ostringstream text;
+    text << "colour,size,grade\n";
+    const char* colours[] = {"red", "green", "blue"};
+    for(int row = 0; row < 60; row++)
+        text << colours[row % 3] << "," << 10 * (row % 3) + (row % 5) / 10.0 << "," << row % 4 << "\n";
+    text << ",4.5,1\nred,NA,2\nblue,12,?\n";
+
+    depnet::CsvReader reader;
+    reader.read(textBuffer(text.str()));
+    const auto& data = reader.getData();
+    BOOST_REQUIRE_EQUAL(data.shape()[0], 60);
+    for(std::size_t row = 0; row < data.shape()[0]; row++)
+        for(std::size_t col = 0; col < data.shape()[1]; col++)
+            BOOST_REQUIRE(!std::isnan(data[row][col]));
+
+    depnet::DependencyNetwork network(reader.getVariableSpecs());
+    network.train(data);
+    BOOST_CHECK_EQUAL(network.getSamples(5)->shape()[0], 5);
+
+    depnet::CsvOptions options;
+    options.missing = depnet::MissingPolicy::Reject;
+    depnet::CsvReader strict(options);
+    try
+    {
+        strict.read(textBuffer(text.str()));
+        BOOST_ERROR("Expected a missing value to be rejected");
+    } catch(const depnet::ConversionException& e)
+    {
+        BOOST_CHECK_EQUAL(std::string(e.what()), "Column colour is missing a value in row 61.");
+    }
+}
@@ -0,0 +1,72 @@
+#include <boost/test/unit_test.hpp>
+#include "io/sample_file.h"
+#include "exceptions/conversion.h"
+
+#include<cstdio>
+#include<string>
+
+namespace
+{
+    void checkRoundTrip(depnet::ColumnCodec codec)
+    {
+        std::string path = "test_sample_file.dnsf";
+        depnet::SampleFileOptions options;
+        options.stripeRows = 64;
+        options.defaultCodec = codec;
+
+        // blocks which straddle stripe boundaries, so that stripes are handed over mid-block
+        {
+            depnet::SampleFileWriter writer(path, std::vector<std::string>{"x", "y"}, options);
+            std::vector<double> block;
+            for(int row = 0; row < 1000; row++)
+            {
+                block.push_back(row);
+                block.push_back(row % 3 - 0.5);
+                if(block.size() == 2 * 37)
+                {
+                    writer.append(block.data(), 37, 2);
+                    block.clear();
+                }
+            }
+            writer.append(block.data(), block.size() / 2, 2);
+            writer.close();
+            BOOST_CHECK_EQUAL(writer.getNumRows(), 1000);
+        }
+
+        depnet::SampleFileReader reader(path);
+        BOOST_REQUIRE_EQUAL(reader.getNumRows(), 1000);
+        BOOST_REQUIRE_EQUAL(reader.getNames().size(), 2);
+        BOOST_CHECK_EQUAL(reader.getNames()[1], "y");
+
+        std::vector<double> y = reader.readColumn(1);
+        boost::multi_array<double, 2> all = reader.readAll();
+        for(int row = 0; row < 1000; row++)
+        {
+            BOOST_REQUIRE_EQUAL(all[row][0], row);
+            BOOST_REQUIRE_EQUAL(all[row][1], row % 3 - 0.5);
+            BOOST_REQUIRE_EQUAL(y[row], row % 3 - 0.5);
+        }
+        std::remove(path.c_str());
+    }
+}
+
+// rows written through the background thread should read back column by column in order
+BOOST_AUTO_TEST_CASE(test_sample_file_round_trip)
+{
+    checkRoundTrip(depnet::ColumnCodec::Raw);
+#ifdef DEPNET_HAVE_ZLIB
+    checkRoundTrip(depnet::ColumnCodec::Deflate);
+#endif
+}
+
+// appending rows of the wrong width should be rejected
+BOOST_AUTO_TEST_CASE(test_sample_file_width)
+{
+    std::string path = "test_sample_file_width.dnsf";
+    {
+        depnet::SampleFileWriter writer(path, std::vector<std::string>{"x"});
+        double row[2] = {1, 2};
+        BOOST_CHECK_THROW(writer.append(row, 1, 2), depnet::ConversionException);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,68 @@
+
+#include <boost/test/unit_test.hpp>
+#include "mcmc/philox_random.h"
+
+#include<cmath>
+
+// the raw block function should match the published Random123 known-answer vector
+BOOST_AUTO_TEST_CASE(test_philox_known_answer)
+{
+    std::uint32_t counter[4] = {0, 0, 0, 0};
+    std::uint32_t key[2] = {0, 0};
+    std::uint32_t out[4];
+    depnet::PhiloxRandom::block(counter, key, out);
+
+    BOOST_CHECK_EQUAL(out[0], 0x6627e8d5u);
+    BOOST_CHECK_EQUAL(out[1], 0xe169c58du);
+    BOOST_CHECK_EQUAL(out[2], 0xbc57ac4cu);
+    BOOST_CHECK_EQUAL(out[3], 0x9b00dbd8u);
+}
+
+// draws should depend only on the seed and stream, and distinct streams should differ
+BOOST_AUTO_TEST_CASE(test_philox_streams)
+{
+    depnet::PhiloxRandom random(42);
+    depnet::RandomStream stream = {3, 17, 5};
+    depnet::RandomStream otherChain = {4, 17, 5};
+
+    double first[5], second[5], other[5];
+    random.uniform(stream, first, 5);
+    depnet::PhiloxRandom(42).uniform(stream, second, 5);
+    random.uniform(otherChain, other, 5);
+
+    for(int i = 0; i < 5; i++)
+    {
+        BOOST_CHECK_EQUAL(first[i], second[i]);
+        BOOST_CHECK(first[i] != other[i]);
+        BOOST_CHECK(first[i] > 0 && first[i] < 1);
+    }
+    BOOST_CHECK_EQUAL(random.uniform(stream), first[0]);
+}
+
+// normal and categorical draws should roughly follow their target distributions
+BOOST_AUTO_TEST_CASE(test_philox_distributions)
+{
+    depnet::PhiloxRandom random(7);
+    depnet::RandomStream stream = {0, 1, 0};
+    const int numDraws = 20000;
+
+    std::vector<double> normals(numDraws);
+    random.normal(stream, 3.0, 2.0, normals.data(), numDraws);
+    double mean = 0, sumSquares = 0;
+    for(int i = 0; i < numDraws; i++)
+        mean += normals[i] / numDraws;
+    for(int i = 0; i < numDraws; i++)
+        sumSquares += (normals[i] - mean) * (normals[i] - mean);
+    BOOST_CHECK_CLOSE(mean, 3.0, 5);
+    BOOST_CHECK_CLOSE(std::sqrt(sumSquares / numDraws), 2.0, 5);
+
+    double weights[3] = {1, 0, 3};
+    std::vector<int> categories(numDraws);
+    random.categorical(stream, weights, 3, categories.data(), numDraws);
+    int counts[3] = {0, 0, 0};
+    for(int i = 0; i < numDraws; i++)
+        counts[categories[i]]++;
+    BOOST_CHECK_EQUAL(counts[1], 0);
+    BOOST_CHECK_CLOSE(counts[2] / (double) numDraws, 0.75, 5);
+}
+
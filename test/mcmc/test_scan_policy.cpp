@@ -0,0 +1,64 @@
+
+#include <boost/test/unit_test.hpp>
+#include "mcmc/scan_policy.h"
+
+// a systematic scan should visit every variable once, in order
+BOOST_AUTO_TEST_CASE(test_systematic_scan)
+{
+    depnet::SystematicScan scan;
+    depnet::PhiloxRandom random(1);
+    depnet::RandomStream stream = {0, 1, 0};
+    std::vector<std::size_t> visits;
+    scan.schedule({1, 1, 1}, random, stream, visits);
+
+    BOOST_REQUIRE_EQUAL(visits.size(), 3);
+    for(std::size_t i = 0; i < visits.size(); i++)
+        BOOST_CHECK_EQUAL(visits[i], i);
+}
+
+// an adaptive scan should favour a slowly mixing, cheap variable over a 
+// fast mixing one, and an expensive variable over neither
+BOOST_AUTO_TEST_CASE(test_adaptive_scan_weights)
+{
+    depnet::AdaptiveScan scan(1000, 0.1);
+    depnet::PhiloxRandom random(1);
+    std::vector<double> costs = {1, 1, 10};
+    std::vector<std::size_t> visits;
+
+    double slow = 0, noise[3];
+    for(std::uint64_t sweep = 1; sweep <= 200; sweep++)
+    {
+        depnet::RandomStream stream = {0, sweep, 0};
+        scan.schedule(costs, random, stream, visits);
+        random.uniform(stream, noise, 3);
+
+        // variable 0 drifts slowly, variable 1 is independent noise, variable 2 drifts slowly but is costly
+        scan.observe(0, slow, slow + noise[0] - 0.5);
+        scan.observe(1, noise[1], noise[2]);
+        scan.observe(2, slow, slow + noise[0] - 0.5);
+        slow += noise[0] - 0.5;
+    }
+
+    BOOST_CHECK_GT(scan.getAutocorrelation(0), 0.8);
+    BOOST_CHECK_LT(scan.getAutocorrelation(1), 0.3);
+
+    std::vector<double> weights;
+    scan.getWeights(costs, weights);
+    BOOST_CHECK_GT(weights[0], weights[1]);
+    BOOST_CHECK_GT(weights[0], weights[2]);
+    BOOST_CHECK_CLOSE(weights[0] + weights[1] + weights[2], 1.0, 1e-6);
+
+    // adaptation state should survive a round trip
+    std::vector<double> state;
+    scan.saveState(state);
+    depnet::AdaptiveScan restored;
+    restored.restoreState(state);
+    BOOST_CHECK_EQUAL(restored.getAutocorrelation(0), scan.getAutocorrelation(0));
+
+    // a clone keeps the settings but starts adapting from scratch
+    std::shared_ptr<depnet::ScanPolicy> clone = scan.clone();
+    std::vector<double> cloneState;
+    clone->saveState(cloneState);
+    BOOST_CHECK_EQUAL(cloneState.size(), 1);
+    BOOST_CHECK_EQUAL(std::dynamic_pointer_cast<depnet::AdaptiveScan>(clone)->getAutocorrelation(0), 0);
+}
@@ -1,11 +1,11 @@
 
 
 #include <boost/test/unit_test.hpp>
-#include "standard_var_spec.h"
+#include "mcmc/standard_gibbs_iterator.h"
 
-// test construction of a variable specification to 
+// test construction of a Gibbs iterator to 
 // ensure reasonable initial defaults
-BOOST_AUTO_TEST_CASE(test_construction)
+BOOST_AUTO_TEST_CASE(test_iterator_construction)
 {
     
     depnet::StandardGibbsIterator varSpec();
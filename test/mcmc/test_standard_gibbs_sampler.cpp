@@ -0,0 +1,240 @@
+
+#include <boost/test/unit_test.hpp>
+#include "mcmc/standard_gibbs_sampler.h"
+#include "standard_var_spec.h"
+#include "exceptions/checkpoint.h"
+#include "exceptions/conversion.h"
+#include "binary_io.h"
+
+#include<sstream>
+
+namespace
+{
+    // a model for a discrete variable with a fixed posterior, independent of its blanket
+    class FixedDensityModel : public depnet::ConditionalModel
+    {
+    public:
+        FixedDensityModel(std::shared_ptr<depnet::VariableSpecification> dep,
+            std::vector<std::shared_ptr<depnet::VariableSpecification> > indep) : dep(dep), indep(indep), calls(0) { }
+
+        const std::vector<std::shared_ptr<depnet::VariableSpecification> > & getIndependentVars() { return indep; }
+        const std::shared_ptr<depnet::VariableSpecification> getDependentVar() { return dep; }
+        void getClassDensity(const std::vector<double>& values, std::vector<double> & posterior) const 
+        {
+            calls++;
+            posterior.assign({0.25, 0.75});
+        }
+        bool supportsClassDensity() { return true; }
+        double predict(const std::vector<double>& values) const { return 1; }
+        void train(const boost::const_multi_array_ref<double, 2>& data, 
+            boost::multi_array<double, 2>::index dependentIndex) { }
+        std::string getModelType() const { return "fixed"; }
+        void save(depnet::binary_io::OffsetStream& out) const { }
+        void load(depnet::binary_io::MemoryReader& in) { }
+
+    private:
+        std::shared_ptr<depnet::VariableSpecification> dep;
+        std::vector<std::shared_ptr<depnet::VariableSpecification> > indep;
+
+    public:
+        /** The number of densities computed, rather than reused by the sampler */
+        mutable int calls;
+    };
+
+    std::map<std::shared_ptr<depnet::VariableSpecification>, std::shared_ptr<depnet::ConditionalModel> > 
+        buildNetwork()
+    {
+        std::shared_ptr<depnet::VariableSpecification> a(new depnet::StandardVariableSpecification());
+        std::shared_ptr<depnet::VariableSpecification> b(new depnet::StandardVariableSpecification());
+        a->setName("a");
+        a->setLevels({"no", "yes"});
+        a->setDiscrete(true);
+        b->setName("b");
+        b->setLevels({"no", "yes"});
+        b->setDiscrete(true);
+
+        std::map<std::shared_ptr<depnet::VariableSpecification>, std::shared_ptr<depnet::ConditionalModel> > network;
+        network[a].reset(new FixedDensityModel(a, {b}));
+        network[b].reset(new FixedDensityModel(b, {a}));
+        return network;
+    }
+
+    std::vector<double> drawSequence(depnet::StandardGibbsSampler& sampler, int numSamples)
+    {
+        std::vector<double> values;
+        for(int i = 0; i < numSamples; i++)
+        {
+            depnet::SampleType sample = sampler.sample();
+            for(auto it = sampler.getSampleOrder().begin(); it != sampler.getSampleOrder().end(); ++it)
+                values.push_back((*sample)[*it]);
+        }
+        return values;
+    }
+}
+
+// samplers with the same seed should produce identical chains, and discrete 
+// variables should be drawn from their posterior rather than fixed at the mode
+BOOST_AUTO_TEST_CASE(test_sampler_reproducible)
+{
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler first(network, 3, boost::none, boost::none, 11);
+    depnet::StandardGibbsSampler second(network, 3, boost::none, boost::none, 11);
+    depnet::StandardGibbsSampler other(network, 3, boost::none, boost::none, 12);
+
+    auto firstValues = drawSequence(first, 300);
+    auto secondValues = drawSequence(second, 300);
+    auto otherValues = drawSequence(other, 300);
+
+    BOOST_CHECK(firstValues == secondValues);
+    BOOST_CHECK(firstValues != otherValues);
+
+    double ones = std::count(firstValues.begin(), firstValues.end(), 1.0);
+    BOOST_CHECK_CLOSE(ones / firstValues.size(), 0.75, 10);
+}
+
+// a sampler resumed from a serialized checkpoint should continue exactly where the original left off
+BOOST_AUTO_TEST_CASE(test_sampler_checkpoint)
+{
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler original(network, 4, boost::none, boost::none, 5);
+    drawSequence(original, 37);
+
+    depnet::SamplerCheckpoint saved;
+    original.saveCheckpoint(saved);
+    std::stringstream stream;
+    saved.write(stream);
+    auto expected = drawSequence(original, 50);
+
+    depnet::SamplerCheckpoint loaded;
+    loaded.read(stream);
+    BOOST_CHECK_EQUAL(loaded.getNumChains(), 4);
+
+    // resuming over a freshly built network with the same variable names
+    depnet::StandardGibbsSampler resumed(buildNetwork(), loaded);
+    BOOST_CHECK(drawSequence(resumed, 50) == expected);
+
+    depnet::StandardGibbsSampler restored(network, 1, boost::none, boost::none, 99);
+    restored.restoreCheckpoint(loaded);
+    BOOST_CHECK(drawSequence(restored, 50) == expected);
+
+    loaded.variableNames[0] = "renamed";
+    BOOST_CHECK_THROW(depnet::StandardGibbsSampler(network, loaded), depnet::CheckpointException);
+}
+
+// corrupt lengths should fail as truncated input, and ambiguous names should never be written
+BOOST_AUTO_TEST_CASE(test_sampler_checkpoint_validation)
+{
+    std::stringstream corrupt;
+    const char magic[4] = {'D', 'N', 'C', 'K'};
+    depnet::binary_io::writeHeader(corrupt, magic, 2);
+    depnet::binary_io::write<std::uint64_t>(corrupt, 5);
+    depnet::binary_io::write<std::uint32_t>(corrupt, 0);
+    depnet::binary_io::write<std::int64_t>(corrupt, 0);
+    depnet::binary_io::write<std::int64_t>(corrupt, 0);
+    depnet::binary_io::write<std::uint32_t>(corrupt, 0);
+    depnet::binary_io::write<std::uint64_t>(corrupt, std::uint64_t(1) << 60);
+    depnet::SamplerCheckpoint loaded;
+    BOOST_CHECK_THROW(loaded.read(corrupt), depnet::ConversionException);
+
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler sampler(network, 1, boost::none, boost::none, 5);
+    depnet::SamplerCheckpoint saved;
+    sampler.saveCheckpoint(saved);
+
+    // a checkpoint without chains would leave nothing to sample
+    depnet::SamplerCheckpoint empty = saved;
+    empty.sweeps.clear();
+    empty.chainStates.clear();
+    std::stringstream emptyStream;
+    empty.write(emptyStream);
+    BOOST_CHECK_THROW(loaded.read(emptyStream), depnet::CheckpointException);
+    BOOST_CHECK_THROW(sampler.restoreCheckpoint(empty), depnet::CheckpointException);
+    BOOST_CHECK_THROW(depnet::StandardGibbsSampler(network, empty), depnet::CheckpointException);
+    saved.variableNames[1] = saved.variableNames[0];
+    std::stringstream stream;
+    BOOST_CHECK_THROW(saved.write(stream), depnet::CheckpointException);
+}
+
+// level codes outside a discrete variable's levels should be rejected before any sampling
+BOOST_AUTO_TEST_CASE(test_sampler_level_codes)
+{
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler original(network, 2, boost::none, boost::none, 5);
+    depnet::SamplerCheckpoint checkpoint;
+    original.saveCheckpoint(checkpoint);
+    checkpoint.chainStates[1] = 2;
+    BOOST_CHECK_THROW(depnet::StandardGibbsSampler(network, checkpoint), depnet::CheckpointException);
+    checkpoint.chainStates[1] = 0.5;
+    BOOST_CHECK_THROW(original.restoreCheckpoint(checkpoint), depnet::CheckpointException);
+
+    std::map<unsigned int, depnet::SampleType> initial;
+    initial[0].reset(new std::map<std::shared_ptr<depnet::VariableSpecification>, double>());
+    for(auto it = network.begin(); it != network.end(); ++it)
+        (*initial[0])[it->first] = 1;
+    depnet::StandardGibbsSampler valid(network, 1, boost::none, initial, 5);
+    (*initial[0])[network.begin()->first] = -1;
+    BOOST_CHECK_THROW(depnet::StandardGibbsSampler(network, 1, boost::none, initial, 5), std::invalid_argument);
+}
+
+// random and adaptive scans should stay reproducible for a given seed
+BOOST_AUTO_TEST_CASE(test_sampler_scan_policy)
+{
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler first(network, 2, boost::none, boost::none, 3);
+    depnet::StandardGibbsSampler second(network, 2, boost::none, boost::none, 3);
+    first.setScanPolicy(std::make_shared<depnet::AdaptiveScan>(20));
+    second.setScanPolicy(std::make_shared<depnet::AdaptiveScan>(20));
+    BOOST_CHECK(drawSequence(first, 100) == drawSequence(second, 100));
+
+    first.setScanPolicy(std::make_shared<depnet::RandomScan>());
+    second.setScanPolicy(std::make_shared<depnet::RandomScan>());
+    BOOST_CHECK(drawSequence(first, 100) == drawSequence(second, 100));
+
+    // an adaptive scan should resume the same way whether the checkpoint is restored or constructed from
+    first.setScanPolicy(std::make_shared<depnet::AdaptiveScan>(1000));
+    drawSequence(first, 50);
+    depnet::SamplerCheckpoint checkpoint;
+    first.saveCheckpoint(checkpoint);
+    second.setScanPolicy(std::make_shared<depnet::AdaptiveScan>(1000));
+    second.restoreCheckpoint(checkpoint);
+    depnet::StandardGibbsSampler resumed(network, checkpoint);
+    resumed.setScanPolicy(std::make_shared<depnet::AdaptiveScan>(1000));
+    BOOST_CHECK(drawSequence(resumed, 100) == drawSequence(second, 100));
+}
+
+
+// updates whose Markov blanket is unchanged should reuse the previous density without altering the chain,
+// and every update should be either a prediction or a cache hit
+BOOST_AUTO_TEST_CASE(test_sampler_prediction_cache)
+{
+    auto network = buildNetwork();
+    depnet::StandardGibbsSampler sampler(network, 2, boost::none, boost::none, 3);
+    auto values = drawSequence(sampler, 200);
+
+    int calls = 0;
+    std::uint64_t hits = 0;
+    for(auto it = network.begin(); it != network.end(); ++it)
+    {
+        calls += static_cast<FixedDensityModel&>(*it->second).calls;
+        hits += sampler.getCacheHits(it->first);
+    }
+    BOOST_CHECK(hits > 0);
+    BOOST_CHECK_EQUAL(calls + hits, 400);
+
+    // the chain is the same as one drawn with every density recomputed
+    auto fresh = buildNetwork();
+    depnet::StandardGibbsSampler other(fresh, 2, boost::none, boost::none, 3);
+    BOOST_CHECK(drawSequence(other, 200) == values);
+
+    for(int i = 0; i < 3; i++)
+    {
+        sampler.sample();
+        sampler.acceptSample();
+    }
+    auto chains = sampler.getChainMetrics();
+    BOOST_CHECK_EQUAL(chains.size(), 2);
+    BOOST_CHECK_EQUAL(chains[0].sweeps, 102);
+    BOOST_CHECK_EQUAL(chains[1].sweeps, 101);
+    BOOST_CHECK_EQUAL(chains[0].acceptedSamples, 2);
+    BOOST_CHECK_EQUAL(chains[1].acceptedSamples, 1);
+}
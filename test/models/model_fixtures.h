@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef MODEL_FIXTURES_H
+#define MODEL_FIXTURES_H
+
+#include "models/conditional_model.h"
+#include "standard_var_spec.h"
+#include "binary_io.h"
+#include "mapped_buffer.h"
+
+#include<memory>
+#include<sstream>
+#include<string>
+
+/**
+ * Variables and round trips shared by the conditional model tests
+ */
+namespace model_fixtures
+{
+    /**
+     * Creates a continuous variable
+     */
+    inline std::shared_ptr<depnet::VariableSpecification> continuous()
+    {
+        return std::make_shared<depnet::StandardVariableSpecification>();
+    }
+
+    /**
+     * Creates a strictly discrete variable with the levels red, green and blue
+     */
+    inline std::shared_ptr<depnet::VariableSpecification> color()
+    {
+        std::shared_ptr<depnet::VariableSpecification> color(new depnet::StandardVariableSpecification());
+        color->setLevels({"red", "green", "blue"});
+        color->setDiscrete(true);
+        return color;
+    }
+
+    /**
+     * Saves a model into a buffer, which can be read back as many times as needed with a MemoryReader
+     */
+    inline std::shared_ptr<const depnet::MappedBuffer> save(const depnet::ConditionalModel& model)
+    {
+        std::ostringstream saved;
+        depnet::binary_io::OffsetStream out(saved);
+        model.save(out);
+        std::shared_ptr<std::string> bytes(new std::string(saved.str()));
+        return std::make_shared<depnet::MappedBuffer>(bytes->data(), bytes->size(), bytes);
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/boosted_model.h"
+#include "model_fixtures.h"
+#include "exceptions/conversion.h"
+
+#include<cmath>
+
+// boosted regression trees should fit a nonlinear function of two variables,
+// and a discrete independent variable should be split on its level
+BOOST_AUTO_TEST_CASE(test_boosted_regression)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+    std::shared_ptr<depnet::VariableSpecification> y = model_fixtures::continuous();
+
+    boost::multi_array<double, 2> data(boost::extents[1000][3]);
+    for(int i = 0; i < 1000; i++)
+    {
+        data[i][0] = (i % 200) / 20.0;
+        data[i][1] = i % 3;
+        data[i][2] = std::sin(data[i][0]) * 5 + (i % 3 == 1 ? 10 : 0);
+    }
+
+    depnet::BoostedTreeModel model({x, color}, y, 200, 4, 0.1, 64, 2);
+    model.train(data, 2);
+    BOOST_CHECK_EQUAL(model.getModelType(), "gbt");
+    BOOST_CHECK(!model.supportsClassDensity());
+    BOOST_CHECK_SMALL(model.predict({1.5, 0}) - std::sin(1.5) * 5, 0.5);
+    BOOST_CHECK_SMALL(model.predict({4.5, 1}) - (std::sin(4.5) * 5 + 10), 0.5);
+
+    depnet::VariableMetrics metrics;
+    model.getMetrics(metrics);
+    BOOST_CHECK_LE(metrics.maxDepth, 5);
+    BOOST_CHECK(metrics.numNodes > 200);
+
+    // training with a single thread should build identical trees
+    depnet::BoostedTreeModel serial({x, color}, y, 200, 4, 0.1, 64, 1);
+    serial.train(data, 2);
+    BOOST_CHECK_EQUAL(serial.predict({2.2, 2}), model.predict({2.2, 2}));
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::BoostedTreeModel loaded({x, color}, y);
+    loaded.load(in);
+    BOOST_CHECK_EQUAL(loaded.predict({3.3, 1}), model.predict({3.3, 1}));
+    BOOST_CHECK_EQUAL(loaded.getPredictCost(), model.getPredictCost());
+}
+
+// a discrete variable should be fit with a softmax over one tree per level in each round
+BOOST_AUTO_TEST_CASE(test_boosted_classification)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+
+    // green in the middle of the range, so no single linear boundary separates it
+    boost::multi_array<double, 2> data(boost::extents[600][2]);
+    for(int i = 0; i < 600; i++)
+    {
+        data[i][0] = (i % 100) / 10.0;
+        data[i][1] = data[i][0] < 3 || data[i][0] >= 7 ? (data[i][0] < 3 ? 0 : 2) : 1;
+    }
+
+    depnet::BoostedTreeModel model({x}, color, 50);
+    model.train(data, 1);
+    BOOST_CHECK(model.supportsClassDensity());
+
+    std::vector<double> posterior;
+    model.getClassDensity({5}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 3);
+    BOOST_CHECK_CLOSE(posterior[0] + posterior[1] + posterior[2], 1.0, 1e-6);
+    BOOST_CHECK(posterior[1] > 0.9);
+    BOOST_CHECK_EQUAL(model.predict({1}), 0);
+    BOOST_CHECK_EQUAL(model.predict({9}), 2);
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    std::shared_ptr<depnet::VariableSpecification> flag(new depnet::StandardVariableSpecification());
+    flag->setDiscrete(true);
+    flag->setBoolean(true);
+    depnet::BoostedTreeModel mismatched({x}, flag);
+    BOOST_CHECK_THROW(mismatched.load(in), depnet::ConversionException);
+}
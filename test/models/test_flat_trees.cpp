@@ -0,0 +1,45 @@
+#include <boost/test/unit_test.hpp>
+#include "models/flat_trees.h"
+#include "exceptions/conversion.h"
+
+#include<vector>
+
+// trees whose features, classes or offsets leave their array should be rejected before anything walks them
+BOOST_AUTO_TEST_CASE(test_flat_trees_validate)
+{
+    // a split on feature 0 at 0.5, with leaves holding 1 and 2
+    std::vector<double> tree = {8, 0, 0.5, 6, -1, 1, -1, 2};
+    depnet::flat_trees::validate(tree.data(), tree.size(), 1, 1, 0);
+    depnet::flat_trees::validate(tree.data(), tree.size(), 1, 1, 3);
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(tree.data(), tree.size(), 1, 1, 2), depnet::ConversionException);
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(tree.data(), tree.size(), 2, 1, 0), depnet::ConversionException);
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(tree.data(), tree.size() - 1, 1, 1, 0), depnet::ConversionException);
+
+    std::vector<double> corrupt = tree;
+    corrupt[1] = 1;
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(corrupt.data(), corrupt.size(), 1, 1, 0), depnet::ConversionException);
+    corrupt[1] = 0.5;
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(corrupt.data(), corrupt.size(), 1, 1, 0), depnet::ConversionException);
+
+    // right children must follow their parent and stay inside the tree
+    corrupt = tree;
+    corrupt[3] = 1;
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(corrupt.data(), corrupt.size(), 1, 1, 0), depnet::ConversionException);
+    corrupt[3] = 8;
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(corrupt.data(), corrupt.size(), 1, 1, 0), depnet::ConversionException);
+    corrupt = tree;
+    corrupt[0] = 100;
+    BOOST_CHECK_THROW(depnet::flat_trees::validate(corrupt.data(), corrupt.size(), 1, 1, 0), depnet::ConversionException);
+}
+
+// every node of every tree should be counted, with the root at depth 1
+BOOST_AUTO_TEST_CASE(test_flat_trees_measure)
+{
+    // a split whose right child splits again, followed by a single leaf
+    std::vector<double> trees = {13, 0, 0.5, 6, -1, 1, 1, 0.2, 11, -1, 2, -1, 3, 3, -1, 4};
+    depnet::VariableMetrics metrics;
+    depnet::flat_trees::measure(trees.data(), 2, metrics);
+    BOOST_CHECK_EQUAL(metrics.numNodes, 6);
+    BOOST_CHECK_EQUAL(metrics.maxDepth, 3);
+    depnet::flat_trees::validate(trees.data(), trees.size(), 2, 2, 0);
+}
@@ -0,0 +1,125 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/knn_model.h"
+#include "model_fixtures.h"
+#include "dependency_network.h"
+#include "exceptions/conversion.h"
+
+#include<set>
+#include<thread>
+
+// the value density should consist of the values of the nearest training instances, 
+// and predictions should be their mean
+BOOST_AUTO_TEST_CASE(test_knn_value_density)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> y = model_fixtures::continuous();
+
+    boost::multi_array<double, 2> data(boost::extents[100][2]);
+    for(int i = 0; i < 100; i++)
+    {
+        data[i][0] = i;
+        data[i][1] = 1000 + i;
+    }
+
+    depnet::KnnConditionalModel model({x}, y, 3);
+    model.train(data, 1);
+    BOOST_CHECK_EQUAL(model.getModelType(), "knn");
+    BOOST_CHECK(!model.supportsClassDensity());
+    BOOST_CHECK(model.supportsValueDensity());
+
+    std::vector<double> values, weights;
+    model.getValueDensity({50.2}, values, weights);
+    BOOST_REQUIRE_EQUAL(values.size(), 3);
+    BOOST_CHECK_EQUAL(weights.size(), 3);
+    BOOST_CHECK(std::set<double>(values.begin(), values.end()) == std::set<double>({1049, 1050, 1051}));
+    BOOST_CHECK_CLOSE(model.predict({50.2}), 1050, 1e-6);
+
+    // a batch should match individual predictions
+    boost::multi_array<double, 2> batch(boost::extents[3][1]);
+    batch[0][0] = 0;
+    batch[1][0] = 20.4;
+    batch[2][0] = 99;
+    double out[3];
+    model.predictBatch(batch, out);
+    for(int row = 0; row < 3; row++)
+        BOOST_CHECK_EQUAL(out[row], model.predict({batch[row][0]}));
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::KnnConditionalModel loaded({x}, y);
+    loaded.load(in);
+    BOOST_CHECK_EQUAL(loaded.predict({20.4}), model.predict({20.4}));
+
+    depnet::binary_io::MemoryReader again(saved);
+    depnet::KnnConditionalModel mismatched({x, x}, y);
+    BOOST_CHECK_THROW(mismatched.load(again), depnet::ConversionException);
+}
+
+// a discrete variable's class density should be the frequency of each level among the neighbours,
+// and concurrent queries should not interfere with one another
+BOOST_AUTO_TEST_CASE(test_knn_class_density)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+
+    boost::multi_array<double, 2> data(boost::extents[300][2]);
+    for(int i = 0; i < 300; i++)
+    {
+        data[i][0] = i % 100;
+        data[i][1] = (i % 100) / 34;
+    }
+
+    depnet::KnnConditionalModel model({x}, color, 4);
+    model.train(data, 1);
+    std::vector<double> posterior;
+    model.getClassDensity({10}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 3);
+    BOOST_CHECK_CLOSE(posterior[0], 1.0, 1e-6);
+    BOOST_CHECK_EQUAL(model.predict({90}), 2);
+
+    std::vector<int> mismatches(4, 0);
+    std::vector<std::thread> threads;
+    for(int thread = 0; thread < 4; thread++)
+    {
+        threads.push_back(std::thread([&, thread]() {
+            for(int i = 0; i < 500; i++)
+            {
+                double value = (i * 7 + thread) % 100;
+                if(model.predict({value}) != static_cast<int>(value) / 34)
+                    mismatches[thread]++;
+            }
+        }));
+    }
+    for(auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+    for(int thread = 0; thread < 4; thread++)
+        BOOST_CHECK_LE(mismatches[thread], 20);
+}
+
+// a network of nearest-neighbour models should only sample values seen during training
+BOOST_AUTO_TEST_CASE(test_knn_network_samples)
+{
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    factory->setDefaultModelType("knn");
+    std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
+    varSpecs.push_back(factory->createVariableSpec());
+    varSpecs.back()->setName("x");
+    varSpecs.push_back(factory->createVariableSpec());
+    varSpecs.back()->setName("y");
+
+    boost::multi_array<double, 2> data(boost::extents[50][2]);
+    std::set<double> observed;
+    for(int i = 0; i < 50; i++)
+    {
+        data[i][0] = i;
+        data[i][1] = i * 0.5 + (i % 3);
+        observed.insert(data[i][1]);
+    }
+
+    depnet::DependencyNetwork network(varSpecs, factory);
+    network.train(data);
+    auto samples = network.getSamples(10);
+    for(int row = 0; row < 10; row++)
+        BOOST_CHECK(observed.count((*samples)[row][1]) == 1);
+}
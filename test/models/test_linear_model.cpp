@@ -0,0 +1,55 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/linear_model.h"
+#include "model_fixtures.h"
+
+#include<random>
+
+// a continuous variable should recover the coefficients of a linear relationship,
+// with strictly discrete independent variables contributing one coefficient per level
+BOOST_AUTO_TEST_CASE(test_linear_model)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+    std::shared_ptr<depnet::VariableSpecification> y = model_fixtures::continuous();
+
+    boost::multi_array<double, 2> data(boost::extents[300][3]);
+    std::default_random_engine generator;
+    std::normal_distribution<double> noise(0.0, 0.01);
+    for(int i = 0; i < 300; i++)
+    {
+        data[i][0] = i / 30.0;
+        data[i][1] = i % 3;
+        data[i][2] = 1 + 2 * data[i][0] + (i % 3 == 2 ? 5 : 0) + noise(generator);
+    }
+
+    depnet::LinearConditionalModel model({x, color}, y);
+    model.train(data, 2);
+    BOOST_CHECK_EQUAL(model.getModelType(), "linear");
+    BOOST_CHECK(!model.supportsClassDensity());
+    BOOST_CHECK_CLOSE(model.predict({4, 0}), 9, 1);
+    BOOST_CHECK_CLOSE(model.predict({4, 2}), 14, 1);
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::LinearConditionalModel loaded({x, color}, y);
+    loaded.load(in);
+    BOOST_CHECK_EQUAL(loaded.predict({3.5, 1}), model.predict({3.5, 1}));
+}
+
+// too few rows to fit every coefficient should leave a model predicting the mean
+BOOST_AUTO_TEST_CASE(test_linear_model_mean)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> y = model_fixtures::continuous();
+
+    boost::multi_array<double, 2> data(boost::extents[2][2]);
+    data[0][0] = 0;
+    data[0][1] = 1;
+    data[1][0] = 1;
+    data[1][1] = 3;
+
+    depnet::LinearConditionalModel model({x}, y);
+    model.train(data, 1);
+    BOOST_CHECK_CLOSE(model.predict({10}), 2, 1e-6);
+}
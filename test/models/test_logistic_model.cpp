@@ -0,0 +1,71 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/logistic_model.h"
+#include "model_fixtures.h"
+#include "exceptions/conversion.h"
+
+
+// a discrete variable should be classified by its log-odds, with one posterior entry per level
+BOOST_AUTO_TEST_CASE(test_logistic_model)
+{
+    std::shared_ptr<depnet::VariableSpecification> size = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+
+    // red for small sizes, green for middling sizes and blue for large sizes, with some overlap
+    boost::multi_array<double, 2> data(boost::extents[300][2]);
+    for(int i = 0; i < 300; i++)
+    {
+        data[i][0] = (i % 100) / 10.0;
+        data[i][1] = data[i][0] < 3 ? 0 : (data[i][0] < 7 ? 1 : 2);
+        if(i % 17 == 0)
+            data[i][1] = (static_cast<int>(data[i][1]) + 1) % 3;
+    }
+
+    depnet::LogisticConditionalModel model({size}, color);
+    model.train(data, 1);
+    BOOST_CHECK_EQUAL(model.getModelType(), "logistic");
+    BOOST_CHECK(model.supportsClassDensity());
+
+    std::vector<double> posterior;
+    model.getClassDensity({5}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 3);
+    BOOST_CHECK_CLOSE(posterior[0] + posterior[1] + posterior[2], 1.0, 1e-6);
+    BOOST_CHECK_EQUAL(model.predict({0.5}), 0);
+    BOOST_CHECK_EQUAL(model.predict({5}), 1);
+    BOOST_CHECK_EQUAL(model.predict({9.5}), 2);
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::LogisticConditionalModel loaded({size}, color);
+    loaded.load(in);
+    std::vector<double> restored;
+    loaded.getClassDensity({5}, restored);
+    BOOST_CHECK(restored == posterior);
+
+    // a model over different variables should refuse the saved coefficients
+    depnet::binary_io::MemoryReader again(saved);
+    depnet::LogisticConditionalModel mismatched({size, size}, color);
+    BOOST_CHECK_THROW(mismatched.load(again), depnet::ConversionException);
+}
+
+// too few rows to fit every coefficient should leave a model predicting the frequency of each level
+BOOST_AUTO_TEST_CASE(test_logistic_model_frequencies)
+{
+    std::shared_ptr<depnet::VariableSpecification> size = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> flag(new depnet::StandardVariableSpecification());
+    flag->setDiscrete(true);
+    flag->setBoolean(true);
+
+    boost::multi_array<double, 2> data(boost::extents[2][2]);
+    data[0][0] = 0;
+    data[0][1] = 1;
+    data[1][0] = 1;
+    data[1][1] = 1;
+
+    depnet::LogisticConditionalModel model({size}, flag);
+    model.train(data, 1);
+    std::vector<double> posterior;
+    model.getClassDensity({0}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 2);
+    BOOST_CHECK_CLOSE(posterior[1], 0.75, 1e-6);
+}
@@ -0,0 +1,120 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/rdf_model.h"
+#include "model_fixtures.h"
+#include "exceptions/conversion.h"
+
+#include<cmath>
+#include<limits>
+#include<random>
+#include<string>
+
+// a discrete dependent variable should be trained as a classifier with one posterior entry per level,
+// and strictly discrete independent variables should be one-hot encoded at prediction time
+BOOST_AUTO_TEST_CASE(test_rdf_class_density)
+{
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+    std::shared_ptr<depnet::VariableSpecification> size = model_fixtures::continuous();
+
+    boost::multi_array<double, 2> data(boost::extents[90][2]);
+    for(int i = 0; i < 90; i++)
+    {
+        data[i][0] = i % 3;
+        data[i][1] = 10 * (i % 3) + (i % 5) / 10.0;
+    }
+
+    depnet::RandomForestModel colorModel({size}, color, 0.5, 20);
+    colorModel.train(data, 0);
+
+    std::vector<double> posterior;
+    colorModel.getClassDensity({20.2}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 3);
+    BOOST_CHECK_CLOSE(posterior[0] + posterior[1] + posterior[2], 1.0, 1e-6);
+    BOOST_CHECK_EQUAL(colorModel.predict({20.2}), 2);
+
+    depnet::RandomForestModel sizeModel({color}, size, 0.5, 20);
+    sizeModel.train(data, 1);
+    BOOST_CHECK_CLOSE(sizeModel.predict({1}), 10.1, 5);
+
+    // codes outside the levels, including missing values, should leave every level feature unset
+    sizeModel.predict({3});
+    sizeModel.predict({std::numeric_limits<double>::quiet_NaN()});
+}
+
+
+// strictly discrete independent variables with many levels should be coded as a single ranked feature,
+// which still separates levels by their outcome
+BOOST_AUTO_TEST_CASE(test_rdf_native_levels)
+{
+    std::vector<std::string> levels;
+    for(int level = 0; level < 500; level++)
+        levels.push_back("id" + std::to_string(level));
+    std::shared_ptr<depnet::VariableSpecification> id(new depnet::StandardVariableSpecification());
+    id->setLevels(levels);
+    id->setDiscrete(true);
+    std::shared_ptr<depnet::VariableSpecification> score = model_fixtures::continuous();
+
+    // levels alternate between low and high scores, so their codes carry no order
+    boost::multi_array<double, 2> data(boost::extents[5000][2]);
+    for(int i = 0; i < 5000; i++)
+    {
+        data[i][0] = (i * 7) % 500;
+        data[i][1] = ((i * 7) % 500) % 2 == 0 ? 0 : 10;
+    }
+
+    depnet::RandomForestModel scoreModel({id}, score, 0.5, 20, 32);
+    scoreModel.train(data, 1);
+    BOOST_CHECK_SMALL(scoreModel.predict({124}), 1.0);
+    BOOST_CHECK_CLOSE(scoreModel.predict({125}), 10, 10);
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(scoreModel);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::RandomForestModel loaded({id}, score, 0.5, 20);
+    loaded.load(in);
+    BOOST_CHECK_EQUAL(loaded.predict({125}), scoreModel.predict({125}));
+
+    // a forest is only loaded over variables encoded into as many features as it was trained on
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+    depnet::binary_io::MemoryReader again(saved);
+    depnet::RandomForestModel mismatched({color}, score, 0.5, 20);
+    BOOST_CHECK_THROW(mismatched.load(again), depnet::ConversionException);
+}
+
+// ranks computed on the rows a forest trains on would let it memorize outcomes of rare levels,
+// so a level carrying no signal should not predict its own training rows
+BOOST_AUTO_TEST_CASE(test_rdf_out_of_fold_ranks)
+{
+    std::vector<std::string> levels;
+    for(int level = 0; level < 1000; level++)
+        levels.push_back("id" + std::to_string(level));
+    std::shared_ptr<depnet::VariableSpecification> id(new depnet::StandardVariableSpecification());
+    id->setLevels(levels);
+    id->setDiscrete(true);
+    std::shared_ptr<depnet::VariableSpecification> noise = model_fixtures::continuous();
+
+    std::mt19937 generator(7);
+    std::normal_distribution<double> distr;
+    boost::multi_array<double, 2> data(boost::extents[3000][2]);
+    for(int i = 0; i < 3000; i++)
+    {
+        data[i][0] = i % 1000;
+        data[i][1] = distr(generator);
+    }
+
+    depnet::RandomForestModel model({id}, noise, 0.5, 20);
+    model.train(data, 1);
+    double sumPredicted = 0, sumTarget = 0, sumProduct = 0, sumPredictedSq = 0, sumTargetSq = 0;
+    for(int i = 0; i < 3000; i++)
+    {
+        double predicted = model.predict({data[i][0]});
+        sumPredicted += predicted;
+        sumTarget += data[i][1];
+        sumProduct += predicted * data[i][1];
+        sumPredictedSq += predicted * predicted;
+        sumTargetSq += data[i][1] * data[i][1];
+    }
+    double covariance = sumProduct / 3000 - sumPredicted / 3000 * sumTarget / 3000;
+    double correlation = covariance / std::sqrt((sumPredictedSq / 3000 - std::pow(sumPredicted / 3000, 2)) * 
+        (sumTargetSq / 3000 - std::pow(sumTarget / 3000, 2)));
+    BOOST_CHECK_LT(correlation, 0.25);
+}
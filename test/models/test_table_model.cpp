@@ -0,0 +1,70 @@
+
+#include <boost/test/unit_test.hpp>
+#include "models/table_model.h"
+#include "model_fixtures.h"
+#include "exceptions/conversion.h"
+
+
+// each combination of independent levels should hold the smoothed frequencies of the dependent levels,
+// and combinations with an unknown level should fall back to the marginal distribution
+BOOST_AUTO_TEST_CASE(test_table_model)
+{
+    std::shared_ptr<depnet::VariableSpecification> color = model_fixtures::color();
+    std::shared_ptr<depnet::VariableSpecification> flag(new depnet::StandardVariableSpecification());
+    flag->setDiscrete(true);
+    flag->setBoolean(true);
+    std::shared_ptr<depnet::VariableSpecification> size(new depnet::StandardVariableSpecification());
+    size->setLevels({"small", "large"});
+    size->setDiscrete(true);
+
+    // large exactly when the color is blue and the flag is set
+    boost::multi_array<double, 2> data(boost::extents[60][3]);
+    for(int i = 0; i < 60; i++)
+    {
+        data[i][0] = i % 3;
+        data[i][1] = (i / 3) % 2;
+        data[i][2] = data[i][0] == 2 && data[i][1] == 1 ? 1 : 0;
+    }
+
+    BOOST_CHECK_EQUAL(depnet::TableConditionalModel::getTableBytes({color, flag}, size), 3 * 2 * 2 * sizeof(double));
+    depnet::TableConditionalModel model({color, flag}, size, 1.0);
+    model.train(data, 2);
+    BOOST_CHECK_EQUAL(model.getModelType(), "cpt");
+
+    // each combination appears 10 times
+    std::vector<double> posterior;
+    model.getClassDensity({2, 1}, posterior);
+    BOOST_REQUIRE_EQUAL(posterior.size(), 2);
+    BOOST_CHECK_CLOSE(posterior[1], 11.0 / 12.0, 1e-6);
+    BOOST_CHECK_EQUAL(model.predict({2, 1}), 1);
+    BOOST_CHECK_EQUAL(model.predict({2, 0}), 0);
+
+    model.getClassDensity({5, 1}, posterior);
+    BOOST_CHECK_CLOSE(posterior[1], 11.0 / 62.0, 1e-6);
+
+    std::shared_ptr<const depnet::MappedBuffer> saved = model_fixtures::save(model);
+    depnet::binary_io::MemoryReader in(saved);
+    depnet::TableConditionalModel loaded({color, flag}, size);
+    loaded.load(in);
+    std::vector<double> restored;
+    loaded.getClassDensity({2, 1}, restored);
+    model.getClassDensity({2, 1}, posterior);
+    BOOST_CHECK(restored == posterior);
+
+    depnet::binary_io::MemoryReader again(saved);
+    depnet::TableConditionalModel mismatched({color}, size);
+    BOOST_CHECK_THROW(mismatched.load(again), depnet::ConversionException);
+}
+
+// a table needs discrete variables with known levels
+BOOST_AUTO_TEST_CASE(test_table_model_requires_levels)
+{
+    std::shared_ptr<depnet::VariableSpecification> x = model_fixtures::continuous();
+    std::shared_ptr<depnet::VariableSpecification> flag(new depnet::StandardVariableSpecification());
+    flag->setDiscrete(true);
+    flag->setBoolean(true);
+
+    BOOST_CHECK_EQUAL(depnet::TableConditionalModel::getTableBytes({x}, flag), 0);
+    BOOST_CHECK_EQUAL(depnet::TableConditionalModel::getTableBytes({flag}, x), 0);
+    BOOST_CHECK_THROW(depnet::TableConditionalModel({x}, flag), depnet::ConversionException);
+}
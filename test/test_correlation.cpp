@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+#include "correlation.h"
+#include "alglib/statistics.h"
+
+#include<algorithm>
+#include<cmath>
+#include<random>
+
+namespace
+{
+    /** Columns which share a few latent factors, plus one constant column */
+    boost::multi_array<double, 2> factorData(int rows, int cols)
+    {
+        std::mt19937 generator(7);
+        std::normal_distribution<double> distr;
+        boost::multi_array<double, 2> data(boost::extents[rows][cols]);
+        for(int i = 0; i < rows; i++)
+        {
+            double factors[3] = {distr(generator), distr(generator), distr(generator)};
+            for(int j = 0; j < cols; j++)
+                data[i][j] = (j + 1) * factors[j % 3] + distr(generator) + j;
+            data[i][cols / 2] = 4.0;
+        }
+        return data;
+    }
+
+    alglib::real_2d_array toAlglib(const boost::multi_array<double, 2>& data)
+    {
+        alglib::real_2d_array result;
+        result.setlength(data.shape()[0], data.shape()[1]);
+        for(std::size_t i = 0; i < data.shape()[0]; i++)
+            for(std::size_t j = 0; j < data.shape()[1]; j++)
+                result[i][j] = data[i][j];
+        return result;
+    }
+}
+
+// tiled matrices should match alglib's for tiles which do and do not divide the number of columns
+BOOST_AUTO_TEST_CASE(test_correlation_matrices)
+{
+    boost::multi_array<double, 2> data = factorData(300, 20);
+    alglib::real_2d_array x = toAlglib(data);
+    alglib::real_2d_array expectedCorr, expectedCov;
+    alglib::pearsoncorrm(x, expectedCorr);
+    alglib::covm(x, expectedCov);
+
+    for(std::size_t blockSize : {3, 7, 20, 256})
+    {
+        depnet::CorrelationOptions options;
+        options.blockSize = blockSize;
+        options.numThreads = 2;
+        depnet::ColumnCorrelations correlations(data, options);
+        BOOST_CHECK_EQUAL(correlations.getNumColumns(), 20);
+
+        boost::multi_array<double, 2> corr, cov;
+        correlations.correlation(corr);
+        correlations.covariance(cov);
+        for(int i = 0; i < 20; i++)
+            for(int j = 0; j < 20; j++)
+            {
+                if(i != 10 && j != 10)
+                    BOOST_CHECK_SMALL(corr[i][j] - expectedCorr[i][j], 1e-12);
+                else
+                    BOOST_CHECK_EQUAL(corr[i][j], 0);
+                BOOST_CHECK_SMALL(cov[i][j] - expectedCov[i][j], 1e-9 * (1 + std::fabs(expectedCov[i][j])));
+            }
+    }
+}
+
+// single precision accumulation should keep about six digits
+BOOST_AUTO_TEST_CASE(test_correlation_single_precision)
+{
+    boost::multi_array<double, 2> data = factorData(1000, 12);
+    depnet::CorrelationOptions options;
+    options.blockSize = 5;
+    boost::multi_array<double, 2> expected, corr;
+    depnet::ColumnCorrelations(data).correlation(expected);
+
+    options.singlePrecision = true;
+    depnet::ColumnCorrelations(data, options).correlation(corr);
+    for(int i = 0; i < 12; i++)
+        for(int j = 0; j < 12; j++)
+        {
+            BOOST_CHECK_SMALL(corr[i][j] - expected[i][j], 1e-5);
+            BOOST_CHECK_EQUAL(corr[i][j], corr[j][i]);
+        }
+}
+
+// the top correlations of each column should be the strongest entries of its row in the full matrix
+BOOST_AUTO_TEST_CASE(test_top_correlations)
+{
+    boost::multi_array<double, 2> data = factorData(200, 17);
+    boost::multi_array<double, 2> corr;
+    depnet::ColumnCorrelations(data).correlation(corr);
+
+    for(bool singlePrecision : {false, true})
+    {
+        depnet::CorrelationOptions options;
+        options.blockSize = 4;
+        options.numThreads = 3;
+        options.singlePrecision = singlePrecision;
+        depnet::ColumnCorrelations correlations(data, options);
+        BOOST_CHECK(correlations.topCorrelations(0)[0].empty());
+
+        std::vector<std::vector<depnet::CorrelatedColumn> > top = correlations.topCorrelations(3);
+        BOOST_REQUIRE_EQUAL(top.size(), 17);
+        for(std::size_t col = 0; col < 17; col++)
+        {
+            std::vector<double> strengths;
+            for(std::size_t other = 0; other < 17; other++)
+                if(other != col)
+                    strengths.push_back(std::fabs(corr[col][other]));
+            std::sort(strengths.rbegin(), strengths.rend());
+
+            BOOST_REQUIRE_EQUAL(top[col].size(), 3);
+            for(std::size_t rank = 0; rank < 3; rank++)
+            {
+                const depnet::CorrelatedColumn& found = top[col][rank];
+                BOOST_CHECK_NE(found.column, col);
+                BOOST_CHECK_SMALL(found.correlation - corr[col][found.column], 1e-5);
+                BOOST_CHECK_SMALL(std::fabs(found.correlation) - strengths[rank], 1e-5);
+            }
+        }
+    }
+
+    // every other column is reported when k exceeds the number of columns
+    depnet::ColumnCorrelations correlations(data);
+    BOOST_CHECK_EQUAL(correlations.topCorrelations(100)[5].size(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_correlation_invalid)
+{
+    boost::multi_array<double, 2> data(boost::extents[1][3]);
+    BOOST_CHECK_THROW(depnet::ColumnCorrelations correlations(data), std::invalid_argument);
+}
@@ -0,0 +1,258 @@
+
+#include <boost/test/unit_test.hpp>
+#include "dependency_network.h"
+#include "exceptions/conversion.h"
+
+#include<cstdio>
+#include<random>
+#include<sstream>
+#include<thread>
+
+#include<unistd.h>
+
+namespace
+{
+    // builds a trained two-variable network where y is a noisy function of x
+    std::shared_ptr<depnet::DependencyNetwork> trainLinearNetwork()
+    {
+        depnet::StandardFactory factory;
+        std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
+        varSpecs.push_back(factory.createVariableSpec());
+        varSpecs.back()->setName("x");
+        varSpecs.push_back(factory.createVariableSpec());
+        varSpecs.back()->setName("y");
+
+        boost::multi_array<double, 2> data(boost::extents[200][2]);
+        std::default_random_engine generator;
+        std::uniform_real_distribution<double> distr(0.0, 10.0);
+        for(int i = 0; i < 200; i++)
+        {
+            data[i][0] = distr(generator);
+            data[i][1] = 2 * data[i][0] + distr(generator) / 10;
+        }
+
+        std::shared_ptr<depnet::DependencyNetwork> network(new depnet::DependencyNetwork(varSpecs));
+        network->train(data);
+        return network;
+    }
+}
+
+// streamed samples should arrive in blocks no larger than requested, 
+// and the total should match the number of samples requested
+BOOST_AUTO_TEST_CASE(test_stream_samples)
+{
+    auto network = trainLinearNetwork();
+
+    std::size_t rowsSeen = 0, largestBlock = 0;
+    long delivered = network->getSamples(25, 
+        [&](const double* rows, std::size_t numRows, std::size_t numCols)
+        {
+            BOOST_CHECK_EQUAL(numCols, 2);
+            rowsSeen += numRows;
+            largestBlock = std::max(largestBlock, numRows);
+            return true;
+        }, 10);
+
+    BOOST_CHECK_EQUAL(delivered, 25);
+    BOOST_CHECK_EQUAL(rowsSeen, 25);
+    BOOST_CHECK_EQUAL(largestBlock, 10);
+}
+
+// returning false from the callback should stop sampling after the current block
+BOOST_AUTO_TEST_CASE(test_stream_samples_stop)
+{
+    auto network = trainLinearNetwork();
+
+    int numCalls = 0;
+    long delivered = network->getSamples(100, 
+        [&](const double* rows, std::size_t numRows, std::size_t numCols)
+        {
+            numCalls++;
+            return false;
+        }, 8);
+
+    BOOST_CHECK_EQUAL(numCalls, 1);
+    BOOST_CHECK_EQUAL(delivered, 8);
+}
+
+// the materialized and buffered interfaces should produce the requested number of rows
+BOOST_AUTO_TEST_CASE(test_buffered_samples)
+{
+    auto network = trainLinearNetwork();
+
+    auto samples = network->getSamples(5);
+    BOOST_CHECK_EQUAL(samples->shape()[0], 5);
+    BOOST_CHECK_EQUAL(samples->shape()[1], 2);
+
+    depnet::SampleBuffer buffer(2, 4);
+    long consumed = 0;
+    std::thread consumer([&]()
+    {
+        double rows[2 * 3];
+        std::size_t numRows;
+        while((numRows = buffer.pop(rows, 3)) > 0)
+            consumed += numRows;
+    });
+
+    long produced = network->getSamples(20, buffer);
+    consumer.join();
+
+    BOOST_CHECK_EQUAL(produced, 20);
+    BOOST_CHECK_EQUAL(consumed, 20);
+}
+
+// restoring a checkpoint should replay the same samples without repeating warm up
+BOOST_AUTO_TEST_CASE(test_network_checkpoint)
+{
+    auto network = trainLinearNetwork();
+    network->getSamples(3);
+
+    std::stringstream stream;
+    network->saveCheckpoint(stream);
+    auto expected = network->getSamples(4);
+
+    network->restoreCheckpoint(stream);
+    auto resumed = network->getSamples(4);
+    BOOST_CHECK(*resumed == *expected);
+}
+
+// a saved network should load without retraining and behave identically to the original
+BOOST_AUTO_TEST_CASE(test_network_persistence)
+{
+    auto network = trainLinearNetwork();
+    network->setSeed(0);
+
+    std::ostringstream out;
+    network->save(out);
+    std::shared_ptr<std::string> bytes(new std::string(out.str()));
+
+    depnet::DependencyNetwork loaded(std::vector<std::shared_ptr<depnet::VariableSpecification> >(), 
+        std::shared_ptr<depnet::Factory>(new depnet::StandardFactory()));
+    loaded.load(std::make_shared<depnet::MappedBuffer>(bytes->data(), bytes->size(), bytes));
+
+    BOOST_REQUIRE_EQUAL(loaded.getVariableSpecs().size(), 2);
+    BOOST_CHECK_EQUAL(loaded.getVariableSpecs()[1]->getName(), "y");
+    auto original = network->getModel(network->getVariableSpecs()[1]);
+    auto restored = loaded.getModel(loaded.getVariableSpecs()[1]);
+    for(double x = 0; x < 10; x += 0.5)
+        BOOST_CHECK_EQUAL(restored->predict({x}), original->predict({x}));
+
+    // loading through a memory-mapped file should give the same samples
+    std::string path = "test_network_persistence.bin";
+    network->save(path);
+    depnet::DependencyNetwork mapped{std::vector<std::shared_ptr<depnet::VariableSpecification> >()};
+    mapped.load(path);
+
+    // saving over the mapped file replaces it, leaving the loaded network intact
+    network->save(path);
+    std::remove(path.c_str());
+    BOOST_CHECK(*mapped.getSamples(3) == *loaded.getSamples(3));
+
+    // counts larger than the input should be rejected before anything is allocated
+    std::shared_ptr<std::string> inflated(new std::string(*bytes));
+    std::uint32_t numVars = 0x7fffffff;
+    inflated->replace(16, sizeof(numVars), reinterpret_cast<const char*>(&numVars), sizeof(numVars));
+    BOOST_CHECK_THROW(mapped.load(std::make_shared<depnet::MappedBuffer>(inflated->data(), inflated->size(), inflated)),
+        depnet::ConversionException);
+
+    std::shared_ptr<std::string> garbage(new std::string("not a network"));
+    BOOST_CHECK_THROW(mapped.load(std::make_shared<depnet::MappedBuffer>(garbage->data(), garbage->size(), garbage)),
+        depnet::ConversionException);
+}
+
+
+// a network published to shared memory should load in place and predict like the original
+BOOST_AUTO_TEST_CASE(test_network_shared_memory)
+{
+    auto network = trainLinearNetwork();
+    std::string name = "/depnet_test_network_" + std::to_string(getpid());
+    network->saveSharedMemory(name);
+
+    depnet::DependencyNetwork shared{std::vector<std::shared_ptr<depnet::VariableSpecification> >()};
+    shared.loadSharedMemory(name);
+
+    // replacing the segment should leave the mapping already loaded untouched
+    depnet::MappedBuffer::publishSharedMemory(name, "replaced", 8);
+    depnet::MappedBuffer::unlinkSharedMemory(name);
+
+    auto original = network->getModel(network->getVariableSpecs()[1]);
+    auto restored = shared.getModel(shared.getVariableSpecs()[1]);
+    for(double x = 0; x < 10; x += 0.5)
+        BOOST_CHECK_EQUAL(restored->predict({x}), original->predict({x}));
+
+    BOOST_CHECK_THROW(shared.loadSharedMemory(name), depnet::ConversionException);
+}
+
+// metrics should describe every trained model and account for each accepted sample
+BOOST_AUTO_TEST_CASE(test_network_metrics)
+{
+    auto network = trainLinearNetwork();
+    network->getSamples(20);
+
+    depnet::NetworkMetrics metrics = network->metrics();
+    BOOST_CHECK_EQUAL(metrics.variables.size(), 2);
+    for(auto it = metrics.variables.begin(); it != metrics.variables.end(); ++it)
+    {
+        BOOST_CHECK_EQUAL(it->modelType, "rdf");
+        BOOST_CHECK(it->trainSeconds > 0);
+        BOOST_CHECK(it->numNodes > 100);
+        BOOST_CHECK(it->maxDepth > 1);
+        BOOST_CHECK(it->predictCalls > 0);
+        BOOST_CHECK(it->getNanosecondsPerPredict() > 0);
+    }
+    BOOST_CHECK_EQUAL(metrics.variables[0].name, "x");
+
+    std::uint64_t accepted = 0, sweeps = 0;
+    for(auto it = metrics.chains.begin(); it != metrics.chains.end(); ++it)
+    {
+        accepted += it->acceptedSamples;
+        sweeps += it->sweeps;
+    }
+    BOOST_CHECK_EQUAL(accepted, 20);
+    // warm up, then the first sample, then one sample at the end of each interval
+    BOOST_CHECK_EQUAL(sweeps, 500 + 1 + 19 * 100);
+
+    // each update either predicted or reused a prediction
+    std::uint64_t updates = 0;
+    for(auto it = metrics.variables.begin(); it != metrics.variables.end(); ++it)
+        updates += it->predictCalls + it->cacheHits;
+    BOOST_CHECK_EQUAL(updates, 2 * sweeps);
+
+    std::ostringstream json;
+    metrics.writeJson(json);
+    BOOST_CHECK(json.str().find("\"name\": \"x\", \"model_type\": \"rdf\"") != std::string::npos);
+    BOOST_CHECK(json.str().find("\"accepted_samples\"") != std::string::npos);
+}
+
+// a network in fast mode should train linear models, which survive a save and load
+BOOST_AUTO_TEST_CASE(test_network_fast_models)
+{
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    factory->setDefaultModelType("fast");
+    std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
+    varSpecs.push_back(factory->createVariableSpec());
+    varSpecs.back()->setName("x");
+    varSpecs.push_back(factory->createVariableSpec());
+    varSpecs.back()->setName("y");
+
+    boost::multi_array<double, 2> data(boost::extents[200][2]);
+    for(int i = 0; i < 200; i++)
+    {
+        data[i][0] = i / 20.0;
+        data[i][1] = 2 * data[i][0] + (i % 7) / 70.0;
+    }
+
+    depnet::DependencyNetwork network(varSpecs, factory);
+    network.train(data);
+    auto model = network.getModel(varSpecs[1]);
+    BOOST_CHECK_EQUAL(model->getModelType(), "linear");
+    BOOST_CHECK_CLOSE(model->predict({5}), 10.04, 1);
+    BOOST_CHECK_EQUAL(network.getSamples(5)->shape()[0], 5);
+
+    std::ostringstream out;
+    network.save(out);
+    std::shared_ptr<std::string> bytes(new std::string(out.str()));
+    depnet::DependencyNetwork loaded{std::vector<std::shared_ptr<depnet::VariableSpecification> >()};
+    loaded.load(std::make_shared<depnet::MappedBuffer>(bytes->data(), bytes->size(), bytes));
+    BOOST_CHECK_EQUAL(loaded.getModel(loaded.getVariableSpecs()[1])->predict({5}), model->predict({5}));
+}
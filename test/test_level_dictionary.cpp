@@ -0,0 +1,38 @@
+#include <boost/test/unit_test.hpp>
+#include "level_dictionary.h"
+#include "exceptions/conversion.h"
+
+#include<string>
+
+// lookups should work in both directions, and unknown levels should have no code
+BOOST_AUTO_TEST_CASE(test_level_dictionary_lookup)
+{
+    auto dictionary = depnet::LevelDictionary::intern({"red", "green", "blue"});
+    BOOST_REQUIRE_EQUAL(dictionary->size(), 3);
+    BOOST_CHECK_EQUAL(dictionary->getCode("blue"), 2);
+    BOOST_CHECK_EQUAL(dictionary->getLevel(1), "green");
+    BOOST_CHECK_EQUAL(dictionary->getCode("purple"), -1);
+}
+
+// identical level lists should share a dictionary for as long as it is in use
+BOOST_AUTO_TEST_CASE(test_level_dictionary_interning)
+{
+    auto first = depnet::LevelDictionary::intern({"no", "yes"});
+    auto second = depnet::LevelDictionary::intern({"no", "yes"});
+    auto reordered = depnet::LevelDictionary::intern({"yes", "no"});
+    BOOST_CHECK(first == second);
+    BOOST_CHECK(first != reordered);
+    BOOST_CHECK_THROW(depnet::LevelDictionary::intern({"a", "b", "a"}), depnet::ConversionException);
+}
+
+// sweeping the dictionaries of many short-lived columns should keep the ones still in use shared
+BOOST_AUTO_TEST_CASE(test_level_dictionary_sweep)
+{
+    auto kept = depnet::LevelDictionary::intern({"kept", "levels"});
+    for(int column = 0; column < 1000; column++)
+    {
+        auto temporary = depnet::LevelDictionary::intern({"level" + std::to_string(column)});
+        BOOST_CHECK_EQUAL(temporary->getCode("level" + std::to_string(column)), 0);
+    }
+    BOOST_CHECK(depnet::LevelDictionary::intern({"kept", "levels"}) == kept);
+}
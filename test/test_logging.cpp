@@ -0,0 +1,81 @@
+
+#include <boost/test/unit_test.hpp>
+#include "logging.h"
+
+#include<iostream>
+#include<thread>
+#include<vector>
+
+namespace
+{
+    // collects records in memory so tests can inspect them
+    class CollectingSink : public depnet::LogSink
+    {
+    public:
+        void write(const depnet::LogRecord& record)
+        {
+            records.push_back(record);
+        }
+
+        std::vector<depnet::LogRecord> records;
+    };
+
+    int countEvaluations(int& counter)
+    {
+        return ++counter;
+    }
+}
+
+// records below the runtime threshold should be dropped without evaluating their arguments
+BOOST_AUTO_TEST_CASE(test_logging_levels)
+{
+    std::shared_ptr<CollectingSink> sink(new CollectingSink());
+    depnet::Logger::clearSinks();
+    depnet::Logger::addSink(sink);
+    depnet::Logger::setLevel(depnet::LogLevel::Warn);
+
+    int evaluations = 0;
+    DEPNET_INFO("dropped " << countEvaluations(evaluations));
+    DEPNET_WARN("kept " << countEvaluations(evaluations));
+
+    BOOST_CHECK_EQUAL(evaluations, 1);
+    BOOST_REQUIRE_EQUAL(sink->records.size(), 1);
+    BOOST_CHECK(sink->records[0].level == depnet::LogLevel::Warn);
+    BOOST_CHECK_EQUAL(sink->records[0].message, "kept 1");
+
+    depnet::Logger::clearSinks();
+    depnet::Logger::addSink(std::shared_ptr<depnet::LogSink>(new depnet::StreamLogSink(std::cerr)));
+}
+
+// a rate-limited statement should stop firing once its budget for the window is spent
+BOOST_AUTO_TEST_CASE(test_logging_rate_limit)
+{
+    depnet::LogRateLimiter limiter(3);
+    int allowed = 0;
+    for(int i = 0; i < 10; i++)
+        allowed += limiter.allow() ? 1 : 0;
+    BOOST_CHECK_EQUAL(allowed, 3);
+}
+
+
+// records logged from several threads should reach a sink which is not thread-safe one at a time
+BOOST_AUTO_TEST_CASE(test_logging_threads)
+{
+    std::shared_ptr<CollectingSink> sink(new CollectingSink());
+    depnet::Logger::clearSinks();
+    depnet::Logger::addSink(sink);
+    depnet::Logger::setLevel(depnet::LogLevel::Warn);
+
+    std::vector<std::thread> threads;
+    for(int thread = 0; thread < 4; thread++)
+        threads.push_back(std::thread([thread]() {
+            for(int i = 0; i < 250; i++)
+                DEPNET_WARN("thread " << thread << " record " << i);
+        }));
+    for(auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+    BOOST_CHECK_EQUAL(sink->records.size(), 1000);
+
+    depnet::Logger::clearSinks();
+    depnet::Logger::addSink(std::shared_ptr<depnet::LogSink>(new depnet::StreamLogSink(std::cerr)));
+}
@@ -0,0 +1,49 @@
+#include <boost/test/unit_test.hpp>
+#include "metrics.h"
+
+#include<sstream>
+#include<thread>
+#include<vector>
+
+// additions from many threads should all be counted
+BOOST_AUTO_TEST_CASE(test_sharded_counter)
+{
+    depnet::ShardedCounter counter;
+    std::vector<std::thread> threads;
+    for(int thread = 0; thread < 20; thread++)
+        threads.push_back(std::thread([&counter]()
+        {
+            for(int i = 0; i < 1000; i++)
+                counter.add(2);
+        }));
+    for(auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+
+    BOOST_CHECK_EQUAL(counter.get(), 40000);
+    counter.reset();
+    BOOST_CHECK_EQUAL(counter.get(), 0);
+}
+
+// names should be escaped so the output stays valid JSON
+BOOST_AUTO_TEST_CASE(test_metrics_json)
+{
+    depnet::NetworkMetrics metrics;
+    metrics.variables.resize(1);
+    metrics.variables[0].name = "a \"quoted\"\tname";
+    metrics.variables[0].predictCalls = 4;
+    metrics.variables[0].predictNanoseconds = 10;
+    metrics.variables[0].candidates.resize(1);
+    metrics.variables[0].candidates[0].modelType = "gbt";
+    metrics.variables[0].candidates[0].validationLoss = 0.5;
+    metrics.chains.resize(2);
+    metrics.chains[1].sweeps = 7;
+
+    std::ostringstream out;
+    metrics.writeJson(out);
+    BOOST_CHECK_EQUAL(out.str(), "{\"variables\": [{\"name\": \"a \\\"quoted\\\"\\u0009name\", \"model_type\": \"\", "
+        "\"train_seconds\": 0, \"num_nodes\": 0, \"max_depth\": 0, \"predict_calls\": 4, "
+        "\"predict_nanoseconds\": 10, \"nanoseconds_per_predict\": 2.5, \"cache_hits\": 0, "
+        "\"candidates\": [{\"model_type\": \"gbt\", \"validation_loss\": 0.5, \"nanoseconds_per_predict\": 0, "
+        "\"train_seconds\": 0}]}], "
+        "\"chains\": [{\"sweeps\": 0, \"accepted_samples\": 0}, {\"sweeps\": 7, \"accepted_samples\": 0}]}");
+}
@@ -0,0 +1,127 @@
+#include <boost/test/unit_test.hpp>
+#include "model_selection.h"
+#include "dependency_network.h"
+#include "standard_factory.h"
+
+#include<algorithm>
+
+namespace
+{
+    std::vector<std::shared_ptr<depnet::VariableSpecification> > linearVariables(depnet::StandardFactory& factory)
+    {
+        std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
+        varSpecs.push_back(factory.createVariableSpec());
+        varSpecs.back()->setName("x");
+        varSpecs.push_back(factory.createVariableSpec());
+        varSpecs.back()->setName("y");
+        return varSpecs;
+    }
+
+    boost::multi_array<double, 2> linearData()
+    {
+        boost::multi_array<double, 2> data(boost::extents[200][2]);
+        for(int i = 0; i < 200; i++)
+        {
+            data[i][0] = i / 20.0;
+            data[i][1] = 2 * data[i][0] + (i % 7) / 70.0;
+        }
+        return data;
+    }
+}
+
+// the chosen model should be the cheapest within tolerance of the best validation loss
+BOOST_AUTO_TEST_CASE(test_select_within_tolerance)
+{
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    auto varSpecs = linearVariables(*factory);
+    boost::multi_array<double, 2> data = linearData();
+
+    depnet::ModelSelectionOptions options;
+    options.candidates = {"rdf", "fast", "cpt"};
+    depnet::ModelSelection selection = depnet::ModelSelector(factory, options).select(varSpecs, data);
+    BOOST_REQUIRE_EQUAL(selection.models.size(), 2);
+    for(std::size_t var = 0; var < 2; var++)
+    {
+        // probability tables do not apply to continuous variables
+        const std::vector<depnet::CandidateMetrics>& candidates = selection.candidates[var];
+        BOOST_REQUIRE_EQUAL(candidates.size(), 2);
+        BOOST_CHECK_EQUAL(candidates[0].modelType, "rdf");
+        BOOST_CHECK_EQUAL(candidates[1].modelType, "linear");
+
+        double best = std::min(candidates[0].validationLoss, candidates[1].validationLoss);
+        auto chosen = std::find_if(candidates.begin(), candidates.end(), [&](const depnet::CandidateMetrics& c) {
+            return c.modelType == selection.models[var]->getModelType(); });
+        BOOST_REQUIRE(chosen != candidates.end());
+        BOOST_CHECK_LE(chosen->validationLoss, best + options.tolerance * best + 1e-12);
+        for(auto it = candidates.begin(); it != candidates.end(); ++it)
+            if(it->validationLoss <= best + options.tolerance * best)
+                BOOST_CHECK_LE(chosen->nanosecondsPerPredict, it->nanosecondsPerPredict);
+    }
+    BOOST_CHECK_EQUAL(selection.models[1]->getModelType(), "linear");
+    BOOST_CHECK_CLOSE(selection.models[1]->predict({5}), 10.04, 1);
+}
+
+// probability tables larger than the table budget should not be candidates
+BOOST_AUTO_TEST_CASE(test_select_table_budget)
+{
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    std::vector<std::shared_ptr<depnet::VariableSpecification> > varSpecs;
+    for(int var = 0; var < 2; var++)
+    {
+        varSpecs.push_back(factory->createVariableSpec());
+        varSpecs.back()->setName(var == 0 ? "a" : "b");
+        varSpecs.back()->setLevels({"low", "mid", "high"});
+        varSpecs.back()->setDiscrete(true);
+    }
+    boost::multi_array<double, 2> data(boost::extents[60][2]);
+    for(int i = 0; i < 60; i++)
+    {
+        data[i][0] = i % 3;
+        data[i][1] = (i / 3) % 3;
+    }
+
+    depnet::ModelSelectionOptions options;
+    options.candidates = {"cpt", "fast"};
+    depnet::ModelSelection selection = depnet::ModelSelector(factory, options).select(varSpecs, data);
+    BOOST_CHECK_EQUAL(selection.candidates[0].size(), 2);
+
+    options.tableBudget = 9 * sizeof(double) - 1;
+    selection = depnet::ModelSelector(factory, options).select(varSpecs, data);
+    for(std::size_t var = 0; var < 2; var++)
+    {
+        BOOST_REQUIRE_EQUAL(selection.candidates[var].size(), 1);
+        BOOST_CHECK_EQUAL(selection.candidates[var][0].modelType, "logistic");
+    }
+}
+
+// an unreachable budget should leave every variable with its cheapest candidate, reported in the network's metrics
+BOOST_AUTO_TEST_CASE(test_select_latency_budget)
+{
+    std::shared_ptr<depnet::StandardFactory> factory(new depnet::StandardFactory());
+    auto varSpecs = linearVariables(*factory);
+    boost::multi_array<double, 2> data = linearData();
+
+    std::shared_ptr<depnet::ModelSelectionOptions> options(new depnet::ModelSelectionOptions());
+    options->candidates = {"rdf", "gbt"};
+    options->tolerance = 1e6;
+    options->latencyBudget = 1e-3;
+    depnet::DependencyNetwork network(varSpecs, factory);
+    network.setModelSelection(options);
+    network.train(data);
+
+    depnet::NetworkMetrics metrics = network.metrics();
+    for(auto varIt = metrics.variables.begin(); varIt != metrics.variables.end(); ++varIt)
+    {
+        BOOST_REQUIRE_EQUAL(varIt->candidates.size(), 2);
+        auto cheapest = std::min_element(varIt->candidates.begin(), varIt->candidates.end(),
+            [](const depnet::CandidateMetrics& a, const depnet::CandidateMetrics& b) { 
+                return a.nanosecondsPerPredict < b.nanosecondsPerPredict; });
+        BOOST_CHECK_EQUAL(varIt->modelType, cheapest->modelType);
+        BOOST_CHECK_GT(varIt->trainSeconds, 0);
+    }
+    BOOST_CHECK_EQUAL(network.getSamples(5)->shape()[0], 5);
+
+    network.setModelSelection(std::shared_ptr<depnet::ModelSelectionOptions>());
+    network.train(data);
+    BOOST_CHECK(network.metrics().variables[0].candidates.empty());
+}
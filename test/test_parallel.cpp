@@ -0,0 +1,36 @@
+#include <boost/test/unit_test.hpp>
+#include "parallel.h"
+#include "alglib/ap.h"
+
+#include<atomic>
+#include<stdexcept>
+#include<thread>
+#include<vector>
+
+// every index should run once on the shared pool, nested calls should stay on their thread, 
+// and a task's exception should reach the caller
+BOOST_AUTO_TEST_CASE(test_parallel_for)
+{
+    alglib::setnworkers(4);
+    BOOST_CHECK_EQUAL(depnet::getDefaultThreads(), 4);
+
+    std::vector<std::atomic<int> > runs(1000);
+    std::atomic<bool> nestedMoved(false);
+    depnet::parallelFor(100, 0, [&](std::size_t outer) {
+        std::thread::id id = std::this_thread::get_id();
+        depnet::parallelFor(10, 0, [&](std::size_t inner) {
+            runs[outer * 10 + inner]++;
+            if(std::this_thread::get_id() != id)
+                nestedMoved = true;
+        });
+    });
+    for(auto it = runs.begin(); it != runs.end(); ++it)
+        BOOST_CHECK_EQUAL(it->load(), 1);
+    BOOST_CHECK(!nestedMoved);
+
+    BOOST_CHECK_THROW(depnet::parallelFor(50, 4, [](std::size_t index) {
+        if(index == 17)
+            throw std::runtime_error("failed task");
+    }), std::runtime_error);
+    alglib::setnworkers(0);
+}
@@ -0,0 +1,51 @@
+
+#include <boost/test/unit_test.hpp>
+#include "sample_buffer.h"
+
+#include<thread>
+
+// rows should come out of the ring in the order they were pushed, including after wrapping around
+BOOST_AUTO_TEST_CASE(test_sample_buffer_order)
+{
+    depnet::SampleBuffer buffer(2, 3);
+    std::thread producer([&]()
+    {
+        for(int i = 0; i < 10; i++)
+        {
+            double row[2] = {(double) i, (double) -i};
+            buffer.push(row);
+        }
+        buffer.close();
+    });
+
+    std::vector<double> received;
+    double rows[2 * 2];
+    std::size_t numRows;
+    while((numRows = buffer.pop(rows, 2)) > 0)
+        received.insert(received.end(), rows, rows + numRows * 2);
+    producer.join();
+
+    BOOST_REQUIRE_EQUAL(received.size(), 20);
+    for(int i = 0; i < 10; i++)
+    {
+        BOOST_CHECK_EQUAL(received[2 * i], i);
+        BOOST_CHECK_EQUAL(received[2 * i + 1], -i);
+    }
+}
+
+// pushing to a closed buffer should fail rather than block
+BOOST_AUTO_TEST_CASE(test_sample_buffer_closed)
+{
+    depnet::SampleBuffer buffer(1, 1);
+    double value = 1;
+    BOOST_CHECK(buffer.push(&value));
+    buffer.close();
+    BOOST_CHECK(!buffer.push(&value));
+    BOOST_CHECK(buffer.isClosed());
+
+    // rows buffered before closing can still be drained
+    double out;
+    BOOST_CHECK_EQUAL(buffer.pop(&out, 1), 1);
+    BOOST_CHECK_EQUAL(buffer.pop(&out, 1), 0);
+}
+
@@ -0,0 +1,53 @@
+
+#include <boost/test/unit_test.hpp>
+#include "standard_factory.h"
+#include "exceptions/conversion.h"
+
+// the fast model type should resolve by variable type, and per-variable types should override the default
+BOOST_AUTO_TEST_CASE(test_choose_model_type)
+{
+    depnet::StandardFactory factory;
+    auto x = factory.createVariableSpec();
+    x->setName("x");
+    auto color = factory.createVariableSpec();
+    color->setName("color");
+    color->setLevels({"red", "green"});
+    color->setDiscrete(true);
+
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color}, x), "rdf");
+    factory.setDefaultModelType("fast");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color}, x), "linear");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({x}, color), "logistic");
+    factory.setModelType("color", "rdf");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({x}, color), "rdf");
+
+    BOOST_CHECK_EQUAL(factory.createModel("linear", {color}, x)->getModelType(), "linear");
+    BOOST_CHECK_EQUAL(factory.createModel("logistic", {x}, color)->getModelType(), "logistic");
+    BOOST_CHECK_THROW(factory.createModel("logistic", {color}, x), depnet::ConversionException);
+    BOOST_CHECK_THROW(factory.createModel("unknown", {color}, x), depnet::ConversionException);
+}
+
+// discrete variables with discrete inputs should get a probability table when it fits the budget
+BOOST_AUTO_TEST_CASE(test_choose_table)
+{
+    depnet::StandardFactory factory;
+    auto color = factory.createVariableSpec();
+    color->setName("color");
+    color->setLevels({"red", "green", "blue"});
+    color->setDiscrete(true);
+    auto flag = factory.createVariableSpec();
+    flag->setName("flag");
+    flag->setDiscrete(true);
+    flag->setBoolean(true);
+    auto x = factory.createVariableSpec();
+    x->setName("x");
+
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color}, flag), "rdf");
+    factory.setTableBudget(6 * sizeof(double));
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color}, flag), "cpt");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color, flag}, flag), "rdf");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color, x}, flag), "rdf");
+    factory.setModelType("flag", "logistic");
+    BOOST_CHECK_EQUAL(factory.chooseModelType({color}, flag), "logistic");
+    BOOST_CHECK_EQUAL(factory.createModel("cpt", {color}, flag)->getModelType(), "cpt");
+}
@@ -9,9 +9,20 @@
 BOOST_AUTO_TEST_CASE(test_construction)
 {
     depnet::StandardVariableSpecification varSpec;
-    BOOST_CHECK_MESSAGE(!varSpec->hasRange(), 
+    BOOST_CHECK_MESSAGE(!varSpec.hasRange(), 
         "Variable specifications should not have a range after construction.");
 }
 
 
 
+
+// the level map should number levels in order, and agree with the shared dictionary
+BOOST_AUTO_TEST_CASE(test_level_map)
+{
+    depnet::StandardVariableSpecification varSpec;
+    varSpec.setLevels({"low", "medium", "high"});
+    std::map<int, std::string> levelMap = varSpec.getLevelMap();
+    BOOST_REQUIRE_EQUAL(levelMap.size(), 3);
+    BOOST_CHECK_EQUAL(levelMap[2], "high");
+    BOOST_CHECK_EQUAL(varSpec.getLevelDictionary()->getCode("medium"), 1);
+}
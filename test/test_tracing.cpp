@@ -0,0 +1,82 @@
+#include <boost/test/unit_test.hpp>
+#include "tracing.h"
+#include "models/rdf_model.h"
+#include "standard_var_spec.h"
+
+#include<sstream>
+#include<string>
+#include<thread>
+#include<vector>
+
+namespace
+{
+    std::size_t countOccurrences(const std::string& text, const std::string& pattern)
+    {
+        std::size_t count = 0;
+        for(std::size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+            count++;
+        return count;
+    }
+
+    std::string traceText()
+    {
+        std::ostringstream out;
+        depnet::tracing::writeChromeTrace(out);
+        return out.str();
+    }
+}
+
+// spans should only be recorded while tracing is on, from every thread, and be discarded by clear
+BOOST_AUTO_TEST_CASE(test_trace_spans)
+{
+    depnet::tracing::clear();
+    {
+        depnet::TraceSpan span("ignored", "test");
+    }
+
+    depnet::tracing::setEnabled(true);
+    std::vector<std::thread> threads;
+    for(int thread = 0; thread < 4; thread++)
+        threads.push_back(std::thread([]()
+        {
+            for(int i = 0; i < 5000; i++)
+                depnet::TraceSpan span("work", "test", depnet::tracing::intern("a \"detail\""));
+        }));
+    for(auto it = threads.begin(); it != threads.end(); ++it)
+        it->join();
+    depnet::tracing::setEnabled(false);
+
+    std::string trace = traceText();
+    BOOST_CHECK_EQUAL(countOccurrences(trace, "\"name\": \"work\""), 20000);
+    BOOST_CHECK_EQUAL(countOccurrences(trace, "\"ignored\""), 0);
+    BOOST_CHECK_EQUAL(countOccurrences(trace, "\"thread_name\""), 4);
+    BOOST_CHECK(trace.find("\"args\": {\"detail\": \"a \\\"detail\\\"\"}") != std::string::npos);
+    BOOST_CHECK_EQUAL(depnet::tracing::getDroppedEvents(), 0);
+    BOOST_CHECK(depnet::tracing::intern("x") == depnet::tracing::intern(std::string("x")));
+
+    depnet::tracing::clear();
+    BOOST_CHECK_EQUAL(countOccurrences(traceText(), "\"name\": \"work\""), 0);
+}
+
+// each tree of a forest should be traced through alglib's tree hooks, but only while tracing is on
+BOOST_AUTO_TEST_CASE(test_trace_forest_trees)
+{
+    std::shared_ptr<depnet::VariableSpecification> x(new depnet::StandardVariableSpecification());
+    std::shared_ptr<depnet::VariableSpecification> y(new depnet::StandardVariableSpecification());
+    boost::multi_array<double, 2> data(boost::extents[50][2]);
+    for(int i = 0; i < 50; i++)
+    {
+        data[i][0] = i;
+        data[i][1] = 2 * i;
+    }
+
+    depnet::tracing::clear();
+    depnet::RandomForestModel(std::vector<std::shared_ptr<depnet::VariableSpecification> >{x}, y, 0.5, 7).train(data, 1);
+    BOOST_CHECK_EQUAL(countOccurrences(traceText(), "\"dfbuildtree\""), 0);
+
+    depnet::tracing::setEnabled(true);
+    depnet::RandomForestModel(std::vector<std::shared_ptr<depnet::VariableSpecification> >{x}, y, 0.5, 7).train(data, 1);
+    depnet::tracing::setEnabled(false);
+    BOOST_CHECK_EQUAL(countOccurrences(traceText(), "\"dfbuildtree\""), 7);
+    depnet::tracing::clear();
+}